@@ -3,8 +3,11 @@
 #include "Input/AimAssistInputModifier.h"
 #include "EnhancedPlayerInput.h"
 #include "GameFramework/GameStateBase.h"
+#include "HAL/FileManager.h"
 #include "Input/AimAssistTargetManagerComponent.h"
 #include "Input/LyraAimSensitivityData.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
 #include "Player/LyraLocalPlayer.h"
 #include "Player/LyraPlayerState.h"
 #include "Settings/LyraSettingsShared.h"
@@ -33,6 +36,13 @@ namespace LyraConsoleVariables
 		bDrawAimAssistDebug,
 		TEXT("Should we draw some debug stats about aim assist?"),
 		ECVF_Cheat);
+
+	static FString RecordAimAssistInputFile;
+	static FAutoConsoleVariableRef CVarRecordAimAssistInputFile(
+		TEXT("lyra.Weapon.AimAssist.RecordInputFile"),
+		RecordAimAssistInputFile,
+		TEXT("When set, appends each frame's delta time, look input and move input to this file (relative to the Saved directory). The format matches the stick traces replayed by the Lyra.AimAssist.Replay tests."),
+		ECVF_Cheat);
 }
 
 ///////////////////////////////////////////////////////////////////
@@ -53,6 +63,7 @@ void FLyraAimAssistTarget::ResetTarget()
 	AssistWeight = 0.0f;
 
 	VisibilityTraceHandle = FTraceHandle();
+	LastVisibilityTraceTime = -1.0;
 
 	bIsVisible = false;
 	bUnderAssistInnerReticle = false;
@@ -487,15 +498,36 @@ FInputActionValue UAimAssistInputModifier::ModifyRaw_Implementation(const UEnhan
 	{
 		return CurrentValue;
 	}
-	
+
+	const FVector BaselineInput = CurrentValue.Get<FVector>();
+	const FVector CurrentMoveInput = MoveInputAction ? PlayerInput->GetActionValue(MoveInputAction).Get<FVector>() : FVector::ZeroVector;	
+
+#if !UE_BUILD_SHIPPING
+	if (!LyraConsoleVariables::RecordAimAssistInputFile.IsEmpty())
+	{
+		const FString Line = FString::Printf(TEXT("%.5f,%.4f,%.4f,%.4f,%.4f%s"), DeltaTime, BaselineInput.X, BaselineInput.Y, CurrentMoveInput.X, CurrentMoveInput.Y, LINE_TERMINATOR);
+		FFileHelper::SaveStringToFile(Line, *(FPaths::ProjectSavedDir() / LyraConsoleVariables::RecordAimAssistInputFile), FFileHelper::EEncodingOptions::ForceAnsi, &IFileManager::Get(), FILEWRITE_Append);
+	}
+#endif //UE_BUILD_SHIPPING
+
+	return ApplyAimAssist(PC, BaselineInput, CurrentMoveInput, DeltaTime);
+}
+
+FVector UAimAssistInputModifier::ReplayLookInput(APlayerController* PC, const FAimAssistOwnerViewData& ViewData, const FVector& LookInput, const FVector& MoveInput, float DeltaTime)
+{
+	check(PC);
+
+	OwnerViewData = ViewData;
+	return ApplyAimAssist(PC, LookInput, MoveInput, DeltaTime);
+}
+
+FVector UAimAssistInputModifier::ApplyAimAssist(APlayerController* PC, const FVector& BaselineInput, const FVector& CurrentMoveInput, float DeltaTime)
+{
 	// Swaps the target cache's and determines what targets are currently visible. Updates the score of each target to determine
 	// how much pull/slow effect should be applied to each
 	UpdateTargetData(DeltaTime);
 
-	FVector BaselineInput = CurrentValue.Get<FVector>();
-	
 	FVector OutAssistedInput = BaselineInput;
-	FVector CurrentMoveInput = MoveInputAction ? PlayerInput->GetActionValue(MoveInputAction).Get<FVector>() : FVector::ZeroVector;	
 
 	// Something about the look rates is incorrect
 	FRotator LookRates = GetLookRates(BaselineInput);
@@ -3,13 +3,35 @@
 #include "Input/AimAssistTargetComponent.h"
 
 #include "Components/ShapeComponent.h"
+#include "Engine/World.h"
 #include "GameFramework/Actor.h"
+#include "Input/AimAssistTargetRegistry.h"
 #include "Input/IAimAssistTargetInterface.h"
 #include "UObject/WeakObjectPtr.h"
 #include "UObject/WeakObjectPtrTemplates.h"
 
 #include UE_INLINE_GENERATED_CPP_BY_NAME(AimAssistTargetComponent)
 
+void UAimAssistTargetComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (UAimAssistTargetRegistry* Registry = UWorld::GetSubsystem<UAimAssistTargetRegistry>(GetWorld()))
+	{
+		Registry->RegisterTarget(this);
+	}
+}
+
+void UAimAssistTargetComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UAimAssistTargetRegistry* Registry = UWorld::GetSubsystem<UAimAssistTargetRegistry>(GetWorld()))
+	{
+		Registry->UnregisterTarget(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
 void UAimAssistTargetComponent::GatherTargetOptions(FAimAssistTargetOptions& OutTargetData)
 {
 	if (!TargetData.TargetShapeComponent.IsValid())
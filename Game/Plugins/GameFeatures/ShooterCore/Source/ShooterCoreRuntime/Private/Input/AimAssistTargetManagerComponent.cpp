@@ -2,6 +2,7 @@
 
 #include "Input/AimAssistTargetManagerComponent.h"
 #include "Input/AimAssistTargetComponent.h"
+#include "Input/AimAssistTargetRegistry.h"
 #include "GameFramework/PlayerController.h"
 #include "GameFramework/InputSettings.h"
 #include "GameFramework/Character.h"
@@ -25,6 +26,13 @@ namespace LyraConsoleVariables
 		bDrawDebugViewfinder,
 		TEXT("Should we draw a debug box for the aim assist target viewfinder?"),
 		ECVF_Cheat);
+
+	static bool bUseTargetRegistry = true;
+	static FAutoConsoleVariableRef CVarUseTargetRegistry(
+		TEXT("lyra.Weapon.AimAssist.UseTargetRegistry"),
+		bUseTargetRegistry,
+		TEXT("Should aim assist find its targets in the target registry? If not, it uses an overlap query on the aim assist channel."),
+		ECVF_Default);
 }
 
 const FLyraAimAssistTarget* FindTarget(const TArray<FLyraAimAssistTarget>& Targets, const UShapeComponent* TargetComponent)
@@ -118,51 +126,74 @@ void UAimAssistTargetManagerComponent::GetVisibleTargets(const FAimAssistFilter&
 	const FBox2D AssistOuterReticleBounds = OwnerData.ProjectReticleToScreen(Settings.AssistOuterReticleWidth.GetValue(), Settings.AssistOuterReticleHeight.GetValue(), ReticleDepth);
 	const FBox2D TargetingReticleBounds = OwnerData.ProjectReticleToScreen(Settings.TargetingReticleWidth.GetValue(), Settings.TargetingReticleHeight.GetValue(), ReticleDepth);
 
-	static TArray<FOverlapResult> OverlapResults;
-	// Do a world trace on the Aim Assist channel to get any visible targets
+	// Gather target options from everything inside the viewfinder box that implements the IAimAssistTarget interface
+	TArray<FAimAssistTargetOptions> NewTargetData;
 	{
 		UWorld* World = GetWorld();
-		
-		OverlapResults.Reset();
 
 		const FVector PawnLocation = OwnerPawn->GetActorLocation();
-		ECollisionChannel AimAssistChannel = GetAimAssistChannel();
-		FCollisionQueryParams Params(SCENE_QUERY_STAT(AimAssist_QueryTargetsInRange), true);
-		Params.AddIgnoredActor(OwnerPawn);
+		const FQuat ViewfinderRotation = OwnerData.PlayerTransform.GetRotation();
+		const ECollisionChannel AimAssistChannel = GetAimAssistChannel();
 
-		// Need to multiply these by 0.5 because MakeBox takes in half extents
-		FCollisionShape BoxShape = FCollisionShape::MakeBox(FVector3f(ReticleDepth * 0.5f, Settings.AssistOuterReticleWidth.GetValue() * 0.5f, Settings.AssistOuterReticleHeight.GetValue() * 0.5f));						
-		World->OverlapMultiByChannel(OUT OverlapResults, PawnLocation, OwnerData.PlayerTransform.GetRotation(), AimAssistChannel, BoxShape, Params);
+		// Half extents, the reticle settings are full sizes
+		const FVector ViewfinderHalfExtents(ReticleDepth * 0.5f, Settings.AssistOuterReticleWidth.GetValue() * 0.5f, Settings.AssistOuterReticleHeight.GetValue() * 0.5f);
 
-#if ENABLE_DRAW_DEBUG && !UE_BUILD_SHIPPING
-		if(LyraConsoleVariables::bDrawDebugViewfinder)
+		UAimAssistTargetRegistry* Registry = LyraConsoleVariables::bUseTargetRegistry ? UWorld::GetSubsystem<UAimAssistTargetRegistry>(World) : nullptr;
+		if (Registry)
 		{
-			DrawDebugBox(World, PawnLocation, BoxShape.GetBox(), OwnerData.PlayerTransform.GetRotation(), FColor::Red);	
-		}
-#endif
-	}
+			TArray<UAimAssistTargetComponent*> RegisteredTargets;
+			Registry->GatherTargetsInBox(PawnLocation, ViewfinderRotation, ViewfinderHalfExtents, RegisteredTargets);
 
-	// Gather target options from any visibile hit results that implement the IAimAssistTarget interface
-	TArray<FAimAssistTargetOptions> NewTargetData;
-	{
-		for (const FOverlapResult& Overlap : OverlapResults)
-		{
-			TScriptInterface<IAimAssistTaget> TargetActor(Overlap.GetActor());
-			if (TargetActor)
+			for (UAimAssistTargetComponent* TargetComponent : RegisteredTargets)
 			{
+				// Match what an overlap on the aim assist channel would have found
+				if ((TargetComponent->GetOwner() == OwnerPawn) || !TargetComponent->IsQueryCollisionEnabled() || (TargetComponent->GetCollisionResponseToChannel(AimAssistChannel) == ECR_Ignore))
+				{
+					continue;
+				}
+
 				FAimAssistTargetOptions TargetData;
-				TargetActor->GatherTargetOptions(TargetData);
+				TargetComponent->GatherTargetOptions(TargetData);
 				NewTargetData.Add(TargetData);
 			}
-			
-			TScriptInterface<IAimAssistTaget> TargetComponent(Overlap.GetComponent());
-			if (TargetComponent)
+		}
+		else
+		{
+			// Do a world overlap on the Aim Assist channel to get any visible targets
+			TArray<FOverlapResult> OverlapResults;
+
+			FCollisionQueryParams Params(SCENE_QUERY_STAT(AimAssist_QueryTargetsInRange), true);
+			Params.AddIgnoredActor(OwnerPawn);
+
+			const FCollisionShape BoxShape = FCollisionShape::MakeBox(FVector3f(ViewfinderHalfExtents));
+			World->OverlapMultiByChannel(OUT OverlapResults, PawnLocation, ViewfinderRotation, AimAssistChannel, BoxShape, Params);
+
+			for (const FOverlapResult& Overlap : OverlapResults)
 			{
-				FAimAssistTargetOptions TargetData;
-				TargetComponent->GatherTargetOptions(TargetData);
-				NewTargetData.Add(TargetData);
-			}			
+				TScriptInterface<IAimAssistTaget> TargetActor(Overlap.GetActor());
+				if (TargetActor)
+				{
+					FAimAssistTargetOptions TargetData;
+					TargetActor->GatherTargetOptions(TargetData);
+					NewTargetData.Add(TargetData);
+				}
+
+				TScriptInterface<IAimAssistTaget> TargetComponent(Overlap.GetComponent());
+				if (TargetComponent)
+				{
+					FAimAssistTargetOptions TargetData;
+					TargetComponent->GatherTargetOptions(TargetData);
+					NewTargetData.Add(TargetData);
+				}
+			}
 		}
+
+#if ENABLE_DRAW_DEBUG && !UE_BUILD_SHIPPING
+		if(LyraConsoleVariables::bDrawDebugViewfinder)
+		{
+			DrawDebugBox(World, PawnLocation, ViewfinderHalfExtents, ViewfinderRotation, FColor::Red);	
+		}
+#endif
 	}
 	
 	// Gather targets that are in front of the player
@@ -243,6 +274,8 @@ void UAimAssistTargetManagerComponent::GetVisibleTargets(const FAimAssistFilter&
 				NewTarget.AssistTime = OldTarget->AssistTime;
 				NewTarget.AssistWeight = OldTarget->AssistWeight;
 				NewTarget.VisibilityTraceHandle = OldTarget->VisibilityTraceHandle;
+				NewTarget.LastVisibilityTraceTime = OldTarget->LastVisibilityTraceTime;
+				NewTarget.bIsVisible = OldTarget->bIsVisible;
 			}
 
 			// Calculate a score used for sorting based on previous weight, distance from target, and distance from reticle.
@@ -268,12 +301,7 @@ void UAimAssistTargetManagerComponent::GetVisibleTargets(const FAimAssistFilter&
 	}
 
 	// Do visibliity traces on the targets
-	{
-		for (FLyraAimAssistTarget& Target : OutNewTargets)
-		{
-			DetermineTargetVisibility(Target, Settings, Filter, OwnerData);
-		}
-	}
+	UpdateTargetVisibility(OutNewTargets, Settings, Filter, OwnerData);
 }
 
 bool UAimAssistTargetManagerComponent::DoesTargetPassFilter(const FAimAssistOwnerViewData& OwnerData, const FAimAssistFilter& Filter, const FAimAssistTargetOptions& Target, const float AcceptableRange) const
@@ -381,7 +409,74 @@ float UAimAssistTargetManagerComponent::GetFOVScale(const APlayerController* PC,
 	return FovScale;
 }
 
-void UAimAssistTargetManagerComponent::DetermineTargetVisibility(FLyraAimAssistTarget& Target, const FAimAssistSettings& Settings, const FAimAssistFilter& Filter, const FAimAssistOwnerViewData& OwnerData)
+void UAimAssistTargetManagerComponent::UpdateTargetVisibility(TArray<FLyraAimAssistTarget>& Targets, const FAimAssistSettings& Settings, const FAimAssistFilter& Filter, const FAimAssistOwnerViewData& OwnerData)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(UAimAssistTargetManagerComponent::UpdateTargetVisibility);
+
+	UWorld* World = GetWorld();
+	check(World);
+
+	const double CurrentTime = World->GetTimeSeconds();
+
+	// Pick up the results of the asynchronous traces started last frame
+	for (FLyraAimAssistTarget& Target : Targets)
+	{
+		if (Target.VisibilityTraceHandle.IsValid())
+		{
+			FTraceDatum TraceDatum;
+			if (World->QueryTraceData(Target.VisibilityTraceHandle, TraceDatum))
+			{
+				Target.bIsVisible = (FHitResult::GetFirstBlockingHit(TraceDatum.OutHits) == nullptr);
+			}
+			else
+			{
+				UE_LOG(LogAimAssist, Warning, TEXT("UAimAssistTargetManagerComponent::UpdateTargetVisibility() - Failed to find async visibility trace data!"));
+
+				// Keep the last known visibility but trace again as soon as possible
+				Target.LastVisibilityTraceTime = -1.0;
+			}
+
+			// Invalidate the async trace handle.
+			Target.VisibilityTraceHandle = FTraceHandle();
+		}
+	}
+
+	// Round robin, the targets traced the longest ago (or never) go first
+	TArray<int32, TInlineAllocator<16>> TraceOrder;
+	for (int32 TargetIndex = 0; TargetIndex < Targets.Num(); ++TargetIndex)
+	{
+		TraceOrder.Add(TargetIndex);
+	}
+
+	TraceOrder.Sort([&Targets](int32 IndexA, int32 IndexB)
+	{
+		return (Targets[IndexA].LastVisibilityTraceTime < Targets[IndexB].LastVisibilityTraceTime);
+	});
+
+	const int32 MaxTraces = (Settings.MaxVisibilityTracesPerFrame > 0) ? Settings.MaxVisibilityTracesPerFrame : Targets.Num();
+	int32 NumTraces = 0;
+
+	for (const int32 TargetIndex : TraceOrder)
+	{
+		FLyraAimAssistTarget& Target = Targets[TargetIndex];
+
+		const bool bHasBeenTraced = (Target.LastVisibilityTraceTime >= 0.0);
+		const bool bIsStale = !bHasBeenTraced || ((CurrentTime - Target.LastVisibilityTraceTime) > Settings.MaxVisibilityAge);
+
+		// Everything after this one was traced more recently, so it is not stale either
+		if ((NumTraces >= MaxTraces) && !bIsStale)
+		{
+			break;
+		}
+
+		// Targets seen for the first time trace synchronously so they get a result this frame
+		DetermineTargetVisibility(Target, Settings, Filter, OwnerData, bHasBeenTraced);
+		Target.LastVisibilityTraceTime = CurrentTime;
+		++NumTraces;
+	}
+}
+
+void UAimAssistTargetManagerComponent::DetermineTargetVisibility(FLyraAimAssistTarget& Target, const FAimAssistSettings& Settings, const FAimAssistFilter& Filter, const FAimAssistOwnerViewData& OwnerData, bool bAllowAsync)
 {
 	UWorld* World = GetWorld();
 	check(World);
@@ -408,31 +503,10 @@ void UAimAssistTargetManagerComponent::DetermineTargetVisibility(FLyraAimAssistT
 	ResponseParams.CollisionResponse.SetResponse(ECC_Pawn, ECR_Ignore);	
 	ResponseParams.CollisionResponse.SetResponse(AimAssistChannel, ECR_Ignore);
 
-	if (Target.bIsVisible && Settings.bEnableAsyncVisibilityTrace)
+	if (bAllowAsync && Settings.bEnableAsyncVisibilityTrace)
 	{
-		// Query for previous asynchronous trace result.
-		if (Target.VisibilityTraceHandle.IsValid())
-		{
-			FTraceDatum TraceDatum;
-			if (World->QueryTraceData(Target.VisibilityTraceHandle, TraceDatum))
-			{
-				Target.bIsVisible = (FHitResult::GetFirstBlockingHit(TraceDatum.OutHits) == nullptr);
-			}
-			else
-			{
-				UE_LOG(LogAimAssist, Warning, TEXT("UAimAssistTargetManagerComponent::DetermineTargetVisibility() - Failed to find async visibility trace data!"));
-				Target.bIsVisible = false;
-			}
-
-			// Invalidate the async trace handle.
-			Target.VisibilityTraceHandle = FTraceHandle();
-		}
-
-		// Only start a new asynchronous trace for next frame if the target is still visible.
-		if (Target.bIsVisible)
-		{
-			Target.VisibilityTraceHandle = World->AsyncLineTraceByChannel(EAsyncTraceType::Test, OwnerData.ViewTransform.GetTranslation(), TargetEyeLocation, ECC_Visibility, QueryParams, ResponseParams);
-		}
+		// The target keeps its current visibility until the result is picked up next frame
+		Target.VisibilityTraceHandle = World->AsyncLineTraceByChannel(EAsyncTraceType::Test, OwnerData.ViewTransform.GetTranslation(), TargetEyeLocation, ECC_Visibility, QueryParams, ResponseParams);
 	}
 	else
 	{
@@ -0,0 +1,373 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Input/AimAssistTargetRegistry.h"
+
+#include "Algo/Sort.h"
+#include "Components/CapsuleComponent.h"
+#include "CoreGlobals.h"
+#include "HAL/IConsoleManager.h"
+#include "Input/AimAssistTargetComponent.h"
+#include "Math/Transform.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(AimAssistTargetRegistry)
+
+namespace LyraConsoleVariables
+{
+	static float AimAssistTargetGridCellSize = 2000.0f;
+	static FAutoConsoleVariableRef CVarAimAssistTargetGridCellSize(
+		TEXT("lyra.Weapon.AimAssist.TargetGridCellSize"),
+		AimAssistTargetGridCellSize,
+		TEXT("Size (in cm) of the grid cells aim assist targets are bucketed into. Roughly the depth of the aim assist reticle works best."),
+		ECVF_Default);
+}
+
+//////////////////////////////////////////////////////////////////////
+// FAimAssistTargetShape
+
+FAimAssistTargetShape::FAimAssistTargetShape(const FVector& InCenter, const FVector& InAxis, float InRadius, float InHalfHeight)
+	: Center(InCenter)
+	, SegmentHalf(InAxis * FMath::Max(InHalfHeight - InRadius, 0.0f))
+	, Radius(InRadius)
+{
+}
+
+FAimAssistTargetShape FAimAssistTargetShape::FromCapsule(const UCapsuleComponent& Capsule)
+{
+	return FAimAssistTargetShape(Capsule.GetComponentLocation(), Capsule.GetUpVector(), Capsule.GetScaledCapsuleRadius(), Capsule.GetScaledCapsuleHalfHeight());
+}
+
+bool FAimAssistTargetShape::OverlapsBox(const FTransform& BoxTransform, const FVector& HalfExtents) const
+{
+	// In the space of the box the capsule is the segment Start + Dir * T for T in [0, 1], grown by the radius
+	const FVector Start = BoxTransform.InverseTransformPositionNoScale(Center - SegmentHalf);
+	const FVector Dir = BoxTransform.InverseTransformPositionNoScale(Center + SegmentHalf) - Start;
+
+	// The squared distance from the segment to the box is a sum of one quadratic per axis, each of which only changes
+	// form where the segment crosses one of the faces of its slab.  Split the segment at those crossings and minimize
+	// the exact quadratic of each piece.
+	double Splits[8];
+	int32 NumSplits = 0;
+	Splits[NumSplits++] = 0.0;
+	Splits[NumSplits++] = 1.0;
+	for (int32 Axis = 0; Axis < 3; ++Axis)
+	{
+		if (Dir[Axis] != 0.0)
+		{
+			for (const double Face : { -HalfExtents[Axis], HalfExtents[Axis] })
+			{
+				const double T = (Face - Start[Axis]) / Dir[Axis];
+				if ((T > 0.0) && (T < 1.0))
+				{
+					Splits[NumSplits++] = T;
+				}
+			}
+		}
+	}
+	Algo::Sort(MakeArrayView(Splits, NumSplits));
+
+	const double RadiusSquared = FMath::Square(double(Radius));
+	for (int32 Piece = 0; Piece + 1 < NumSplits; ++Piece)
+	{
+		const double MinT = Splits[Piece];
+		const double MaxT = Splits[Piece + 1];
+		const double MidT = (MinT + MaxT) * 0.5;
+
+		// Distance squared on this piece is A * T^2 + B * T + C
+		double A = 0.0;
+		double B = 0.0;
+		double C = 0.0;
+		for (int32 Axis = 0; Axis < 3; ++Axis)
+		{
+			const double Mid = Start[Axis] + Dir[Axis] * MidT;
+			const double Face = (Mid > HalfExtents[Axis]) ? HalfExtents[Axis] : ((Mid < -HalfExtents[Axis]) ? -HalfExtents[Axis] : Mid);
+			if (Face != Mid)
+			{
+				const double Offset = Start[Axis] - Face;
+				A += Dir[Axis] * Dir[Axis];
+				B += 2.0 * Dir[Axis] * Offset;
+				C += Offset * Offset;
+			}
+		}
+
+		const double BestT = (A > 0.0) ? FMath::Clamp(-B / (2.0 * A), MinT, MaxT) : ((B > 0.0) ? MinT : MaxT);
+		if ((A * BestT + B) * BestT + C <= RadiusSquared)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+//////////////////////////////////////////////////////////////////////
+// FAimAssistTargetGrid
+
+FAimAssistTargetGrid::FAimAssistTargetGrid(float InCellSize)
+{
+	CellSize = FMath::Max(InCellSize, 1.0f);
+	InvCellSize = 1.0f / CellSize;
+}
+
+void FAimAssistTargetGrid::SetCellSize(float InCellSize)
+{
+	InCellSize = FMath::Max(InCellSize, 1.0f);
+	if (InCellSize == CellSize)
+	{
+		return;
+	}
+
+	CellSize = InCellSize;
+	InvCellSize = 1.0f / CellSize;
+
+	Cells.Reset();
+	MaxExtent = 0.0;
+	for (int32 Index = 0; Index < Records.Num(); ++Index)
+	{
+		Records[Index].Cell = GetCell(Records[Index].Location);
+		MaxExtent = FMath::Max3(MaxExtent, Records[Index].Extent.X, Records[Index].Extent.Y);
+		AddToCell(Index);
+	}
+}
+
+int32 FAimAssistTargetGrid::Add(const FVector& Location, const FVector& Extent)
+{
+	const int32 Index = Records.AddDefaulted();
+
+	FRecord& Record = Records[Index];
+	Record.Location = Location;
+	Record.Extent = Extent;
+	Record.Cell = GetCell(Location);
+	MaxExtent = FMath::Max3(MaxExtent, Extent.X, Extent.Y);
+
+	AddToCell(Index);
+	return Index;
+}
+
+void FAimAssistTargetGrid::Update(int32 Index, const FVector& Location, const FVector& Extent)
+{
+	FRecord& Record = Records[Index];
+	Record.Location = Location;
+	Record.Extent = Extent;
+	MaxExtent = FMath::Max3(MaxExtent, Extent.X, Extent.Y);
+
+	const FIntPoint NewCell = GetCell(Location);
+	if (NewCell != Record.Cell)
+	{
+		RemoveFromCell(Index);
+		Records[Index].Cell = NewCell;
+		AddToCell(Index);
+	}
+}
+
+int32 FAimAssistTargetGrid::RemoveAtSwap(int32 Index)
+{
+	RemoveFromCell(Index);
+
+	const int32 LastIndex = Records.Num() - 1;
+	int32 MovedIndex = INDEX_NONE;
+
+	if (Index != LastIndex)
+	{
+		Records[Index] = Records[LastIndex];
+
+		// Point the moved record's cell entry at its new index
+		Cells.FindChecked(Records[Index].Cell)[Records[Index].SlotInCell] = Index;
+		MovedIndex = LastIndex;
+	}
+
+	Records.RemoveAt(LastIndex, 1, false);
+	return MovedIndex;
+}
+
+void FAimAssistTargetGrid::Reset()
+{
+	Records.Reset();
+	Cells.Reset();
+	MaxExtent = 0.0;
+}
+
+void FAimAssistTargetGrid::GatherInBox(const FBox& Box, TArray<int32>& OutIndices) const
+{
+	if (!Box.IsValid || (Records.Num() == 0))
+	{
+		return;
+	}
+
+	// Records live in the cell of their center, so grow the walked area by the largest extent
+	const FBox CellBox = Box.ExpandBy(MaxExtent);
+	const FIntPoint MinCell = GetCell(CellBox.Min);
+	const FIntPoint MaxCell = GetCell(CellBox.Max);
+	const int64 NumCellsInBox = int64(MaxCell.X - MinCell.X + 1) * int64(MaxCell.Y - MinCell.Y + 1);
+
+	if (NumCellsInBox > Cells.Num())
+	{
+		// Visiting every occupied cell is cheaper than probing the empty ones
+		for (const TPair<FIntPoint, TArray<int32>>& Pair : Cells)
+		{
+			const FIntPoint& Cell = Pair.Key;
+			if ((Cell.X >= MinCell.X) && (Cell.X <= MaxCell.X) && (Cell.Y >= MinCell.Y) && (Cell.Y <= MaxCell.Y))
+			{
+				GatherInCell(Pair.Value, Box, OutIndices);
+			}
+		}
+	}
+	else
+	{
+		for (int32 CellY = MinCell.Y; CellY <= MaxCell.Y; ++CellY)
+		{
+			for (int32 CellX = MinCell.X; CellX <= MaxCell.X; ++CellX)
+			{
+				if (const TArray<int32>* CellRecords = Cells.Find(FIntPoint(CellX, CellY)))
+				{
+					GatherInCell(*CellRecords, Box, OutIndices);
+				}
+			}
+		}
+	}
+}
+
+FIntPoint FAimAssistTargetGrid::GetCell(const FVector& Location) const
+{
+	return FIntPoint(FMath::FloorToInt32(Location.X * InvCellSize), FMath::FloorToInt32(Location.Y * InvCellSize));
+}
+
+void FAimAssistTargetGrid::AddToCell(int32 Index)
+{
+	FRecord& Record = Records[Index];
+	TArray<int32>& CellRecords = Cells.FindOrAdd(Record.Cell);
+	Record.SlotInCell = CellRecords.Add(Index);
+}
+
+void FAimAssistTargetGrid::RemoveFromCell(int32 Index)
+{
+	FRecord& Record = Records[Index];
+	TArray<int32>& CellRecords = Cells.FindChecked(Record.Cell);
+
+	const int32 Slot = Record.SlotInCell;
+	check(CellRecords.IsValidIndex(Slot) && (CellRecords[Slot] == Index));
+
+	CellRecords.RemoveAtSwap(Slot, 1, false);
+	if (Slot < CellRecords.Num())
+	{
+		Records[CellRecords[Slot]].SlotInCell = Slot;
+	}
+
+	if (CellRecords.Num() == 0)
+	{
+		Cells.Remove(Record.Cell);
+	}
+
+	Record.SlotInCell = INDEX_NONE;
+}
+
+void FAimAssistTargetGrid::GatherInCell(const TArray<int32>& CellRecords, const FBox& Box, TArray<int32>& OutIndices) const
+{
+	for (const int32 Index : CellRecords)
+	{
+		const FRecord& Record = Records[Index];
+		if (Box.Intersect(FBox(Record.Location - Record.Extent, Record.Location + Record.Extent)))
+		{
+			OutIndices.Add(Index);
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+// UAimAssistTargetRegistry
+
+void UAimAssistTargetRegistry::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	Grid.SetCellSize(LyraConsoleVariables::AimAssistTargetGridCellSize);
+}
+
+void UAimAssistTargetRegistry::Deinitialize()
+{
+	Grid.Reset();
+	Targets.Reset();
+	Shapes.Reset();
+
+	Super::Deinitialize();
+}
+
+void UAimAssistTargetRegistry::RegisterTarget(UAimAssistTargetComponent* Target)
+{
+	check(Target);
+
+	if (Targets.Contains(Target))
+	{
+		return;
+	}
+
+	const FAimAssistTargetShape Shape = FAimAssistTargetShape::FromCapsule(*Target);
+	const int32 Index = Grid.Add(Shape.GetCenter(), Shape.GetBoundsExtent());
+	const int32 TargetIndex = Targets.Add(Target);
+	const int32 ShapeIndex = Shapes.Add(Shape);
+	check((Index == TargetIndex) && (Index == ShapeIndex));
+}
+
+void UAimAssistTargetRegistry::UnregisterTarget(UAimAssistTargetComponent* Target)
+{
+	const int32 Index = Targets.IndexOfByKey(Target);
+	if (Index != INDEX_NONE)
+	{
+		RemoveTargetAt(Index);
+	}
+}
+
+void UAimAssistTargetRegistry::GatherTargetsInBox(const FVector& Center, const FQuat& Rotation, const FVector& HalfExtents, TArray<UAimAssistTargetComponent*>& OutTargets)
+{
+	UpdateTargetLocations();
+
+	const FTransform BoxTransform(Rotation, Center);
+	const FBox WorldBounds = FBox(-HalfExtents, HalfExtents).TransformBy(BoxTransform);
+
+	CandidateIndices.Reset();
+	Grid.GatherInBox(WorldBounds, CandidateIndices);
+
+	for (const int32 Index : CandidateIndices)
+	{
+		// The grid only knows the axis aligned bounds, test the capsule itself against the oriented box
+		if (Shapes[Index].OverlapsBox(BoxTransform, HalfExtents))
+		{
+			if (UAimAssistTargetComponent* Target = Targets[Index].Get())
+			{
+				OutTargets.Add(Target);
+			}
+		}
+	}
+}
+
+void UAimAssistTargetRegistry::UpdateTargetLocations()
+{
+	if (LastUpdateFrame == GFrameCounter)
+	{
+		return;
+	}
+	LastUpdateFrame = GFrameCounter;
+
+	Grid.SetCellSize(LyraConsoleVariables::AimAssistTargetGridCellSize);
+
+	// Walk backwards so removing a stale target only moves records that were already updated
+	for (int32 Index = Targets.Num() - 1; Index >= 0; --Index)
+	{
+		if (const UAimAssistTargetComponent* Target = Targets[Index].Get())
+		{
+			Shapes[Index] = FAimAssistTargetShape::FromCapsule(*Target);
+			Grid.Update(Index, Shapes[Index].GetCenter(), Shapes[Index].GetBoundsExtent());
+		}
+		else
+		{
+			RemoveTargetAt(Index);
+		}
+	}
+}
+
+void UAimAssistTargetRegistry::RemoveTargetAt(int32 Index)
+{
+	// All the arrays move their last element into the removed slot, so they stay in the same order
+	Grid.RemoveAtSwap(Index);
+	Targets.RemoveAtSwap(Index, 1, false);
+	Shapes.RemoveAtSwap(Index, 1, false);
+}
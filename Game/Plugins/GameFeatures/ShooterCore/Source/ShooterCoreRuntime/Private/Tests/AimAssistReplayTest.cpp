@@ -0,0 +1,453 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Components/SceneComponent.h"
+#include "Curves/CurveFloat.h"
+#include "Engine/Engine.h"
+#include "Engine/LocalPlayer.h"
+#include "Engine/World.h"
+#include "GameFramework/GameStateBase.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/WorldSettings.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Input/AimAssistInputModifier.h"
+#include "Input/AimAssistTargetComponent.h"
+#include "Input/AimAssistTargetManagerComponent.h"
+#include "Interfaces/IPluginManager.h"
+#include "Math/InverseRotationMatrix.h"
+#include "Math/PerspectiveMatrix.h"
+#include "Math/TranslationMatrix.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "ShooterCoreRuntimeSettings.h"
+#include "UObject/Package.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace AimAssistReplayTest
+{
+	// Matches the look rates ULyraHeroComponent applies to the (assisted) stick input
+	static const float LookYawRate = 300.0f;
+	static const float LookPitchRate = 165.0f;
+
+	static const float MoveSpeed = 400.0f;
+	static const float EyeHeight = 160.0f;
+	static const FIntPoint ViewSize(1920, 1080);
+	static const float FieldOfView = 90.0f;
+
+	// Rotations are accumulated over the whole trace, so allow a little float drift between platforms
+	static const float GoldenTolerance = 0.01f;
+
+	static const int32 TargetCounts[] = { 1, 8, 32 };
+
+	struct FStickSample
+	{
+		float DeltaTime = 0.0f;
+		FVector Look = FVector::ZeroVector;
+		FVector Move = FVector::ZeroVector;
+	};
+
+	static FString GetTestDataDir()
+	{
+		TSharedPtr<IPlugin> Plugin = IPluginManager::Get().FindPlugin(TEXT("ShooterCore"));
+		return Plugin.IsValid() ? (Plugin->GetBaseDir() / TEXT("Tests/AimAssist")) : FString();
+	}
+
+	static FString GetGoldenFile(int32 NumTargets)
+	{
+		return GetTestDataDir() / FString::Printf(TEXT("GoldenRotations_%d.csv"), NumTargets);
+	}
+
+	// Lines are DeltaTime,LookX,LookY,MoveX,MoveY, lines starting with # are comments
+	static bool LoadStickTrace(const FString& FileName, TArray<FStickSample>& OutTrace)
+	{
+		TArray<FString> Lines;
+		if (!FFileHelper::LoadFileToStringArray(Lines, *FileName))
+		{
+			return false;
+		}
+
+		for (const FString& Line : Lines)
+		{
+			if (Line.IsEmpty() || Line.StartsWith(TEXT("#")))
+			{
+				continue;
+			}
+
+			TArray<FString> Values;
+			Line.ParseIntoArray(Values, TEXT(","));
+			if (Values.Num() != 5)
+			{
+				return false;
+			}
+
+			FStickSample& Sample = OutTrace.AddDefaulted_GetRef();
+			Sample.DeltaTime = FCString::Atof(*Values[0]);
+			Sample.Look = FVector(FCString::Atof(*Values[1]), FCString::Atof(*Values[2]), 0.0);
+			Sample.Move = FVector(FCString::Atof(*Values[3]), FCString::Atof(*Values[4]), 0.0);
+		}
+
+		return (OutTrace.Num() > 0);
+	}
+
+	static bool LoadGoldenRotations(const FString& FileName, TArray<FRotator>& OutRotations)
+	{
+		TArray<FString> Lines;
+		if (!FFileHelper::LoadFileToStringArray(Lines, *FileName))
+		{
+			return false;
+		}
+
+		for (const FString& Line : Lines)
+		{
+			FString Yaw;
+			FString Pitch;
+			if (Line.Split(TEXT(","), &Yaw, &Pitch))
+			{
+				OutRotations.Add(FRotator(FCString::Atof(*Pitch), FCString::Atof(*Yaw), 0.0));
+			}
+		}
+
+		return (OutRotations.Num() > 0);
+	}
+
+	static bool SaveGoldenRotations(const FString& FileName, const TArray<FRotator>& Rotations)
+	{
+		FString Contents;
+		for (const FRotator& Rotation : Rotations)
+		{
+			Contents += FString::Printf(TEXT("%.5f,%.5f%s"), Rotation.Yaw, Rotation.Pitch, LINE_TERMINATOR);
+		}
+
+		return FFileHelper::SaveStringToFile(Contents, *FileName);
+	}
+
+	/** How the targets are found and traced */
+	enum class EReplayPath : uint8
+	{
+		// What the game runs: the target registry and visibility traces spread over frames
+		Current,
+
+		// What the goldens are recorded from: an overlap query for the targets and a synchronous visibility trace of
+		// every target every frame, the way aim assist worked before the registry and the trace budget
+		Reference,
+	};
+
+	/**
+	 * A game world with one player and NumTargets aim assist targets strafing in front of it.
+	 * Replaying a stick trace feeds each sample through the aim assist modifier and turns the player by the
+	 * assisted input, like ULyraHeroComponent would.
+	 */
+	class FAimAssistReplay
+	{
+	public:
+		FAimAssistReplay(int32 NumTargets, EReplayPath InPath)
+			: Path(InPath)
+		{
+			World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("AimAssistReplay"));
+
+			FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+			WorldContext.SetCurrentWorld(World);
+
+			World->InitializeActorsForPlay(FURL());
+			World->BeginPlay();
+
+			// There is no game mode to start the match, so start it here
+			World->GetWorldSettings()->NotifyBeginPlay();
+
+			AGameStateBase* GameState = World->SpawnActor<AGameStateBase>();
+			World->SetGameState(GameState);
+
+			UAimAssistTargetManagerComponent* TargetManager = NewObject<UAimAssistTargetManagerComponent>(GameState);
+			TargetManager->RegisterComponent();
+
+			Pawn = World->SpawnActor<APawn>();
+			USceneComponent* PawnRoot = NewObject<USceneComponent>(Pawn);
+			Pawn->SetRootComponent(PawnRoot);
+			PawnRoot->RegisterComponent();
+
+			PlayerController = World->SpawnActor<APlayerController>();
+			PlayerController->SetPawn(Pawn);
+
+			// Only needed for the view data to be valid, the aim assist never reads it
+			LocalPlayer = NewObject<ULocalPlayer>(GetTransientPackage());
+
+			UCurveFloat* TargetWeightCurve = NewObject<UCurveFloat>(GetTransientPackage());
+			TargetWeightCurve->FloatCurve.AddKey(0.0f, 0.0f);
+			TargetWeightCurve->FloatCurve.AddKey(0.25f, 1.0f);
+
+			Modifier = NewObject<UAimAssistInputModifier>(GetTransientPackage());
+			Modifier->Settings.TargetWeightCurve = TargetWeightCurve;
+
+			if (Path == EReplayPath::Reference)
+			{
+				Modifier->Settings.MaxVisibilityTracesPerFrame = 0;
+				Modifier->Settings.bEnableAsyncVisibilityTrace = false;
+			}
+
+			const ECollisionChannel AimAssistChannel = GetDefault<UShooterCoreRuntimeSettings>()->GetAimAssistCollisionChannel();
+
+			for (int32 TargetIndex = 0; TargetIndex < NumTargets; ++TargetIndex)
+			{
+				AActor* TargetActor = World->SpawnActor<AActor>();
+
+				UAimAssistTargetComponent* TargetComponent = NewObject<UAimAssistTargetComponent>(TargetActor);
+				TargetComponent->InitCapsuleSize(34.0f, 88.0f);
+				TargetComponent->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
+				TargetComponent->SetCollisionResponseToAllChannels(ECR_Ignore);
+				TargetComponent->SetCollisionResponseToChannel(AimAssistChannel, ECR_Overlap);
+				TargetActor->SetRootComponent(TargetComponent);
+				TargetComponent->RegisterComponent();
+
+				Targets.Add(TargetActor);
+			}
+
+			MoveTargets(0.0);
+		}
+
+		~FAimAssistReplay()
+		{
+			GEngine->DestroyWorldContext(World);
+			World->DestroyWorld(false);
+		}
+
+		/** Replays the trace, returning the player's rotation after every sample and the time spent in aim assist per sample */
+		void Run(const TArray<FStickSample>& Trace, TArray<FRotator>& OutRotations, TArray<double>& OutAimAssistSeconds)
+		{
+			IConsoleVariable* UseTargetRegistry = IConsoleManager::Get().FindConsoleVariable(TEXT("lyra.Weapon.AimAssist.UseTargetRegistry"));
+			check(UseTargetRegistry);
+			const bool bUsedTargetRegistry = UseTargetRegistry->GetBool();
+			UseTargetRegistry->Set(Path == EReplayPath::Current, ECVF_SetByCode);
+
+			FRotator ControlRotation = FRotator::ZeroRotator;
+			FVector LastPawnLocation = Pawn->GetActorLocation();
+			double Time = 0.0;
+
+			for (const FStickSample& Sample : Trace)
+			{
+				// Stand in for the engine loop, per frame caches (such as the target registry) key off it
+				++GFrameCounter;
+
+				Time += Sample.DeltaTime;
+				MoveTargets(Time);
+
+				const FVector PawnLocation = Pawn->GetActorLocation();
+				const FAimAssistOwnerViewData ViewData = MakeViewData(PawnLocation, PawnLocation - LastPawnLocation, ControlRotation);
+				LastPawnLocation = PawnLocation;
+
+				const uint64 StartCycles = FPlatformTime::Cycles64();
+				const FVector AssistedLook = Modifier->ReplayLookInput(PlayerController, ViewData, Sample.Look, Sample.Move, Sample.DeltaTime);
+				OutAimAssistSeconds.Add(FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles));
+
+				ControlRotation.Yaw = FRotator::NormalizeAxis(ControlRotation.Yaw + (AssistedLook.X * LookYawRate * Sample.DeltaTime));
+				ControlRotation.Pitch = FMath::Clamp(ControlRotation.Pitch + (AssistedLook.Y * LookPitchRate * Sample.DeltaTime), -89.0, 89.0);
+				PlayerController->SetControlRotation(ControlRotation);
+				OutRotations.Add(ControlRotation);
+
+				const FRotator MoveRotation(0.0, ControlRotation.Yaw, 0.0);
+				const FVector MoveDelta = (MoveRotation.RotateVector(FVector(Sample.Move.Y, Sample.Move.X, 0.0)) * MoveSpeed * Sample.DeltaTime);
+				Pawn->SetActorLocation(PawnLocation + MoveDelta);
+
+				// Finishes this frame's async visibility traces so the next frame can read them
+				World->Tick(LEVELTICK_All, Sample.DeltaTime);
+			}
+
+			UseTargetRegistry->Set(bUsedTargetRegistry, ECVF_SetByCode);
+		}
+
+	private:
+		// Targets are spread over a 40 degree arc in front of the player, each strafing at its own rate
+		void MoveTargets(double Time)
+		{
+			const int32 NumTargets = Targets.Num();
+			for (int32 TargetIndex = 0; TargetIndex < NumTargets; ++TargetIndex)
+			{
+				const double Alpha = (NumTargets > 1) ? (double(TargetIndex) / double(NumTargets - 1)) : 0.5;
+				const double Yaw = FMath::DegreesToRadians(FMath::Lerp(-20.0, 20.0, Alpha));
+				const double Distance = 800.0 + (TargetIndex % 5) * 350.0;
+				const double Strafe = 150.0 * FMath::Sin((Time * (0.6 + 0.15 * (TargetIndex % 4))) + TargetIndex);
+
+				const FVector Forward(FMath::Cos(Yaw), FMath::Sin(Yaw), 0.0);
+				const FVector Right(-Forward.Y, Forward.X, 0.0);
+				Targets[TargetIndex]->SetActorLocation((Forward * Distance) + (Right * Strafe) + FVector(0.0, 0.0, 90.0));
+			}
+		}
+
+		FAimAssistOwnerViewData MakeViewData(const FVector& PawnLocation, const FVector& DeltaMovement, const FRotator& ControlRotation) const
+		{
+			FAimAssistOwnerViewData ViewData;
+			ViewData.PlayerController = PlayerController;
+			ViewData.LocalPlayer = LocalPlayer;
+
+			const FVector ViewLocation = PawnLocation + FVector(0.0, 0.0, EyeHeight);
+
+			// Same projection as a 90 degree player camera filling the view
+			ViewData.ViewRect = FIntRect(0, 0, ViewSize.X, ViewSize.Y);
+			ViewData.ProjectionMatrix = FReversedZPerspectiveMatrix(FMath::DegreesToRadians(FieldOfView * 0.5f), ViewSize.X, ViewSize.Y, GNearClippingPlane);
+
+			const FMatrix ViewRotationMatrix = FInverseRotationMatrix(ControlRotation) * FMatrix(
+				FPlane(0, 0, 1, 0),
+				FPlane(1, 0, 0, 0),
+				FPlane(0, 1, 0, 0),
+				FPlane(0, 0, 0, 1));
+			ViewData.ViewProjectionMatrix = FTranslationMatrix(-ViewLocation) * ViewRotationMatrix * ViewData.ProjectionMatrix;
+
+			ViewData.ViewTransform = FTransform(ControlRotation, ViewLocation);
+			ViewData.ViewForward = ViewData.ViewTransform.GetUnitAxis(EAxis::X);
+
+			ViewData.PlayerTransform = FTransform(ControlRotation, PawnLocation);
+			ViewData.PlayerInverseTransform = ViewData.PlayerTransform.Inverse();
+			ViewData.DeltaMovement = DeltaMovement;
+			ViewData.TeamID = INDEX_NONE;
+
+			return ViewData;
+		}
+
+		EReplayPath Path = EReplayPath::Current;
+		UWorld* World = nullptr;
+		APawn* Pawn = nullptr;
+		APlayerController* PlayerController = nullptr;
+		ULocalPlayer* LocalPlayer = nullptr;
+		UAimAssistInputModifier* Modifier = nullptr;
+		TArray<AActor*> Targets;
+	};
+
+	// Reports the first frame that drifts, the rest usually follow it
+	static void TestRotationsMatch(FAutomationTestBase& Test, const FString& What, const TArray<FRotator>& Rotations, const TArray<FRotator>& ExpectedRotations)
+	{
+		if (!Test.TestEqual(What + TEXT(": frame count"), Rotations.Num(), ExpectedRotations.Num()))
+		{
+			return;
+		}
+
+		for (int32 Frame = 0; Frame < Rotations.Num(); ++Frame)
+		{
+			if (!Rotations[Frame].Equals(ExpectedRotations[Frame], GoldenTolerance))
+			{
+				Test.AddError(FString::Printf(TEXT("%s: frame %d rotation %s does not match %s"),
+					*What, Frame, *Rotations[Frame].ToCompactString(), *ExpectedRotations[Frame].ToCompactString()));
+				return;
+			}
+		}
+	}
+
+	static bool LoadDefaultTrace(FAutomationTestBase& Test, TArray<FStickSample>& OutTrace)
+	{
+		const FString TraceFile = GetTestDataDir() / TEXT("StickInput.csv");
+		if (!LoadStickTrace(TraceFile, OutTrace))
+		{
+			Test.AddError(FString::Printf(TEXT("Could not load the stick trace %s"), *TraceFile));
+			return false;
+		}
+		return true;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAimAssistReplayTest, "Lyra.AimAssist.Replay", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+bool FAimAssistReplayTest::RunTest(const FString& Parameters)
+{
+	using namespace AimAssistReplayTest;
+
+	TArray<FStickSample> Trace;
+	if (!LoadDefaultTrace(*this, Trace))
+	{
+		return false;
+	}
+
+	// Pass -AimAssistRecordGolden to record the golden files from the reference path after an intended change to how
+	// aim assist feels.  The current path is never recorded, it has to reproduce what the reference path does.
+	const bool bRecordGolden = FParse::Param(FCommandLine::Get(), TEXT("AimAssistRecordGolden"));
+
+	for (const int32 NumTargets : TargetCounts)
+	{
+		const FString GoldenFile = GetGoldenFile(NumTargets);
+
+		TArray<FRotator> ReferenceRotations;
+		TArray<double> AimAssistSeconds;
+		{
+			FAimAssistReplay Replay(NumTargets, EReplayPath::Reference);
+			Replay.Run(Trace, ReferenceRotations, AimAssistSeconds);
+		}
+
+		if (bRecordGolden)
+		{
+			if (SaveGoldenRotations(GoldenFile, ReferenceRotations))
+			{
+				AddWarning(FString::Printf(TEXT("Recorded %s from the reference path, check it in if aim assist is behaving as intended"), *GoldenFile));
+			}
+			else
+			{
+				AddError(FString::Printf(TEXT("Could not write %s"), *GoldenFile));
+			}
+		}
+
+		// Nothing in the replay world blocks visibility, so the trace budget only changes when a target is traced, not what
+		// the trace finds, and the current path has to match the reference frame for frame.  This is checked against a
+		// reference run of this build, the golden only pins down the reference path itself.
+		TArray<FRotator> Rotations;
+		{
+			FAimAssistReplay Replay(NumTargets, EReplayPath::Current);
+			Replay.Run(Trace, Rotations, AimAssistSeconds);
+		}
+
+		TestRotationsMatch(*this, FString::Printf(TEXT("%d targets, current path against the reference path"), NumTargets), Rotations, ReferenceRotations);
+
+		TArray<FRotator> GoldenRotations;
+		if (!LoadGoldenRotations(GoldenFile, GoldenRotations))
+		{
+			AddError(FString::Printf(TEXT("Missing golden %s, record it with -AimAssistRecordGolden and check it in"), *GoldenFile));
+			continue;
+		}
+
+		TestRotationsMatch(*this, FString::Printf(TEXT("%d targets, reference path against the golden"), NumTargets), ReferenceRotations, GoldenRotations);
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAimAssistReplayBenchmark, "Lyra.AimAssist.Replay.Benchmark", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::PerfFilter)
+
+bool FAimAssistReplayBenchmark::RunTest(const FString& Parameters)
+{
+	using namespace AimAssistReplayTest;
+
+	TArray<FStickSample> Trace;
+	if (!LoadDefaultTrace(*this, Trace))
+	{
+		return false;
+	}
+
+	for (const int32 NumTargets : TargetCounts)
+	{
+		TArray<FRotator> Rotations;
+		TArray<double> AimAssistSeconds;
+		{
+			FAimAssistReplay Replay(NumTargets, EReplayPath::Current);
+			Replay.Run(Trace, Rotations, AimAssistSeconds);
+		}
+
+		AimAssistSeconds.Sort();
+
+		double TotalSeconds = 0.0;
+		for (const double Seconds : AimAssistSeconds)
+		{
+			TotalSeconds += Seconds;
+		}
+
+		const int32 NumFrames = AimAssistSeconds.Num();
+		const double AverageMicroseconds = (TotalSeconds / NumFrames) * 1.0e6;
+		const double P95Microseconds = AimAssistSeconds[FMath::Min(FMath::FloorToInt32(NumFrames * 0.95), NumFrames - 1)] * 1.0e6;
+		const double MaxMicroseconds = AimAssistSeconds.Last() * 1.0e6;
+
+		AddInfo(FString::Printf(TEXT("%2d targets: %.2f us/frame average, %.2f us p95, %.2f us max over %d frames"),
+			NumTargets, AverageMicroseconds, P95Microseconds, MaxMicroseconds, NumFrames));
+	}
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
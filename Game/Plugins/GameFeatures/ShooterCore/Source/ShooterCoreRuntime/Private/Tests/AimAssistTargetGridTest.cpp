@@ -0,0 +1,119 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Input/AimAssistTargetRegistry.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace AimAssistTargetGridTest
+{
+	static TArray<int32> Gather(const FAimAssistTargetGrid& Grid, const FBox& Box)
+	{
+		TArray<int32> Indices;
+		Grid.GatherInBox(Box, Indices);
+		Indices.Sort();
+		return Indices;
+	}
+
+	static bool GathersExactly(const FAimAssistTargetGrid& Grid, const FBox& Box, const TArray<int32>& Expected)
+	{
+		return (Gather(Grid, Box) == Expected);
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAimAssistTargetGridTest, "Lyra.AimAssist.TargetGrid", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ServerContext | EAutomationTestFlags::EngineFilter)
+
+bool FAimAssistTargetGridTest::RunTest(const FString& Parameters)
+{
+	using namespace AimAssistTargetGridTest;
+
+	FAimAssistTargetGrid Grid(1000.0f);
+
+	const int32 A = Grid.Add(FVector(100.0, 100.0, 0.0), FVector(50.0));
+	const int32 B = Grid.Add(FVector(2500.0, 100.0, 0.0), FVector(50.0));
+	const int32 C = Grid.Add(FVector(-1500.0, -1500.0, 0.0), FVector(50.0));
+
+	const FBox NearOrigin(FVector(-500.0, -500.0, -100.0), FVector(500.0, 500.0, 100.0));
+	TestTrue(TEXT("Only the target inside the box"), GathersExactly(Grid, NearOrigin, TArray<int32>({ A })));
+
+	// A record just outside the box still overlaps it with its extent, even from a neighbouring cell
+	Grid.Update(B, FVector(1030.0, 100.0, 0.0), FVector(50.0));
+	const FBox ToTheEdge(FVector(-500.0, -500.0, -100.0), FVector(1000.0, 500.0, 100.0));
+	TestTrue(TEXT("Extent reaches into the box"), GathersExactly(Grid, ToTheEdge, TArray<int32>({ A, B })));
+
+	// Moving across cells
+	Grid.Update(C, FVector(0.0, 300.0, 0.0), FVector(50.0));
+	TestTrue(TEXT("Moved into the box"), GathersExactly(Grid, NearOrigin, TArray<int32>({ A, C })));
+
+	// Height is not bucketed but is still tested
+	Grid.Update(A, FVector(100.0, 100.0, 5000.0), FVector(50.0));
+	TestTrue(TEXT("Too high"), GathersExactly(Grid, NearOrigin, TArray<int32>({ C })));
+
+	// Tall and thin, only the height reaches into the box
+	Grid.Update(A, FVector(100.0, 100.0, 190.0), FVector(50.0, 50.0, 100.0));
+	TestTrue(TEXT("Height extent reaches into the box"), GathersExactly(Grid, NearOrigin, TArray<int32>({ A, C })));
+	Grid.Update(A, FVector(560.0, 100.0, 0.0), FVector(50.0, 50.0, 100.0));
+	TestTrue(TEXT("Height extent does not reach sideways"), GathersExactly(Grid, NearOrigin, TArray<int32>({ C })));
+
+	// Removing A moves C (the last record) into its slot
+	TestEqual(TEXT("Last record moved"), Grid.RemoveAtSwap(A), C);
+	TestEqual(TEXT("Num after remove"), Grid.Num(), 2);
+	TestTrue(TEXT("Moved record found at its new index"), GathersExactly(Grid, NearOrigin, TArray<int32>({ A })));
+	TestEqual(TEXT("Moved record location"), Grid.GetLocation(A), FVector(0.0, 300.0, 0.0));
+
+	// Changing the cell size keeps every record findable
+	Grid.SetCellSize(250.0f);
+	TestTrue(TEXT("After rebucketing"), GathersExactly(Grid, ToTheEdge, TArray<int32>({ 0, 1 })));
+
+	// A huge box visits the occupied cells rather than every cell it covers
+	const FBox Everything(FVector(-1.0e6, -1.0e6, -1.0e6), FVector(1.0e6, 1.0e6, 1.0e6));
+	TestTrue(TEXT("Huge box"), GathersExactly(Grid, Everything, TArray<int32>({ 0, 1 })));
+
+	TestEqual(TEXT("Removing the last record moves nothing"), Grid.RemoveAtSwap(1), int32(INDEX_NONE));
+	Grid.Reset();
+	TestEqual(TEXT("Empty after reset"), Gather(Grid, Everything).Num(), 0);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAimAssistTargetShapeTest, "Lyra.AimAssist.TargetShape", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ServerContext | EAutomationTestFlags::EngineFilter)
+
+bool FAimAssistTargetShapeTest::RunTest(const FString& Parameters)
+{
+	// A standing character's capsule, its bounding sphere reaches 88 uu sideways but the capsule only 34 uu
+	static const float Radius = 34.0f;
+	static const float HalfHeight = 88.0f;
+	auto Standing = [](const FVector& Center) { return FAimAssistTargetShape(Center, FVector::UpVector, Radius, HalfHeight); };
+
+	const FVector HalfExtents(100.0);
+	const FTransform Box(FQuat::Identity, FVector::ZeroVector);
+
+	TestEqual(TEXT("Bounds"), Standing(FVector::ZeroVector).GetBoundsExtent(), FVector(Radius, Radius, HalfHeight));
+
+	TestTrue(TEXT("Inside"), Standing(FVector::ZeroVector).OverlapsBox(Box, HalfExtents));
+	TestTrue(TEXT("Radius reaches the side"), Standing(FVector(133.0, 0.0, 0.0)).OverlapsBox(Box, HalfExtents));
+	TestFalse(TEXT("Radius short of the side"), Standing(FVector(135.0, 0.0, 0.0)).OverlapsBox(Box, HalfExtents));
+	TestFalse(TEXT("Inside the bounding sphere but not the capsule"), Standing(FVector(150.0, 0.0, 0.0)).OverlapsBox(Box, HalfExtents));
+	TestTrue(TEXT("Half height reaches the top"), Standing(FVector(0.0, 0.0, 187.0)).OverlapsBox(Box, HalfExtents));
+	TestFalse(TEXT("Half height short of the top"), Standing(FVector(0.0, 0.0, 190.0)).OverlapsBox(Box, HalfExtents));
+
+	// Past a vertical edge the capsule is round, its axis aligned bounds would still overlap
+	TestTrue(TEXT("Round side reaches the edge"), Standing(FVector(120.0, 120.0, 0.0)).OverlapsBox(Box, HalfExtents));
+	TestFalse(TEXT("Round side short of the edge"), Standing(FVector(130.0, 130.0, 0.0)).OverlapsBox(Box, HalfExtents));
+
+	// Turned box, its edge sticks out to 141.4 uu along X
+	const FTransform TurnedBox(FRotator(0.0, 45.0, 0.0).Quaternion(), FVector::ZeroVector);
+	TestTrue(TEXT("Reaches the turned edge"), Standing(FVector(174.0, 0.0, 0.0)).OverlapsBox(TurnedBox, HalfExtents));
+	TestFalse(TEXT("Short of the turned edge"), Standing(FVector(178.0, 0.0, 0.0)).OverlapsBox(TurnedBox, HalfExtents));
+
+	// Lying down along X, the half height is sideways now
+	const FAimAssistTargetShape LyingReaches(FVector(187.0, 0.0, 0.0), FVector::ForwardVector, Radius, HalfHeight);
+	const FAimAssistTargetShape LyingShort(FVector(190.0, 0.0, 0.0), FVector::ForwardVector, Radius, HalfHeight);
+	TestTrue(TEXT("Lying capsule reaches the side"), LyingReaches.OverlapsBox(Box, HalfExtents));
+	TestFalse(TEXT("Lying capsule short of the side"), LyingShort.OverlapsBox(Box, HalfExtents));
+	TestEqual(TEXT("Lying bounds"), LyingReaches.GetBoundsExtent(), FVector(HalfHeight, Radius, Radius));
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -98,6 +98,9 @@ struct FLyraAimAssistTarget
 	float AssistWeight = 0.0f;
 
 	FTraceHandle VisibilityTraceHandle;
+
+	// World time the current visibility was traced (or the pending async trace was started), negative if never traced
+	double LastVisibilityTraceTime = -1.0;
 	
 	uint8 bIsVisible : 1;
 	
@@ -272,6 +275,17 @@ struct FAimAssistSettings
 	UPROPERTY(EditAnywhere)
 	int32 MaxNumberOfTargets = 6;
 
+	/**
+	 * The number of visibility traces started per frame.  Targets take turns, the one traced the longest ago goes first,
+	 * and the others keep using their last result.  Set to '0' to trace every target every frame.
+	 */
+	UPROPERTY(EditAnywhere, meta=(ClampMin=0))
+	int32 MaxVisibilityTracesPerFrame = 2;
+
+	/** The oldest (in seconds) a target's visibility can get before it is traced regardless of MaxVisibilityTracesPerFrame. */
+	UPROPERTY(EditAnywhere, meta=(ClampMin=0.0))
+	float MaxVisibilityAge = 0.1f;
+
 	/**  */
 	UPROPERTY(EditAnywhere)
 	float ReticleDepth = 3000.0f;
@@ -347,11 +361,20 @@ public:
 	/** Asset that gives us access to the float scalar value being used for sensitivty */
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, meta=(AssetBundles="Client,Server"))
 	TObjectPtr<const ULyraAimSensitivityData> SensitivityLevelTable = nullptr;
+
+	/**
+	 * Runs aim assist on the given input from the given view rather than the player's viewport, returning the assisted look input.
+	 * Used to replay recorded input against scripted targets.
+	 */
+	FVector ReplayLookInput(APlayerController* PC, const FAimAssistOwnerViewData& ViewData, const FVector& LookInput, const FVector& MoveInput, float DeltaTime);
 	
 protected:
 	
 	virtual FInputActionValue ModifyRaw_Implementation(const UEnhancedPlayerInput* PlayerInput, FInputActionValue CurrentValue, float DeltaTime) override;
 
+	/** Updates the targets and returns the assisted look input, OwnerViewData must already be up to date */
+	FVector ApplyAimAssist(APlayerController* PC, const FVector& BaselineInput, const FVector& CurrentMoveInput, float DeltaTime);
+
 	/**
 	* Swaps the target cache's and determines what targets are currently visible.
 	* Updates the score of each target to determine
@@ -12,6 +12,7 @@ class UObject;
 
 /**
  * This component can be added to any actor to have it register with the Aim Assist Target Manager.
+ * It is kept in the world's UAimAssistTargetRegistry while it is playing.
  */
 UCLASS(BlueprintType, meta=(BlueprintSpawnableComponent))
 class SHOOTERCORERUNTIME_API UAimAssistTargetComponent : public UCapsuleComponent, public IAimAssistTaget
@@ -19,6 +20,11 @@ class SHOOTERCORERUNTIME_API UAimAssistTargetComponent : public UCapsuleComponen
 	GENERATED_BODY()
 
 public:
+
+	//~UActorComponent interface
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	//~End of UActorComponent interface
 	
 	//~ Begin IAimAssistTaget interface
 	virtual void GatherTargetOptions(OUT FAimAssistTargetOptions& TargetData) override;
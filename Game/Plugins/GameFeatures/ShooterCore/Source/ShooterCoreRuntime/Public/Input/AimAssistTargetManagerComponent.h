@@ -24,6 +24,7 @@ struct FLyraAimAssistTarget;
  * The Aim Assist Target Manager Component is used to gather all aim assist targets that are within
  * a given player's view. Targets must implement the IAimAssistTargetInterface and be on the
  * collision channel that is set in the ShooterCoreRuntimeSettings. 
+ * UAimAssistTargetComponents are found through the world's UAimAssistTargetRegistry rather than a physics query.
  */
 UCLASS(Blueprintable)
 class SHOOTERCORERUNTIME_API UAimAssistTargetManagerComponent : public UGameStateComponent
@@ -49,8 +50,17 @@ protected:
 	 */
 	bool DoesTargetPassFilter(const FAimAssistOwnerViewData& OwnerData, const FAimAssistFilter& Filter, const FAimAssistTargetOptions& Target, const float AcceptableRange) const;
 
-	/** Determine if the given target is visible based on our current view data. */
-	void DetermineTargetVisibility(FLyraAimAssistTarget& Target, const FAimAssistSettings& Settings, const FAimAssistFilter& Filter, const FAimAssistOwnerViewData& OwnerData);
+	/**
+	 * Collects last frame's asynchronous visibility results, then traces the targets whose visibility is the oldest,
+	 * up to the settings' per frame budget.  Targets that are not traced keep their last visibility.
+	 */
+	void UpdateTargetVisibility(TArray<FLyraAimAssistTarget>& Targets, const FAimAssistSettings& Settings, const FAimAssistFilter& Filter, const FAimAssistOwnerViewData& OwnerData);
+
+	/**
+	 * Determine if the given target is visible based on our current view data.
+	 * When bAllowAsync is true (and the settings enable it) the trace is asynchronous and its result is picked up next frame.
+	 */
+	void DetermineTargetVisibility(FLyraAimAssistTarget& Target, const FAimAssistSettings& Settings, const FAimAssistFilter& Filter, const FAimAssistOwnerViewData& OwnerData, bool bAllowAsync);
 	
 	/** Setup CollisionQueryParams to ignore a set of actors based on filter settings. Such as Ignoring Requester or Instigator. */
 	void InitTargetSelectionCollisionParams(FCollisionQueryParams& OutParams, const AActor& RequestedBy, const FAimAssistFilter& Filter) const;
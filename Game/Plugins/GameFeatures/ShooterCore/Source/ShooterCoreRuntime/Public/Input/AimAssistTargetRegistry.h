@@ -0,0 +1,148 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "Containers/Array.h"
+#include "Containers/Map.h"
+#include "Math/Box.h"
+#include "Math/IntPoint.h"
+#include "Math/Quat.h"
+#include "Math/Transform.h"
+#include "Math/Vector.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/WeakObjectPtr.h"
+
+#include "AimAssistTargetRegistry.generated.h"
+
+class UAimAssistTargetComponent;
+class UCapsuleComponent;
+
+/**
+ * A capsule in world space, the shape an aim assist target is found by.
+ */
+struct SHOOTERCORERUNTIME_API FAimAssistTargetShape
+{
+public:
+	FAimAssistTargetShape() = default;
+	FAimAssistTargetShape(const FVector& InCenter, const FVector& InAxis, float InRadius, float InHalfHeight);
+
+	static FAimAssistTargetShape FromCapsule(const UCapsuleComponent& Capsule);
+
+	const FVector& GetCenter() const { return Center; }
+
+	/** Half size of the axis aligned box around the capsule */
+	FVector GetBoundsExtent() const { return SegmentHalf.GetAbs() + FVector(Radius); }
+
+	/** True if the capsule overlaps the oriented box, the test the physics overlap of the box does against the capsule */
+	bool OverlapsBox(const FTransform& BoxTransform, const FVector& HalfExtents) const;
+
+private:
+	FVector Center = FVector::ZeroVector;
+
+	// From the center to the center of one of the hemispheres
+	FVector SegmentHalf = FVector::ZeroVector;
+
+	float Radius = 0.0f;
+};
+
+/**
+ * A uniform grid over the XY plane holding a location and an axis aligned half extent per record.
+ * Records are packed in one array and moved between cells incrementally as they move.
+ * Removing a record moves the last record into its slot, so indices are only stable between removals.
+ */
+struct SHOOTERCORERUNTIME_API FAimAssistTargetGrid
+{
+public:
+	explicit FAimAssistTargetGrid(float InCellSize = 2000.0f);
+
+	/** Changes the cell size, re-bucketing every record if it is different */
+	void SetCellSize(float InCellSize);
+
+	float GetCellSize() const { return CellSize; }
+
+	int32 Num() const { return Records.Num(); }
+
+	/** Adds a record and returns its index */
+	int32 Add(const FVector& Location, const FVector& Extent);
+
+	/** Moves a record, only touches the cells if it crossed into a different one */
+	void Update(int32 Index, const FVector& Location, const FVector& Extent);
+
+	/** Removes the record at Index by moving the last record into its place, returns the old index of the moved record (INDEX_NONE if none moved) */
+	int32 RemoveAtSwap(int32 Index);
+
+	void Reset();
+
+	/** Adds the index of every record whose bounds overlap the box to OutIndices */
+	void GatherInBox(const FBox& Box, TArray<int32>& OutIndices) const;
+
+	const FVector& GetLocation(int32 Index) const { return Records[Index].Location; }
+	const FVector& GetExtent(int32 Index) const { return Records[Index].Extent; }
+
+private:
+	struct FRecord
+	{
+		FVector Location = FVector::ZeroVector;
+		FVector Extent = FVector::ZeroVector;
+		FIntPoint Cell = FIntPoint::ZeroValue;
+
+		// Where this record's index is in its cell's list
+		int32 SlotInCell = INDEX_NONE;
+	};
+
+	FIntPoint GetCell(const FVector& Location) const;
+	void AddToCell(int32 Index);
+	void RemoveFromCell(int32 Index);
+	void GatherInCell(const TArray<int32>& CellRecords, const FBox& Box, TArray<int32>& OutIndices) const;
+
+	TArray<FRecord> Records;
+	TMap<FIntPoint, TArray<int32>> Cells;
+
+	float CellSize = 2000.0f;
+	float InvCellSize = 1.0f / 2000.0f;
+
+	// Largest extent along X or Y added since the last rebuild, queries grow by it to find records centered just outside the box
+	double MaxExtent = 0.0;
+};
+
+/**
+ * Keeps every UAimAssistTargetComponent in the world in a FAimAssistTargetGrid, so finding the targets in front of
+ * a player is a walk over the nearby cells rather than a physics overlap query.  Target locations are refreshed at
+ * most once per frame, the first time targets are gathered.
+ */
+UCLASS()
+class SHOOTERCORERUNTIME_API UAimAssistTargetRegistry : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	//~USubsystem interface
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	//~End of USubsystem interface
+
+	void RegisterTarget(UAimAssistTargetComponent* Target);
+	void UnregisterTarget(UAimAssistTargetComponent* Target);
+
+	/** Adds every registered target whose capsule overlaps the oriented box to OutTargets */
+	void GatherTargetsInBox(const FVector& Center, const FQuat& Rotation, const FVector& HalfExtents, TArray<UAimAssistTargetComponent*>& OutTargets);
+
+	int32 GetNumTargets() const { return Targets.Num(); }
+
+private:
+	void UpdateTargetLocations();
+	void RemoveTargetAt(int32 Index);
+
+	FAimAssistTargetGrid Grid;
+
+	// In the same order as the grid records
+	TArray<TWeakObjectPtr<UAimAssistTargetComponent>> Targets;
+
+	// The capsule of each target as of the last location update, in the same order as the grid records
+	TArray<FAimAssistTargetShape> Shapes;
+
+	TArray<int32> CandidateIndices;
+
+	uint64 LastUpdateFrame = MAX_uint64;
+};
@@ -54,6 +54,10 @@ bool UGameplayMessageSubsystem::HasInstance(const UObject* WorldContextObject)
 void UGameplayMessageSubsystem::Deinitialize()
 {
 	ListenerMap.Reset();
+	ChannelsPendingRemoval.Reset();
+	DispatchSpans.Reset();
+	DispatchListeners.Reset();
+	bDispatchTableDirty = false;
 
 	Super::Deinitialize();
 }
@@ -77,44 +81,104 @@ void UGameplayMessageSubsystem::BroadcastMessageInternal(FGameplayTag Channel, c
 		UE_LOG(LogGameplayMessageSubsystem, Log, TEXT("BroadcastMessage(%s, %s, %s)"), pContextString ? **pContextString : *GetPathNameSafe(this), *Channel.ToString(), *HumanReadableMessage);
 	}
 
-	// Broadcast the message
+	// Throw away the cached dispatch spans if listeners changed since they were built (never while a broadcast is using them)
+	if ((BroadcastDepth == 0) && bDispatchTableDirty)
+	{
+		DispatchSpans.Reset();
+		DispatchListeners.Reset();
+		bDispatchTableDirty = false;
+	}
+
+	FDispatchSpan Span;
+	if (!bDispatchTableDirty)
+	{
+		if (const FDispatchSpan* pSpan = DispatchSpans.Find(Channel))
+		{
+			Span = *pSpan;
+		}
+		else
+		{
+			Span = BuildDispatchSpan(Channel);
+			DispatchSpans.Add(Channel, Span);
+		}
+	}
+	else
+	{
+		// Listeners changed during an outer broadcast so the cached spans are out of date, build a one off span
+		Span = BuildDispatchSpan(Channel);
+	}
+
+	// Broadcast the message.  Listeners unregistered by a callback are only marked until the outermost broadcast is
+	// done, and listeners registered by a callback are newer than this broadcast so are skipped.
+	const uint32 BroadcastGeneration = ListenerGeneration;
+	++BroadcastDepth;
+
+	for (int32 DispatchIndex = Span.Start; DispatchIndex < Span.Start + Span.Num; ++DispatchIndex)
+	{
+		// Copied out, a nested broadcast can grow the array
+		const FDispatchListener Dispatch = DispatchListeners[DispatchIndex];
+		const FGameplayMessageListenerData& Listener = *Dispatch.Listener;
+
+		if (Listener.bPendingRemoval || (Listener.Generation > BroadcastGeneration))
+		{
+			continue;
+		}
+
+		if (Listener.bHadValidType && !Listener.ListenerStructType.IsValid())
+		{
+			UE_LOG(LogGameplayMessageSubsystem, Warning, TEXT("Listener struct type has gone invalid on Channel %s. Removing listener from list"), *Dispatch.ListenerChannel.ToString());
+			UnregisterListenerInternal(Dispatch.ListenerChannel, Listener.HandleID);
+			continue;
+		}
+
+		// The receiving type must be either a parent of the sending type or completely ambiguous (for internal use)
+		if (!Listener.bHadValidType || StructType->IsChildOf(Listener.ListenerStructType.Get()))
+		{
+			Listener.ReceivedCallback(Channel, StructType, MessageBytes);
+		}
+		else
+		{
+			UE_LOG(LogGameplayMessageSubsystem, Error, TEXT("Struct type mismatch on channel %s (broadcast type %s, listener at %s was expecting type %s)"),
+				*Channel.ToString(),
+				*StructType->GetPathName(),
+				*Dispatch.ListenerChannel.ToString(),
+				*Listener.ListenerStructType->GetPathName());
+		}
+	}
+
+	--BroadcastDepth;
+	if ((BroadcastDepth == 0) && (ChannelsPendingRemoval.Num() > 0))
+	{
+		RemovePendingListeners();
+	}
+}
+
+UGameplayMessageSubsystem::FDispatchSpan UGameplayMessageSubsystem::BuildDispatchSpan(FGameplayTag Channel)
+{
+	FDispatchSpan Span;
+	Span.Start = DispatchListeners.Num();
+
+	// Everything registered on the channel itself, then the partial match listeners of each parent
 	bool bOnInitialTag = true;
 	for (FGameplayTag Tag = Channel; Tag.IsValid(); Tag = Tag.RequestDirectParent())
 	{
-		if (const FChannelListenerList* pList = ListenerMap.Find(Tag))
+		if (const TUniquePtr<FChannelListenerList>* pList = ListenerMap.Find(Tag))
 		{
-			// Copy in case there are removals while handling callbacks
-			TArray<FGameplayMessageListenerData> ListenerArray(pList->Listeners);
-
-			for (const FGameplayMessageListenerData& Listener : ListenerArray)
+			for (const TUniquePtr<FGameplayMessageListenerData>& Listener : (*pList)->Listeners)
 			{
-				if (bOnInitialTag || (Listener.MatchType == EGameplayMessageMatch::PartialMatch))
+				if (!Listener->bPendingRemoval && (bOnInitialTag || (Listener->MatchType == EGameplayMessageMatch::PartialMatch)))
 				{
-					if (Listener.bHadValidType && !Listener.ListenerStructType.IsValid())
-					{
-						UE_LOG(LogGameplayMessageSubsystem, Warning, TEXT("Listener struct type has gone invalid on Channel %s. Removing listener from list"), *Channel.ToString());
-						UnregisterListenerInternal(Channel, Listener.HandleID);
-						continue;
-					}
-
-					// The receiving type must be either a parent of the sending type or completely ambiguous (for internal use)
-					if (!Listener.bHadValidType || StructType->IsChildOf(Listener.ListenerStructType.Get()))
-					{
-						Listener.ReceivedCallback(Channel, StructType, MessageBytes);
-					}
-					else
-					{
-						UE_LOG(LogGameplayMessageSubsystem, Error, TEXT("Struct type mismatch on channel %s (broadcast type %s, listener at %s was expecting type %s)"),
-							*Channel.ToString(),
-							*StructType->GetPathName(),
-							*Tag.ToString(),
-							*Listener.ListenerStructType->GetPathName());
-					}
+					FDispatchListener& Dispatch = DispatchListeners.AddDefaulted_GetRef();
+					Dispatch.Listener = Listener.Get();
+					Dispatch.ListenerChannel = Tag;
 				}
 			}
 		}
 		bOnInitialTag = false;
 	}
+
+	Span.Num = DispatchListeners.Num() - Span.Start;
+	return Span;
 }
 
 void UGameplayMessageSubsystem::K2_BroadcastMessage(FGameplayTag Channel, const int32& Message)
@@ -142,14 +206,22 @@ DEFINE_FUNCTION(UGameplayMessageSubsystem::execK2_BroadcastMessage)
 
 FGameplayMessageListenerHandle UGameplayMessageSubsystem::RegisterListenerInternal(FGameplayTag Channel, TFunction<void(FGameplayTag, const UScriptStruct*, const void*)>&& Callback, const UScriptStruct* StructType, EGameplayMessageMatch MatchType)
 {
-	FChannelListenerList& List = ListenerMap.FindOrAdd(Channel);
+	TUniquePtr<FChannelListenerList>& ListPtr = ListenerMap.FindOrAdd(Channel);
+	if (!ListPtr.IsValid())
+	{
+		ListPtr = MakeUnique<FChannelListenerList>();
+	}
+	FChannelListenerList& List = *ListPtr;
 
-	FGameplayMessageListenerData& Entry = List.Listeners.AddDefaulted_GetRef();
+	FGameplayMessageListenerData& Entry = *List.Listeners.Add_GetRef(MakeUnique<FGameplayMessageListenerData>());
 	Entry.ReceivedCallback = MoveTemp(Callback);
 	Entry.ListenerStructType = StructType;
 	Entry.bHadValidType = StructType != nullptr;
 	Entry.HandleID = ++List.HandleID;
 	Entry.MatchType = MatchType;
+	Entry.Generation = ++ListenerGeneration;
+
+	bDispatchTableDirty = true;
 
 	return FGameplayMessageListenerHandle(this, Channel, Entry.HandleID);
 }
@@ -170,18 +242,60 @@ void UGameplayMessageSubsystem::UnregisterListener(FGameplayMessageListenerHandl
 
 void UGameplayMessageSubsystem::UnregisterListenerInternal(FGameplayTag Channel, int32 HandleID)
 {
-	if (FChannelListenerList* pList = ListenerMap.Find(Channel))
+	if (TUniquePtr<FChannelListenerList>* pList = ListenerMap.Find(Channel))
 	{
-		int32 MatchIndex = pList->Listeners.IndexOfByPredicate([ID = HandleID](const FGameplayMessageListenerData& Other) { return Other.HandleID == ID; });
+		FChannelListenerList& List = **pList;
+
+		int32 MatchIndex = List.Listeners.IndexOfByPredicate([ID = HandleID](const TUniquePtr<FGameplayMessageListenerData>& Other) { return Other->HandleID == ID; });
 		if (MatchIndex != INDEX_NONE)
 		{
-			pList->Listeners.RemoveAtSwap(MatchIndex);
+			if (BroadcastDepth > 0)
+			{
+				// A broadcast may be walking this list (or running this very listener), remove it once they are done
+				FGameplayMessageListenerData& Listener = *List.Listeners[MatchIndex];
+				if (!Listener.bPendingRemoval)
+				{
+					Listener.bPendingRemoval = true;
+					if (List.NumPendingRemovals++ == 0)
+					{
+						ChannelsPendingRemoval.Add(Channel);
+					}
+				}
+			}
+			else
+			{
+				List.Listeners.RemoveAtSwap(MatchIndex);
+				bDispatchTableDirty = true;
+			}
 		}
 
-		if (pList->Listeners.Num() == 0)
+		if (List.Listeners.Num() == 0)
 		{
 			ListenerMap.Remove(Channel);
 		}
 	}
 }
 
+void UGameplayMessageSubsystem::RemovePendingListeners()
+{
+	check(BroadcastDepth == 0);
+
+	for (const FGameplayTag& Channel : ChannelsPendingRemoval)
+	{
+		if (TUniquePtr<FChannelListenerList>* pList = ListenerMap.Find(Channel))
+		{
+			FChannelListenerList& List = **pList;
+			List.Listeners.RemoveAllSwap([](const TUniquePtr<FGameplayMessageListenerData>& Listener) { return Listener->bPendingRemoval; });
+			List.NumPendingRemovals = 0;
+
+			if (List.Listeners.Num() == 0)
+			{
+				ListenerMap.Remove(Channel);
+			}
+		}
+	}
+
+	ChannelsPendingRemoval.Reset();
+	bDispatchTableDirty = true;
+}
+
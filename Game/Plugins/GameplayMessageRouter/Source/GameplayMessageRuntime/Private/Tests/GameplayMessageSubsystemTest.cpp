@@ -0,0 +1,213 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Engine/GameInstance.h"
+#include "GameFramework/GameplayMessageSubsystem.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/AutomationTest.h"
+#include "NativeGameplayTags.h"
+#include "UObject/Package.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_GameplayMessageTest_Parent, "Test.GameplayMessage.Parent");
+UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_GameplayMessageTest_Child, "Test.GameplayMessage.Parent.Child");
+UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_GameplayMessageTest_Other, "Test.GameplayMessage.Other");
+
+namespace GameplayMessageSubsystemTest
+{
+	static UGameplayMessageSubsystem* MakeSubsystem()
+	{
+		// Game instance subsystems must live inside a game instance
+		UGameInstance* GameInstance = NewObject<UGameInstance>(GetTransientPackage());
+		return NewObject<UGameplayMessageSubsystem>(GameInstance);
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGameplayMessageDispatchTest, "GameplayMessageRouter.Dispatch", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ServerContext | EAutomationTestFlags::EngineFilter)
+
+bool FGameplayMessageDispatchTest::RunTest(const FString& Parameters)
+{
+	using namespace GameplayMessageSubsystemTest;
+
+	UGameplayMessageSubsystem* Router = MakeSubsystem();
+	const FVector Message(1.0, 2.0, 3.0);
+
+	// Exact and partial matches
+	{
+		int32 ParentExactCalls = 0;
+		int32 ParentPartialCalls = 0;
+		int32 ChildCalls = 0;
+
+		FGameplayMessageListenerHandle ParentExact = Router->RegisterListener<FVector>(TAG_GameplayMessageTest_Parent, [&ParentExactCalls](FGameplayTag, const FVector&) { ++ParentExactCalls; });
+
+		FGameplayMessageListenerParams<FVector> PartialParams;
+		PartialParams.MatchType = EGameplayMessageMatch::PartialMatch;
+		PartialParams.OnMessageReceivedCallback = [&ParentPartialCalls](FGameplayTag, const FVector&) { ++ParentPartialCalls; };
+		FGameplayMessageListenerHandle ParentPartial = Router->RegisterListener<FVector>(TAG_GameplayMessageTest_Parent, PartialParams);
+
+		FGameplayMessageListenerHandle Child = Router->RegisterListener<FVector>(TAG_GameplayMessageTest_Child, [&ChildCalls, &Message, this](FGameplayTag Channel, const FVector& Payload)
+		{
+			++ChildCalls;
+			TestTrue(TEXT("Channel passed to the listener"), Channel == TAG_GameplayMessageTest_Child.GetTag());
+			TestEqual(TEXT("Payload passed to the listener"), Payload, Message);
+		});
+
+		Router->BroadcastMessage(TAG_GameplayMessageTest_Child, Message);
+		TestEqual(TEXT("Exact parent listener ignores children"), ParentExactCalls, 0);
+		TestEqual(TEXT("Partial parent listener hears children"), ParentPartialCalls, 1);
+		TestEqual(TEXT("Child listener"), ChildCalls, 1);
+
+		Router->BroadcastMessage(TAG_GameplayMessageTest_Parent, Message);
+		TestEqual(TEXT("Exact parent listener"), ParentExactCalls, 1);
+		TestEqual(TEXT("Partial parent listener"), ParentPartialCalls, 2);
+		TestEqual(TEXT("Child listener ignores parents"), ChildCalls, 1);
+
+		Router->BroadcastMessage(TAG_GameplayMessageTest_Other, Message);
+		TestEqual(TEXT("Unrelated channel"), ParentExactCalls + ParentPartialCalls + ChildCalls, 4);
+
+		ParentExact.Unregister();
+		ParentPartial.Unregister();
+		Child.Unregister();
+
+		Router->BroadcastMessage(TAG_GameplayMessageTest_Child, Message);
+		Router->BroadcastMessage(TAG_GameplayMessageTest_Parent, Message);
+		TestEqual(TEXT("Nothing after unregistering"), ParentExactCalls + ParentPartialCalls + ChildCalls, 4);
+	}
+
+	// Listeners added and removed between broadcasts on a channel that has already been looked up
+	{
+		int32 ChildCalls = 0;
+		int32 ParentPartialCalls = 0;
+
+		FGameplayMessageListenerHandle Child = Router->RegisterListener<FVector>(TAG_GameplayMessageTest_Child, [&ChildCalls](FGameplayTag, const FVector&) { ++ChildCalls; });
+		Router->BroadcastMessage(TAG_GameplayMessageTest_Child, Message);
+		TestEqual(TEXT("Before adding a parent listener"), ChildCalls, 1);
+
+		FGameplayMessageListenerParams<FVector> PartialParams;
+		PartialParams.MatchType = EGameplayMessageMatch::PartialMatch;
+		PartialParams.OnMessageReceivedCallback = [&ParentPartialCalls](FGameplayTag, const FVector&) { ++ParentPartialCalls; };
+		FGameplayMessageListenerHandle ParentPartial = Router->RegisterListener<FVector>(TAG_GameplayMessageTest_Parent, PartialParams);
+
+		Router->BroadcastMessage(TAG_GameplayMessageTest_Child, Message);
+		TestEqual(TEXT("Parent listener added after the channel was looked up"), ParentPartialCalls, 1);
+		TestEqual(TEXT("Child listener still called"), ChildCalls, 2);
+
+		Child.Unregister();
+		Router->BroadcastMessage(TAG_GameplayMessageTest_Child, Message);
+		TestEqual(TEXT("Child listener removed after the channel was looked up"), ChildCalls, 2);
+		TestEqual(TEXT("Parent listener still called"), ParentPartialCalls, 2);
+
+		ParentPartial.Unregister();
+	}
+
+	// Listeners unregistering themselves and each other from inside a callback
+	{
+		int32 SelfCalls = 0;
+		int32 VictimCalls = 0;
+		int32 BystanderCalls = 0;
+
+		FGameplayMessageListenerHandle SelfHandle;
+		FGameplayMessageListenerHandle VictimHandle;
+
+		SelfHandle = Router->RegisterListener<FVector>(TAG_GameplayMessageTest_Child, [&](FGameplayTag, const FVector&)
+		{
+			++SelfCalls;
+			SelfHandle.Unregister();
+			VictimHandle.Unregister();
+		});
+		VictimHandle = Router->RegisterListener<FVector>(TAG_GameplayMessageTest_Child, [&VictimCalls](FGameplayTag, const FVector&) { ++VictimCalls; });
+		FGameplayMessageListenerHandle Bystander = Router->RegisterListener<FVector>(TAG_GameplayMessageTest_Child, [&BystanderCalls](FGameplayTag, const FVector&) { ++BystanderCalls; });
+
+		Router->BroadcastMessage(TAG_GameplayMessageTest_Child, Message);
+		TestEqual(TEXT("Self removing listener ran once"), SelfCalls, 1);
+		TestEqual(TEXT("Listener removed by an earlier callback is skipped"), VictimCalls, 0);
+		TestEqual(TEXT("Other listeners still run"), BystanderCalls, 1);
+
+		Router->BroadcastMessage(TAG_GameplayMessageTest_Child, Message);
+		TestEqual(TEXT("Self removing listener is gone"), SelfCalls, 1);
+		TestEqual(TEXT("Bystander again"), BystanderCalls, 2);
+
+		Bystander.Unregister();
+	}
+
+	// Listeners registered and messages broadcast from inside a callback
+	{
+		int32 LateCalls = 0;
+		int32 NestedCalls = 0;
+		FGameplayMessageListenerHandle LateHandle;
+
+		FGameplayMessageListenerHandle Registrar = Router->RegisterListener<FVector>(TAG_GameplayMessageTest_Child, [&](FGameplayTag, const FVector&)
+		{
+			if (!LateHandle.IsValid())
+			{
+				// Enough registrations to grow the list while it is being walked
+				LateHandle = Router->RegisterListener<FVector>(TAG_GameplayMessageTest_Child, [&LateCalls](FGameplayTag, const FVector&) { ++LateCalls; });
+				for (int32 Index = 0; Index < 32; ++Index)
+				{
+					Router->RegisterListener<FVector>(TAG_GameplayMessageTest_Other, [](FGameplayTag, const FVector&) {});
+				}
+
+				Router->BroadcastMessage(TAG_GameplayMessageTest_Other, Message);
+			}
+		});
+		FGameplayMessageListenerHandle Nested = Router->RegisterListener<FVector>(TAG_GameplayMessageTest_Other, [&NestedCalls](FGameplayTag, const FVector&) { ++NestedCalls; });
+
+		Router->BroadcastMessage(TAG_GameplayMessageTest_Child, Message);
+		TestEqual(TEXT("Listener registered during a broadcast waits for the next one"), LateCalls, 0);
+		TestEqual(TEXT("Nested broadcast"), NestedCalls, 1);
+
+		Router->BroadcastMessage(TAG_GameplayMessageTest_Child, Message);
+		TestEqual(TEXT("Late listener on the next broadcast"), LateCalls, 1);
+
+		Registrar.Unregister();
+		LateHandle.Unregister();
+		Nested.Unregister();
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FGameplayMessageDispatchBenchmark, "GameplayMessageRouter.Dispatch.Benchmark", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ServerContext | EAutomationTestFlags::PerfFilter)
+
+bool FGameplayMessageDispatchBenchmark::RunTest(const FString& Parameters)
+{
+	using namespace GameplayMessageSubsystemTest;
+
+	static const int32 ListenerCounts[] = { 1, 10, 100 };
+	static const int32 NumListenerCalls = 2000000;
+
+	const FVector Message(1.0, 2.0, 3.0);
+
+	for (const int32 NumListeners : ListenerCounts)
+	{
+		UGameplayMessageSubsystem* Router = MakeSubsystem();
+
+		// Spread over the channel and its parent, like listeners for a specific message and for a whole family of them
+		int64 NumCalls = 0;
+		for (int32 Index = 0; Index < NumListeners; ++Index)
+		{
+			FGameplayMessageListenerParams<FVector> Params;
+			Params.MatchType = (Index % 2 == 0) ? EGameplayMessageMatch::ExactMatch : EGameplayMessageMatch::PartialMatch;
+			Params.OnMessageReceivedCallback = [&NumCalls](FGameplayTag, const FVector&) { ++NumCalls; };
+			Router->RegisterListener<FVector>((Index % 2 == 0) ? TAG_GameplayMessageTest_Child : TAG_GameplayMessageTest_Parent, Params);
+		}
+
+		const int32 NumBroadcasts = NumListenerCalls / NumListeners;
+
+		const double StartTime = FPlatformTime::Seconds();
+		for (int32 Index = 0; Index < NumBroadcasts; ++Index)
+		{
+			Router->BroadcastMessage(TAG_GameplayMessageTest_Child, Message);
+		}
+		const double ElapsedSeconds = FPlatformTime::Seconds() - StartTime;
+
+		TestEqual(FString::Printf(TEXT("%d listeners: every listener called"), NumListeners), NumCalls, int64(NumBroadcasts) * NumListeners);
+
+		AddInfo(FString::Printf(TEXT("%3d listeners: %.1f ns per broadcast, %.2f M broadcasts/s"),
+			NumListeners, (ElapsedSeconds / NumBroadcasts) * 1.0e9, (NumBroadcasts / ElapsedSeconds) * 1.0e-6));
+	}
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
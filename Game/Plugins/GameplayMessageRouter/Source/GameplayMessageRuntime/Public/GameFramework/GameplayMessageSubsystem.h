@@ -11,6 +11,7 @@
 #include "Logging/LogMacros.h"
 #include "Subsystems/GameInstanceSubsystem.h"
 #include "Templates/Function.h"
+#include "Templates/UniquePtr.h"
 #include "Templates/UnrealTemplate.h"
 #include "UObject/Class.h"
 #include "UObject/Object.h"
@@ -77,6 +78,12 @@ struct FGameplayMessageListenerData
 	// Adding some logging and extra variables around some potential problems with this
 	TWeakObjectPtr<const UScriptStruct> ListenerStructType = nullptr;
 	bool bHadValidType = false;
+
+	// Unregistered while a broadcast was in progress, skipped until the broadcast finishes and removes it
+	bool bPendingRemoval = false;
+
+	// Value of the subsystem's listener generation when this was registered, broadcasts skip listeners newer than themselves
+	uint32 Generation = 0;
 };
 
 /**
@@ -234,14 +241,54 @@ private:
 
 	void UnregisterListenerInternal(FGameplayTag Channel, int32 HandleID);
 
+	// Removes the listeners that were unregistered while broadcasts were in progress
+	void RemovePendingListeners();
+
+	// Where the listeners for broadcasts on one channel are in DispatchListeners
+	struct FDispatchSpan
+	{
+		int32 Start = 0;
+		int32 Num = 0;
+	};
+
+	// A listener and the channel it is registered on
+	struct FDispatchListener
+	{
+		FGameplayMessageListenerData* Listener = nullptr;
+		FGameplayTag ListenerChannel;
+	};
+
+	// Appends every listener that hears broadcasts on Channel (exact and partial matches on it, partial matches on its parents) to DispatchListeners
+	FDispatchSpan BuildDispatchSpan(FGameplayTag Channel);
+
 private:
 	// List of all entries for a given channel
 	struct FChannelListenerList
 	{
-		TArray<FGameplayMessageListenerData> Listeners;
+		// Listeners are allocated one by one so they stay put if a callback registers more of them
+		TArray<TUniquePtr<FGameplayMessageListenerData>> Listeners;
 		int32 HandleID = 0;
+
+		// Listeners marked bPendingRemoval
+		int32 NumPendingRemovals = 0;
 	};
 
 private:
-	TMap<FGameplayTag, FChannelListenerList> ListenerMap;
+	// Lists are allocated one by one so a broadcast can keep walking a list while callbacks add new channels
+	TMap<FGameplayTag, TUniquePtr<FChannelListenerList>> ListenerMap;
+
+	// Incremented for every registered listener
+	uint32 ListenerGeneration = 0;
+
+	// Number of broadcasts in progress (callbacks may broadcast in turn), listeners are only removed when it is zero
+	int32 BroadcastDepth = 0;
+
+	// Channels with listeners marked bPendingRemoval
+	TArray<FGameplayTag> ChannelsPendingRemoval;
+
+	// The listeners of every channel broadcast on since listeners last changed, so a broadcast is one lookup rather
+	// than a walk up the tag hierarchy.  Filled in lazily per channel and thrown away when listeners are added or removed.
+	TMap<FGameplayTag, FDispatchSpan> DispatchSpans;
+	TArray<FDispatchListener> DispatchListeners;
+	bool bDispatchTableDirty = false;
 };
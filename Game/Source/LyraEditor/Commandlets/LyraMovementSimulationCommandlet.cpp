@@ -0,0 +1,136 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "LyraMovementSimulationCommandlet.h"
+
+#include "Containers/Array.h"
+#include "Containers/Map.h"
+#include "Logging/LogMacros.h"
+#include "Misc/CString.h"
+#include "Misc/Paths.h"
+#include "Tests/LyraMovementSimulation.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(LyraMovementSimulationCommandlet)
+
+DEFINE_LOG_CATEGORY_STATIC(LogLyraMovementSimulation, Log, Log);
+
+ULyraMovementSimulationCommandlet::ULyraMovementSimulationCommandlet(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+}
+
+int32 ULyraMovementSimulationCommandlet::Main(const FString& FullCommandLine)
+{
+	UE_LOG(LogLyraMovementSimulation, Display, TEXT("Running LyraMovementSimulation commandlet..."));
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+	TArray<FString> Tokens;
+	TArray<FString> Switches;
+	TMap<FString, FString> Params;
+	ParseCommandLine(*FullCommandLine, Tokens, Switches, Params);
+
+	const bool bUpdateGolden = Switches.Contains(TEXT("UpdateGolden"));
+
+	int32 NumCharacters = 1;
+	if (const FString* CharactersString = Params.Find(TEXT("Characters")))
+	{
+		NumCharacters = FMath::Max(FCString::Atoi(**CharactersString), 1);
+	}
+
+	// Gather the streams to replay, either a recorded file or one or all of the built-in scenarios.
+	TArray<FLyraMovementInputStream> Streams;
+	if (const FString* InputString = Params.Find(TEXT("Input")))
+	{
+		FLyraMovementInputStream& Stream = Streams.AddDefaulted_GetRef();
+		if (!Stream.LoadFromFile(*InputString))
+		{
+			UE_LOG(LogLyraMovementSimulation, Error, TEXT("Failed to load input stream [%s]."), **InputString);
+			return 1;
+		}
+
+		if (Stream.Name.IsEmpty())
+		{
+			Stream.Name = FPaths::GetBaseFilename(*InputString);
+		}
+	}
+	else
+	{
+		const FString* ScenarioString = Params.Find(TEXT("Scenario"));
+		for (const FString& ScenarioName : FLyraMovementInputStream::GetBuiltInScenarioNames())
+		{
+			if (!ScenarioString || ScenarioString->Equals(ScenarioName, ESearchCase::IgnoreCase))
+			{
+				FLyraMovementInputStream::MakeBuiltInScenario(ScenarioName, Streams.AddDefaulted_GetRef());
+			}
+		}
+
+		if (Streams.IsEmpty())
+		{
+			UE_LOG(LogLyraMovementSimulation, Error, TEXT("Unknown scenario [%s]. Known scenarios: %s"), **ScenarioString, *FString::Join(FLyraMovementInputStream::GetBuiltInScenarioNames(), TEXT(", ")));
+			return 1;
+		}
+	}
+
+	FLyraMovementSimulation Simulation;
+	if (!Simulation.Initialize())
+	{
+		return 1;
+	}
+
+	int32 ReturnVal = 0;
+
+	for (const FLyraMovementInputStream& Stream : Streams)
+	{
+		FLyraMovementSimulationResult Result;
+		if (!Simulation.Run(Stream, NumCharacters, Result))
+		{
+			UE_LOG(LogLyraMovementSimulation, Error, TEXT("[%s] Simulation failed to run."), *Stream.Name);
+			ReturnVal = 1;
+			continue;
+		}
+
+		UE_LOG(LogLyraMovementSimulation, Display, TEXT("[%s] %d frames x %d characters: %lld character ticks in %.3f ms (%.0f character ticks/sec)"),
+			*Stream.Name, Stream.Frames.Num(), NumCharacters, Result.CharacterTicks, Result.MovementSeconds * 1000.0, Result.GetCharacterTicksPerSecond());
+
+		const FString GoldenFilename = FLyraMovementSimulation::GetGoldenFilename(Stream.Name);
+
+		if (bUpdateGolden)
+		{
+			if (Result.Trajectory.SaveToFile(GoldenFilename))
+			{
+				UE_LOG(LogLyraMovementSimulation, Display, TEXT("[%s] Wrote golden trajectory to %s."), *Stream.Name, *GoldenFilename);
+			}
+			else
+			{
+				ReturnVal = 1;
+			}
+			continue;
+		}
+
+		// A missing golden is a failure, otherwise a checkout without them would pass without comparing anything
+		FLyraMovementTrajectory Golden;
+		if (!Golden.LoadFromFile(GoldenFilename))
+		{
+			UE_LOG(LogLyraMovementSimulation, Error, TEXT("[%s] No golden trajectory at %s, run with -UpdateGolden to create one."), *Stream.Name, *GoldenFilename);
+			ReturnVal = 1;
+			continue;
+		}
+
+		int32 MismatchFrame = INDEX_NONE;
+		if (Result.Trajectory.IsBitIdentical(Golden, MismatchFrame))
+		{
+			UE_LOG(LogLyraMovementSimulation, Display, TEXT("[%s] Trajectory matches golden."), *Stream.Name);
+		}
+		else
+		{
+			UE_LOG(LogLyraMovementSimulation, Error, TEXT("[%s] Trajectory diverges from golden at frame %d."), *Stream.Name, MismatchFrame);
+			ReturnVal = 1;
+		}
+	}
+
+	return ReturnVal;
+#else
+	UE_LOG(LogLyraMovementSimulation, Error, TEXT("The movement simulation harness is only built with WITH_DEV_AUTOMATION_TESTS."));
+	return 1;
+#endif // WITH_DEV_AUTOMATION_TESTS
+}
@@ -0,0 +1,29 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+#include "Containers/UnrealString.h"
+#include "HAL/Platform.h"
+#include "UObject/UObjectGlobals.h"
+
+#include "LyraMovementSimulationCommandlet.generated.h"
+
+class UObject;
+
+/**
+ * Replays movement input streams through ULyraCharacterMovementComponent at a fixed timestep,
+ * reports throughput and compares the trajectories against the golden files.
+ *
+ * Usage: -run=LyraMovementSimulation [-Scenario=BhopStrafe] [-Input=Path.lmis] [-Characters=64] [-UpdateGolden]
+ */
+UCLASS()
+class ULyraMovementSimulationCommandlet : public UCommandlet
+{
+	GENERATED_UCLASS_BODY()
+
+public:
+	// Begin UCommandlet Interface
+	virtual int32 Main(const FString& Params) override;
+	// End UCommandlet Interface
+};
@@ -28,6 +28,44 @@ static FDamageStatics& DamageStatics()
 }
 
 
+#if WITH_SERVER_CODE
+// Returns the damage multiplier for one hit, from how far it travelled and what it hit
+static float ComputeHitAttenuation(const FGameplayEffectSpec& Spec, const FLyraGameplayEffectContext& TypedContext, const AActor* EffectCauser, const FVector& ImpactLocation, const UPhysicalMaterial* PhysMat, const FGameplayTagContainer* SourceTags, const FGameplayTagContainer* TargetTags)
+{
+	// Determine distance
+	double Distance = WORLD_MAX;
+
+	if (TypedContext.HasOrigin())
+	{
+		Distance = FVector::Dist(TypedContext.GetOrigin(), ImpactLocation);
+	}
+	else if (EffectCauser)
+	{
+		Distance = FVector::Dist(EffectCauser->GetActorLocation(), ImpactLocation);
+	}
+	else
+	{
+		ensureMsgf(false, TEXT("Damage Calculation cannot deduce a source location for damage coming from %s; Falling back to WORLD_MAX dist!"), *GetPathNameSafe(Spec.Def));
+	}
+
+	// Apply ability source modifiers
+	float PhysicalMaterialAttenuation = 1.0f;
+	float DistanceAttenuation = 1.0f;
+	if (const ILyraAbilitySourceInterface* AbilitySource = TypedContext.GetAbilitySource())
+	{
+		if (PhysMat)
+		{
+			PhysicalMaterialAttenuation = AbilitySource->GetPhysicalMaterialAttenuation(PhysMat, SourceTags, TargetTags);
+		}
+
+		DistanceAttenuation = AbilitySource->GetDistanceAttenuation(Distance, SourceTags, TargetTags);
+	}
+	DistanceAttenuation = FMath::Max(DistanceAttenuation, 0.0f);
+
+	return DistanceAttenuation * PhysicalMaterialAttenuation;
+}
+#endif // #if WITH_SERVER_CODE
+
 ULyraDamageExecution::ULyraDamageExecution()
 {
 	RelevantAttributesToCapture.Add(DamageStatics().BaseDamageDef);
@@ -94,38 +132,22 @@ void ULyraDamageExecution::Execute_Implementation(const FGameplayEffectCustomExe
 		DamageInteractionAllowedMultiplier = TeamSubsystem->CanCauseDamage(EffectCauser, HitActor) ? 1.0 : 0.0;
 	}
 
-	// Determine distance
-	double Distance = WORLD_MAX;
-
-	if (TypedContext->HasOrigin())
+	// Hits folded together by a batched application all land on this target, their damage adds up
+	float HitAttenuation = 0.0f;
+	if (TypedContext->BatchedHits.Num() > 0)
 	{
-		Distance = FVector::Dist(TypedContext->GetOrigin(), ImpactLocation);
-	}
-	else if (EffectCauser)
-	{
-		Distance = FVector::Dist(EffectCauser->GetActorLocation(), ImpactLocation);
+		for (const FHitResult& BatchedHit : TypedContext->BatchedHits)
+		{
+			HitAttenuation += ComputeHitAttenuation(Spec, *TypedContext, EffectCauser, BatchedHit.ImpactPoint, BatchedHit.PhysMaterial.Get(), SourceTags, TargetTags);
+		}
 	}
 	else
 	{
-		ensureMsgf(false, TEXT("Damage Calculation cannot deduce a source location for damage coming from %s; Falling back to WORLD_MAX dist!"), *GetPathNameSafe(Spec.Def));
+		HitAttenuation = ComputeHitAttenuation(Spec, *TypedContext, EffectCauser, ImpactLocation, TypedContext->GetPhysicalMaterial(), SourceTags, TargetTags);
 	}
 
-	// Apply ability source modifiers
-	float PhysicalMaterialAttenuation = 1.0f;
-	float DistanceAttenuation = 1.0f;
-	if (const ILyraAbilitySourceInterface* AbilitySource = TypedContext->GetAbilitySource())
-	{
-		if (const UPhysicalMaterial* PhysMat = TypedContext->GetPhysicalMaterial())
-		{
-			PhysicalMaterialAttenuation = AbilitySource->GetPhysicalMaterialAttenuation(PhysMat, SourceTags, TargetTags);
-		}
-
-		DistanceAttenuation = AbilitySource->GetDistanceAttenuation(Distance, SourceTags, TargetTags);
-	}
-	DistanceAttenuation = FMath::Max(DistanceAttenuation, 0.0f);
-
 	// Clamping is done when damage is converted to -health
-	const float DamageDone = FMath::Max(BaseDamage * DistanceAttenuation * PhysicalMaterialAttenuation * DamageInteractionAllowedMultiplier, 0.0f);
+	const float DamageDone = FMath::Max(BaseDamage * HitAttenuation * DamageInteractionAllowedMultiplier, 0.0f);
 
 	if (DamageDone > 0.0f)
 	{
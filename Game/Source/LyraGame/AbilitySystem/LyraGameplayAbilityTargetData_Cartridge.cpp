@@ -0,0 +1,84 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "LyraGameplayAbilityTargetData_Cartridge.h"
+
+#include "GameFramework/Actor.h"
+#include "PhysicalMaterials/PhysicalMaterial.h"
+#include "Serialization/Archive.h"
+#include "Serialization/BitReader.h"
+#include "Serialization/BitWriter.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(LyraGameplayAbilityTargetData_Cartridge)
+
+//////////////////////////////////////////////////////////////////////
+
+bool FLyraCartridgeHitClaim::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	Ar << BulletIndex;
+
+	uint8 bHitBlocked = bBlockingHit ? 1 : 0;
+	Ar.SerializeBits(&bHitBlocked, 1);
+	bBlockingHit = (bHitBlocked != 0);
+
+	Ar << Actor;
+	Ar << PhysMaterial;
+
+	bOutSuccess = true;
+	bool bPointSuccess = true;
+	ImpactPoint.NetSerialize(Ar, Map, bPointSuccess);
+	bOutSuccess &= bPointSuccess;
+	ImpactNormal.NetSerialize(Ar, Map, bPointSuccess);
+	bOutSuccess &= bPointSuccess;
+
+	return true;
+}
+
+bool FLyraGameplayAbilityTargetData_Cartridge::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	bOutSuccess = true;
+
+	bool bFieldSuccess = true;
+	Origin.NetSerialize(Ar, Map, bFieldSuccess);
+	bOutSuccess &= bFieldSuccess;
+	AimDir.NetSerialize(Ar, Map, bFieldSuccess);
+	bOutSuccess &= bFieldSuccess;
+
+	Ar << SpreadAngle;
+	Ar << Seed;
+	Ar << ShotIndex;
+
+	// A cartridge never has more than 255 hits worth sending
+	uint8 NumHits = uint8(FMath::Min(Hits.Num(), 255));
+	Ar << NumHits;
+
+	if (Ar.IsLoading())
+	{
+		Hits.SetNum(NumHits);
+	}
+
+	for (int32 HitIndex = 0; HitIndex < NumHits; ++HitIndex)
+	{
+		Hits[HitIndex].NetSerialize(Ar, Map, bFieldSuccess);
+		bOutSuccess &= bFieldSuccess;
+	}
+
+	return true;
+}
+
+void FLyraGameplayAbilityTargetData_Cartridge::QuantizeAim(FVector& InOutOrigin, FVector& InOutAimDir)
+{
+	FVector_NetQuantize10 Origin(InOutOrigin);
+	FVector_NetQuantizeNormal AimDir(InOutAimDir);
+
+	bool bSuccess = true;
+	FBitWriter Writer(256, /*AllowResize=*/ true);
+	Origin.NetSerialize(Writer, nullptr, bSuccess);
+	AimDir.NetSerialize(Writer, nullptr, bSuccess);
+
+	FBitReader Reader(Writer.GetData(), Writer.GetNumBits());
+	Origin.NetSerialize(Reader, nullptr, bSuccess);
+	AimDir.NetSerialize(Reader, nullptr, bSuccess);
+
+	InOutOrigin = Origin;
+	InOutAimDir = AimDir;
+}
@@ -0,0 +1,98 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "Abilities/GameplayAbilityTargetTypes.h"
+#include "Engine/NetSerialization.h"
+#include "HAL/Platform.h"
+#include "UObject/Class.h"
+#include "UObject/WeakObjectPtr.h"
+
+#include "LyraGameplayAbilityTargetData_Cartridge.generated.h"
+
+class AActor;
+class FArchive;
+class UPackageMap;
+class UPhysicalMaterial;
+
+/** A hit the shooter claims for one bullet of a seeded cartridge */
+USTRUCT()
+struct FLyraCartridgeHitClaim
+{
+	GENERATED_BODY()
+
+	/** Which bullet of the cartridge made this hit */
+	UPROPERTY()
+	uint8 BulletIndex = 0;
+
+	UPROPERTY()
+	bool bBlockingHit = false;
+
+	UPROPERTY()
+	TWeakObjectPtr<AActor> Actor;
+
+	UPROPERTY()
+	TWeakObjectPtr<UPhysicalMaterial> PhysMaterial;
+
+	UPROPERTY()
+	FVector_NetQuantize10 ImpactPoint = FVector::ZeroVector;
+
+	UPROPERTY()
+	FVector_NetQuantizeNormal ImpactNormal = FVector::ZeroVector;
+
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+};
+
+/**
+ * FLyraGameplayAbilityTargetData_Cartridge
+ *
+ *	Compact form of a whole cartridge sent from the shooter to the server.  Bullet directions are not sent, the
+ *	server regenerates them from the aim, the spread and the seed, so only the claimed hits travel per bullet.
+ *	The server expands it back into one FLyraGameplayAbilityTargetData_SingleTargetHit per claimed hit.
+ */
+USTRUCT()
+struct FLyraGameplayAbilityTargetData_Cartridge : public FGameplayAbilityTargetData
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FVector_NetQuantize10 Origin = FVector::ZeroVector;
+
+	UPROPERTY()
+	FVector_NetQuantizeNormal AimDir = FVector::ForwardVector;
+
+	/** Spread angle the shooter fired with (in degrees, diametrical), the server expands with it clamped to the weapon's range */
+	UPROPERTY()
+	float SpreadAngle = 0.0f;
+
+	/** Spread seed, derived from the activation prediction key and ShotIndex */
+	UPROPERTY()
+	int32 Seed = 0;
+
+	/** Low byte of the index of this cartridge within the ability activation */
+	UPROPERTY()
+	uint8 ShotIndex = 0;
+
+	/** Claimed hits, in the same order as the shooter's own target data */
+	UPROPERTY()
+	TArray<FLyraCartridgeHitClaim> Hits;
+
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+
+	/** Rounds an origin and aim direction the way NetSerialize sends them, so the shooter fires the bullets the server regenerates */
+	static void QuantizeAim(FVector& InOutOrigin, FVector& InOutAimDir);
+
+	virtual UScriptStruct* GetScriptStruct() const override
+	{
+		return FLyraGameplayAbilityTargetData_Cartridge::StaticStruct();
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FLyraGameplayAbilityTargetData_Cartridge> : public TStructOpsTypeTraitsBase2<FLyraGameplayAbilityTargetData_Cartridge>
+{
+	enum
+	{
+		WithNetSerializer = true	// For now this is REQUIRED for FGameplayAbilityTargetDataHandle net serialization to work
+	};
+};
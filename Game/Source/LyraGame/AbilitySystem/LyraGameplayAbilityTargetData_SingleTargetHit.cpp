@@ -2,7 +2,10 @@
 
 #include "LyraGameplayAbilityTargetData_SingleTargetHit.h"
 
+#include "Components/PrimitiveComponent.h"
+#include "Engine/NetSerialization.h"
 #include "LyraGameplayEffectContext.h"
+#include "PhysicalMaterials/PhysicalMaterial.h"
 #include "Serialization/Archive.h"
 
 #include UE_INLINE_GENERATED_CPP_BY_NAME(LyraGameplayAbilityTargetData_SingleTargetHit)
@@ -11,6 +14,17 @@ struct FGameplayEffectContextHandle;
 
 //////////////////////////////////////////////////////////////////////
 
+TArray<TWeakObjectPtr<AActor>> FLyraGameplayAbilityTargetData_SingleTargetHit::GetActors() const
+{
+	// The actor is already targeted by the hit carrying the batch
+	if (bFoldedIntoBatch)
+	{
+		return TArray<TWeakObjectPtr<AActor>>();
+	}
+
+	return FGameplayAbilityTargetData_SingleTargetHit::GetActors();
+}
+
 void FLyraGameplayAbilityTargetData_SingleTargetHit::AddTargetDataToContext(FGameplayEffectContextHandle& Context, bool bIncludeActorArray) const
 {
 	FGameplayAbilityTargetData_SingleTargetHit::AddTargetDataToContext(Context, bIncludeActorArray);
@@ -19,15 +33,123 @@ void FLyraGameplayAbilityTargetData_SingleTargetHit::AddTargetDataToContext(FGam
 	if (FLyraGameplayEffectContext* TypedContext = FLyraGameplayEffectContext::ExtractEffectContext(Context))
 	{
 		TypedContext->CartridgeID = CartridgeID;
+		TypedContext->BatchedHits = BatchedHits;
+	}
+}
+
+uint16 LyraTargetData::EncodeOctahedralNormal16(const FVector& Normal)
+{
+	const double L1Norm = FMath::Abs(Normal.X) + FMath::Abs(Normal.Y) + FMath::Abs(Normal.Z);
+	if (L1Norm <= UE_SMALL_NUMBER)
+	{
+		// Zero normals (misses) decode to straight up, they are never read
+		return (uint16(128) << 8) | uint16(128);
+	}
+
+	double X = Normal.X / L1Norm;
+	double Y = Normal.Y / L1Norm;
+	if (Normal.Z < 0.0)
+	{
+		// Fold the lower hemisphere over the diagonals
+		const double FoldedX = (1.0 - FMath::Abs(Y)) * (X >= 0.0 ? 1.0 : -1.0);
+		const double FoldedY = (1.0 - FMath::Abs(X)) * (Y >= 0.0 ? 1.0 : -1.0);
+		X = FoldedX;
+		Y = FoldedY;
 	}
+
+	const uint16 EncodedX = uint16(FMath::Clamp(FMath::RoundToInt((X * 0.5 + 0.5) * 255.0), 0, 255));
+	const uint16 EncodedY = uint16(FMath::Clamp(FMath::RoundToInt((Y * 0.5 + 0.5) * 255.0), 0, 255));
+	return (EncodedX << 8) | EncodedY;
+}
+
+FVector LyraTargetData::DecodeOctahedralNormal16(uint16 Encoded)
+{
+	const double X = (double(Encoded >> 8) / 255.0) * 2.0 - 1.0;
+	const double Y = (double(Encoded & 0xFF) / 255.0) * 2.0 - 1.0;
+	const double Z = 1.0 - FMath::Abs(X) - FMath::Abs(Y);
+
+	FVector Normal(X, Y, Z);
+	if (Z < 0.0)
+	{
+		Normal.X = (1.0 - FMath::Abs(Y)) * (X >= 0.0 ? 1.0 : -1.0);
+		Normal.Y = (1.0 - FMath::Abs(X)) * (Y >= 0.0 ? 1.0 : -1.0);
+	}
+
+	return Normal.GetSafeNormal();
 }
 
 bool FLyraGameplayAbilityTargetData_SingleTargetHit::NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess)
 {
-	FGameplayAbilityTargetData_SingleTargetHit::NetSerialize(Ar, Map, bOutSuccess);
+	FHitResult& Hit = HitResult;
+
+	uint8 bBlockingHit = Hit.bBlockingHit ? 1 : 0;
+	uint8 bHasImpact = (Hit.bBlockingHit || Hit.HitObjectHandle.IsValid()) ? 1 : 0;
+	Ar.SerializeBits(&bBlockingHit, 1);
+	Ar.SerializeBits(&bHasImpact, 1);
+
+	// Start is absolute, the rest is relative to it and therefore small enough to pack into few bits
+	bOutSuccess = SerializePackedVector<10, 24>(Hit.TraceStart, Ar);
+
+	FVector TraceDelta = Hit.TraceEnd - Hit.TraceStart;
+	bOutSuccess &= SerializePackedVector<10, 24>(TraceDelta, Ar);
+
+	FVector ImpactOffset = Hit.ImpactPoint - Hit.TraceStart;
+	uint16 QuantizedTime = 0;
+	uint16 EncodedNormal = 0;
+	if (bHasImpact)
+	{
+		bOutSuccess &= SerializePackedVector<10, 24>(ImpactOffset, Ar);
+
+		QuantizedTime = uint16(FMath::Clamp(FMath::RoundToInt(Hit.Time * 65535.0f), 0, 65535));
+		Ar << QuantizedTime;
+
+		EncodedNormal = LyraTargetData::EncodeOctahedralNormal16(Hit.ImpactNormal);
+		Ar << EncodedNormal;
+
+		Ar << Hit.HitObjectHandle;
+		Ar << Hit.Component;
+		Ar << Hit.PhysMaterial;
+	}
 
 	Ar << CartridgeID;
 
+	if (Ar.IsLoading())
+	{
+		Hit.bBlockingHit = (bBlockingHit != 0);
+		Hit.bStartPenetrating = false;
+		Hit.PenetrationDepth = 0.0f;
+		Hit.FaceIndex = INDEX_NONE;
+		Hit.Item = INDEX_NONE;
+		Hit.ElementIndex = INDEX_NONE;
+		Hit.MyItem = INDEX_NONE;
+		Hit.BoneName = NAME_None;
+		Hit.MyBoneName = NAME_None;
+		Hit.TraceEnd = Hit.TraceStart + TraceDelta;
+
+		if (bHasImpact)
+		{
+			Hit.Time = QuantizedTime / 65535.0f;
+			Hit.ImpactPoint = Hit.TraceStart + ImpactOffset;
+			Hit.Location = Hit.TraceStart + (TraceDelta * Hit.Time);
+			Hit.Distance = TraceDelta.Size() * Hit.Time;
+			Hit.ImpactNormal = LyraTargetData::DecodeOctahedralNormal16(EncodedNormal);
+			Hit.Normal = Hit.ImpactNormal;
+		}
+		else
+		{
+			// Misses are located at the end of the trace (see TraceBulletsInCartridge)
+			Hit.Time = 1.0f;
+			Hit.ImpactPoint = Hit.TraceEnd;
+			Hit.Location = Hit.TraceEnd;
+			Hit.Distance = TraceDelta.Size();
+			Hit.ImpactNormal = FVector::ZeroVector;
+			Hit.Normal = FVector::ZeroVector;
+			Hit.HitObjectHandle = FActorInstanceHandle();
+			Hit.Component = nullptr;
+			Hit.PhysMaterial = nullptr;
+		}
+	}
+
 	return true;
 }
 
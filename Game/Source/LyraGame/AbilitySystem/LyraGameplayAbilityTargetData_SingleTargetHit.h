@@ -11,6 +11,12 @@
 class FArchive;
 struct FGameplayEffectContextHandle;
 
+namespace LyraTargetData
+{
+	// Unit vector packed into 16 bits with an octahedral mapping (8 bits per axis), roughly 1 degree of precision
+	LYRAGAME_API uint16 EncodeOctahedralNormal16(const FVector& Normal);
+	LYRAGAME_API FVector DecodeOctahedralNormal16(uint16 Encoded);
+};
 
 /** Game-specific additions to SingleTargetHit tracking */
 USTRUCT()
@@ -22,12 +28,30 @@ struct FLyraGameplayAbilityTargetData_SingleTargetHit : public FGameplayAbilityT
 		: CartridgeID(-1)
 	{ }
 
+	virtual TArray<TWeakObjectPtr<AActor>> GetActors() const override;
 	virtual void AddTargetDataToContext(FGameplayEffectContextHandle& Context, bool bIncludeActorArray) const override;
 
 	/** ID to allow the identification of multiple bullets that were part of the same cartridge */
 	UPROPERTY()
 	int32 CartridgeID;
 
+	/**
+	 * Every hit of the shot on this target when several were folded into this one, see
+	 * ULyraGameplayAbility_RangedWeapon::BatchHitsPerTarget.  Effects applied through this target data are applied
+	 * once for all of them.  NOT replicated
+	 */
+	TArray<FHitResult> BatchedHits;
+
+	/** Set when the hit was folded into the BatchedHits of an earlier one, effects are not applied through it again. NOT replicated */
+	bool bFoldedIntoBatch = false;
+
+	/**
+	 * Compact replacement for FHitResult::NetSerialize.  TraceStart is sent at 0.1uu precision, the other positions
+	 * relative to it, the impact normal as 16 bit octahedral and fields the server does not use (or can recompute
+	 * from the trace) are left out:
+	 *	Location and Distance come back from Time, Normal is the impact normal, bone names, face and item indices,
+	 *	penetration info are dropped.
+	 */
 	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
 
 	virtual UScriptStruct* GetScriptStruct() const override
@@ -34,6 +34,7 @@ bool FLyraGameplayEffectContext::NetSerialize(FArchive& Ar, class UPackageMap* M
 
 	// Not serialized for post-activation use:
 	// CartridgeID
+	// BatchedHits
 
 	return true;
 }
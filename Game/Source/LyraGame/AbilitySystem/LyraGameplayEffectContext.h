@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include "Engine/HitResult.h"
 #include "GameplayEffectTypes.h"
 #include "HAL/Platform.h"
 #include "UObject/Class.h"
@@ -68,6 +69,10 @@ public:
 	UPROPERTY()
 	int32 CartridgeID = -1;
 
+	/** Every hit on the target when several hits of one shot were folded into a single application, the hit result is the first of them. NOT replicated */
+	UPROPERTY()
+	TArray<FHitResult> BatchedHits;
+
 protected:
 	/** Ability Source object (should implement ILyraAbilitySourceInterface). NOT replicated currently */
 	UPROPERTY()
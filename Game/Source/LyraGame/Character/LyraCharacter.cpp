@@ -44,6 +44,7 @@
 #include "UObject/Object.h"
 #include "UObject/ObjectPtr.h"
 #include "UObject/UObjectBaseUtility.h"
+#include "Weapons/LyraLagCompensationSubsystem.h"
 
 #include UE_INLINE_GENERATED_CPP_BY_NAME(LyraCharacter)
 
@@ -137,6 +138,14 @@ void ALyraCharacter::BeginPlay()
 	{
 		LyraSettingsShared = GetLyraSettingsShared();
 	}
+
+	if (HasAuthority())
+	{
+		if (ULyraLagCompensationSubsystem* LagCompensation = UWorld::GetSubsystem<ULyraLagCompensationSubsystem>(World))
+		{
+			LagCompensation->RegisterCharacter(this);
+		}
+	}
 }
 
 void ALyraCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
@@ -153,6 +162,11 @@ void ALyraCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
 			SignificanceManager->UnregisterObject(this);
 		}
 	}
+
+	if (ULyraLagCompensationSubsystem* LagCompensation = UWorld::GetSubsystem<ULyraLagCompensationSubsystem>(World))
+	{
+		LagCompensation->UnregisterCharacter(this);
+	}
 }
 
 void ALyraCharacter::Reset()
@@ -0,0 +1,133 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Character/LyraCharacterMovementAsync.h"
+
+#include "Character/LyraMovementVelocity.h"
+
+// Must match ULyraCharacterMovementComponent::CalcVelocity, both call into the same LyraMovement functions.
+// RVO avoidance is the one exception, characters using it stay on the game thread (see ShouldUseAsyncMovement).
+void FLyraCharacterMovementComponentAsyncInput::CalcVelocity(float DeltaTime, float Friction, bool bFluid, float BrakingDeceleration, FCharacterMovementComponentAsyncOutput& Output) const
+{
+	const bool bMovingOnGround = IsMovingOnGround(Output);
+	const bool bFalling = IsFalling(Output);
+
+	if (!bMovingOnGround && !bFalling)
+	{
+		FCharacterMovementComponentAsyncInput::CalcVelocity(DeltaTime, Friction, bFluid, BrakingDeceleration, Output);
+		return;
+	}
+
+	if (DeltaTime < MIN_TICK_TIME)
+	{
+		return;
+	}
+
+	FLyraCharacterMovementComponentAsyncOutput& LyraOutput = static_cast<FLyraCharacterMovementComponentAsyncOutput&>(Output);
+
+	Friction = FMath::Max(0.f, Friction);
+	const float MaxAccel = GetMaxAcceleration();
+	const float MaxSpeed = GetMaxSpeed(Output);
+
+	// Path following (AI) may turn Velocity directly and hands back an extra acceleration towards its target.
+	FVector RequestedAcceleration = FVector::ZeroVector;
+	float RequestedSpeed = 0.0f;
+	const bool bHasRequestedAcceleration = ApplyRequestedMove(DeltaTime, MaxAccel, MaxSpeed, Friction, BrakingDeceleration, RequestedAcceleration, RequestedSpeed, Output);
+
+	if (bForceMaxAccel)
+	{
+		Output.Acceleration = (Output.Acceleration.SizeSquared() > SMALL_NUMBER) ? (Output.Acceleration.GetSafeNormal() * MaxAccel)
+			: (MaxAccel * (Output.Velocity.SizeSquared() < SMALL_NUMBER ? UpdatedComponentInput->GetForwardVector() : Output.Velocity.GetSafeNormal()));
+		Output.AnalogInputModifier = 1.f;
+	}
+
+	if (bMovingOnGround && (LyraOutput.TimeSinceLastAirborne >= NoFrictionAfterLandingTime))
+	{
+		LyraMovement::ApplyFriction(Output.Velocity, DeltaTime, Friction, 1.0f, StopSpeed);
+	}
+
+	if (bFluid)
+	{
+		Output.Velocity = Output.Velocity * (1.f - FMath::Min(Friction * DeltaTime, 1.f));
+	}
+
+	const FVector& InputAcceleration = Output.Acceleration;
+	const double AccelerationSizeSquared = InputAcceleration.SizeSquared();
+	const FVector AccelerationDirection = (AccelerationSizeSquared < SMALL_NUMBER) ? FVector::ZeroVector : (InputAcceleration * (1.f / FMath::Sqrt(AccelerationSizeSquared)));
+	const float AccelerationAmount = InputAcceleration.Size();
+	const float WishSpeed = FMath::Max(MaxSpeed * Output.AnalogInputModifier, MinAnalogWalkSpeed);
+
+	if (bMovingOnGround)
+	{
+		LyraMovement::ApplyAcceleration(Output.Velocity, DeltaTime, 1.0f, AccelerationDirection, WishSpeed, AccelerationAmount);
+	}
+	else
+	{
+		LyraMovement::ApplyAirAcceleration(Output.Velocity, DeltaTime, 1.0f, AccelerationDirection, WishSpeed, MaxFallAirSpeed, AccelerationAmount);
+	}
+
+	// Requested move acceleration is applied like the engine does, clamped to the requested speed.
+	if (bHasRequestedAcceleration && !RequestedAcceleration.IsZero())
+	{
+		const float NewMaxRequestedSpeed = IsExceedingMaxSpeed(RequestedSpeed, Output) ? Output.Velocity.Size() : RequestedSpeed;
+		Output.Velocity += RequestedAcceleration * DeltaTime;
+		Output.Velocity = Output.Velocity.GetClampedToMaxSize(NewMaxRequestedSpeed);
+	}
+}
+
+float FLyraCharacterMovementComponentAsyncInput::GetMaxSpeed(FCharacterMovementComponentAsyncOutput& Output) const
+{
+	float Speed = FCharacterMovementComponentAsyncInput::GetMaxSpeed(Output);
+
+	if (bIsSlowWalking)
+	{
+		Speed *= SlowWalkingMaxSpeedMultiplier;
+	}
+
+	return Speed;
+}
+
+float FLyraCharacterMovementComponentAsyncInput::GetMaxAcceleration() const
+{
+	return MaxAirAcceleration;
+}
+
+void FLyraCharacterMovementComponentAsyncCallback::OnPreSimulate_Internal()
+{
+	const FLyraCharacterMovementComponentAsyncInput* Input = GetConsumerInput_Internal();
+	if (!Input || !Input->bInitialized || !Input->SimState.IsValid())
+	{
+		return;
+	}
+
+	const float DeltaSeconds = GetDeltaTime_Internal();
+
+	FLyraCharacterMovementComponentAsyncOutput& SimState = *Input->SimState;
+
+	// Take over what the game thread changed on its own since the last revision
+	if (Input->GameThreadRevision != SimState.GameThreadRevision)
+	{
+		SimState.Velocity = Input->GameThreadVelocity;
+		SimState.MovementMode = Input->GameThreadMovementMode;
+		SimState.bForceNextFloorCheck = true;
+		SimState.GameThreadRevision = Input->GameThreadRevision;
+	}
+
+	// The path following request only lives for one move, like the game thread move consumes it.
+	SimState.bHasRequestedVelocity = Input->bHasRequestedVelocity;
+	SimState.bRequestedMoveWithMaxSpeed = Input->bRequestedMoveWithMaxSpeed;
+	SimState.RequestedVelocity = Input->RequestedVelocity;
+
+	Input->Simulate(DeltaSeconds, SimState);
+
+	// Same bookkeeping as ULyraCharacterMovementComponent::OnMovementUpdated.
+	if (Input->IsFalling(SimState))
+	{
+		SimState.TimeSinceLastAirborne = 0.0f;
+	}
+	else
+	{
+		SimState.TimeSinceLastAirborne += DeltaSeconds;
+	}
+
+	GetProducerOutputData_Internal() = SimState;
+}
@@ -0,0 +1,71 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CharacterMovementComponentAsync.h"
+#include "Chaos/SimCallbackObject.h"
+
+struct FLyraCharacterMovementComponentAsyncOutput;
+
+/**
+ * FLyraCharacterMovementComponentAsyncInput
+ *
+ *	Async (physics thread) input for ULyraCharacterMovementComponent.
+ *	Carries the bhop tuning and overrides the velocity rules so the async path moves exactly like the game thread path.
+ */
+struct LYRAGAME_API FLyraCharacterMovementComponentAsyncInput : public FCharacterMovementComponentAsyncInput
+{
+	float MaxAirAcceleration = 0.0f;
+	float StopSpeed = 0.0f;
+	float MaxFallAirSpeed = 0.0f;
+	float NoFrictionAfterLandingTime = 0.0f;
+	float SlowWalkingMaxSpeedMultiplier = 1.0f;
+	bool bIsSlowWalking = false;
+
+	// Path following request (RequestDirectMove) made since the last move.
+	FVector RequestedVelocity = FVector::ZeroVector;
+	bool bHasRequestedVelocity = false;
+	bool bRequestedMoveWithMaxSpeed = false;
+
+	// Simulation state owned by the component, carried across physics steps.
+	TSharedPtr<FLyraCharacterMovementComponentAsyncOutput, ESPMode::ThreadSafe> SimState;
+
+	// Latest state the game thread set on its own (launches, movement mode changes, teleports), sent with every input.
+	// The physics thread takes it over once for each new revision.
+	FVector GameThreadVelocity = FVector::ZeroVector;
+	TEnumAsByte<EMovementMode> GameThreadMovementMode = MOVE_None;
+	uint32 GameThreadRevision = 0;
+
+	//~FCharacterMovementComponentAsyncInput interface
+	virtual void CalcVelocity(float DeltaTime, float Friction, bool bFluid, float BrakingDeceleration, FCharacterMovementComponentAsyncOutput& Output) const override;
+	virtual float GetMaxSpeed(FCharacterMovementComponentAsyncOutput& Output) const override;
+	virtual float GetMaxAcceleration() const override;
+	//~End of FCharacterMovementComponentAsyncInput interface
+};
+
+/**
+ * FLyraCharacterMovementComponentAsyncOutput
+ *
+ *	Async simulation state for ULyraCharacterMovementComponent, persisted between physics steps and
+ *	copied out to the game thread after each step.
+ */
+struct LYRAGAME_API FLyraCharacterMovementComponentAsyncOutput : public FCharacterMovementComponentAsyncOutput
+{
+	// Physics thread copy of ULyraCharacterMovementComponent::TimeSinceLastAirborne.
+	float TimeSinceLastAirborne = 0.0f;
+
+	// Revision of the game thread state this simulation has taken over, outputs from older revisions are stale.
+	uint32 GameThreadRevision = 0;
+};
+
+/**
+ * FLyraCharacterMovementComponentAsyncCallback
+ *
+ *	Physics solver callback that runs the Lyra character movement simulation off the game thread.
+ */
+class LYRAGAME_API FLyraCharacterMovementComponentAsyncCallback : public Chaos::TSimCallbackObject<FLyraCharacterMovementComponentAsyncInput, FLyraCharacterMovementComponentAsyncOutput>
+{
+private:
+
+	virtual void OnPreSimulate_Internal() override;
+};
@@ -4,6 +4,11 @@
 
 #include "AbilitySystemComponent.h"
 #include "AbilitySystemGlobals.h"
+#include "Async/Async.h"
+#include "Character/LyraCharacterMovementAsync.h"
+#include "Character/LyraMovementBudgetSubsystem.h"
+#include "Character/LyraMovementTelemetry.h"
+#include "Character/LyraMovementVelocity.h"
 #include "CharacterMovementComponentAsync.h"
 #include "CollisionQueryParams.h"
 #include "Components/CapsuleComponent.h"
@@ -13,11 +18,19 @@
 #include "LyraCharacter.h"
 #include "Engine/EngineTypes.h"
 #include "Engine/World.h"
+#include "EngineUtils.h"
 #include "GameFramework/Character.h"
 #include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "LyraLogChannels.h"
 #include "Math/Vector.h"
 #include "Misc/AssertionMacros.h"
+#include "Misc/DateTime.h"
+#include "Misc/Paths.h"
 #include "NativeGameplayTags.h"
+#include "Net/UnrealNetwork.h"
+#include "Physics/Experimental/PhysScene_Chaos.h"
+#include "PBDRigidsSolver.h"
 #include "Stats/Stats2.h"
 #include "UObject/NameTypes.h"
 #include "UObject/ObjectPtr.h"
@@ -44,6 +57,15 @@ FORCEINLINE FVector GetSafeNormalPrecise(const FVector& V)
 	}
 }
 
+DECLARE_STATS_GROUP(TEXT("LyraMovement"), STATGROUP_LyraMovement, STATCAT_Advanced);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Server Moves"), STAT_LyraMovement_ServerMoves, STATGROUP_LyraMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Server Corrections"), STAT_LyraMovement_ServerCorrections, STATGROUP_LyraMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Simulated Characters"), STAT_LyraMovement_Characters, STATGROUP_LyraMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Simulation Iterations"), STAT_LyraMovement_Iterations, STATGROUP_LyraMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Collision Sweeps"), STAT_LyraMovement_Sweeps, STATGROUP_LyraMovement);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Sweeps Per Character"), STAT_LyraMovement_SweepsPerCharacter, STATGROUP_LyraMovement);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Capped Steps"), STAT_LyraMovement_CappedSteps, STATGROUP_LyraMovement);
+
 //Gravity 
 constexpr float DesiredGravity = -1143.0f;
 
@@ -51,11 +73,121 @@ namespace LyraCharacter
 {
 	static float GroundTraceDistance = 100000.0f;
 	FAutoConsoleVariableRef CVar_GroundTraceDistance(TEXT("LyraCharacter.GroundTraceDistance"), GroundTraceDistance, TEXT("Distance to trace down when generating ground information."), ECVF_Cheat);
+
+	// Server side move / correction counters, see Lyra.Movement.DumpCorrections.
+	static int64 NumServerMoves = 0;
+	static int64 NumServerCorrections = 0;
+	static double CorrectionCountersResetTime = 0.0;
+
+	static void RecordServerMove(bool bIsCorrection)
+	{
+		INC_DWORD_STAT(STAT_LyraMovement_ServerMoves);
+		++NumServerMoves;
+
+		if (bIsCorrection)
+		{
+			INC_DWORD_STAT(STAT_LyraMovement_ServerCorrections);
+			++NumServerCorrections;
+		}
+	}
+
+	static FAutoConsoleCommand CmdDumpCorrections(
+		TEXT("Lyra.Movement.DumpCorrections"),
+		TEXT("Prints how many client moves the server has corrected with ClientAdjustPosition since the last reset. Pass 'reset' to clear the counters."),
+		FConsoleCommandWithArgsDelegate::CreateStatic([](const TArray<FString>& Args)
+		{
+			const double Now = FPlatformTime::Seconds();
+			const double Elapsed = Now - CorrectionCountersResetTime;
+			const double CorrectionPercent = (NumServerMoves > 0) ? (100.0 * double(NumServerCorrections) / double(NumServerMoves)) : 0.0;
+
+			UE_LOG(LogLyra, Log, TEXT("Movement corrections: %lld of %lld server moves (%.2f%%), %.2f corrections/sec over %.1f sec"),
+				NumServerCorrections, NumServerMoves, CorrectionPercent, (Elapsed > 0.0) ? (double(NumServerCorrections) / Elapsed) : 0.0, Elapsed);
+
+			if ((Args.Num() > 0) && Args[0].Equals(TEXT("reset"), ESearchCase::IgnoreCase))
+			{
+				NumServerMoves = 0;
+				NumServerCorrections = 0;
+				CorrectionCountersResetTime = Now;
+			}
+		}));
+
+	static int32 ProxyExtrapolationMode = 1;
+	FAutoConsoleVariableRef CVar_ProxyExtrapolationMode(TEXT("LyraCharacter.ProxyExtrapolationMode"), ProxyExtrapolationMode, TEXT("How simulated proxies use the replicated acceleration between updates. 0: straight line (engine default), 1: air acceleration while falling, 2: air and ground acceleration."), ECVF_Default);
+
+	static float MaxProxyExtrapolationTime = 0.25f;
+	FAutoConsoleVariableRef CVar_MaxProxyExtrapolationTime(TEXT("LyraCharacter.MaxProxyExtrapolationTime"), MaxProxyExtrapolationTime, TEXT("Stop extrapolating a simulated proxy with its replicated acceleration after this many seconds without a movement update."), ECVF_Default);
+
+	static bool bAsyncGroundTrace = true;
+	FAutoConsoleVariableRef CVar_AsyncGroundTrace(TEXT("LyraCharacter.AsyncGroundTrace"), bAsyncGroundTrace, TEXT("Use amortized async traces for ground information while airborne instead of a synchronous trace every frame."), ECVF_Default);
+
+	static float GroundTraceRefreshDistance = 50.0f;
+	FAutoConsoleVariableRef CVar_GroundTraceRefreshDistance(TEXT("LyraCharacter.GroundTraceRefreshDistance"), GroundTraceRefreshDistance, TEXT("Horizontal distance from the last ground trace that triggers a new async ground trace."), ECVF_Default);
+
+	static bool bUseLegacyCalcVelocity = false;
+	FAutoConsoleVariableRef CVar_UseLegacyCalcVelocity(TEXT("LyraCharacter.UseLegacyCalcVelocity"), bUseLegacyCalcVelocity, TEXT("Use the old two pass CalcVelocity (engine integration followed by the bhop integration). For A/B comparisons only."), ECVF_Cheat);
+
+	static int32 AsyncMovementMode = 0;
+	FAutoConsoleVariableRef CVar_AsyncMovement(TEXT("LyraCharacter.AsyncMovement"), AsyncMovementMode, TEXT("Where character movement is simulated. 0: game thread, 1: physics thread for server driven characters (bots), requires p.TickPhysicsAsync / bTickPhysicsAsync."), ECVF_Default);
+
+	static bool bAdaptiveSubstepping = true;
+	FAutoConsoleVariableRef CVar_AdaptiveSubstepping(TEXT("LyraCharacter.AdaptiveSubstepping"), bAdaptiveSubstepping, TEXT("Pick the movement sub-step length from the character speed and the distance to nearby geometry instead of MaxSimulationTimeStep alone."), ECVF_Default);
+
+	static int32 ServerIterationBudget = 0;
+	FAutoConsoleVariableRef CVar_ServerIterationBudget(TEXT("LyraCharacter.ServerIterationBudget"), ServerIterationBudget, TEXT("Movement sub-steps the server aims to spend per frame across all characters. Split evenly over the moves of the previous frame into a per-move sub-step cap, which owning clients predict with and send back with each move. 0 disables the budget."), ECVF_Default);
+
+	static int32 MinMoveSubstepCap = 4;
+	FAutoConsoleVariableRef CVar_MinMoveSubstepCap(TEXT("LyraCharacter.MinMoveSubstepCap"), MinMoveSubstepCap, TEXT("Lowest per-move sub-step cap the server hands out under LyraCharacter.ServerIterationBudget, and accepts from clients."), ECVF_Default);
+
+	static void RecordSweep(const UWorld* World)
+	{
+		INC_DWORD_STAT(STAT_LyraMovement_Sweeps);
+		if (ULyraMovementBudgetSubsystem* MovementBudget = World ? World->GetSubsystem<ULyraMovementBudgetSubsystem>() : nullptr)
+		{
+			MovementBudget->RecordSweep();
+		}
+	}
+
+	static bool bRecordTelemetry = false;
+	FAutoConsoleVariableRef CVar_RecordTelemetry(TEXT("LyraCharacter.Telemetry"), bRecordTelemetry, TEXT("Record a movement telemetry sample per character per tick, see Lyra.Movement.Telemetry.Flush."), ECVF_Default);
+
+	static int32 TelemetryCapacity = 8192;
+	FAutoConsoleVariableRef CVar_TelemetryCapacity(TEXT("LyraCharacter.TelemetryCapacity"), TelemetryCapacity, TEXT("Samples kept per character by the movement telemetry ring buffer (rounded up to a power of two). Only read when recording starts."), ECVF_Default);
+
+	static FAutoConsoleCommandWithWorldAndArgs CmdFlushTelemetry(
+		TEXT("Lyra.Movement.Telemetry.Flush"),
+		TEXT("Writes the recorded movement telemetry of every Lyra character to Saved/Telemetry. Pass 'bin' for the binary format, CSV otherwise."),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+		{
+			if (!World)
+			{
+				return;
+			}
+
+			const bool bBinary = (Args.Num() > 0) && Args[0].Equals(TEXT("bin"), ESearchCase::IgnoreCase);
+			const FString Directory = FPaths::ProjectSavedDir() / TEXT("Telemetry");
+			const FString Timestamp = FDateTime::Now().ToString();
+
+			int32 NumFlushed = 0;
+			for (TActorIterator<ALyraCharacter> It(World); It; ++It)
+			{
+				const ULyraCharacterMovementComponent* MoveComp = Cast<ULyraCharacterMovementComponent>(It->GetCharacterMovement());
+				const FString Filename = Directory / FString::Printf(TEXT("Movement_%s_%s.%s"), *It->GetName(), *Timestamp, bBinary ? TEXT("bin") : TEXT("csv"));
+
+				if (MoveComp && MoveComp->FlushTelemetry(Filename, bBinary))
+				{
+					++NumFlushed;
+				}
+			}
+
+			UE_LOG(LogLyra, Log, TEXT("Flushing movement telemetry for %d characters to %s"), NumFlushed, *Directory);
+		}));
 };
 
 
 ULyraCharacterMovementComponent::ULyraCharacterMovementComponent()
 {
+	SetNetworkMoveDataContainer(LyraNetworkMoveDataContainer);
+
 	//Variables crucial for adjusting behaviour of movement
 	//First of all Friction and Braking
 	GroundFriction = 4.0f;
@@ -111,7 +243,7 @@ ULyraCharacterMovementComponent::ULyraCharacterMovementComponent()
 ULyraCharacterMovementComponent::ULyraCharacterMovementComponent(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
 {
-
+	SetNetworkMoveDataContainer(LyraNetworkMoveDataContainer);
 }
 
 void ULyraCharacterMovementComponent::TickComponent(float DeltaTime, ELevelTick TickType,
@@ -119,71 +251,243 @@ void ULyraCharacterMovementComponent::TickComponent(float DeltaTime, ELevelTick
 {
 	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
 	
-	if (IsFalling())
-	{
-		LastAirTimestamp = GetWorld()->GetTimeSeconds();
-	}
-	
 	if (!bCanSlowWalk && bIsSlowWalking)
 	{
 		bIsSlowWalking = false;
 	}
+
+	if (LyraCharacter::bRecordTelemetry)
+	{
+		RecordTelemetry(DeltaTime);
+	}
+}
+
+void ULyraCharacterMovementComponent::RecordTelemetry(float DeltaTime)
+{
+	if (!HasValidData())
+	{
+		return;
+	}
+
+	if (!TelemetryBuffer.IsValid())
+	{
+		TelemetryBuffer = MakeShared<FLyraMovementTelemetryBuffer, ESPMode::ThreadSafe>(LyraCharacter::TelemetryCapacity);
+	}
+
+	const bool bAirborne = IsFalling() || IsSurfing();
+
+	FLyraMovementTelemetrySample Sample;
+	Sample.Time = GetWorld()->GetTimeSeconds();
+	Sample.Speed = Velocity.Size();
+	Sample.HorizontalSpeed = Velocity.Size2D();
+	Sample.MovementMode = MovementMode;
+	Sample.CustomMovementMode = CustomMovementMode;
+	Sample.Flags = PendingTelemetryFlags;
+
+	if (IsMovingOnGround())
+	{
+		Sample.SurfaceNormal = FVector3f(CurrentFloor.HitResult.ImpactNormal);
+	}
+	else if (IsSurfing())
+	{
+		Sample.SurfaceNormal = FVector3f(SurfPlaneNormal);
+	}
+
+	if (PendingTelemetryFlags & FLyraMovementTelemetrySample::Flag_Jumped)
+	{
+		Sample.JumpSpeedGain = Sample.HorizontalSpeed - TelemetryLastJumpHorizontalSpeed;
+		TelemetryLastJumpHorizontalSpeed = Sample.HorizontalSpeed;
+		TelemetryAirTime = 0.0f;
+	}
+
+	if (bAirborne)
+	{
+		TelemetryAirTime += DeltaTime;
+	}
+	else if (bTelemetryWasAirborne)
+	{
+		Sample.Flags |= FLyraMovementTelemetrySample::Flag_Landed;
+	}
+
+	Sample.AirTime = TelemetryAirTime;
+
+	if (!bAirborne)
+	{
+		TelemetryAirTime = 0.0f;
+	}
+
+	bTelemetryWasAirborne = bAirborne;
+	PendingTelemetryFlags = 0;
+
+	TelemetryBuffer->Push(Sample);
+}
+
+bool ULyraCharacterMovementComponent::FlushTelemetry(const FString& Filename, bool bBinary) const
+{
+	if (!TelemetryBuffer.IsValid() || (TelemetryBuffer->GetNumPushed() == 0))
+	{
+		return false;
+	}
+
+	// The buffer is shared with the writer, so the component may go away while the file is written.
+	TSharedPtr<FLyraMovementTelemetryBuffer, ESPMode::ThreadSafe> Buffer = TelemetryBuffer;
+	AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [Buffer, Filename, bBinary]()
+	{
+		TArray<FLyraMovementTelemetrySample> Samples;
+		Buffer->Snapshot(Samples);
+
+		const bool bSaved = bBinary ? FLyraMovementTelemetryBuffer::SaveToBinary(Samples, Filename) : FLyraMovementTelemetryBuffer::SaveToCSV(Samples, Filename);
+		if (!bSaved)
+		{
+			UE_LOG(LogLyra, Warning, TEXT("Failed to write movement telemetry to %s"), *Filename);
+		}
+	});
+
+	return true;
 }
 
 bool ULyraCharacterMovementComponent::DoJump(bool bReplayingMoves)
 {
 	const auto bJumped = Super::DoJump(bReplayingMoves);
+
+	if (bJumped && !bReplayingMoves)
+	{
+		PendingTelemetryFlags |= FLyraMovementTelemetrySample::Flag_Jumped;
+	}
+
 	return bJumped;
 }
 
 void ULyraCharacterMovementComponent::CalcVelocity(float DeltaTime, float Friction, bool bFluid,
 	float BrakingDeceleration)
 {
-	Super::CalcVelocity(DeltaTime, Friction, bFluid, BrakingDeceleration);
-	//Usind the modes created in GetMaxSpeed I keep track of them
+	if (LyraCharacter::bUseLegacyCalcVelocity)
+	{
+		CalcVelocity_Legacy(DeltaTime, Friction, bFluid, BrakingDeceleration);
+		return;
+	}
+
+	// Swimming, flying and custom modes keep the engine integration, the bhop solver below only owns walking and falling.
+	if (!IsMovingOnGround() && !IsFalling())
+	{
+		Super::CalcVelocity(DeltaTime, Friction, bFluid, BrakingDeceleration);
+		return;
+	}
+
+	// Same early out as the engine: root motion and simulated proxies get their velocity from elsewhere.
+	if (!HasValidData() || HasAnimRootMotion() || DeltaTime < MIN_TICK_TIME || (CharacterOwner && CharacterOwner->GetLocalRole() == ROLE_SimulatedProxy && !bWasSimulatingRootMotion))
+	{
+		return;
+	}
 
-	//I also need to check if the friction is correct
 	Friction = FMath::Max(0.f, Friction);
-	const auto MaxAcceleration = GetMaxAcceleration();
-	auto MaxSpeed = GetMaxSpeed();
-	//Check if pathing is correct
+	const auto MaxAccel = GetMaxAcceleration();
+	const auto MaxSpeed = GetMaxSpeed();
 
-	auto bRequestedZeroAcceleration = true;
+	// Path following (AI) may turn Velocity directly and hands back an extra acceleration towards its target.
 	auto RequestedAcceleration = FVector::ZeroVector;
 	auto RequestedSpeed = 0.0f;
-	if(ApplyRequestedMove(DeltaTime, MaxAcceleration, Friction, MaxSpeed, BrakingDeceleration,RequestedAcceleration, RequestedSpeed))
+	const auto bHasRequestedAcceleration = ApplyRequestedMove(DeltaTime, MaxAccel, MaxSpeed, Friction, BrakingDeceleration, RequestedAcceleration, RequestedSpeed);
+
+	if (bForceMaxAccel)
 	{
-		RequestedAcceleration = RequestedAcceleration.GetClampedToMaxSize(MaxAcceleration);
-		bRequestedZeroAcceleration = false;
+		Acceleration = (Acceleration.SizeSquared() > SMALL_NUMBER) ? (Acceleration.GetSafeNormal() * MaxAccel)
+			: (MaxAccel * (Velocity.SizeSquared() < SMALL_NUMBER ? UpdatedComponent->GetForwardVector() : Velocity.GetSafeNormal()));
+		AnalogInputModifier = 1.f;
 	}
 
 	//Friction
-	if(ShouldApplyGroundFriction())
+	if (ShouldApplyGroundFriction())
 	{
 		ApplyFriction(DeltaTime, Friction, 1.0f, StopSpeed);
 	}
 
+	if (bFluid)
+	{
+		Velocity = Velocity * (1.f - FMath::Min(Friction * DeltaTime, 1.f));
+	}
+
 	//Acceleration
 	const auto AccelerationDirection = GetSafeNormalPrecise(Acceleration);
 	const auto AccelerationAmount = Acceleration.Size();
-	
-	if(IsMovingOnGround())
+	const auto WishSpeed = GetInputWishSpeed(MaxSpeed);
+
+	if (IsMovingOnGround())
+	{
+		ApplyAcceleration(DeltaTime, 1.0f, AccelerationDirection, WishSpeed, AccelerationAmount);
+	}
+	else
+	{
+		ApplyAirAcceleration(DeltaTime, 1.0f, AccelerationDirection, WishSpeed, MaxFallAirSpeed, AccelerationAmount);
+	}
+
+	// Requested move acceleration is applied like the engine does, clamped to the requested speed.
+	if (bHasRequestedAcceleration && !RequestedAcceleration.IsZero())
+	{
+		const float NewMaxRequestedSpeed = IsExceedingMaxSpeed(RequestedSpeed) ? Velocity.Size() : RequestedSpeed;
+		Velocity += RequestedAcceleration * DeltaTime;
+		Velocity = Velocity.GetClampedToMaxSize(NewMaxRequestedSpeed);
+	}
+
+	if (bUseRVOAvoidance)
+	{
+		CalcAvoidanceVelocity(DeltaTime);
+	}
+}
+
+void ULyraCharacterMovementComponent::CalcVelocity_Legacy(float DeltaTime, float Friction, bool bFluid,
+	float BrakingDeceleration)
+{
+	// Previous behavior: engine integration followed by a second bhop integration on top of it.
+	Super::CalcVelocity(DeltaTime, Friction, bFluid, BrakingDeceleration);
+
+	Friction = FMath::Max(0.f, Friction);
+	const auto MaxAcceleration = GetMaxAcceleration();
+	auto MaxSpeed = GetMaxSpeed();
+
+	auto RequestedAcceleration = FVector::ZeroVector;
+	auto RequestedSpeed = 0.0f;
+	ApplyRequestedMove(DeltaTime, MaxAcceleration, Friction, MaxSpeed, BrakingDeceleration, RequestedAcceleration, RequestedSpeed);
+
+	if (ShouldApplyGroundFriction())
+	{
+		ApplyFriction(DeltaTime, Friction, 1.0f, StopSpeed);
+	}
+
+	const auto AccelerationDirection = GetSafeNormalPrecise(Acceleration);
+	const auto AccelerationAmount = Acceleration.Size();
+
+	if (IsMovingOnGround())
 	{
 		ApplyAcceleration(DeltaTime, 1.0f, AccelerationDirection, MaxSpeed, AccelerationAmount);
 	}
-	else if(IsFalling())
+	else if (IsFalling())
 	{
-		//TODO Implement AirAccel
-		ApplyAirAcceleration(DeltaTime, 1.0f, AccelerationDirection, MaxSpeed, MaxFallAirSpeed,AccelerationAmount);
+		ApplyAirAcceleration(DeltaTime, 1.0f, AccelerationDirection, MaxSpeed, MaxFallAirSpeed, AccelerationAmount);
 	}
+}
 
-	
+float ULyraCharacterMovementComponent::GetInputWishSpeed(float MaxSpeed) const
+{
+	// Partial analog input asks for a proportionally lower speed, like the engine's MaxInputSpeed.
+	return FMath::Max(MaxSpeed * AnalogInputModifier, GetMinAnalogSpeed());
 }
 
 void ULyraCharacterMovementComponent::SimulateMovement(float DeltaTime)
 {
 	if (bHasReplicatedAcceleration)
 	{
+		if (bNetworkUpdateReceived)
+		{
+			TimeSinceProxyUpdate = 0.0f;
+		}
+		else
+		{
+			TimeSinceProxyUpdate += DeltaTime;
+		}
+
+		ExtrapolateProxyVelocity(DeltaTime);
+
 		// Preserve our replicated acceleration
 		const FVector OriginalAcceleration = Acceleration;
 		Super::SimulateMovement(DeltaTime);
@@ -195,9 +499,40 @@ void ULyraCharacterMovementComponent::SimulateMovement(float DeltaTime)
 	}
 }
 
+void ULyraCharacterMovementComponent::ExtrapolateProxyVelocity(float DeltaTime)
+{
+	// Between net updates the engine moves proxies in a straight line along the last replicated velocity.
+	// Running the bhop acceleration with the replicated acceleration bends that line into the air-strafe curve,
+	// which is what lets remote characters update less often without visibly snapping at surf speeds.
+	const int32 Mode = LyraCharacter::ProxyExtrapolationMode;
+	if ((Mode <= 0) || (DeltaTime < MIN_TICK_TIME) || HasAnimRootMotion() || (TimeSinceProxyUpdate > LyraCharacter::MaxProxyExtrapolationTime))
+	{
+		return;
+	}
+
+	const auto AccelerationDirection = GetSafeNormalPrecise(Acceleration);
+	const auto AccelerationAmount = Acceleration.Size();
+	if (AccelerationAmount <= 0.0)
+	{
+		return;
+	}
+
+	const auto WishSpeed = GetMaxSpeed();
+
+	if (IsFalling())
+	{
+		ApplyAirAcceleration(DeltaTime, 1.0f, AccelerationDirection, WishSpeed, MaxFallAirSpeed, AccelerationAmount);
+	}
+	else if (IsMovingOnGround() && (Mode >= 2))
+	{
+		ApplyAcceleration(DeltaTime, 1.0f, AccelerationDirection, WishSpeed, AccelerationAmount);
+	}
+}
+
 bool ULyraCharacterMovementComponent::CanAttemptJump() const
 {
-	bool bCanAttemptJump = IsJumpAllowed();
+	// No jumping off a ramp, surfers have to ride it out.
+	bool bCanAttemptJump = IsJumpAllowed() && !IsSurfing();
 	if (IsMovingOnGround())
 	{
 		const float FloorZ = FVector(0.0f, 0.0f, 1.0f) | CurrentFloor.HitResult.ImpactNormal;
@@ -221,57 +556,54 @@ bool ULyraCharacterMovementComponent::ShouldLimitAirControl(float DeltaTime, con
 void ULyraCharacterMovementComponent::ApplyAcceleration(float DeltaTime, float SurfaceFriction,
 	const FVector& WishDirection, float WishSpeed, float Acceleration)
 {
-	const auto VelocityProgress = FVector::DotProduct(Velocity, WishDirection);
-	const auto AddSpeed = WishSpeed - VelocityProgress;
-	if (AddSpeed <= 0.0f)
-	{
-		return;
-	}
-
-	auto AccelerationSpeed = Acceleration * WishSpeed * SurfaceFriction * DeltaTime;
-	AccelerationSpeed = FMath::Min(AccelerationSpeed, AddSpeed);
-
-	Velocity += AccelerationSpeed * WishDirection;
+	LyraMovement::ApplyAcceleration(Velocity, DeltaTime, SurfaceFriction, WishDirection, WishSpeed, Acceleration);
 }
 
 
 void ULyraCharacterMovementComponent::SetSlowWalking(bool bNewIsSlowWalking)
 {
+	bIsSlowWalking = bNewIsSlowWalking && bCanSlowWalk;
 }
 
 
 void ULyraCharacterMovementComponent::ApplyAirAcceleration(float DeltaTime, float SurfaceFriction,
 	const FVector& WishDirection, float WishSpeed, float MaxAirWishSpeed, float Acceleration)
 {
-
-	const auto AirWishSpeed = FMath::Min(WishSpeed, MaxAirWishSpeed);
-	const auto VelocityProgress = FVector::DotProduct(Velocity, WishDirection);
-	const auto AddSpeed = AirWishSpeed - VelocityProgress;
-	if(AddSpeed <= 0.0f)
-		return;
-
-	auto AccelerationSpeed = Acceleration * WishSpeed * SurfaceFriction * DeltaTime;
-
-	AccelerationSpeed = FMath::Min(AccelerationSpeed, AddSpeed);
-
-	Velocity += AccelerationSpeed * WishDirection;
+	LyraMovement::ApplyAirAcceleration(Velocity, DeltaTime, SurfaceFriction, WishDirection, WishSpeed, MaxAirWishSpeed, Acceleration);
 }
 
 void ULyraCharacterMovementComponent::ApplyFriction(float DeltaTime, float CharacterFriction, float SurfaceFriction,
 	float StopSpeed)
 {
-	const auto Speed = Velocity.Size();
-	auto ControlSpeed = FMath::Max(StopSpeed, Speed);
-	auto SpeedDrop = ControlSpeed * CharacterFriction * SurfaceFriction * DeltaTime;
-
-	Velocity *= FMath::Max(0.0f, Speed - SpeedDrop) / Speed;
+	LyraMovement::ApplyFriction(Velocity, DeltaTime, CharacterFriction, SurfaceFriction, StopSpeed);
 }
 
 bool ULyraCharacterMovementComponent::ShouldApplyGroundFriction()
 {
 	//if on ground OR time window expired
 	//TODO:: include option for autobhop
-	return (IsMovingOnGround() && GetWorld()->TimeSeconds >= LastAirTimestamp + NoFrictionAfterLandingTime);
+	return (IsMovingOnGround() && !IsInNoFrictionWindow());
+}
+
+bool ULyraCharacterMovementComponent::IsInNoFrictionWindow() const
+{
+	return (TimeSinceLastAirborne < NoFrictionAfterLandingTime);
+}
+
+void ULyraCharacterMovementComponent::OnMovementUpdated(float DeltaSeconds, const FVector& OldLocation, const FVector& OldVelocity)
+{
+	Super::OnMovementUpdated(DeltaSeconds, OldLocation, OldVelocity);
+
+	// Advanced per simulated move rather than from world time, so client prediction, replays and
+	// the server all see the same landing window for the same sequence of moves.
+	if (IsFalling())
+	{
+		TimeSinceLastAirborne = 0.0f;
+	}
+	else
+	{
+		TimeSinceLastAirborne += DeltaSeconds;
+	}
 }
 
 float ULyraCharacterMovementComponent::GetMaxAcceleration() const
@@ -284,6 +616,9 @@ float ULyraCharacterMovementComponent::GetMaxAcceleration() const
 	case MOVE_Flying:
 		return MaxAirAcceleration;
 
+	case MOVE_Custom:
+		return IsSurfing() ? MaxAirAcceleration : MaxAcceleration;
+
 	case MOVE_None:
 	default:
 		return 0.f;
@@ -295,98 +630,878 @@ void ULyraCharacterMovementComponent::InitializeComponent()
 	Super::InitializeComponent();
 }
 
+FNetworkPredictionData_Client* ULyraCharacterMovementComponent::GetPredictionData_Client() const
+{
+	if (ClientPredictionData == nullptr)
+	{
+		ULyraCharacterMovementComponent* MutableThis = const_cast<ULyraCharacterMovementComponent*>(this);
+		MutableThis->ClientPredictionData = new FNetworkPredictionData_Client_Lyra(*this);
+	}
 
+	return ClientPredictionData;
+}
 
-void ULyraCharacterMovementComponent::OnMovementModeChanged(EMovementMode PreviousMovementMode,
-	uint8 PreviousCustomMode)
+void ULyraCharacterMovementComponent::UpdateFromCompressedFlags(uint8 Flags)
 {
-	
-	
+	Super::UpdateFromCompressedFlags(Flags);
+
+	SetSlowWalking((Flags & FSavedMove_Lyra::FLAG_SlowWalking) != 0);
 }
 
-auto ULyraCharacterMovementComponent::GetGroundInfo() -> const FLyraCharacterGroundInfo&
+void ULyraCharacterMovementComponent::MoveAutonomous(float ClientTimeStamp, float DeltaTime, uint8 CompressedFlags, const FVector& NewAccel)
 {
-	if (!CharacterOwner || (GFrameCounter == CachedGroundInfo.LastUpdateFrame))
-    	{
-    		return CachedGroundInfo;
-    	}
-    
-    	if (MovementMode == MOVE_Walking)
-    	{
-    		CachedGroundInfo.GroundHitResult = CurrentFloor.HitResult;
-    		CachedGroundInfo.GroundDistance = 0.0f;
-    	}
-    	else
-    	{
-    		const UCapsuleComponent* CapsuleComp = CharacterOwner->GetCapsuleComponent();
-    		check(CapsuleComp);
-    
-    		const float CapsuleHalfHeight = CapsuleComp->GetUnscaledCapsuleHalfHeight();
-    		const ECollisionChannel CollisionChannel = (UpdatedComponent ? UpdatedComponent->GetCollisionObjectType() : ECC_Pawn);
-    		const FVector TraceStart(GetActorLocation());
-    		const FVector TraceEnd(TraceStart.X, TraceStart.Y, (TraceStart.Z - LyraCharacter::GroundTraceDistance - CapsuleHalfHeight));
-    
-    		FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(LyraCharacterMovementComponent_GetGroundInfo), false, CharacterOwner);
-    		FCollisionResponseParams ResponseParam;
-    		InitCollisionParams(QueryParams, ResponseParam);
-    
-    		FHitResult HitResult;
-    		GetWorld()->LineTraceSingleByChannel(HitResult, TraceStart, TraceEnd, CollisionChannel, QueryParams, ResponseParam);
-    
-    		CachedGroundInfo.GroundHitResult = HitResult;
-    		CachedGroundInfo.GroundDistance = LyraCharacter::GroundTraceDistance;
-    
-    		if (MovementMode == MOVE_NavWalking)
-    		{
-    			CachedGroundInfo.GroundDistance = 0.0f;
-    		}
-    		else if (HitResult.bBlockingHit)
-    		{
-    			CachedGroundInfo.GroundDistance = FMath::Max((HitResult.Distance - CapsuleHalfHeight), 0.0f);
-    		}
-    	}
-    
-    	CachedGroundInfo.LastUpdateFrame = GFrameCounter;
-    
-    	return CachedGroundInfo;
+	// Client replays already restored the cap in FSavedMove_Lyra::PrepMoveFor.
+	if (CharacterOwner && (CharacterOwner->GetLocalRole() == ROLE_Authority))
+	{
+		const FLyraCharacterNetworkMoveData* MoveData = static_cast<const FLyraCharacterNetworkMoveData*>(GetCurrentNetworkMoveData());
+		const uint8 ClientCap = MoveData ? MoveData->MoveSubstepCap : 0;
+
+		// Run the move with the cap the client predicted it with, kept within what the server could have handed out:
+		// never looser than the server's own cap, never tighter than LyraCharacter.MinMoveSubstepCap, and no cap at all
+		// while the server has no budget.  Moves predicted with another cap are corrected like any other mismatch.
+		if (MoveSubstepCap > 0)
+		{
+			const int32 LowestCap = FMath::Clamp(LyraCharacter::MinMoveSubstepCap, 1, int32(MoveSubstepCap));
+			CurrentMoveSubstepCap = (ClientCap == 0) ? MoveSubstepCap : uint8(FMath::Clamp(int32(ClientCap), LowestCap, int32(MoveSubstepCap)));
+		}
+		else
+		{
+			CurrentMoveSubstepCap = 0;
+		}
+	}
+
+	Super::MoveAutonomous(ClientTimeStamp, DeltaTime, CompressedFlags, NewAccel);
 }
 
-void ULyraCharacterMovementComponent::SetReplicatedAcceleration(const FVector& InAcceleration)
+void ULyraCharacterMovementComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
 {
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
+	DOREPLIFETIME_CONDITION(ThisClass, MoveSubstepCap, COND_AutonomousOnly);
 }
 
-FRotator ULyraCharacterMovementComponent::GetDeltaRotation(float DeltaTime) const
+void ULyraCharacterMovementComponent::PerformMovement(float DeltaTime)
 {
+	INC_DWORD_STAT(STAT_LyraMovement_Characters);
 
-	return Super::GetDeltaRotation(DeltaTime);
+	ULyraMovementBudgetSubsystem* MovementBudget = GetWorld() ? GetWorld()->GetSubsystem<ULyraMovementBudgetSubsystem>() : nullptr;
+	if (MovementBudget)
+	{
+		MovementBudget->RecordCharacter();
+
+		if ((GetOwnerRole() == ROLE_Authority) && (GetNetMode() != NM_Client))
+		{
+			MoveSubstepCap = MovementBudget->GetMoveSubstepCap(LyraCharacter::ServerIterationBudget, LyraCharacter::MinMoveSubstepCap);
+		}
+	}
+
+	// Nothing known about nearby geometry until the first sweep of this move.
+	NearestGeometryDistance = TNumericLimits<float>::Max();
+
+	Super::PerformMovement(DeltaTime);
+
+	if (MovementBudget)
+	{
+		SET_FLOAT_STAT(STAT_LyraMovement_SweepsPerCharacter, MovementBudget->GetSweepsPerCharacter());
+	}
+}
+
+bool ULyraCharacterMovementComponent::IsMoveSubstepCapReached(int32 Iterations) const
+{
+	return (CurrentMoveSubstepCap > 0) && (Iterations >= CurrentMoveSubstepCap);
 }
 
+float ULyraCharacterMovementComponent::GetSimulationTimeStep(float RemainingTime, int32 Iterations) const
+{
+	INC_DWORD_STAT(STAT_LyraMovement_Iterations);
 
+	if (IsMoveSubstepCapReached(Iterations))
+	{
+		// Out of sub-steps for this move, finish it in one step like the engine does at MaxSimulationIterations.
+		INC_DWORD_STAT(STAT_LyraMovement_CappedSteps);
+		return FMath::Max(MIN_TICK_TIME, RemainingTime);
+	}
 
-float ULyraCharacterMovementComponent::GetMaxSpeed() const
+	if (!LyraCharacter::bAdaptiveSubstepping)
+	{
+		return Super::GetSimulationTimeStep(RemainingTime, Iterations);
+	}
+
+	if (Iterations >= MaxSimulationIterations)
+	{
+		// Out of iterations, finish the move in one step like the engine does.
+		return FMath::Max(MIN_TICK_TIME, RemainingTime);
+	}
+
+	// Short steps near geometry and at high speed, long steps in open space and at low speed.
+	const float StepDistance = FMath::Clamp(NearestGeometryDistance, MinSubstepDistance, FMath::Max(MinSubstepDistance, MaxSubstepDistance));
+	const float Speed = Velocity.Size();
+	const float MaxTimeStep = (Speed > KINDA_SMALL_NUMBER) ? FMath::Clamp(StepDistance / Speed, MIN_TICK_TIME, MaxAdaptiveTimeStep) : MaxAdaptiveTimeStep;
+
+	if (RemainingTime > MaxTimeStep)
+	{
+		// Same split as the engine, so the last step is never much shorter than the others.
+		RemainingTime = FMath::Min(MaxTimeStep, RemainingTime * 0.5f);
+	}
+
+	return FMath::Max(MIN_TICK_TIME, RemainingTime);
+}
+
+bool ULyraCharacterMovementComponent::MoveUpdatedComponentImpl(const FVector& Delta, const FQuat& NewRotation, bool bSweep, FHitResult* OutHit, ETeleportType Teleport)
 {
-	auto Speed = 0.0f;
-	switch (MovementMode)
+	const bool bMoved = Super::MoveUpdatedComponentImpl(Delta, NewRotation, bSweep, OutHit, Teleport);
+
+	if (bSweep && !Delta.IsNearlyZero())
 	{
-	case MOVE_Walking:
-	case MOVE_NavWalking:
-	case MOVE_Falling:
-		Speed = (IsCrouching() ? MaxWalkSpeedCrouched : MaxWalkSpeed);
-		break;
-	case MOVE_Flying:
-		Speed = MaxFlySpeed;
-		break;
-	case MOVE_None:
-	default:
-		Speed = 0.f;
-		break;
+		LyraCharacter::RecordSweep(GetWorld());
+
+		// Floors are moved along, not into, only walls and ramps shorten the following sub-steps.
+		if (OutHit && OutHit->IsValidBlockingHit() && !IsWalkable(*OutHit))
+		{
+			NearestGeometryDistance = FMath::Min(NearestGeometryDistance, float(OutHit->Distance));
+		}
 	}
 
-	if (bIsSlowWalking)
+	return bMoved;
+}
+
+void ULyraCharacterMovementComponent::ComputeFloorDist(const FVector& CapsuleLocation, float LineDistance, float SweepDistance, FFindFloorResult& OutFloorResult, float SweepRadius, const FHitResult* DownwardSweepResult) const
+{
+	// Only a new sweep when the engine could not reuse the downward sweep of the move.
+	if (!DownwardSweepResult)
 	{
-		Speed *= SlowWalkingMaxSpeedMultiplier;
+		LyraCharacter::RecordSweep(GetWorld());
 	}
 
-	return Speed;
-}
\ No newline at end of file
+	Super::ComputeFloorDist(CapsuleLocation, LineDistance, SweepDistance, OutFloorResult, SweepRadius, DownwardSweepResult);
+}
+
+void ULyraCharacterMovementComponent::OnUnregister()
+{
+	UnregisterLyraAsyncCallback();
+
+	Super::OnUnregister();
+}
+
+bool ULyraCharacterMovementComponent::ShouldUseAsyncMovement() const
+{
+	if (LyraCharacter::AsyncMovementMode <= 0 || !HasValidData() || !UPhysicsSettings::Get()->bTickPhysicsAsync)
+	{
+		return false;
+	}
+
+	// Only characters the server drives on its own.  Player moves are predicted and replayed
+	// through the saved move path, which has to stay on the game thread.
+	if (CharacterOwner->GetLocalRole() != ROLE_Authority || CharacterOwner->GetRemoteRole() == ROLE_AutonomousProxy || (CharacterOwner->IsLocallyControlled() && CharacterOwner->IsPlayerControlled()))
+	{
+		return false;
+	}
+
+	// Root motion and surfing are not supported by the async simulation.  Neither is RVO avoidance, which
+	// needs the avoidance manager on the game thread.
+	return (MovementMode != MOVE_Custom) && !bUseRVOAvoidance && !HasAnimRootMotion() && !CurrentRootMotion.HasActiveRootMotionSources();
+}
+
+void ULyraCharacterMovementComponent::RegisterLyraAsyncCallback()
+{
+	if (LyraAsyncCallback)
+	{
+		return;
+	}
+
+	UWorld* World = GetWorld();
+	FPhysScene* PhysScene = World ? World->GetPhysicsScene() : nullptr;
+	if (!PhysScene || !PhysScene->GetSolver())
+	{
+		return;
+	}
+
+	LyraAsyncCallback = PhysScene->GetSolver()->CreateAndRegisterSimCallbackObject_External<FLyraCharacterMovementComponentAsyncCallback>();
+
+	// Seed the physics thread with the current game thread state.
+	LyraAsyncSimState = MakeShared<FLyraCharacterMovementComponentAsyncOutput, ESPMode::ThreadSafe>();
+	LyraAsyncSimState->Velocity = Velocity;
+	LyraAsyncSimState->MovementMode = MovementMode;
+	LyraAsyncSimState->TimeSinceLastAirborne = TimeSinceLastAirborne;
+
+	LyraAsyncGameThreadVelocity = Velocity;
+	LyraAsyncGameThreadMovementMode = MovementMode;
+	LyraAsyncSimState->GameThreadRevision = LyraAsyncGameThreadRevision;
+	bLyraAsyncTeleported = false;
+}
+
+void ULyraCharacterMovementComponent::UnregisterLyraAsyncCallback()
+{
+	if (!LyraAsyncCallback)
+	{
+		return;
+	}
+
+	UWorld* World = GetWorld();
+	FPhysScene* PhysScene = World ? World->GetPhysicsScene() : nullptr;
+	if (PhysScene && PhysScene->GetSolver())
+	{
+		PhysScene->GetSolver()->UnregisterAndFreeSimCallbackObject_External(LyraAsyncCallback);
+	}
+
+	LyraAsyncCallback = nullptr;
+	LyraAsyncSimState.Reset();
+}
+
+void ULyraCharacterMovementComponent::ControlledCharacterMove(const FVector& InputVector, float DeltaSeconds)
+{
+	// New moves use the latest cap, FSavedMove_Lyra records it for the server and for replays.
+	CurrentMoveSubstepCap = MoveSubstepCap;
+
+	if (!ShouldUseAsyncMovement())
+	{
+		// Switching back to the game thread, the last applied output is the current state.
+		UnregisterLyraAsyncCallback();
+
+		Super::ControlledCharacterMove(InputVector, DeltaSeconds);
+		return;
+	}
+
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_LyraCharacterMovement_AsyncMove);
+
+	RegisterLyraAsyncCallback();
+	if (!LyraAsyncCallback)
+	{
+		Super::ControlledCharacterMove(InputVector, DeltaSeconds);
+		return;
+	}
+
+	// Pick up everything the physics thread finished since the last frame, only the latest step matters.  Steps simulated
+	// before the physics thread took over the latest game thread change would undo it.
+	while (Chaos::TSimCallbackOutputHandle<FLyraCharacterMovementComponentAsyncOutput> Output = LyraAsyncCallback->PopOutputData_External())
+	{
+		if (Output->GameThreadRevision == LyraAsyncGameThreadRevision)
+		{
+			ApplyAsyncOutput(*Output);
+		}
+	}
+
+	// Jump input is consumed here just like the game thread move does.
+	CharacterOwner->CheckJumpInput(DeltaSeconds);
+
+	if (FLyraCharacterMovementComponentAsyncInput* AsyncInput = LyraAsyncCallback->GetProducerInputData_External())
+	{
+		// Pooled inputs start out empty, set them up the way UCharacterMovementComponent::BuildAsyncInput does.
+		if (!AsyncInput->bInitialized)
+		{
+			AsyncInput->Initialize<FCharacterMovementComponentAsyncInput::FCharacterInput, FCharacterMovementComponentAsyncInput::FUpdatedComponentAsyncInput>();
+		}
+
+		FillAsyncInput(InputVector, *AsyncInput);
+	}
+
+	CharacterOwner->ClearJumpInput(DeltaSeconds);
+
+	// The path following request went to the physics thread, consume it like PerformMovement does.
+	LastUpdateRequestedVelocity = bHasRequestedVelocity ? RequestedVelocity : FVector::ZeroVector;
+	bHasRequestedVelocity = false;
+}
+
+void ULyraCharacterMovementComponent::FillAsyncInput(const FVector& InputVector, FCharacterMovementComponentAsyncInput& AsyncInput)
+{
+	Super::FillAsyncInput(InputVector, AsyncInput);
+
+	// The engine's own async path (p.AsyncCharacterMovement) fills plain inputs, only ours carry the bhop state.
+	if (!LyraAsyncCallback)
+	{
+		return;
+	}
+
+	FLyraCharacterMovementComponentAsyncInput& LyraInput = static_cast<FLyraCharacterMovementComponentAsyncInput&>(AsyncInput);
+	LyraInput.MaxAirAcceleration = MaxAirAcceleration;
+	LyraInput.StopSpeed = StopSpeed;
+	LyraInput.MaxFallAirSpeed = MaxFallAirSpeed;
+	LyraInput.NoFrictionAfterLandingTime = NoFrictionAfterLandingTime;
+	LyraInput.SlowWalkingMaxSpeedMultiplier = SlowWalkingMaxSpeedMultiplier;
+	LyraInput.bIsSlowWalking = bIsSlowWalking;
+	LyraInput.RequestedVelocity = RequestedVelocity;
+	LyraInput.bHasRequestedVelocity = bHasRequestedVelocity;
+	LyraInput.bRequestedMoveWithMaxSpeed = bRequestedMoveWithMaxSpeed;
+	LyraInput.SimState = LyraAsyncSimState;
+
+	// Anything that differs from the last output applied was changed on the game thread (LaunchCharacter, SetMovementMode,
+	// a teleport) and becomes a new revision for the physics thread to take over.
+	if (bLyraAsyncTeleported || !Velocity.Equals(LyraAsyncGameThreadVelocity) || (MovementMode != LyraAsyncGameThreadMovementMode))
+	{
+		LyraAsyncGameThreadVelocity = Velocity;
+		LyraAsyncGameThreadMovementMode = MovementMode;
+		++LyraAsyncGameThreadRevision;
+		bLyraAsyncTeleported = false;
+	}
+
+	// Sent every frame, the physics thread may skip inputs when the game thread runs faster than it.
+	LyraInput.GameThreadVelocity = LyraAsyncGameThreadVelocity;
+	LyraInput.GameThreadMovementMode = LyraAsyncGameThreadMovementMode;
+	LyraInput.GameThreadRevision = LyraAsyncGameThreadRevision;
+}
+
+void ULyraCharacterMovementComponent::ApplyAsyncOutput(FCharacterMovementComponentAsyncOutput& Output)
+{
+	Super::ApplyAsyncOutput(Output);
+
+	if (!LyraAsyncCallback)
+	{
+		return;
+	}
+
+	TimeSinceLastAirborne = static_cast<FLyraCharacterMovementComponentAsyncOutput&>(Output).TimeSinceLastAirborne;
+
+	LyraAsyncGameThreadVelocity = Velocity;
+	LyraAsyncGameThreadMovementMode = MovementMode;
+}
+
+void ULyraCharacterMovementComponent::OnTeleported()
+{
+	Super::OnTeleported();
+
+	// The physics thread keeps simulating from its own state, it has to be told.
+	bLyraAsyncTeleported = (LyraAsyncCallback != nullptr);
+}
+
+void ULyraCharacterMovementComponent::ServerMoveHandleClientError(float ClientTimeStamp, float DeltaTime, const FVector& Accel, const FVector& RelativeClientLocation, UPrimitiveComponent* ClientMovementBase, FName ClientBaseBoneName, uint8 ClientMovementMode)
+{
+	Super::ServerMoveHandleClientError(ClientTimeStamp, DeltaTime, Accel, RelativeClientLocation, ClientMovementBase, ClientBaseBoneName, ClientMovementMode);
+
+	// A pending adjustment that is not a good move ack becomes a ClientAdjustPosition RPC.
+	const FNetworkPredictionData_Server_Character* ServerData = GetPredictionData_Server_Character();
+	const bool bIsCorrection = ServerData && (ServerData->PendingAdjustment.TimeStamp > 0.0f) && !ServerData->PendingAdjustment.bAckGoodMove;
+	LyraCharacter::RecordServerMove(bIsCorrection);
+
+	if (bIsCorrection)
+	{
+		PendingTelemetryFlags |= FLyraMovementTelemetrySample::Flag_Correction;
+	}
+}
+
+void ULyraCharacterMovementComponent::OnClientCorrectionReceived(FNetworkPredictionData_Client_Character& ClientData, float TimeStamp, FVector NewLocation, FVector NewVelocity, UPrimitiveComponent* NewBase, FName NewBaseBoneName, bool bHasBase, bool bBaseRelativePosition, uint8 ServerMovementMode)
+{
+	Super::OnClientCorrectionReceived(ClientData, TimeStamp, NewLocation, NewVelocity, NewBase, NewBaseBoneName, bHasBase, bBaseRelativePosition, ServerMovementMode);
+
+	PendingTelemetryFlags |= FLyraMovementTelemetrySample::Flag_Correction;
+}
+
+
+
+void ULyraCharacterMovementComponent::OnMovementModeChanged(EMovementMode PreviousMovementMode,
+	uint8 PreviousCustomMode)
+{
+	Super::OnMovementModeChanged(PreviousMovementMode, PreviousCustomMode);
+
+	// The cached ramp is only valid for the surf session that found it.
+	if (!IsSurfing())
+	{
+		bHasSurfPlane = false;
+	}
+}
+
+bool ULyraCharacterMovementComponent::IsSurfing() const
+{
+	return (MovementMode == MOVE_Custom) && (CustomMovementMode == uint8(ELyraCustomMovementMode::Surf)) && UpdatedComponent;
+}
+
+bool ULyraCharacterMovementComponent::IsSurfableSurface(const FHitResult& Hit) const
+{
+	return Hit.IsValidBlockingHit() && !IsWalkable(Hit) && (Hit.ImpactNormal.Z >= SurfMinNormalZ);
+}
+
+void ULyraCharacterMovementComponent::HandleImpact(const FHitResult& Hit, float TimeSlice, const FVector& MoveDelta)
+{
+	Super::HandleImpact(Hit, TimeSlice, MoveDelta);
+
+	if ((MovementMode == MOVE_Falling) && IsSurfableSurface(Hit))
+	{
+		PendingSurfHit = Hit;
+		bHasPendingSurfHit = true;
+	}
+}
+
+void ULyraCharacterMovementComponent::PhysFalling(float deltaTime, int32 Iterations)
+{
+	bHasPendingSurfHit = false;
+
+	Super::PhysFalling(deltaTime, Iterations);
+
+	// Start surfing from the next move rather than switching modes halfway through the falling step.
+	if (bHasPendingSurfHit && HasValidData() && (MovementMode == MOVE_Falling))
+	{
+		bHasPendingSurfHit = false;
+		CacheSurfPlane(PendingSurfHit);
+		ClipVelocityToSurfPlane();
+		SetMovementMode(MOVE_Custom, uint8(ELyraCustomMovementMode::Surf));
+	}
+}
+
+void ULyraCharacterMovementComponent::PhysCustom(float deltaTime, int32 Iterations)
+{
+	if (CustomMovementMode == uint8(ELyraCustomMovementMode::Surf))
+	{
+		PhysSurf(deltaTime, Iterations);
+		return;
+	}
+
+	Super::PhysCustom(deltaTime, Iterations);
+}
+
+int32 ULyraCharacterMovementComponent::GetSurfSubstepCount(float DeltaTime, int32 Iterations) const
+{
+	// Keep every sub-step shorter than SurfMaxSubstepDistance so fast surfers cannot skip over a ramp seam.
+	const float StepDistance = FMath::Max(SurfMaxSubstepDistance, 1.0f);
+	int32 MaxSubsteps = FMath::Max(SurfMaxSubsteps, 1);
+	if (CurrentMoveSubstepCap > 0)
+	{
+		MaxSubsteps = FMath::Clamp(CurrentMoveSubstepCap - Iterations, 1, MaxSubsteps);
+	}
+
+	const int32 NumSubsteps = FMath::CeilToInt(Velocity.Size() * DeltaTime / StepDistance);
+	return FMath::Clamp(NumSubsteps, 1, MaxSubsteps);
+}
+
+void ULyraCharacterMovementComponent::CacheSurfPlane(const FHitResult& Hit)
+{
+	SurfPlaneNormal = Hit.ImpactNormal;
+	SurfPlaneLocation = Hit.Location;
+	LastSurfProbeLocation = Hit.Location;
+	bHasSurfPlane = true;
+}
+
+void ULyraCharacterMovementComponent::ClipVelocityToSurfPlane()
+{
+	// Remove only the part of the velocity going into the ramp, the rest carries on along it.
+	const double Backoff = FVector::DotProduct(Velocity, SurfPlaneNormal);
+	if (Backoff < 0.0)
+	{
+		Velocity -= SurfPlaneNormal * Backoff;
+	}
+}
+
+bool ULyraCharacterMovementComponent::ProbeSurfPlane()
+{
+	const FVector Location = UpdatedComponent->GetComponentLocation();
+	const FVector Direction = bHasSurfPlane ? -SurfPlaneNormal : FVector::DownVector;
+
+	// The capsule is usually touching the ramp already.  A sweep starting in contact reports a start penetrating
+	// hit, which is not a valid blocking hit, so start pulled back off the ramp.
+	const float PullBack = SurfContactTolerance + MAX_FLOOR_DIST;
+	const FVector Start = Location - Direction * PullBack;
+	const FVector End = Location + Direction * (SurfContactTolerance * 2.0f + KINDA_SMALL_NUMBER);
+
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(LyraSurfProbe), false, CharacterOwner);
+	FCollisionResponseParams ResponseParam;
+	InitCollisionParams(QueryParams, ResponseParam);
+
+	LyraCharacter::RecordSweep(GetWorld());
+
+	FHitResult Hit;
+	const bool bHit = GetWorld()->SweepSingleByChannel(Hit, Start, End, UpdatedComponent->GetComponentQuat(), UpdatedComponent->GetCollisionObjectType(),
+		GetPawnCapsuleCollisionShape(SHRINK_None), QueryParams, ResponseParam);
+
+	LastSurfProbeLocation = Location;
+
+	if (bHit && IsSurfableSurface(Hit))
+	{
+		CacheSurfPlane(Hit);
+		return true;
+	}
+
+	// Off the end of the ramp, or onto something walkable.  Falling handles both, including the landing.
+	SetMovementMode(MOVE_Falling);
+	return false;
+}
+
+void ULyraCharacterMovementComponent::PhysSurf(float deltaTime, int32 Iterations)
+{
+	if (deltaTime < MIN_TICK_TIME)
+	{
+		return;
+	}
+
+	if (!bHasSurfPlane && !ProbeSurfPlane())
+	{
+		StartNewPhysics(deltaTime, Iterations);
+		return;
+	}
+
+	const FVector Gravity(0.f, 0.f, GetGravityZ());
+	const auto AccelerationDirection = GetSafeNormalPrecise(Acceleration);
+	const auto AccelerationAmount = Acceleration.Size();
+	const auto WishSpeed = GetInputWishSpeed(GetMaxSpeed());
+
+	const int32 NumSubsteps = GetSurfSubstepCount(deltaTime, Iterations);
+	const float SubstepTime = deltaTime / NumSubsteps;
+	float RemainingTime = deltaTime;
+
+	for (int32 Substep = 0; (Substep < NumSubsteps) && (RemainingTime >= MIN_TICK_TIME); ++Substep)
+	{
+		Iterations++;
+		INC_DWORD_STAT(STAT_LyraMovement_Iterations);
+		const float TimeTick = (Substep == NumSubsteps - 1) ? RemainingTime : SubstepTime;
+		RemainingTime -= TimeTick;
+
+		// Same air rules as falling, then the ramp takes away whatever pushes into it.
+		Velocity += Gravity * TimeTick;
+		ApplyAirAcceleration(TimeTick, 1.0f, AccelerationDirection, WishSpeed, MaxFallAirSpeed, AccelerationAmount);
+		ClipVelocityToSurfPlane();
+
+		const FVector Adjusted = Velocity * TimeTick;
+		FHitResult Hit(1.f);
+		SafeMoveUpdatedComponent(Adjusted, UpdatedComponent->GetComponentQuat(), true, Hit);
+
+		if (Hit.IsValidBlockingHit())
+		{
+			if (IsValidLandingSpot(UpdatedComponent->GetComponentLocation(), Hit))
+			{
+				ProcessLanded(Hit, RemainingTime + TimeTick * (1.f - Hit.Time), Iterations);
+				return;
+			}
+
+			if (IsSurfableSurface(Hit))
+			{
+				// Ramp seam or the next ramp, it becomes the cached plane.
+				CacheSurfPlane(Hit);
+				ClipVelocityToSurfPlane();
+			}
+			else
+			{
+				HandleImpact(Hit, TimeTick, Adjusted);
+				Velocity = FVector::VectorPlaneProject(Velocity, Hit.Normal);
+			}
+
+			SlideAlongSurface(Adjusted, 1.f - Hit.Time, Hit.Normal, Hit, true);
+		}
+
+		if (!HasValidData() || !IsSurfing())
+		{
+			return;
+		}
+	}
+
+	// Moving along the plane keeps the separation at zero, so only sweep again once the character
+	// drifts off it or has travelled far enough that the ramp may have ended.
+	const FVector Location = UpdatedComponent->GetComponentLocation();
+	const double Separation = FVector::DotProduct(Location - SurfPlaneLocation, SurfPlaneNormal);
+	if ((FMath::Abs(Separation) > SurfContactTolerance) || (FVector::DistSquared(Location, LastSurfProbeLocation) > FMath::Square(SurfProbeDistance)))
+	{
+		ProbeSurfPlane();
+	}
+}
+
+auto ULyraCharacterMovementComponent::GetGroundInfo() -> const FLyraCharacterGroundInfo&
+{
+	if (!CharacterOwner || (GFrameCounter == CachedGroundInfo.LastUpdateFrame))
+	{
+		return CachedGroundInfo;
+	}
+
+	if (MovementMode == MOVE_Walking)
+	{
+		CachedGroundInfo.GroundHitResult = CurrentFloor.HitResult;
+		CachedGroundInfo.GroundDistance = 0.0f;
+
+		// Start from a fresh trace the next time we leave the ground.
+		bHasGroundTraceResult = false;
+		PendingGroundTraceHandle = FTraceHandle();
+	}
+	else
+	{
+		const UCapsuleComponent* CapsuleComp = CharacterOwner->GetCapsuleComponent();
+		check(CapsuleComp);
+
+		const float CapsuleHalfHeight = CapsuleComp->GetUnscaledCapsuleHalfHeight();
+		const FVector ActorLocation(GetActorLocation());
+
+		if (LyraCharacter::bAsyncGroundTrace)
+		{
+			UpdateAsyncGroundTrace(ActorLocation, CapsuleHalfHeight);
+		}
+		else
+		{
+			LastGroundTraceHit = TraceGround(ActorLocation, CapsuleHalfHeight);
+			LastGroundTraceStart = ActorLocation;
+			bHasGroundTraceResult = true;
+		}
+
+		CachedGroundInfo.GroundHitResult = LastGroundTraceHit;
+		CachedGroundInfo.GroundDistance = LyraCharacter::GroundTraceDistance;
+
+		if (MovementMode == MOVE_NavWalking)
+		{
+			CachedGroundInfo.GroundDistance = 0.0f;
+		}
+		else if (LastGroundTraceHit.bBlockingHit)
+		{
+			// Measured from the current location so a result traced on an earlier frame is still exact for flat ground.
+			CachedGroundInfo.GroundDistance = FMath::Max((float(ActorLocation.Z - LastGroundTraceHit.Location.Z) - CapsuleHalfHeight), 0.0f);
+		}
+	}
+
+	CachedGroundInfo.LastUpdateFrame = GFrameCounter;
+
+	return CachedGroundInfo;
+}
+
+FHitResult ULyraCharacterMovementComponent::TraceGround(const FVector& TraceStart, float CapsuleHalfHeight) const
+{
+	const ECollisionChannel CollisionChannel = (UpdatedComponent ? UpdatedComponent->GetCollisionObjectType() : ECC_Pawn);
+	const FVector TraceEnd(TraceStart.X, TraceStart.Y, (TraceStart.Z - LyraCharacter::GroundTraceDistance - CapsuleHalfHeight));
+
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(LyraCharacterMovementComponent_GetGroundInfo), false, CharacterOwner);
+	FCollisionResponseParams ResponseParam;
+	InitCollisionParams(QueryParams, ResponseParam);
+
+	FHitResult HitResult;
+	GetWorld()->LineTraceSingleByChannel(HitResult, TraceStart, TraceEnd, CollisionChannel, QueryParams, ResponseParam);
+
+	return HitResult;
+}
+
+void ULyraCharacterMovementComponent::UpdateAsyncGroundTrace(const FVector& ActorLocation, float CapsuleHalfHeight)
+{
+	UWorld* World = GetWorld();
+
+	// Pick up the trace issued on a previous frame.
+	if (PendingGroundTraceHandle.IsValid())
+	{
+		FTraceDatum TraceDatum;
+		if (World->QueryTraceData(PendingGroundTraceHandle, TraceDatum))
+		{
+			LastGroundTraceHit = (TraceDatum.OutHits.Num() > 0) ? TraceDatum.OutHits[0] : FHitResult();
+			LastGroundTraceStart = TraceDatum.Start;
+			bHasGroundTraceResult = true;
+			PendingGroundTraceHandle = FTraceHandle();
+		}
+		else if (!World->IsTraceHandleValid(PendingGroundTraceHandle, false))
+		{
+			PendingGroundTraceHandle = FTraceHandle();
+		}
+	}
+
+	if (!bHasGroundTraceResult)
+	{
+		// Nothing to serve yet (just left the ground), pay for one synchronous trace.
+		LastGroundTraceHit = TraceGround(ActorLocation, CapsuleHalfHeight);
+		LastGroundTraceStart = ActorLocation;
+		bHasGroundTraceResult = true;
+		return;
+	}
+
+	// The result is served until the character is predicted to move far enough sideways that the ground under it may differ.
+	// Vertical movement does not need a new trace, the distance is re-measured from the current location.
+	const FVector PredictedLocation = ActorLocation + (Velocity * World->GetDeltaSeconds());
+	const double PredictedDrift = FVector::Dist2D(PredictedLocation, LastGroundTraceStart);
+
+	if ((PredictedDrift > LyraCharacter::GroundTraceRefreshDistance) && !PendingGroundTraceHandle.IsValid())
+	{
+		const ECollisionChannel CollisionChannel = (UpdatedComponent ? UpdatedComponent->GetCollisionObjectType() : ECC_Pawn);
+		const FVector TraceStart(PredictedLocation);
+		const FVector TraceEnd(TraceStart.X, TraceStart.Y, (TraceStart.Z - LyraCharacter::GroundTraceDistance - CapsuleHalfHeight));
+
+		FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(LyraCharacterMovementComponent_GetGroundInfoAsync), false, CharacterOwner);
+		FCollisionResponseParams ResponseParam;
+		InitCollisionParams(QueryParams, ResponseParam);
+
+		PendingGroundTraceHandle = World->AsyncLineTraceByChannel(EAsyncTraceType::Single, TraceStart, TraceEnd, CollisionChannel, QueryParams, ResponseParam);
+	}
+}
+
+float ULyraCharacterMovementComponent::EstimateTimeToLand()
+{
+	if (IsMovingOnGround())
+	{
+		return 0.0f;
+	}
+
+	const FLyraCharacterGroundInfo& GroundInfo = GetGroundInfo();
+	const float GravityZ = GetGravityZ();
+	if (!IsFalling() || !GroundInfo.GroundHitResult.bBlockingHit || (GravityZ >= 0.0f))
+	{
+		return -1.0f;
+	}
+
+	// Solve GroundDistance + VelocityZ * t + 0.5 * GravityZ * t^2 = 0 for the positive root.
+	const double VelocityZ = Velocity.Z;
+	const double Discriminant = (VelocityZ * VelocityZ) - (2.0 * GravityZ * GroundInfo.GroundDistance);
+
+	return float((VelocityZ + FMath::Sqrt(FMath::Max(Discriminant, 0.0))) / -GravityZ);
+}
+
+void ULyraCharacterMovementComponent::SetReplicatedAcceleration(const FVector& InAcceleration)
+{
+	bHasReplicatedAcceleration = true;
+	Acceleration = InAcceleration;
+}
+
+FRotator ULyraCharacterMovementComponent::GetDeltaRotation(float DeltaTime) const
+{
+
+	return Super::GetDeltaRotation(DeltaTime);
+}
+
+
+
+float ULyraCharacterMovementComponent::GetMaxSpeed() const
+{
+	auto Speed = 0.0f;
+	switch (MovementMode)
+	{
+	case MOVE_Walking:
+	case MOVE_NavWalking:
+	case MOVE_Falling:
+		Speed = (IsCrouching() ? MaxWalkSpeedCrouched : MaxWalkSpeed);
+		break;
+	case MOVE_Flying:
+		Speed = MaxFlySpeed;
+		break;
+	case MOVE_Custom:
+		Speed = IsSurfing() ? MaxWalkSpeed : MaxCustomMovementSpeed;
+		break;
+	case MOVE_None:
+	default:
+		Speed = 0.f;
+		break;
+	}
+
+	if (bIsSlowWalking)
+	{
+		Speed *= SlowWalkingMaxSpeedMultiplier;
+	}
+
+	return Speed;
+}
+
+//////////////////////////////////////////////////////////////////////
+// FSavedMove_Lyra
+
+void FSavedMove_Lyra::Clear()
+{
+	Super::Clear();
+
+	bSavedIsSlowWalking = false;
+	bSavedInNoFrictionWindow = false;
+	SavedTimeSinceLastAirborne = 0.0f;
+
+	bSavedHasSurfPlane = false;
+	SavedSurfPlaneNormal = FVector::UpVector;
+	SavedSurfPlaneLocation = FVector::ZeroVector;
+	SavedLastSurfProbeLocation = FVector::ZeroVector;
+
+	SavedMoveSubstepCap = 0;
+}
+
+uint8 FSavedMove_Lyra::GetCompressedFlags() const
+{
+	uint8 Result = Super::GetCompressedFlags();
+
+	if (bSavedIsSlowWalking)
+	{
+		Result |= FLAG_SlowWalking;
+	}
+
+	return Result;
+}
+
+bool FSavedMove_Lyra::CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const
+{
+	const FSavedMove_Lyra* NewLyraMove = static_cast<const FSavedMove_Lyra*>(NewMove.Get());
+
+	// Combining across a change in bhop state would replay the landing window or slow walk on the wrong frames.
+	if ((bSavedIsSlowWalking != NewLyraMove->bSavedIsSlowWalking) || (bSavedInNoFrictionWindow != NewLyraMove->bSavedInNoFrictionWindow))
+	{
+		return false;
+	}
+
+	// The combined move replays from this move's ramp, so a new ramp (or losing it) has to start a new move.
+	if ((bSavedHasSurfPlane != NewLyraMove->bSavedHasSurfPlane) || (bSavedHasSurfPlane && !SavedSurfPlaneNormal.Equals(NewLyraMove->SavedSurfPlaneNormal, 0.0)))
+	{
+		return false;
+	}
+
+	if (SavedMoveSubstepCap != NewLyraMove->SavedMoveSubstepCap)
+	{
+		return false;
+	}
+
+	return Super::CanCombineWith(NewMove, InCharacter, MaxDelta);
+}
+
+void FSavedMove_Lyra::SetMoveFor(ACharacter* C, float InDeltaTime, FVector const& NewAccel, FNetworkPredictionData_Client_Character& ClientData)
+{
+	Super::SetMoveFor(C, InDeltaTime, NewAccel, ClientData);
+
+	if (const ULyraCharacterMovementComponent* LyraMoveComp = Cast<ULyraCharacterMovementComponent>(C->GetCharacterMovement()))
+	{
+		bSavedIsSlowWalking = LyraMoveComp->bIsSlowWalking;
+		bSavedInNoFrictionWindow = LyraMoveComp->IsInNoFrictionWindow();
+		SavedTimeSinceLastAirborne = LyraMoveComp->TimeSinceLastAirborne;
+
+		bSavedHasSurfPlane = LyraMoveComp->bHasSurfPlane;
+		SavedSurfPlaneNormal = LyraMoveComp->SurfPlaneNormal;
+		SavedSurfPlaneLocation = LyraMoveComp->SurfPlaneLocation;
+		SavedLastSurfProbeLocation = LyraMoveComp->LastSurfProbeLocation;
+
+		SavedMoveSubstepCap = LyraMoveComp->CurrentMoveSubstepCap;
+	}
+}
+
+void FSavedMove_Lyra::PrepMoveFor(ACharacter* C)
+{
+	Super::PrepMoveFor(C);
+
+	// Restore the state this move started with so replays after a correction take the same friction decisions.
+	if (ULyraCharacterMovementComponent* LyraMoveComp = Cast<ULyraCharacterMovementComponent>(C->GetCharacterMovement()))
+	{
+		LyraMoveComp->SetSlowWalking(bSavedIsSlowWalking);
+		LyraMoveComp->TimeSinceLastAirborne = SavedTimeSinceLastAirborne;
+
+		// Surf moves replay against the ramp they were predicted on rather than whatever was cached last
+		LyraMoveComp->bHasSurfPlane = bSavedHasSurfPlane;
+		LyraMoveComp->SurfPlaneNormal = SavedSurfPlaneNormal;
+		LyraMoveComp->SurfPlaneLocation = SavedSurfPlaneLocation;
+		LyraMoveComp->LastSurfProbeLocation = SavedLastSurfProbeLocation;
+
+		LyraMoveComp->CurrentMoveSubstepCap = SavedMoveSubstepCap;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+// FNetworkPredictionData_Client_Lyra
+
+FNetworkPredictionData_Client_Lyra::FNetworkPredictionData_Client_Lyra(const UCharacterMovementComponent& ClientMovement)
+	: Super(ClientMovement)
+{
+}
+
+FSavedMovePtr FNetworkPredictionData_Client_Lyra::AllocateNewMove()
+{
+	return FSavedMovePtr(new FSavedMove_Lyra());
+}
+
+//////////////////////////////////////////////////////////////////////
+// FLyraCharacterNetworkMoveData
+
+void FLyraCharacterNetworkMoveData::ClientFillNetworkMoveData(const FSavedMove_Character& ClientMove, ENetworkMoveType MoveType)
+{
+	Super::ClientFillNetworkMoveData(ClientMove, MoveType);
+
+	MoveSubstepCap = static_cast<const FSavedMove_Lyra&>(ClientMove).SavedMoveSubstepCap;
+}
+
+bool FLyraCharacterNetworkMoveData::Serialize(UCharacterMovementComponent& CharacterMovement, FArchive& Ar, UPackageMap* PackageMap, ENetworkMoveType MoveType)
+{
+	Super::Serialize(CharacterMovement, Ar, PackageMap, MoveType);
+
+	Ar << MoveSubstepCap;
+
+	return !Ar.IsError();
+}
+
+FLyraCharacterNetworkMoveDataContainer::FLyraCharacterNetworkMoveDataContainer()
+{
+	NewMoveData = &LyraMoveData[0];
+	PendingMoveData = &LyraMoveData[1];
+	OldMoveData = &LyraMoveData[2];
+}
@@ -8,15 +8,35 @@
 #include "Math/UnrealMathSSE.h"
 #include "NativeGameplayTags.h"
 #include "UObject/UObjectGlobals.h"
+#include "WorldCollision.h"
 
 #include "LyraCharacterMovementComponent.generated.h"
 
 class UObject;
 class ALyraCharacter;
 struct FFrame;
+struct FLyraCharacterMovementComponentAsyncOutput;
+class FLyraCharacterMovementComponentAsyncCallback;
+class FLyraMovementTelemetryBuffer;
 
 LYRAGAME_API UE_DECLARE_GAMEPLAY_TAG_EXTERN(TAG_Gameplay_MovementStopped);
 
+/**
+ * ELyraCustomMovementMode
+ *
+ *	Custom movement modes used with MOVE_Custom.
+ */
+UENUM(BlueprintType)
+enum class ELyraCustomMovementMode : uint8
+{
+	None	UMETA(Hidden),
+
+	// Sliding along a ramp too steep to walk on, see ULyraCharacterMovementComponent::PhysSurf.
+	Surf,
+
+	MAX		UMETA(Hidden)
+};
+
 USTRUCT(BlueprintType)
 struct FLyraCharacterGroundInfo
 {
@@ -36,6 +56,88 @@ struct FLyraCharacterGroundInfo
 	float GroundDistance;
 };
 
+/**
+ * FSavedMove_Lyra
+ *
+ *	Saved move that carries the bhop state (slow walk and the no friction landing window) so the server and
+ *	client replays apply ground friction on the same moves.
+ */
+class LYRAGAME_API FSavedMove_Lyra : public FSavedMove_Character
+{
+public:
+
+	typedef FSavedMove_Character Super;
+
+	enum ELyraCompressedFlags
+	{
+		FLAG_SlowWalking = FLAG_Custom_0,
+	};
+
+	//~FSavedMove_Character interface
+	virtual void Clear() override;
+	virtual uint8 GetCompressedFlags() const override;
+	virtual bool CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const override;
+	virtual void SetMoveFor(ACharacter* C, float InDeltaTime, FVector const& NewAccel, FNetworkPredictionData_Client_Character& ClientData) override;
+	virtual void PrepMoveFor(ACharacter* C) override;
+	//~End of FSavedMove_Character interface
+
+	uint32 bSavedIsSlowWalking : 1;
+	uint32 bSavedInNoFrictionWindow : 1;
+	float SavedTimeSinceLastAirborne = 0.0f;
+
+	// Cached surf ramp at the start of the move, PhysSurf only sweeps again when it drifts off or travels far enough.
+	uint32 bSavedHasSurfPlane : 1;
+	FVector SavedSurfPlaneNormal = FVector::UpVector;
+	FVector SavedSurfPlaneLocation = FVector::ZeroVector;
+	FVector SavedLastSurfProbeLocation = FVector::ZeroVector;
+
+	// Sub-step cap the move was predicted with, sent to the server in FLyraCharacterNetworkMoveData.
+	uint8 SavedMoveSubstepCap = 0;
+};
+
+/**
+ * FLyraCharacterNetworkMoveData
+ *
+ *	Move data sent to the server, adds the sub-step cap the client predicted the move with.
+ */
+struct LYRAGAME_API FLyraCharacterNetworkMoveData : public FCharacterNetworkMoveData
+{
+	typedef FCharacterNetworkMoveData Super;
+
+	//~FCharacterNetworkMoveData interface
+	virtual void ClientFillNetworkMoveData(const FSavedMove_Character& ClientMove, ENetworkMoveType MoveType) override;
+	virtual bool Serialize(UCharacterMovementComponent& CharacterMovement, FArchive& Ar, UPackageMap* PackageMap, ENetworkMoveType MoveType) override;
+	//~End of FCharacterNetworkMoveData interface
+
+	uint8 MoveSubstepCap = 0;
+};
+
+/**
+ * FLyraCharacterNetworkMoveDataContainer
+ */
+struct LYRAGAME_API FLyraCharacterNetworkMoveDataContainer : public FCharacterNetworkMoveDataContainer
+{
+	FLyraCharacterNetworkMoveDataContainer();
+
+	FLyraCharacterNetworkMoveData LyraMoveData[3];
+};
+
+/**
+ * FNetworkPredictionData_Client_Lyra
+ */
+class LYRAGAME_API FNetworkPredictionData_Client_Lyra : public FNetworkPredictionData_Client_Character
+{
+public:
+
+	typedef FNetworkPredictionData_Client_Character Super;
+
+	FNetworkPredictionData_Client_Lyra(const UCharacterMovementComponent& ClientMovement);
+
+	//~FNetworkPredictionData_Client_Character interface
+	virtual FSavedMovePtr AllocateNewMove() override;
+	//~End of FNetworkPredictionData_Client_Character interface
+};
+
 UCLASS(Config = Game)
 class LYRAGAME_API ULyraCharacterMovementComponent : public UCharacterMovementComponent
 {
@@ -53,8 +155,29 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Lyra|CharacterMovement")
 	const FLyraCharacterGroundInfo& GetGroundInfo();
 
+	// Returns the estimated time until a falling character lands, based on the cached ground info and gravity.
+	// Does not trace on its own.  Returns 0 when on the ground and -1 if there is no ground below.
+	UFUNCTION(BlueprintCallable, Category = "Lyra|CharacterMovement")
+	float EstimateTimeToLand();
+
+	// Returns true while the character is in the surf custom movement mode.
+	UFUNCTION(BlueprintCallable, Category = "Lyra|CharacterMovement")
+	bool IsSurfing() const;
+
+	// Returns true if the hit is a ramp that can be surfed: blocking, too steep to walk on and not facing down.
+	bool IsSurfableSurface(const FHitResult& Hit) const;
+
 	void SetReplicatedAcceleration(const FVector& InAcceleration);
 
+	// Writes the recorded movement telemetry (see LyraCharacter.Telemetry) to a CSV or binary file on a background thread.
+	// Returns false if nothing has been recorded.
+	bool FlushTelemetry(const FString& Filename, bool bBinary) const;
+
+	//~UCharacterMovementComponent network interface
+	virtual FNetworkPredictionData_Client* GetPredictionData_Client() const override;
+	virtual void ServerMoveHandleClientError(float ClientTimeStamp, float DeltaTime, const FVector& Accel, const FVector& RelativeClientLocation, UPrimitiveComponent* ClientMovementBase, FName ClientBaseBoneName, uint8 ClientMovementMode) override;
+	//~End of UCharacterMovementComponent network interface
+
 	//~UMovementComponent interface
 	virtual FRotator GetDeltaRotation(float DeltaTime) const override;
 	//virtual float GetMaxSpeed() const override;
@@ -72,6 +195,8 @@ public:
 	
 	virtual bool CanAttemptJump() const override;
 	virtual void CalcVelocity(float DeltaTime, float Friction, bool bFluid, float BrakingDeceleration) override;
+	// Old two pass version of CalcVelocity, kept behind LyraCharacter.UseLegacyCalcVelocity for comparisons.
+	void CalcVelocity_Legacy(float DeltaTime, float Friction, bool bFluid, float BrakingDeceleration);
 	virtual void ApplyVelocityBraking(float DeltaTime, float Friction, float BrakingDeceleration) override;
 	virtual bool ShouldLimitAirControl(float DeltaTime, const FVector& FallAcceleration) const override;
 	void ApplyAcceleration(float DeltaTime, float SurfaceFriction, const FVector& WishDirection, float WishSpeed, float Acceleration);
@@ -86,8 +211,8 @@ public:
 
 
 	// Sector 3 : Variables
-	//Timestamp when character was in-air
-	float LastAirTimestamp;
+	//Movement time since the character was last in-air, advanced per simulated move (see OnMovementUpdated)
+	float TimeSinceLastAirborne;
 	UPROPERTY(Category = " Movement: Bunnyhopping", EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0", UIMin = "0"))
 	float NoFrictionAfterLandingTime;
 
@@ -113,14 +238,51 @@ public:
 	void ApplyAirAcceleration(float DeltaTime, float SurfaceFriction, const FVector& WishDirection, float WishSpeed, float MaxAirWishSpeed, float Acceleration);
 	void ApplyFriction(float DeltaTime, float CharacterFriction, float SurfaceFriction, float StopSpeed);
 	bool ShouldApplyGroundFriction();
+	// True while the character has landed recently enough that ground friction is skipped.
+	bool IsInNoFrictionWindow() const;
 
 	UPROPERTY(Category = "Movement: Jumping", EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0", UIMin = "0"))
 	float MaxAirAcceleration;
 	UPROPERTY(Category = "Movement: Walking", EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0", UIMin = "0"))
 	float StopSpeed;
 
+	// Sub-stepping
+	// Shortest distance a movement sub-step may cover, used right next to geometry.
+	UPROPERTY(Category = " Movement: Sub-stepping", EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "1", UIMin = "1"))
+	float MinSubstepDistance = 10.0f;
+
+	// Longest distance a movement sub-step may cover, used in open space.
+	UPROPERTY(Category = " Movement: Sub-stepping", EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "1", UIMin = "1"))
+	float MaxSubstepDistance = 100.0f;
+
+	// Upper bound on the sub-step time at low speed, replaces MaxSimulationTimeStep while adaptive sub-stepping is on.
+	UPROPERTY(Category = " Movement: Sub-stepping", EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0.0166", UIMin = "0.0166", ClampMax = "0.50", UIMax = "0.50"))
+	float MaxAdaptiveTimeStep = 0.1f;
+
+	// Surfing
+	// Smallest ramp normal Z that can be surfed, anything steeper is treated as a wall.
+	UPROPERTY(Category = "Movement: Surfing", EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0", UIMin = "0", ClampMax = "1", UIMax = "1"))
+	float SurfMinNormalZ = 0.05f;
+
+	// Longest distance covered by a single surf sub-step, faster surfers take more sub-steps per frame.
+	UPROPERTY(Category = "Movement: Surfing", EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "1", UIMin = "1"))
+	float SurfMaxSubstepDistance = 20.0f;
+
+	UPROPERTY(Category = "Movement: Surfing", EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "1", UIMin = "1"))
+	int32 SurfMaxSubsteps = 8;
+
+	// Distance travelled along the cached ramp plane before the contact is confirmed with a sweep.
+	UPROPERTY(Category = "Movement: Surfing", EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0", UIMin = "0"))
+	float SurfProbeDistance = 64.0f;
+
+	// How far the character may drift off the cached ramp plane before it is considered to have left it.
+	UPROPERTY(Category = "Movement: Surfing", EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "0", UIMin = "0"))
+	float SurfContactTolerance = 2.0f;
+
 	
 	float GetMaxAcceleration() const override;
+	// Wish speed for the current input, scaled by the analog input modifier.
+	float GetInputWishSpeed(float MaxSpeed) const;
 	// braking
 	
 
@@ -129,14 +291,114 @@ protected:
 	virtual void InitializeComponent() override;
 	// Override to handle resetting jump parameters upon landing
 	virtual void OnMovementModeChanged(EMovementMode PreviousMovementMode, uint8 PreviousCustomMode) override;
+	virtual void OnMovementUpdated(float DeltaSeconds, const FVector& OldLocation, const FVector& OldVelocity) override;
+	virtual void PhysFalling(float deltaTime, int32 Iterations) override;
+	virtual void PhysCustom(float deltaTime, int32 Iterations) override;
+	virtual void PerformMovement(float DeltaTime) override;
+	virtual float GetSimulationTimeStep(float RemainingTime, int32 Iterations) const override;
+	virtual bool MoveUpdatedComponentImpl(const FVector& Delta, const FQuat& NewRotation, bool bSweep, FHitResult* OutHit = nullptr, ETeleportType Teleport = ETeleportType::None) override;
+	virtual void ComputeFloorDist(const FVector& CapsuleLocation, float LineDistance, float SweepDistance, FFindFloorResult& OutFloorResult, float SweepRadius, const FHitResult* DownwardSweepResult = nullptr) const override;
+	virtual void HandleImpact(const FHitResult& Hit, float TimeSlice = 0.f, const FVector& MoveDelta = FVector::ZeroVector) override;
+
+	virtual void MoveAutonomous(float ClientTimeStamp, float DeltaTime, uint8 CompressedFlags, const FVector& NewAccel) override;
+	virtual void UpdateFromCompressedFlags(uint8 Flags) override;
+	virtual void OnClientCorrectionReceived(FNetworkPredictionData_Client_Character& ClientData, float TimeStamp, FVector NewLocation, FVector NewVelocity, UPrimitiveComponent* NewBase, FName NewBaseBoneName, bool bHasBase, bool bBaseRelativePosition, uint8 ServerMovementMode) override;
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+	virtual void OnUnregister() override;
+	virtual void ControlledCharacterMove(const FVector& InputVector, float DeltaSeconds) override;
+
+	// Async (physics thread) movement, see LyraCharacter.AsyncMovement.
+	virtual void FillAsyncInput(const FVector& InputVector, FCharacterMovementComponentAsyncInput& AsyncInput) override;
+	virtual void ApplyAsyncOutput(FCharacterMovementComponentAsyncOutput& Output) override;
+	virtual void OnTeleported() override;
+	bool ShouldUseAsyncMovement() const;
+	void RegisterLyraAsyncCallback();
+	void UnregisterLyraAsyncCallback();
+
+	// True once the move being performed has taken all the sub-steps its cap allows, Iterations counts the sub-steps
+	// taken so far including the current one.
+	bool IsMoveSubstepCapReached(int32 Iterations) const;
+
+	// Surf movement: velocity is clipped analytically against the cached ramp plane and the ramp is only swept again
+	// when the character drifts off the plane or has travelled SurfProbeDistance along it.
+	void PhysSurf(float deltaTime, int32 Iterations);
+	int32 GetSurfSubstepCount(float DeltaTime, int32 Iterations) const;
+	void CacheSurfPlane(const FHitResult& Hit);
+	void ClipVelocityToSurfPlane();
+	// Sweeps towards the cached plane (or down when there is none), starting pulled back off it.  Drops back to falling and returns false when no ramp is found.
+	bool ProbeSurfPlane();
+
+	FHitResult TraceGround(const FVector& TraceStart, float CapsuleHalfHeight) const;
+	void UpdateAsyncGroundTrace(const FVector& ActorLocation, float CapsuleHalfHeight);
+
+	// Simulated proxies only: bends the proxy velocity with the replicated acceleration between net updates.
+	void ExtrapolateProxyVelocity(float DeltaTime);
+
+	// Movement telemetry, allocated once when recording starts.
+	void RecordTelemetry(float DeltaTime);
+
+	// Saved and restored by FSavedMove_Lyra so replayed moves start from the same cached ramp and sub-step cap.
+	friend class FSavedMove_Lyra;
+	friend class FLyraProxyExtrapolationTest;
+
 	// Cached ground info for the character.  Do not access this directly!  It's only updated when accessed via GetGroundInfo().
 	FLyraCharacterGroundInfo CachedGroundInfo;
 	UPROPERTY(Transient)
 	bool bHasReplicatedAcceleration = false;
 
+	// Sub-step cap for the moves made from now on, 0 for none.  Picked by the server from
+	// LyraCharacter.ServerIterationBudget and replicated to the owning client, which predicts with it.
+	UPROPERTY(Replicated)
+	uint8 MoveSubstepCap = 0;
+
+	// Cap of the move being performed.  Taken from MoveSubstepCap for new moves, from the saved move for replays and
+	// from the move data on the server, so both sides sub-step a move the same way.
+	uint8 CurrentMoveSubstepCap = 0;
+
+	FLyraCharacterNetworkMoveDataContainer LyraNetworkMoveDataContainer;
+
+	// Free distance to the closest non-walkable geometry swept into during the current move.
+	float NearestGeometryDistance = TNumericLimits<float>::Max();
+
+	FVector SurfPlaneNormal = FVector::UpVector;
+	// Capsule location on the ramp when the plane was cached.
+	FVector SurfPlaneLocation = FVector::ZeroVector;
+	FVector LastSurfProbeLocation = FVector::ZeroVector;
+	bool bHasSurfPlane = false;
+
+	// Surfable ramp hit while falling, switches to surf once the falling step is done.
+	FHitResult PendingSurfHit;
+	bool bHasPendingSurfHit = false;
+
+	FLyraCharacterMovementComponentAsyncCallback* LyraAsyncCallback = nullptr;
+	TSharedPtr<FLyraCharacterMovementComponentAsyncOutput, ESPMode::ThreadSafe> LyraAsyncSimState;
+
+	// Game thread velocity and movement mode as of the last output applied or change sent, see FillAsyncInput.
+	FVector LyraAsyncGameThreadVelocity = FVector::ZeroVector;
+	TEnumAsByte<EMovementMode> LyraAsyncGameThreadMovementMode = MOVE_None;
+	uint32 LyraAsyncGameThreadRevision = 0;
+	bool bLyraAsyncTeleported = false;
+
+	// Last airborne ground trace, served to GetGroundInfo until the character drifts away from where it was traced.
+	FHitResult LastGroundTraceHit;
+	FVector LastGroundTraceStart = FVector::ZeroVector;
+	FTraceHandle PendingGroundTraceHandle;
+	bool bHasGroundTraceResult = false;
+
+	// Simulated proxies only: time since the last replicated movement update was received.
+	float TimeSinceProxyUpdate = 0.0f;
+
+	TSharedPtr<FLyraMovementTelemetryBuffer, ESPMode::ThreadSafe> TelemetryBuffer;
+	float TelemetryAirTime = 0.0f;
+	float TelemetryLastJumpHorizontalSpeed = 0.0f;
+	// FLyraMovementTelemetrySample::EFlags raised since the last sample.
+	uint8 PendingTelemetryFlags = 0;
+	bool bTelemetryWasAirborne = false;
+
 	///Mine 
 
 	
 };
 
 
+
@@ -0,0 +1,47 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "LyraMovementBudgetSubsystem.h"
+
+#include "CoreGlobals.h"
+#include "Math/UnrealMathUtility.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(LyraMovementBudgetSubsystem)
+
+void ULyraMovementBudgetSubsystem::RecordCharacter()
+{
+	BeginFrame();
+	++FrameCharacters;
+}
+
+void ULyraMovementBudgetSubsystem::RecordSweep()
+{
+	BeginFrame();
+	++FrameSweeps;
+}
+
+uint8 ULyraMovementBudgetSubsystem::GetMoveSubstepCap(int32 IterationBudget, int32 MinCap) const
+{
+	if (IterationBudget <= 0)
+	{
+		return 0;
+	}
+
+	const int32 LowestCap = FMath::Clamp(MinCap, 1, int32(MAX_uint8));
+	return uint8(FMath::Clamp(IterationBudget / FMath::Max(LastFrameCharacters, 1), LowestCap, int32(MAX_uint8)));
+}
+
+float ULyraMovementBudgetSubsystem::GetSweepsPerCharacter() const
+{
+	return float(FrameSweeps) / float(FMath::Max(FrameCharacters, 1));
+}
+
+void ULyraMovementBudgetSubsystem::BeginFrame()
+{
+	if (Frame != GFrameCounter)
+	{
+		Frame = GFrameCounter;
+		LastFrameCharacters = FrameCharacters;
+		FrameSweeps = 0;
+		FrameCharacters = 0;
+	}
+}
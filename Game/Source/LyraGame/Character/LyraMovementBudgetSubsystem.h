@@ -0,0 +1,45 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "Subsystems/WorldSubsystem.h"
+
+#include "LyraMovementBudgetSubsystem.generated.h"
+
+class UObject;
+
+/**
+ * ULyraMovementBudgetSubsystem
+ *
+ *	Per frame movement cost of the characters in a world.  The server splits its movement iteration budget over
+ *	the characters moved in the previous frame, so every world (PIE instances, dedicated servers sharing a
+ *	process) is budgeted on its own.
+ */
+UCLASS()
+class LYRAGAME_API ULyraMovementBudgetSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	// Counts a character starting its movement this frame.
+	void RecordCharacter();
+
+	// Counts a collision sweep made by character movement this frame.
+	void RecordSweep();
+
+	// Per-move share of IterationBudget, never below MinCap.  0 when there is no budget.
+	uint8 GetMoveSubstepCap(int32 IterationBudget, int32 MinCap) const;
+
+	float GetSweepsPerCharacter() const;
+
+private:
+
+	// Starts counting a new frame the first time anything is recorded in it.
+	void BeginFrame();
+
+	uint64 Frame = 0;
+	int32 FrameSweeps = 0;
+	int32 FrameCharacters = 0;
+	int32 LastFrameCharacters = 0;
+};
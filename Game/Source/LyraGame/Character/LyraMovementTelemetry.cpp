@@ -0,0 +1,106 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Character/LyraMovementTelemetry.h"
+
+#include "Math/UnrealMathUtility.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/Archive.h"
+#include "Serialization/MemoryWriter.h"
+
+FArchive& operator<<(FArchive& Ar, FLyraMovementTelemetrySample& Sample)
+{
+	Ar << Sample.Time;
+	Ar << Sample.Speed;
+	Ar << Sample.HorizontalSpeed;
+	Ar << Sample.JumpSpeedGain;
+	Ar << Sample.AirTime;
+	Ar << Sample.SurfaceNormal;
+	Ar << Sample.MovementMode;
+	Ar << Sample.CustomMovementMode;
+	Ar << Sample.Flags;
+	return Ar;
+}
+
+FLyraMovementTelemetryBuffer::FLyraMovementTelemetryBuffer(int32 InCapacity)
+{
+	const int32 Capacity = int32(FMath::RoundUpToPowerOfTwo(uint32(FMath::Max(InCapacity, 2))));
+	Samples.SetNum(Capacity);
+	IndexMask = uint64(Capacity - 1);
+}
+
+void FLyraMovementTelemetryBuffer::Push(const FLyraMovementTelemetrySample& Sample)
+{
+	const uint64 Index = WriteIndex.load(std::memory_order_relaxed);
+	Samples[int32(Index & IndexMask)] = Sample;
+
+	// Publish the sample only once it has been written.
+	WriteIndex.store(Index + 1, std::memory_order_release);
+}
+
+void FLyraMovementTelemetryBuffer::Snapshot(TArray<FLyraMovementTelemetrySample>& OutSamples) const
+{
+	// The slot of the oldest sample is the one the producer writes next, it may be mid write as soon as the ring is
+	// full, so only the newest Capacity - 1 samples are ever copied.
+	const uint64 Capacity = uint64(Samples.Num());
+	const uint64 End = WriteIndex.load(std::memory_order_acquire);
+	const uint64 Begin = (End >= Capacity) ? (End - Capacity + 1) : 0;
+
+	OutSamples.Reset(int32(End - Begin));
+	for (uint64 Index = Begin; Index < End; ++Index)
+	{
+		OutSamples.Add(Samples[int32(Index & IndexMask)]);
+	}
+
+	// Anything the producer lapped while we were copying may be torn, drop it.
+	const uint64 EndAfterCopy = WriteIndex.load(std::memory_order_acquire);
+	const uint64 FirstIntact = (EndAfterCopy >= Capacity) ? (EndAfterCopy - Capacity + 1) : 0;
+	if (FirstIntact > Begin)
+	{
+		OutSamples.RemoveAt(0, int32(FMath::Min(FirstIntact - Begin, uint64(OutSamples.Num()))));
+	}
+}
+
+void FLyraMovementTelemetryBuffer::Reset()
+{
+	WriteIndex.store(0, std::memory_order_release);
+}
+
+bool FLyraMovementTelemetryBuffer::SaveToCSV(const TArray<FLyraMovementTelemetrySample>& InSamples, const FString& Filename)
+{
+	FString Text;
+	Text.Reserve(64 + (InSamples.Num() * 96));
+	Text += TEXT("Time,Speed,HorizontalSpeed,JumpSpeedGain,AirTime,NormalX,NormalY,NormalZ,MovementMode,CustomMovementMode,Jumped,Landed,Correction\n");
+
+	for (const FLyraMovementTelemetrySample& Sample : InSamples)
+	{
+		Text += FString::Printf(TEXT("%.4f,%.2f,%.2f,%.2f,%.4f,%.4f,%.4f,%.4f,%d,%d,%d,%d,%d\n"),
+			Sample.Time, Sample.Speed, Sample.HorizontalSpeed, Sample.JumpSpeedGain, Sample.AirTime,
+			Sample.SurfaceNormal.X, Sample.SurfaceNormal.Y, Sample.SurfaceNormal.Z,
+			Sample.MovementMode, Sample.CustomMovementMode,
+			(Sample.Flags & FLyraMovementTelemetrySample::Flag_Jumped) ? 1 : 0,
+			(Sample.Flags & FLyraMovementTelemetrySample::Flag_Landed) ? 1 : 0,
+			(Sample.Flags & FLyraMovementTelemetrySample::Flag_Correction) ? 1 : 0);
+	}
+
+	return FFileHelper::SaveStringToFile(Text, *Filename);
+}
+
+bool FLyraMovementTelemetryBuffer::SaveToBinary(const TArray<FLyraMovementTelemetrySample>& InSamples, const FString& Filename)
+{
+	TArray<uint8> Bytes;
+	FMemoryWriter Writer(Bytes);
+
+	uint32 Magic = FileMagic;
+	uint32 Version = FileVersion;
+	int32 NumSamples = InSamples.Num();
+	Writer << Magic;
+	Writer << Version;
+	Writer << NumSamples;
+
+	for (const FLyraMovementTelemetrySample& Sample : InSamples)
+	{
+		Writer << const_cast<FLyraMovementTelemetrySample&>(Sample);
+	}
+
+	return FFileHelper::SaveArrayToFile(Bytes, *Filename);
+}
@@ -0,0 +1,86 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "Containers/Array.h"
+#include "Containers/UnrealString.h"
+#include "Math/Vector.h"
+
+#include <atomic>
+
+class FArchive;
+
+/**
+ * FLyraMovementTelemetrySample
+ *
+ *	One movement tick of a character, used to tune the bhop parameters from live data.
+ */
+struct FLyraMovementTelemetrySample
+{
+	enum EFlags : uint8
+	{
+		Flag_Jumped		= 1 << 0,
+		Flag_Landed		= 1 << 1,
+		Flag_Correction	= 1 << 2,
+	};
+
+	double Time = 0.0;
+	float Speed = 0.0f;
+	float HorizontalSpeed = 0.0f;
+
+	// Horizontal take off speed gained since the previous jump, only set on samples with Flag_Jumped.
+	float JumpSpeedGain = 0.0f;
+
+	// Time spent in the air so far, or the total time of the last jump on samples with Flag_Landed.
+	float AirTime = 0.0f;
+
+	// Floor or surf ramp normal, zero while in the air.
+	FVector3f SurfaceNormal = FVector3f::ZeroVector;
+
+	uint8 MovementMode = 0;
+	uint8 CustomMovementMode = 0;
+	uint8 Flags = 0;
+
+	friend FArchive& operator<<(FArchive& Ar, FLyraMovementTelemetrySample& Sample);
+};
+
+/**
+ * FLyraMovementTelemetryBuffer
+ *
+ *	Fixed size ring of telemetry samples.  All memory is allocated up front, Push never allocates.
+ *
+ *	One thread pushes, any thread may take a snapshot without locking.  Samples that were overwritten
+ *	while the snapshot was being copied are dropped from it.
+ */
+class LYRAGAME_API FLyraMovementTelemetryBuffer
+{
+public:
+
+	static constexpr uint32 FileMagic = 0x53544D4C; // 'LMTS'
+	static constexpr uint32 FileVersion = 1;
+
+	// Capacity is rounded up to a power of two.
+	explicit FLyraMovementTelemetryBuffer(int32 InCapacity);
+
+	void Push(const FLyraMovementTelemetrySample& Sample);
+
+	// Copies the samples currently held, oldest first.  Once the ring has wrapped that is the newest Capacity - 1,
+	// the oldest slot is the next one to be overwritten.
+	void Snapshot(TArray<FLyraMovementTelemetrySample>& OutSamples) const;
+
+	void Reset();
+
+	int32 GetCapacity() const { return Samples.Num(); }
+
+	// Total number of samples pushed, including the ones that have since been overwritten.
+	uint64 GetNumPushed() const { return WriteIndex.load(std::memory_order_acquire); }
+
+	static bool SaveToCSV(const TArray<FLyraMovementTelemetrySample>& InSamples, const FString& Filename);
+	static bool SaveToBinary(const TArray<FLyraMovementTelemetrySample>& InSamples, const FString& Filename);
+
+private:
+
+	TArray<FLyraMovementTelemetrySample> Samples;
+	uint64 IndexMask = 0;
+	std::atomic<uint64> WriteIndex { 0 };
+};
@@ -0,0 +1,51 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Character/LyraMovementVelocity.h"
+
+#include "Math/UnrealMathUtility.h"
+
+void LyraMovement::ApplyFriction(FVector& Velocity, float DeltaTime, float CharacterFriction, float SurfaceFriction, float StopSpeed)
+{
+	const auto Speed = Velocity.Size();
+	if (Speed <= 0.0f)
+	{
+		// Already stopped, and avoids 0/0 below.
+		return;
+	}
+
+	auto ControlSpeed = FMath::Max(StopSpeed, Speed);
+	auto SpeedDrop = ControlSpeed * CharacterFriction * SurfaceFriction * DeltaTime;
+
+	Velocity *= FMath::Max(0.0f, Speed - SpeedDrop) / Speed;
+}
+
+void LyraMovement::ApplyAcceleration(FVector& Velocity, float DeltaTime, float SurfaceFriction, const FVector& WishDirection, float WishSpeed, float Acceleration)
+{
+	const auto VelocityProgress = FVector::DotProduct(Velocity, WishDirection);
+	const auto AddSpeed = WishSpeed - VelocityProgress;
+	if (AddSpeed <= 0.0f)
+	{
+		return;
+	}
+
+	auto AccelerationSpeed = Acceleration * WishSpeed * SurfaceFriction * DeltaTime;
+	AccelerationSpeed = FMath::Min(AccelerationSpeed, AddSpeed);
+
+	Velocity += AccelerationSpeed * WishDirection;
+}
+
+void LyraMovement::ApplyAirAcceleration(FVector& Velocity, float DeltaTime, float SurfaceFriction, const FVector& WishDirection, float WishSpeed, float MaxAirWishSpeed, float Acceleration)
+{
+	const auto AirWishSpeed = FMath::Min(WishSpeed, MaxAirWishSpeed);
+	const auto VelocityProgress = FVector::DotProduct(Velocity, WishDirection);
+	const auto AddSpeed = AirWishSpeed - VelocityProgress;
+	if (AddSpeed <= 0.0f)
+	{
+		return;
+	}
+
+	auto AccelerationSpeed = Acceleration * WishSpeed * SurfaceFriction * DeltaTime;
+	AccelerationSpeed = FMath::Min(AccelerationSpeed, AddSpeed);
+
+	Velocity += AccelerationSpeed * WishDirection;
+}
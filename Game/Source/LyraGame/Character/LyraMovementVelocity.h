@@ -0,0 +1,13 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "Math/Vector.h"
+
+namespace LyraMovement
+{
+	// The bhop / air-strafe velocity steps, shared by ULyraCharacterMovementComponent and its physics thread simulation.
+	LYRAGAME_API void ApplyFriction(FVector& Velocity, float DeltaTime, float CharacterFriction, float SurfaceFriction, float StopSpeed);
+	LYRAGAME_API void ApplyAcceleration(FVector& Velocity, float DeltaTime, float SurfaceFriction, const FVector& WishDirection, float WishSpeed, float Acceleration);
+	LYRAGAME_API void ApplyAirAcceleration(FVector& Velocity, float DeltaTime, float SurfaceFriction, const FVector& WishDirection, float WishSpeed, float MaxAirWishSpeed, float Acceleration);
+};
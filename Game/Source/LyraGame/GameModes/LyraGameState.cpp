@@ -10,6 +10,7 @@
 #include "GameModes/LyraExperienceManagerComponent.h"
 #include "HAL/Platform.h"
 #include "Misc/AssertionMacros.h"
+#include "GameFramework/Pawn.h"
 #include "Net/UnrealNetwork.h"
 
 #include UE_INLINE_GENERATED_CPP_BY_NAME(LyraGameState)
@@ -99,3 +100,21 @@ void ALyraGameState::MulticastReliableMessageToClients_Implementation(const FLyr
 {
 	MulticastMessageToClients_Implementation(Message);
 }
+
+void ALyraGameState::MulticastProjectileSpawn_Implementation(const FLyraProjectileSpawnParams& Params)
+{
+	if (GetNetMode() == NM_Client)
+	{
+		// The shooter already predicted this projectile when they fired
+		const APawn* InstigatorPawn = Cast<APawn>(Params.Instigator);
+		if (InstigatorPawn && InstigatorPawn->IsLocallyControlled())
+		{
+			return;
+		}
+
+		if (ULyraProjectileSubsystem* ProjectileSubsystem = UWorld::GetSubsystem<ULyraProjectileSubsystem>(GetWorld()))
+		{
+			ProjectileSubsystem->SpawnCosmeticProjectile(Params);
+		}
+	}
+}
@@ -7,6 +7,7 @@
 #include "Messages/LyraVerbMessage.h"
 #include "ModularGameState.h"
 #include "UObject/UObjectGlobals.h"
+#include "Weapons/LyraProjectileSubsystem.h"
 
 #include "LyraGameState.generated.h"
 
@@ -61,6 +62,10 @@ public:
 	UFUNCTION(NetMulticast, Reliable, BlueprintCallable, Category = "Lyra|GameState")
 	void MulticastReliableMessageToClients(const FLyraVerbMessage Message);
 
+	// Tell every client to fly a cosmetic copy of a projectile the server just spawned (see ULyraProjectileSubsystem)
+	UFUNCTION(NetMulticast, Unreliable)
+	void MulticastProjectileSpawn(const FLyraProjectileSpawnParams& Params);
+
 private:
 	UPROPERTY()
 	TObjectPtr<ULyraExperienceManagerComponent> ExperienceManagerComponent;
@@ -71,6 +71,7 @@ public class LyraGame : ModuleRules
 				"ClientPilot",
 				"AudioModulation",
 				"EngineSettings",
+				"Chaos",
 			}
 		);
 
@@ -2,6 +2,7 @@
 
 #include "LyraGameplayTags.h"
 
+#include "Character/LyraCharacterMovementComponent.h"
 #include "Containers/Array.h"
 #include "Engine/EngineTypes.h"
 #include "GameplayTagsManager.h"
@@ -68,6 +69,8 @@ void FLyraGameplayTags::AddAllTags(UGameplayTagsManager& Manager)
 	AddMovementModeTag(Movement_Mode_Swimming, "Movement.Mode.Swimming", MOVE_Swimming);
 	AddMovementModeTag(Movement_Mode_Flying, "Movement.Mode.Flying", MOVE_Flying);
 	AddMovementModeTag(Movement_Mode_Custom, "Movement.Mode.Custom", MOVE_Custom);
+
+	AddCustomMovementModeTag(Movement_Mode_Custom_Surf, "Movement.Mode.Custom.Surf", uint8(ELyraCustomMovementMode::Surf));
 }
 
 void FLyraGameplayTags::AddTag(FGameplayTag& OutTag, const ANSICHAR* TagName, const ANSICHAR* TagComment)
@@ -78,6 +78,7 @@ public:
 	FGameplayTag Movement_Mode_Swimming;
 	FGameplayTag Movement_Mode_Flying;
 	FGameplayTag Movement_Mode_Custom;
+	FGameplayTag Movement_Mode_Custom_Surf;
 
 	TMap<uint8, FGameplayTag> MovementModeTagMap;
 	TMap<uint8, FGameplayTag> CustomMovementModeTagMap;
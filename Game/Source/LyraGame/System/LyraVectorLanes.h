@@ -0,0 +1,38 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "Containers/Array.h"
+#include "Templates/AlignmentTemplates.h"
+
+/**
+ * Helpers for structure-of-arrays buffers of doubles that are processed one VectorRegister4Double at a time.
+ * Each array is kept a whole number of registers long, so the processing loop can load full registers up to
+ * the last lane without a separate tail.
+ */
+namespace LyraVectorLanes
+{
+	// Doubles held by one VectorRegister4Double.
+	static constexpr int32 DoublesPerRegister = 4;
+
+	// Number of lanes to reserve so NumLanes lanes fit in whole registers.
+	FORCEINLINE int32 GetPaddedNum(int32 NumLanes)
+	{
+		return Align(NumLanes, DoublesPerRegister);
+	}
+
+	// Makes sure Lane exists in Array.  When Lane is past the end, adds a whole register of PadValue.
+	// Lanes must be added in order.
+	FORCEINLINE void AddLane(TArray<double>& Array, int32 Lane, double PadValue)
+	{
+		if (Lane >= Array.Num())
+		{
+			check(Lane == Array.Num());
+			const int32 FirstPadded = Array.AddUninitialized(DoublesPerRegister);
+			for (int32 Index = FirstPadded; Index < Array.Num(); ++Index)
+			{
+				Array[Index] = PadValue;
+			}
+		}
+	}
+};
@@ -0,0 +1,136 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "AbilitySystem/LyraGameplayAbilityTargetData_Cartridge.h"
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+#include "Serialization/BitReader.h"
+#include "Serialization/BitWriter.h"
+#include "UObject/Package.h"
+#include "Weapons/LyraGameplayAbility_RangedWeapon.h"
+#include "Weapons/LyraRangedWeaponInstance.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace LyraCartridgeExpansionTest
+{
+	static const int32 NumBullets = 10;
+
+	// Spread goes from 2 to 10 degrees with heat, crouching halves it and jumping doubles it
+	static const float MinSpreadAngle = 1.0f;
+	static const float MaxSpreadAngle = 20.0f;
+
+	static ULyraRangedWeaponInstance* MakeShotgun()
+	{
+		ULyraRangedWeaponInstance* Weapon = NewObject<ULyraRangedWeaponInstance>(GetTransientPackage());
+
+		FIntProperty* BulletsProperty = FindFProperty<FIntProperty>(ULyraRangedWeaponInstance::StaticClass(), TEXT("BulletsPerCartridge"));
+		check(BulletsProperty);
+		BulletsProperty->SetPropertyValue_InContainer(Weapon, NumBullets);
+
+		FStructProperty* SpreadProperty = FindFProperty<FStructProperty>(ULyraRangedWeaponInstance::StaticClass(), TEXT("HeatToSpreadCurve"));
+		check(SpreadProperty);
+		FRichCurve* HeatToSpread = SpreadProperty->ContainerPtrToValuePtr<FRuntimeFloatCurve>(Weapon)->GetRichCurve();
+		HeatToSpread->UpdateOrAddKey(0.0f, 2.0f);
+		HeatToSpread->UpdateOrAddKey(1.0f, 10.0f);
+
+		FFloatProperty* CrouchingProperty = FindFProperty<FFloatProperty>(ULyraRangedWeaponInstance::StaticClass(), TEXT("SpreadAngleMultiplier_Crouching"));
+		check(CrouchingProperty);
+		CrouchingProperty->SetPropertyValue_InContainer(Weapon, 0.5f);
+
+		FFloatProperty* JumpingProperty = FindFProperty<FFloatProperty>(ULyraRangedWeaponInstance::StaticClass(), TEXT("SpreadAngleMultiplier_JumpingOrFalling"));
+		check(JumpingProperty);
+		JumpingProperty->SetPropertyValue_InContainer(Weapon, 2.0f);
+
+		return Weapon;
+	}
+
+	// The cartridge as the server reads it off the wire
+	static FLyraGameplayAbilityTargetData_Cartridge SendCartridge(const FGameplayAbilityTargetDataHandle& CartridgeData)
+	{
+		FLyraGameplayAbilityTargetData_Cartridge* Sent = static_cast<FLyraGameplayAbilityTargetData_Cartridge*>(CartridgeData.Data[0].Get());
+
+		FBitWriter Writer(1 << 16, /*AllowResize=*/ true);
+		bool bSuccess = true;
+		Sent->NetSerialize(Writer, nullptr, bSuccess);
+
+		FBitReader Reader(Writer.GetData(), Writer.GetNumBits());
+		FLyraGameplayAbilityTargetData_Cartridge Received;
+		Received.NetSerialize(Reader, nullptr, bSuccess);
+		return Received;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLyraCartridgeExpansionTest, "Lyra.Weapon.TargetData.CartridgeExpansion", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ServerContext | EAutomationTestFlags::EngineFilter)
+
+bool FLyraCartridgeExpansionTest::RunTest(const FString& Parameters)
+{
+	using namespace LyraCartridgeExpansionTest;
+
+	ULyraRangedWeaponInstance* Weapon = MakeShotgun();
+
+	float WeaponMinSpreadAngle;
+	float WeaponMaxSpreadAngle;
+	Weapon->GetSpreadAngleRange(/*out*/ WeaponMinSpreadAngle, /*out*/ WeaponMaxSpreadAngle);
+	TestEqual(TEXT("Min spread angle"), WeaponMinSpreadAngle, MinSpreadAngle, 1.0e-4f);
+	TestEqual(TEXT("Max spread angle"), WeaponMaxSpreadAngle, MaxSpreadAngle, 1.0e-4f);
+
+	FRandomStream Random(15);
+
+	for (int32 ShotIndex = 0; ShotIndex < 300; ++ShotIndex)
+	{
+		// Shots far from the origin with unrounded aim, any spread the weapon can fire with and a few it cannot
+		const FVector StartTrace(Random.FRandRange(-60000.0f, 60000.0f), Random.FRandRange(-60000.0f, 60000.0f), Random.FRandRange(-2000.0f, 4000.0f));
+		const FVector AimDir = Random.GetUnitVector();
+		const float SpreadAngle = Random.FRandRange(0.0f, MaxSpreadAngle * 1.5f);
+		const int32 Seed = Random.RandHelper(MAX_int32);
+
+		ULyraGameplayAbility_RangedWeapon::FRangedWeaponCartridge Fired;
+		ULyraGameplayAbility_RangedWeapon::MakeLocalCartridge(*Weapon, StartTrace, AimDir, SpreadAngle, Seed, ShotIndex, /*out*/ Fired);
+		TestEqual(TEXT("Bullets fired"), Fired.EndTraces.Num(), NumBullets);
+
+		FGameplayAbilityTargetDataHandle CartridgeData;
+		if (!ULyraGameplayAbility_RangedWeapon::MakeCartridgeTargetData(Fired, FGameplayAbilityTargetDataHandle(), /*out*/ CartridgeData))
+		{
+			AddError(FString::Printf(TEXT("Shot %d did not pack into a cartridge."), ShotIndex));
+			return false;
+		}
+
+		const FLyraGameplayAbilityTargetData_Cartridge Received = SendCartridge(CartridgeData);
+		TestEqual(TEXT("Shot index low byte"), int32(Received.ShotIndex), ShotIndex & 0xFF);
+
+		TArray<FVector> Expanded;
+		ULyraGameplayAbility_RangedWeapon::ComputeCartridgeEndTraces(Received, *Weapon, /*out*/ Expanded);
+		if (Expanded.Num() != Fired.EndTraces.Num())
+		{
+			AddError(FString::Printf(TEXT("Shot %d expanded into %d bullets, %d were fired."), ShotIndex, Expanded.Num(), Fired.EndTraces.Num()));
+			return false;
+		}
+
+		// Within the weapon's range the server must regenerate exactly the rays the shooter traced
+		const bool bPlausibleSpread = (SpreadAngle >= MinSpreadAngle) && (SpreadAngle <= MaxSpreadAngle);
+		const FVector ReceivedOrigin = Received.Origin;
+		for (int32 BulletIndex = 0; BulletIndex < Expanded.Num(); ++BulletIndex)
+		{
+			if (bPlausibleSpread)
+			{
+				TestTrue(TEXT("Same origin"), ReceivedOrigin.Equals(Fired.StartTrace, UE_KINDA_SMALL_NUMBER));
+				if (!Expanded[BulletIndex].Equals(Fired.EndTraces[BulletIndex], UE_KINDA_SMALL_NUMBER))
+				{
+					AddError(FString::Printf(TEXT("Shot %d bullet %d fired at %s, expanded to %s."), ShotIndex, BulletIndex, *Fired.EndTraces[BulletIndex].ToString(), *Expanded[BulletIndex].ToString()));
+					return false;
+				}
+			}
+			else
+			{
+				// Outside of it the bullets are clamped into the cone the weapon can reach
+				const FVector ExpandedDir = (Expanded[BulletIndex] - ReceivedOrigin).GetSafeNormal();
+				const float AngleFromAim = FMath::RadiansToDegrees(FMath::Acos(FMath::Clamp(ExpandedDir | FVector(Received.AimDir).GetSafeNormal(), -1.0, 1.0)));
+				TestTrue(TEXT("Clamped to the weapon's spread"), AngleFromAim <= (MaxSpreadAngle * 0.5f) + 0.01f);
+			}
+		}
+	}
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
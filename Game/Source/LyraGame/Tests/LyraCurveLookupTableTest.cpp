@@ -0,0 +1,222 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Curves/RichCurve.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/AutomationTest.h"
+#include "Weapons/LyraCurveLookupTable.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace LyraCurveLookupTableTest
+{
+	// Shaped like a typical distance damage falloff, full damage up close and a smooth drop off after
+	static void MakeFalloffCurve(FRichCurve& Curve)
+	{
+		const FKeyHandle Keys[] =
+		{
+			Curve.AddKey(0.0f, 1.0f),
+			Curve.AddKey(1500.0f, 1.0f),
+			Curve.AddKey(6000.0f, 0.6f),
+			Curve.AddKey(25000.0f, 0.25f)
+		};
+
+		for (const FKeyHandle& Key : Keys)
+		{
+			Curve.SetKeyInterpMode(Key, RCIM_Cubic);
+		}
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLyraCurveLookupTableTest, "Lyra.Weapon.CurveLookupTable", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ServerContext | EAutomationTestFlags::EngineFilter)
+
+bool FLyraCurveLookupTableTest::RunTest(const FString& Parameters)
+{
+	using namespace LyraCurveLookupTableTest;
+
+	FRichCurve Curve;
+	MakeFalloffCurve(Curve);
+
+	const float Tolerance = 0.01f;
+
+	FLyraCurveLookupTable Table;
+	TestTrue(TEXT("256 samples fit the falloff curve"), Table.Bake(Curve, 256, Tolerance));
+	TestTrue(TEXT("Reported error is within tolerance"), Table.GetMaxError() <= Tolerance);
+
+	// Check at points that are not on the grid used while baking
+	for (float Distance = 3.7f; Distance < 25000.0f; Distance += 97.3f)
+	{
+		if (!FMath::IsNearlyEqual(Table.Eval(Distance), Curve.Eval(Distance), Tolerance))
+		{
+			AddError(FString::Printf(TEXT("Table gives %f at %f, the curve gives %f."), Table.Eval(Distance), Distance, Curve.Eval(Distance)));
+			return false;
+		}
+	}
+
+	TestEqual(TEXT("Exact at the first key"), Table.Eval(0.0f), 1.0f);
+	TestEqual(TEXT("Exact at the last key"), Table.Eval(25000.0f), 0.25f);
+	TestEqual(TEXT("Clamped below the key range"), Table.Eval(-100.0f), 1.0f);
+	TestEqual(TEXT("Clamped above the key range"), Table.Eval(1.0e6f), 0.25f);
+
+	// Too few samples for the tolerance must not be used
+	FLyraCurveLookupTable CoarseTable;
+	TestFalse(TEXT("3 samples do not fit the falloff curve"), CoarseTable.Bake(Curve, 3, Tolerance));
+	TestFalse(TEXT("Coarse table is not valid"), CoarseTable.IsValid());
+
+	// Outside the key range the table clamps, so curves extrapolated any other way are left to the curve itself
+	FRichCurve LinearExtrapCurve;
+	MakeFalloffCurve(LinearExtrapCurve);
+	LinearExtrapCurve.PostInfinityExtrap = RCCE_Linear;
+
+	FLyraCurveLookupTable LinearExtrapTable;
+	TestFalse(TEXT("Linear post extrapolation does not bake"), LinearExtrapTable.Bake(LinearExtrapCurve, 256, Tolerance));
+	TestFalse(TEXT("Linear post extrapolation table is not valid"), LinearExtrapTable.IsValid());
+
+	FRichCurve CycleExtrapCurve;
+	MakeFalloffCurve(CycleExtrapCurve);
+	CycleExtrapCurve.PreInfinityExtrap = RCCE_Cycle;
+
+	FLyraCurveLookupTable CycleExtrapTable;
+	TestFalse(TEXT("Cycling pre extrapolation does not bake"), CycleExtrapTable.Bake(CycleExtrapCurve, 256, Tolerance));
+
+	// Flat curves (the usual heat per shot setup) bake down to a single value
+	FRichCurve FlatCurve;
+	FlatCurve.AddKey(0.0f, 2.0f);
+
+	FLyraCurveLookupTable FlatTable;
+	TestTrue(TEXT("Flat curve bakes"), FlatTable.Bake(FlatCurve, 256, Tolerance));
+	TestEqual(TEXT("Flat curve is a single sample"), FlatTable.Num(), 1);
+	TestEqual(TEXT("Flat curve value"), FlatTable.Eval(123.0f), 2.0f);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLyraCoolingTimeTableTest, "Lyra.Weapon.CurveLookupTable.CoolingTime", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ServerContext | EAutomationTestFlags::EngineFilter)
+
+bool FLyraCoolingTimeTableTest::RunTest(const FString& Parameters)
+{
+	const float Tolerance = 0.01f;
+
+	// A steady 2 heat per second cools linearly
+	{
+		FRichCurve SteadyCurve;
+		SteadyCurve.AddKey(0.0f, 2.0f);
+		SteadyCurve.AddKey(10.0f, 2.0f);
+
+		FLyraCoolingTimeTable Table;
+		Table.Build(SteadyCurve, 0.0f, 10.0f, 64);
+		TestTrue(TEXT("Steady table is valid"), Table.IsValid());
+
+		TestEqual(TEXT("Steady, one second"), Table.Cool(10.0f, 1.0), 8.0f, Tolerance);
+		TestEqual(TEXT("Steady, from the middle"), Table.Cool(5.0f, 0.5), 4.0f, Tolerance);
+		TestEqual(TEXT("Steady, all the way down"), Table.Cool(10.0f, 6.0), 0.0f);
+		TestEqual(TEXT("Steady, no time"), Table.Cool(7.5f, 0.0), 7.5f, Tolerance);
+	}
+
+	// Cools at 2 heat per second except between 5 and 6, where it does not cool at all
+	{
+		FRichCurve StallCurve;
+		const FKeyHandle Keys[] =
+		{
+			StallCurve.AddKey(0.0f, 2.0f),
+			StallCurve.AddKey(4.0f, 2.0f),
+			StallCurve.AddKey(5.0f, 0.0f),
+			StallCurve.AddKey(6.0f, 0.0f),
+			StallCurve.AddKey(7.0f, 2.0f),
+			StallCurve.AddKey(10.0f, 2.0f)
+		};
+
+		for (const FKeyHandle& Key : Keys)
+		{
+			StallCurve.SetKeyInterpMode(Key, RCIM_Linear);
+		}
+
+		const int32 NumSamples = 64;
+		const float HeatStep = 10.0f / (NumSamples - 1);
+
+		FLyraCoolingTimeTable Table;
+		Table.Build(StallCurve, 0.0f, 10.0f, NumSamples);
+
+		TestEqual(TEXT("Above the stall, one second"), Table.Cool(10.0f, 1.0), 8.0f, Tolerance);
+
+		// Never cools past the stall, however long it has, and never comes out as a huge or broken number
+		for (const double CoolingTime : { 3.0, 10.0, 1000.0, 1.0e9 })
+		{
+			const float Heat = Table.Cool(10.0f, CoolingTime);
+			if (!FMath::IsFinite(Heat) || (Heat < 6.0f) || (Heat > 6.0f + HeatStep))
+			{
+				AddError(FString::Printf(TEXT("Cooling from 10 for %f seconds gives %f, expected to stop just above 6."), CoolingTime, Heat));
+			}
+		}
+
+		TestEqual(TEXT("Inside the stall"), Table.Cool(5.5f, 100.0), 5.5f, Tolerance);
+		TestEqual(TEXT("Below the stall, all the way down"), Table.Cool(3.0f, 100.0), 0.0f);
+		TestEqual(TEXT("Below the stall, one second"), Table.Cool(3.0f, 1.0), 1.0f, Tolerance);
+
+		// Longer cooling never ends up hotter
+		float LastHeat = 10.0f;
+		for (double CoolingTime = 0.0; CoolingTime < 10.0; CoolingTime += 0.05)
+		{
+			const float Heat = Table.Cool(10.0f, CoolingTime);
+			if (Heat > LastHeat)
+			{
+				AddError(FString::Printf(TEXT("Heat went up from %f to %f after cooling for %f seconds."), LastHeat, Heat, CoolingTime));
+				break;
+			}
+			LastHeat = Heat;
+		}
+	}
+
+	// An empty heat range has nothing to cool through
+	{
+		FRichCurve FlatCurve;
+		FlatCurve.AddKey(0.0f, 1.0f);
+
+		FLyraCoolingTimeTable Table;
+		Table.Build(FlatCurve, 0.0f, 0.0f, 64);
+		TestFalse(TEXT("Empty heat range is not valid"), Table.IsValid());
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLyraCurveLookupTableBenchmark, "Lyra.Weapon.CurveLookupTable.Benchmark", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ServerContext | EAutomationTestFlags::PerfFilter)
+
+bool FLyraCurveLookupTableBenchmark::RunTest(const FString& Parameters)
+{
+	using namespace LyraCurveLookupTableTest;
+
+	FRichCurve Curve;
+	MakeFalloffCurve(Curve);
+
+	FLyraCurveLookupTable Table;
+	Table.Bake(Curve, 256, 0.01f);
+
+	const int32 NumEvals = 1000000;
+	const float DistanceStep = 25000.0f / NumEvals;
+
+	float CurveSum = 0.0f;
+	const double CurveStartTime = FPlatformTime::Seconds();
+	for (int32 Index = 0; Index < NumEvals; ++Index)
+	{
+		CurveSum += Curve.Eval(Index * DistanceStep);
+	}
+	const double CurveSeconds = FPlatformTime::Seconds() - CurveStartTime;
+
+	float TableSum = 0.0f;
+	const double TableStartTime = FPlatformTime::Seconds();
+	for (int32 Index = 0; Index < NumEvals; ++Index)
+	{
+		TableSum += Table.Eval(Index * DistanceStep);
+	}
+	const double TableSeconds = FPlatformTime::Seconds() - TableStartTime;
+
+	AddInfo(FString::Printf(TEXT("Rich curve: %.1f ns/eval, lookup table: %.1f ns/eval (%.1fx), mean difference %f"),
+		(CurveSeconds * 1.0e9) / NumEvals,
+		(TableSeconds * 1.0e9) / NumEvals,
+		CurveSeconds / FMath::Max(TableSeconds, UE_SMALL_NUMBER),
+		FMath::Abs(CurveSum - TableSum) / NumEvals));
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
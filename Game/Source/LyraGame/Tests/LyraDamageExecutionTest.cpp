@@ -0,0 +1,212 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "AbilitySystem/Attributes/LyraCombatSet.h"
+#include "AbilitySystem/Attributes/LyraHealthSet.h"
+#include "AbilitySystem/Executions/LyraDamageExecution.h"
+#include "AbilitySystem/LyraAbilitySystemComponent.h"
+#include "AbilitySystem/LyraGameplayAbilityTargetData_SingleTargetHit.h"
+#include "AbilitySystem/LyraGameplayEffectContext.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameplayEffect.h"
+#include "Misc/AutomationTest.h"
+#include "UObject/Package.h"
+#include "Weapons/LyraGameplayAbility_RangedWeapon.h"
+#include "Weapons/LyraRangedWeaponInstance.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace LyraDamageExecutionTest
+{
+	static const float BaseDamage = 10.0f;
+
+	// Distances the hits landed at, the falloff curve below takes 0.05 off the multiplier every 100 uu
+	static const double HitDistances[] = { 100.0, 500.0, 900.0 };
+	static const float ExpectedDamage = BaseDamage * (0.95f + 0.75f + 0.55f);
+
+	/** Scratch world with a source and two targets that only have what the damage execution reads. */
+	class FDamageArena
+	{
+	public:
+		FDamageArena()
+		{
+			World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("LyraDamageArena"), GetTransientPackage());
+			World->AddToRoot();
+
+			FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+			WorldContext.SetCurrentWorld(World);
+
+			World->InitializeActorsForPlay(FURL());
+
+			SourceActor = World->SpawnActor<AActor>();
+			SourceAbilitySystem = AddAbilitySystem(SourceActor);
+			SourceAbilitySystem->AddAttributeSetSubobject(NewObject<ULyraCombatSet>(SourceActor));
+			SourceAbilitySystem->SetNumericAttributeBase(ULyraCombatSet::GetBaseDamageAttribute(), BaseDamage);
+
+			// The weapon is the ability source, it maps the distance of every hit to a damage multiplier
+			Weapon = NewObject<ULyraRangedWeaponInstance>(SourceActor);
+			FStructProperty* FalloffProperty = FindFProperty<FStructProperty>(ULyraRangedWeaponInstance::StaticClass(), TEXT("DistanceDamageFalloff"));
+			check(FalloffProperty);
+			FRichCurve* Falloff = FalloffProperty->ContainerPtrToValuePtr<FRuntimeFloatCurve>(Weapon)->GetRichCurve();
+			Falloff->SetKeyInterpMode(Falloff->UpdateOrAddKey(0.0f, 1.0f), RCIM_Linear);
+			Falloff->SetKeyInterpMode(Falloff->UpdateOrAddKey(1000.0f, 0.5f), RCIM_Linear);
+
+			DamageEffect = NewObject<UGameplayEffect>(GetTransientPackage(), TEXT("LyraDamageExecutionTestEffect"));
+			DamageEffect->DurationPolicy = EGameplayEffectDurationType::Instant;
+			FGameplayEffectExecutionDefinition& Execution = DamageEffect->Executions.AddDefaulted_GetRef();
+			Execution.CalculationClass = ULyraDamageExecution::StaticClass();
+		}
+
+		~FDamageArena()
+		{
+			GEngine->DestroyWorldContext(World);
+			World->DestroyWorld(false);
+			World->RemoveFromRoot();
+		}
+
+		AActor* SpawnTarget()
+		{
+			AActor* TargetActor = World->SpawnActor<AActor>();
+			AddAbilitySystem(TargetActor)->AddAttributeSetSubobject(NewObject<ULyraHealthSet>(TargetActor));
+			return TargetActor;
+		}
+
+		// Hit on TargetActor HitDistance uu in front of the origin of the shot
+		FHitResult MakeHit(AActor* TargetActor, double HitDistance) const
+		{
+			FHitResult Hit;
+			Hit.bBlockingHit = true;
+			Hit.HitObjectHandle = FActorInstanceHandle(TargetActor);
+			Hit.TraceStart = Origin;
+			Hit.TraceEnd = Origin + FVector::ForwardVector * 2000.0;
+			Hit.Location = Origin + FVector::ForwardVector * HitDistance;
+			Hit.ImpactPoint = Hit.Location;
+			Hit.ImpactNormal = -FVector::ForwardVector;
+			Hit.Distance = HitDistance;
+			return Hit;
+		}
+
+		// Target data of one shot, the way the ranged weapon ability hands it to its blueprint
+		static FGameplayAbilityTargetDataHandle MakeTargetData(const TArray<FHitResult>& Hits)
+		{
+			FGameplayAbilityTargetDataHandle TargetData;
+			for (const FHitResult& Hit : Hits)
+			{
+				FLyraGameplayAbilityTargetData_SingleTargetHit* NewTargetData = new FLyraGameplayAbilityTargetData_SingleTargetHit();
+				NewTargetData->HitResult = Hit;
+				TargetData.Add(NewTargetData);
+			}
+			return TargetData;
+		}
+
+		// Damage spec made by the source, with the weapon as the ability source
+		FGameplayEffectSpec MakeDamageSpec() const
+		{
+			FGameplayEffectContextHandle EffectContext = SourceAbilitySystem->MakeEffectContext();
+
+			FLyraGameplayEffectContext* TypedContext = FLyraGameplayEffectContext::ExtractEffectContext(EffectContext);
+			check(TypedContext);
+			TypedContext->SetAbilitySource(Weapon, /*InSourceLevel=*/ 1.0f);
+
+			return FGameplayEffectSpec(DamageEffect, EffectContext, /*Level=*/ 1.0f);
+		}
+
+		// Applies the damage effect through every entry of TargetData, like ApplyGameplayEffectToTarget in a blueprint
+		void ApplyThroughTargetData(const FGameplayAbilityTargetDataHandle& TargetData) const
+		{
+			FGameplayEffectSpec Spec = MakeDamageSpec();
+			for (int32 DataIndex = 0; DataIndex < TargetData.Num(); ++DataIndex)
+			{
+				TargetData.Data[DataIndex]->ApplyGameplayEffectSpec(Spec);
+			}
+		}
+
+		void ApplyBatchedDamage(const TArray<FHitResult>& Hits) const
+		{
+			ULyraGameplayAbility_RangedWeapon::ApplyBatchedDamageEffectSpec(MakeTargetData(Hits), MakeDamageSpec());
+		}
+
+		float GetHealth(AActor* TargetActor) const
+		{
+			return GetAbilitySystem(TargetActor)->GetNumericAttribute(ULyraHealthSet::GetHealthAttribute());
+		}
+
+		UWorld* World = nullptr;
+		FVector Origin = FVector(0.0, 0.0, 100.0);
+
+	private:
+		ULyraAbilitySystemComponent* AddAbilitySystem(AActor* Actor) const
+		{
+			ULyraAbilitySystemComponent* AbilitySystem = NewObject<ULyraAbilitySystemComponent>(Actor);
+			AbilitySystem->RegisterComponent();
+			AbilitySystem->InitAbilityActorInfo(Actor, Actor);
+			return AbilitySystem;
+		}
+
+		static ULyraAbilitySystemComponent* GetAbilitySystem(AActor* Actor)
+		{
+			return Actor->FindComponentByClass<ULyraAbilitySystemComponent>();
+		}
+
+		AActor* SourceActor = nullptr;
+		ULyraAbilitySystemComponent* SourceAbilitySystem = nullptr;
+		ULyraRangedWeaponInstance* Weapon = nullptr;
+		UGameplayEffect* DamageEffect = nullptr;
+	};
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLyraDamageExecutionBatchedHitsTest, "Lyra.AbilitySystem.DamageExecution.BatchedHits", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ServerContext | EAutomationTestFlags::EngineFilter)
+
+bool FLyraDamageExecutionBatchedHitsTest::RunTest(const FString& Parameters)
+{
+	using namespace LyraDamageExecutionTest;
+
+	FDamageArena Arena;
+	AActor* SingleHitsTarget = Arena.SpawnTarget();
+	AActor* BatchedHitsTarget = Arena.SpawnTarget();
+	AActor* BlueprintTarget = Arena.SpawnTarget();
+
+	const float StartHealth = Arena.GetHealth(SingleHitsTarget);
+	TestEqual(TEXT("Same starting health"), Arena.GetHealth(BatchedHitsTarget), StartHealth);
+
+	// One execution per hit
+	TArray<FHitResult> BatchedHits;
+	TArray<FHitResult> BlueprintHits;
+	for (const double HitDistance : HitDistances)
+	{
+		Arena.ApplyThroughTargetData(FDamageArena::MakeTargetData({ Arena.MakeHit(SingleHitsTarget, HitDistance) }));
+		BatchedHits.Add(Arena.MakeHit(BatchedHitsTarget, HitDistance));
+		BlueprintHits.Add(Arena.MakeHit(BlueprintTarget, HitDistance));
+	}
+
+	// One execution for all of them
+	Arena.ApplyBatchedDamage(BatchedHits);
+
+	const float SingleHitsDamage = StartHealth - Arena.GetHealth(SingleHitsTarget);
+	const float BatchedHitsDamage = StartHealth - Arena.GetHealth(BatchedHitsTarget);
+	TestEqual(TEXT("Damage of the single hits"), SingleHitsDamage, ExpectedDamage, 1.0e-3f);
+	TestEqual(TEXT("Batched damage is the sum of the single hits"), BatchedHitsDamage, SingleHitsDamage, 1.0e-3f);
+
+	// The shot's target data as the blueprint receives it, applying through all of it must damage once per target
+	FGameplayAbilityTargetDataHandle BlueprintTargetData = FDamageArena::MakeTargetData(BlueprintHits);
+	ULyraGameplayAbility_RangedWeapon::BatchHitsPerTarget(BlueprintTargetData);
+
+	int32 NumTargetedEntries = 0;
+	for (int32 DataIndex = 0; DataIndex < BlueprintTargetData.Num(); ++DataIndex)
+	{
+		NumTargetedEntries += (BlueprintTargetData.Data[DataIndex]->GetActors().Num() > 0) ? 1 : 0;
+	}
+	TestEqual(TEXT("Entries still targeting the actor"), NumTargetedEntries, 1);
+
+	Arena.ApplyThroughTargetData(BlueprintTargetData);
+	TestEqual(TEXT("Blueprint damage is the sum of the single hits"), StartHealth - Arena.GetHealth(BlueprintTarget), SingleHitsDamage, 1.0e-3f);
+
+	// A batch of one is the single hit path
+	AActor* SingleBatchTarget = Arena.SpawnTarget();
+	Arena.ApplyBatchedDamage({ Arena.MakeHit(SingleBatchTarget, HitDistances[0]) });
+	TestEqual(TEXT("Damage of one hit"), StartHealth - Arena.GetHealth(SingleBatchTarget), BaseDamage * 0.95f, 1.0e-3f);
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,298 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "HAL/PlatformTime.h"
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+#include "Weapons/LyraLagCompensationSubsystem.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace LyraLagCompensationTest
+{
+	struct FShot
+	{
+		FVector Start;
+		FVector End;
+	};
+
+	// Characters spread over an arena, each with a window of frames running in a random direction.
+	static void MakeRandomHistories(int32 Seed, int32 NumCharacters, TArray<FLyraHitboxHistory>& OutHistories)
+	{
+		FRandomStream Random(Seed);
+
+		OutHistories.Reset(NumCharacters);
+		for (int32 Index = 0; Index < NumCharacters; ++Index)
+		{
+			FLyraHitboxHistory& History = OutHistories.AddDefaulted_GetRef();
+
+			FVector Location(Random.FRandRange(-8000.0f, 8000.0f), Random.FRandRange(-8000.0f, 8000.0f), Random.FRandRange(0.0f, 1000.0f));
+			const FVector Velocity = Random.GetUnitVector() * Random.FRandRange(0.0f, 1200.0f);
+
+			for (int32 Frame = 0; Frame < 20; ++Frame)
+			{
+				FLyraHitboxFrame HitboxFrame;
+				HitboxFrame.Time = Frame / 60.0;
+				HitboxFrame.Location = Location;
+				HitboxFrame.CapsuleRadius = 40.0f;
+				HitboxFrame.CapsuleHalfHeight = 90.0f;
+				History.Record(HitboxFrame);
+
+				Location += Velocity / 60.0;
+			}
+		}
+	}
+
+	// Every character fires one shot at a random spot, so the number of shots scales with the player count.
+	static void MakeRandomShots(int32 Seed, const TArray<FLyraHitboxHistory>& Histories, TArray<FShot>& OutShots)
+	{
+		FRandomStream Random(Seed);
+
+		OutShots.Reset(Histories.Num());
+		for (const FLyraHitboxHistory& History : Histories)
+		{
+			FShot& Shot = OutShots.AddDefaulted_GetRef();
+			Shot.Start = History.GetFrame(0).Location;
+
+			// Mix of long range shots, shotgun range shots and straight up or down ones (zero direction components).
+			const int32 Kind = Random.RandRange(0, 3);
+			const FVector Direction = (Kind == 0) ? FVector(0.0, 0.0, Random.RandRange(0, 1) ? 1.0 : -1.0) : Random.GetUnitVector();
+			Shot.End = Shot.Start + Direction * ((Kind == 1) ? 1500.0 : 20000.0);
+		}
+	}
+
+	static void GatherScalar(const TArray<FLyraHitboxHistory>& Histories, const FShot& Shot, float Inflate, TArray<int32>& OutLanes)
+	{
+		for (int32 Index = 0; Index < Histories.Num(); ++Index)
+		{
+			if (Histories[Index].GetWindowCapsule().IntersectsSegment(Shot.Start, Shot.End, Inflate))
+			{
+				OutLanes.Add(Index);
+			}
+		}
+	}
+
+	// True if the shot passes through any recorded hitbox of the character, the way the narrow phase tests them
+	static bool HitsAnyFrame(const FLyraHitboxHistory& History, const FShot& Shot, float Inflate)
+	{
+		for (int32 Age = 0; Age < History.NumFrames; ++Age)
+		{
+			const FLyraHitboxFrame& Frame = History.GetFrame(Age);
+			const FVector AxisOffset(0.0, 0.0, FMath::Max(Frame.CapsuleHalfHeight - Frame.CapsuleRadius, 0.0f));
+
+			FVector PointOnShot;
+			FVector PointOnAxis;
+			FMath::SegmentDistToSegmentSafe(Shot.Start, Shot.End, Frame.Location - AxisOffset, Frame.Location + AxisOffset, PointOnShot, PointOnAxis);
+			if (FVector::Dist(PointOnShot, PointOnAxis) <= (Frame.CapsuleRadius + Inflate))
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	static void BuildBatch(const TArray<FLyraHitboxHistory>& Histories, FLyraHitboxCapsuleBatch& Batch)
+	{
+		Batch.Reset(Histories.Num());
+		for (const FLyraHitboxHistory& History : Histories)
+		{
+			Batch.Add(History.GetWindowCapsule());
+		}
+	}
+
+	static FLyraHitboxWindowCapsule MakeCapsuleAtOrigin()
+	{
+		FLyraHitboxWindowCapsule Capsule;
+		Capsule.BottomZ = -50.0;
+		Capsule.TopZ = 50.0;
+		Capsule.Radius = 40.0;
+		Capsule.bIsValid = true;
+		return Capsule;
+	}
+};
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLyraLagCompensationBroadPhaseTest, "Lyra.Weapon.LagCompensation.BroadPhase", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ServerContext | EAutomationTestFlags::EngineFilter)
+
+bool FLyraLagCompensationBroadPhaseTest::RunTest(const FString& Parameters)
+{
+	using namespace LyraLagCompensationTest;
+
+	const float Inflate = 20.0f;
+
+	// Random arenas at a small match, a full lobby and a full server: everything the scalar test finds must be returned.
+	for (const int32 NumCharacters : { 10, 32, 64 })
+	{
+		TArray<FLyraHitboxHistory> Histories;
+		MakeRandomHistories(NumCharacters, NumCharacters, Histories);
+
+		TArray<FShot> Shots;
+		MakeRandomShots(NumCharacters + 1, Histories, Shots);
+
+		// Point blank shots through every character, these must always be found.
+		for (const FLyraHitboxHistory& History : Histories)
+		{
+			const FVector Center = History.GetFrame(0).Location;
+			Shots.Add({ Center - FVector(500.0, 0.0, 0.0), Center + FVector(500.0, 0.0, 0.0) });
+		}
+
+		FLyraHitboxCapsuleBatch Batch;
+		BuildBatch(Histories, Batch);
+		TestEqual(TEXT("Lanes"), Batch.Num(), NumCharacters);
+
+		for (int32 ShotIndex = 0; ShotIndex < Shots.Num(); ++ShotIndex)
+		{
+			TArray<int32> Expected;
+			GatherScalar(Histories, Shots[ShotIndex], Inflate, Expected);
+
+			TArray<int32> Actual;
+			Batch.GatherSegment(Shots[ShotIndex].Start, Shots[ShotIndex].End, Inflate, Actual);
+
+			// The prefilter may only be conservative: everything the scalar test finds must be there, and anything
+			// extra may only be a grazing hit within rounding of the capsule.
+			for (const int32 Lane : Expected)
+			{
+				if (!Actual.Contains(Lane))
+				{
+					AddError(FString::Printf(TEXT("%d characters, shot %d: lane %d missed by the batched broad phase."), NumCharacters, ShotIndex, Lane));
+					return false;
+				}
+			}
+
+			// And the window capsule has to hold every hitbox it stands for
+			for (int32 Index = 0; Index < Histories.Num(); ++Index)
+			{
+				if (!Actual.Contains(Index) && HitsAnyFrame(Histories[Index], Shots[ShotIndex], Inflate))
+				{
+					AddError(FString::Printf(TEXT("%d characters, shot %d: hitbox of character %d hit but the broad phase missed it."), NumCharacters, ShotIndex, Index));
+					return false;
+				}
+			}
+
+			TArray<int32> Loose;
+			GatherScalar(Histories, Shots[ShotIndex], Inflate + 1.0f, Loose);
+			for (const int32 Lane : Actual)
+			{
+				if (!Histories.IsValidIndex(Lane) || !Loose.Contains(Lane))
+				{
+					AddError(FString::Printf(TEXT("%d characters, shot %d: lane %d returned but the segment does not come near it."), NumCharacters, ShotIndex, Lane));
+					return false;
+				}
+			}
+		}
+	}
+
+	// Every character stacked on the origin, shots through it along each axis (zero direction components on the
+	// other two) and diagonally.  Exactly the real characters come back, never the lanes padding out the last register.
+	{
+		const FLyraHitboxWindowCapsule AtOrigin = MakeCapsuleAtOrigin();
+		const FShot ThroughOrigin[] = {
+			{ FVector(-5000.0, 0.0, 0.0), FVector(5000.0, 0.0, 0.0) },
+			{ FVector(0.0, 5000.0, 0.0), FVector(0.0, -5000.0, 0.0) },
+			{ FVector(0.0, 0.0, -5000.0), FVector(0.0, 0.0, 5000.0) },
+			{ FVector(-5000.0, -5000.0, -5000.0), FVector(5000.0, 5000.0, 5000.0) } };
+
+		FLyraHitboxCapsuleBatch Batch;
+		for (int32 NumCharacters = 1; NumCharacters <= 9; ++NumCharacters)
+		{
+			Batch.Reset(NumCharacters);
+			for (int32 Index = 0; Index < NumCharacters; ++Index)
+			{
+				Batch.Add(AtOrigin);
+			}
+
+			for (const FShot& Shot : ThroughOrigin)
+			{
+				TArray<int32> Lanes;
+				Batch.GatherSegment(Shot.Start, Shot.End, 0.0f, Lanes);
+
+				Lanes.Sort();
+				bool bExactlyEveryCharacter = (Lanes.Num() == NumCharacters);
+				for (int32 Index = 0; bExactlyEveryCharacter && (Index < NumCharacters); ++Index)
+				{
+					bExactlyEveryCharacter = (Lanes[Index] == Index);
+				}
+
+				if (!bExactlyEveryCharacter)
+				{
+					AddError(FString::Printf(TEXT("%d characters at the origin: shot from %s returned %d lanes."), NumCharacters, *Shot.Start.ToString(), Lanes.Num()));
+				}
+			}
+		}
+	}
+
+	// Characters with nothing recorded yet are never returned, even sharing a register with one that is hit.
+	{
+		FLyraHitboxCapsuleBatch Batch;
+		Batch.Add(FLyraHitboxWindowCapsule());
+		Batch.Add(MakeCapsuleAtOrigin());
+		Batch.Add(FLyraHitboxWindowCapsule());
+
+		TArray<int32> Lanes;
+		Batch.GatherSegment(FVector(-100.0, 0.0, 0.0), FVector(100.0, 0.0, 0.0), 1000.0f, Lanes);
+		TestTrue(TEXT("Only the recorded character"), (Lanes.Num() == 1) && (Lanes[0] == 1));
+
+		Lanes.Reset();
+		Batch.GatherSegment(FVector(0.0, 0.0, -1.0e6), FVector(0.0, 0.0, 1.0e6), 1000.0f, Lanes);
+		TestTrue(TEXT("Only the recorded character, straight up"), (Lanes.Num() == 1) && (Lanes[0] == 1));
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLyraLagCompensationBroadPhaseBenchmark, "Lyra.Weapon.LagCompensation.BroadPhase.Benchmark", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ServerContext | EAutomationTestFlags::PerfFilter)
+
+bool FLyraLagCompensationBroadPhaseBenchmark::RunTest(const FString& Parameters)
+{
+	using namespace LyraLagCompensationTest;
+
+	const float Inflate = 20.0f;
+	const int32 NumIterations = 50;
+
+	for (const int32 NumCharacters : { 16, 64, 256 })
+	{
+		TArray<FLyraHitboxHistory> Histories;
+		MakeRandomHistories(0, NumCharacters, Histories);
+
+		TArray<FShot> Shots;
+		MakeRandomShots(1, Histories, Shots);
+
+		int64 Checksum = 0;
+		TArray<int32> Lanes;
+
+		// The scalar path recomputes window capsules per shot and tests them one at a time.
+		const double ScalarStart = FPlatformTime::Seconds();
+		for (int32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+		{
+			for (const FShot& Shot : Shots)
+			{
+				Lanes.Reset();
+				GatherScalar(Histories, Shot, Inflate, Lanes);
+				Checksum += Lanes.Num();
+			}
+		}
+		const double ScalarSeconds = FPlatformTime::Seconds() - ScalarStart;
+
+		// The batched path packs the capsules once per tick and shares them between every shot.
+		FLyraHitboxCapsuleBatch Batch;
+		const double BatchStart = FPlatformTime::Seconds();
+		for (int32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+		{
+			BuildBatch(Histories, Batch);
+			for (const FShot& Shot : Shots)
+			{
+				Lanes.Reset();
+				Batch.GatherSegment(Shot.Start, Shot.End, Inflate, Lanes);
+				Checksum += Lanes.Num();
+			}
+		}
+		const double BatchSeconds = FPlatformTime::Seconds() - BatchStart;
+
+		const double NumShots = double(Shots.Num()) * NumIterations;
+		AddInfo(FString::Printf(TEXT("%d characters, %d shots per tick: scalar %.2f us/shot, batched %.2f us/shot including packing (checksum %lld)"),
+			NumCharacters, Shots.Num(), (ScalarSeconds * 1e6) / NumShots, (BatchSeconds * 1e6) / NumShots, Checksum));
+	}
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
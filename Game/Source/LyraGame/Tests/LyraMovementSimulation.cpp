@@ -0,0 +1,531 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Tests/LyraMovementSimulation.h"
+
+#include "Character/LyraCharacter.h"
+#include "Character/LyraCharacterMovementComponent.h"
+#include "Components/BoxComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "Engine/CollisionProfile.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformTime.h"
+#include "LyraLogChannels.h"
+#include "Misc/Paths.h"
+#include "Serialization/Archive.h"
+#include "UObject/Package.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace LyraMovementSimulation
+{
+	// Bump whenever the file layout changes so stale goldens are rejected instead of misread.
+	static const uint32 InputStreamMagic = 0x4C4D4953;	// 'LMIS'
+	static const uint32 TrajectoryMagic = 0x4C4D5452;	// 'LMTR'
+	static const int32 FileVersion = 3;
+
+	// Characters are spread out along Y so they never collide with each other.
+	static const double CharacterSpacing = 400.0;
+	static const double SpawnHeight = 200.0;
+
+	static const FVector ArenaExtent(200000.0, 200000.0, 50.0);
+
+	// A 60 degree surf ramp, too steep to walk on, far enough down +X that the other scenarios never reach it.
+	// It runs along Y so every character of a throughput run drops onto it, and rises towards +X.
+	static const FVector RampLocation(100000.0, 20000.0, 4000.0);
+	static const FVector RampExtent(4000.0, 40000.0, 50.0);
+	static const FRotator RampRotation(60.0, 0.0, 0.0);
+
+	static FVector GetRampNormal()
+	{
+		return RampRotation.RotateVector(FVector::UpVector);
+	}
+
+	static FVector YawToDirection(double YawDegrees)
+	{
+		double Sin, Cos;
+		FMath::SinCos(&Sin, &Cos, FMath::DegreesToRadians(YawDegrees));
+		return FVector(Cos, Sin, 0.0);
+	}
+
+	// Ground acceleration followed by release, exercises ApplyAcceleration and ApplyFriction.
+	static void BuildGroundRunStop(FLyraMovementInputStream& Stream)
+	{
+		for (int32 Frame = 0; Frame < 120; ++Frame)
+		{
+			FLyraMovementInputFrame& Input = Stream.Frames.AddDefaulted_GetRef();
+			Input.InputVector = (Frame < 60) ? FVector::ForwardVector : FVector::ZeroVector;
+		}
+	}
+
+	// Single jump with alternating strafes while turning, exercises ApplyAirAcceleration.
+	static void BuildAirStrafe(FLyraMovementInputStream& Stream)
+	{
+		double Yaw = 0.0;
+		for (int32 Frame = 0; Frame < 180; ++Frame)
+		{
+			FLyraMovementInputFrame& Input = Stream.Frames.AddDefaulted_GetRef();
+			if (Frame < 30)
+			{
+				Input.InputVector = FVector::ForwardVector;
+				continue;
+			}
+
+			Input.bJump = (Frame == 30);
+
+			// Turn towards the strafe key like a player dragging the mouse.
+			const bool bStrafeRight = (((Frame - 30) / 20) % 2) == 0;
+			Yaw += bStrafeRight ? 3.0 : -3.0;
+			Input.InputVector = YawToDirection(Yaw + (bStrafeRight ? 90.0 : -90.0));
+		}
+	}
+
+	// Held jump with alternating strafes so every landing immediately jumps again.
+	static void BuildBhopStrafe(FLyraMovementInputStream& Stream)
+	{
+		double Yaw = 0.0;
+		for (int32 Frame = 0; Frame < 600; ++Frame)
+		{
+			FLyraMovementInputFrame& Input = Stream.Frames.AddDefaulted_GetRef();
+			if (Frame < 30)
+			{
+				Input.InputVector = FVector::ForwardVector;
+				continue;
+			}
+
+			Input.bJump = true;
+
+			const bool bStrafeRight = (((Frame - 30) / 25) % 2) == 0;
+			Yaw += bStrafeRight ? 2.5 : -2.5;
+			Input.InputVector = YawToDirection(Yaw + (bStrafeRight ? 90.0 : -90.0));
+		}
+	}
+
+	// AI style path following through RequestDirectMove: a straight run, a turn, another run, then the path ends.
+	static void BuildPathFollow(FLyraMovementInputStream& Stream)
+	{
+		const double PathSpeed = 400.0;
+		double Yaw = 0.0;
+		for (int32 Frame = 0; Frame < 240; ++Frame)
+		{
+			FLyraMovementInputFrame& Input = Stream.Frames.AddDefaulted_GetRef();
+			if (Frame >= 200)
+			{
+				continue;
+			}
+
+			if ((Frame >= 90) && (Frame < 120))
+			{
+				Yaw += 3.0;
+			}
+			Input.RequestedVelocity = YawToDirection(Yaw) * PathSpeed;
+		}
+	}
+
+	// Drop onto the surf ramp, then hold into it while strafing along it, exercises PhysSurf and ProbeSurfPlane.
+	static void BuildRampSurf(FLyraMovementInputStream& Stream)
+	{
+		Stream.StartLocation = RampLocation + GetRampNormal() * RampExtent.Z;
+
+		const FVector IntoRamp = -GetRampNormal().GetSafeNormal2D();
+		for (int32 Frame = 0; Frame < 180; ++Frame)
+		{
+			FLyraMovementInputFrame& Input = Stream.Frames.AddDefaulted_GetRef();
+			if (Frame >= 30)
+			{
+				Input.InputVector = (IntoRamp + FVector::RightVector).GetSafeNormal();
+			}
+		}
+	}
+
+	struct FScenario
+	{
+		const TCHAR* Name;
+		void (*Build)(FLyraMovementInputStream&);
+	};
+
+	static const FScenario BuiltInScenarios[] =
+	{
+		{ TEXT("GroundRunStop"), &BuildGroundRunStop },
+		{ TEXT("AirStrafe"), &BuildAirStrafe },
+		{ TEXT("BhopStrafe"), &BuildBhopStrafe },
+		{ TEXT("PathFollow"), &BuildPathFollow },
+		{ TEXT("RampSurf"), &BuildRampSurf },
+	};
+
+	template <typename T>
+	static bool SaveArchivable(const FString& Filename, T& Object)
+	{
+		IFileManager::Get().MakeDirectory(*FPaths::GetPath(Filename), true);
+
+		TUniquePtr<FArchive> Ar(IFileManager::Get().CreateFileWriter(*Filename));
+		if (!Ar)
+		{
+			UE_LOG(LogLyra, Error, TEXT("Failed to open [%s] for writing."), *Filename);
+			return false;
+		}
+
+		*Ar << Object;
+		return Ar->Close();
+	}
+
+	template <typename T>
+	static bool LoadArchivable(const FString& Filename, T& Object)
+	{
+		TUniquePtr<FArchive> Ar(IFileManager::Get().CreateFileReader(*Filename));
+		if (!Ar)
+		{
+			return false;
+		}
+
+		*Ar << Object;
+		return !Ar->IsError();
+	}
+};
+
+//////////////////////////////////////////////////////////////////////
+// FLyraMovementInputStream
+
+FArchive& operator<<(FArchive& Ar, FLyraMovementInputStream& Stream)
+{
+	uint32 Magic = LyraMovementSimulation::InputStreamMagic;
+	int32 Version = LyraMovementSimulation::FileVersion;
+	Ar << Magic;
+	Ar << Version;
+
+	if (Ar.IsLoading() && ((Magic != LyraMovementSimulation::InputStreamMagic) || (Version != LyraMovementSimulation::FileVersion)))
+	{
+		Ar.SetError();
+		return Ar;
+	}
+
+	Ar << Stream.Name;
+	Ar << Stream.FixedDeltaTime;
+	Ar << Stream.StartLocation;
+
+	int32 NumFrames = Stream.Frames.Num();
+	Ar << NumFrames;
+
+	if (Ar.IsLoading())
+	{
+		Stream.Frames.SetNum(NumFrames);
+	}
+
+	for (FLyraMovementInputFrame& Frame : Stream.Frames)
+	{
+		Ar << Frame.InputVector;
+		Ar << Frame.bJump;
+		Ar << Frame.RequestedVelocity;
+	}
+
+	return Ar;
+}
+
+bool FLyraMovementInputStream::SaveToFile(const FString& Filename) const
+{
+	return LyraMovementSimulation::SaveArchivable(Filename, const_cast<FLyraMovementInputStream&>(*this));
+}
+
+bool FLyraMovementInputStream::LoadFromFile(const FString& Filename)
+{
+	return LyraMovementSimulation::LoadArchivable(Filename, *this);
+}
+
+TArray<FString> FLyraMovementInputStream::GetBuiltInScenarioNames()
+{
+	TArray<FString> Names;
+	for (const LyraMovementSimulation::FScenario& Scenario : LyraMovementSimulation::BuiltInScenarios)
+	{
+		Names.Add(Scenario.Name);
+	}
+	return Names;
+}
+
+bool FLyraMovementInputStream::MakeBuiltInScenario(const FString& ScenarioName, FLyraMovementInputStream& OutStream)
+{
+	for (const LyraMovementSimulation::FScenario& Scenario : LyraMovementSimulation::BuiltInScenarios)
+	{
+		if (ScenarioName.Equals(Scenario.Name, ESearchCase::IgnoreCase))
+		{
+			OutStream = FLyraMovementInputStream();
+			OutStream.Name = Scenario.Name;
+			Scenario.Build(OutStream);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+//////////////////////////////////////////////////////////////////////
+// FLyraMovementTrajectory
+
+void FLyraMovementTrajectory::Reset(int32 ExpectedFrames)
+{
+	Locations.Reset(ExpectedFrames);
+	Velocities.Reset(ExpectedFrames);
+}
+
+void FLyraMovementTrajectory::AddSample(const FVector& Location, const FVector& Velocity)
+{
+	Locations.Add(Location);
+	Velocities.Add(Velocity);
+}
+
+bool FLyraMovementTrajectory::IsBitIdentical(const FLyraMovementTrajectory& Other, int32& OutFirstMismatchFrame) const
+{
+	const int32 NumCommon = FMath::Min(Num(), Other.Num());
+	for (int32 Frame = 0; Frame < NumCommon; ++Frame)
+	{
+		// Compare the raw bits, -0.0 vs 0.0 or differing NaN payloads count as a change in behavior.
+		if ((FMemory::Memcmp(&Locations[Frame], &Other.Locations[Frame], sizeof(FVector)) != 0) ||
+			(FMemory::Memcmp(&Velocities[Frame], &Other.Velocities[Frame], sizeof(FVector)) != 0))
+		{
+			OutFirstMismatchFrame = Frame;
+			return false;
+		}
+	}
+
+	if (Num() != Other.Num())
+	{
+		OutFirstMismatchFrame = NumCommon;
+		return false;
+	}
+
+	OutFirstMismatchFrame = INDEX_NONE;
+	return true;
+}
+
+FArchive& operator<<(FArchive& Ar, FLyraMovementTrajectory& Trajectory)
+{
+	uint32 Magic = LyraMovementSimulation::TrajectoryMagic;
+	int32 Version = LyraMovementSimulation::FileVersion;
+	Ar << Magic;
+	Ar << Version;
+
+	if (Ar.IsLoading() && ((Magic != LyraMovementSimulation::TrajectoryMagic) || (Version != LyraMovementSimulation::FileVersion)))
+	{
+		Ar.SetError();
+		return Ar;
+	}
+
+	Ar << Trajectory.Locations;
+	Ar << Trajectory.Velocities;
+
+	if (Ar.IsLoading() && (Trajectory.Locations.Num() != Trajectory.Velocities.Num()))
+	{
+		Ar.SetError();
+	}
+
+	return Ar;
+}
+
+bool FLyraMovementTrajectory::SaveToFile(const FString& Filename) const
+{
+	return LyraMovementSimulation::SaveArchivable(Filename, const_cast<FLyraMovementTrajectory&>(*this));
+}
+
+bool FLyraMovementTrajectory::LoadFromFile(const FString& Filename)
+{
+	return LyraMovementSimulation::LoadArchivable(Filename, *this);
+}
+
+//////////////////////////////////////////////////////////////////////
+// FLyraMovementSimulation
+
+FLyraMovementSimulation::FLyraMovementSimulation()
+	: World(nullptr)
+{
+}
+
+FLyraMovementSimulation::~FLyraMovementSimulation()
+{
+	Shutdown();
+}
+
+bool FLyraMovementSimulation::Initialize()
+{
+	check(GEngine);
+
+	if (World)
+	{
+		return true;
+	}
+
+	World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("LyraMovementSimulation"), GetTransientPackage());
+	if (!World)
+	{
+		UE_LOG(LogLyra, Error, TEXT("LyraMovementSimulation: Failed to create a world."));
+		return false;
+	}
+
+	World->AddToRoot();
+
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+
+	// Initialize actors so spawned characters run InitializeComponent, but never begin play.
+	// The harness ticks the movement components itself so nothing else in the world can affect the result.
+	World->InitializeActorsForPlay(FURL());
+
+	SpawnArena();
+
+	return true;
+}
+
+void FLyraMovementSimulation::Shutdown()
+{
+	if (!World)
+	{
+		return;
+	}
+
+	DestroyCharacters();
+
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+	World->RemoveFromRoot();
+	World = nullptr;
+}
+
+void FLyraMovementSimulation::SpawnArena()
+{
+	AActor* Arena = World->SpawnActor<AActor>();
+	check(Arena);
+
+	UBoxComponent* Floor = NewObject<UBoxComponent>(Arena, TEXT("Floor"));
+	Floor->SetMobility(EComponentMobility::Static);
+	Floor->SetBoxExtent(LyraMovementSimulation::ArenaExtent);
+	Floor->SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
+	Arena->SetRootComponent(Floor);
+	Floor->SetWorldLocation(FVector(0.0, 0.0, -LyraMovementSimulation::ArenaExtent.Z));
+	Floor->RegisterComponent();
+
+	UBoxComponent* Ramp = NewObject<UBoxComponent>(Arena, TEXT("Ramp"));
+	Ramp->SetMobility(EComponentMobility::Static);
+	Ramp->SetBoxExtent(LyraMovementSimulation::RampExtent);
+	Ramp->SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
+	Ramp->SetupAttachment(Floor);
+	Ramp->SetWorldLocationAndRotation(LyraMovementSimulation::RampLocation, LyraMovementSimulation::RampRotation);
+	Ramp->RegisterComponent();
+}
+
+ALyraCharacter* FLyraMovementSimulation::SpawnCharacter(int32 Index, const FVector& StartLocation)
+{
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	const FVector SpawnLocation = StartLocation + FVector(0.0, double(Index) * LyraMovementSimulation::CharacterSpacing, LyraMovementSimulation::SpawnHeight);
+	ALyraCharacter* Character = World->SpawnActor<ALyraCharacter>(ALyraCharacter::StaticClass(), SpawnLocation, FRotator::ZeroRotator, SpawnParams);
+	if (!Character)
+	{
+		return nullptr;
+	}
+
+	ULyraCharacterMovementComponent* MoveComp = CastChecked<ULyraCharacterMovementComponent>(Character->GetCharacterMovement());
+
+	// There is no controller in the harness, so let the authority path drive the character directly.
+	MoveComp->bRunPhysicsWithNoController = true;
+	MoveComp->SetMovementMode(MOVE_Falling);
+
+	return Character;
+}
+
+void FLyraMovementSimulation::DestroyCharacters()
+{
+	for (ALyraCharacter* Character : Characters)
+	{
+		if (IsValid(Character))
+		{
+			Character->Destroy();
+		}
+	}
+
+	Characters.Reset();
+}
+
+bool FLyraMovementSimulation::Run(const FLyraMovementInputStream& Stream, int32 NumCharacters, FLyraMovementSimulationResult& OutResult)
+{
+	if (!Initialize())
+	{
+		return false;
+	}
+
+	DestroyCharacters();
+
+	NumCharacters = FMath::Max(NumCharacters, 1);
+	for (int32 Index = 0; Index < NumCharacters; ++Index)
+	{
+		ALyraCharacter* Character = SpawnCharacter(Index, Stream.StartLocation);
+		if (!Character)
+		{
+			UE_LOG(LogLyra, Error, TEXT("LyraMovementSimulation: Failed to spawn character %d."), Index);
+			DestroyCharacters();
+			return false;
+		}
+		Characters.Add(Character);
+	}
+
+	OutResult = FLyraMovementSimulationResult();
+	OutResult.Trajectory.Reset(Stream.Frames.Num());
+	OutResult.SurfingFrames.Reset(Stream.Frames.Num());
+
+	const float DeltaTime = Stream.FixedDeltaTime;
+
+	for (const FLyraMovementInputFrame& Input : Stream.Frames)
+	{
+		for (ALyraCharacter* Character : Characters)
+		{
+			if (!Input.InputVector.IsZero())
+			{
+				Character->AddMovementInput(Input.InputVector);
+			}
+
+			if (Input.bJump)
+			{
+				Character->Jump();
+			}
+			else
+			{
+				Character->StopJumping();
+			}
+
+			if (!Input.RequestedVelocity.IsZero())
+			{
+				Character->GetCharacterMovement()->RequestDirectMove(Input.RequestedVelocity, false);
+			}
+		}
+
+		const double StartTime = FPlatformTime::Seconds();
+		for (ALyraCharacter* Character : Characters)
+		{
+			UCharacterMovementComponent* MoveComp = Character->GetCharacterMovement();
+			MoveComp->TickComponent(DeltaTime, LEVELTICK_All, &MoveComp->PrimaryComponentTick);
+		}
+		OutResult.MovementSeconds += FPlatformTime::Seconds() - StartTime;
+		OutResult.CharacterTicks += Characters.Num();
+
+		// Advance world time (used by the bhop landing window) and keep the physics scene in sync.
+		World->Tick(LEVELTICK_All, DeltaTime);
+
+		const ALyraCharacter* FirstCharacter = Characters[0];
+		OutResult.Trajectory.AddSample(FirstCharacter->GetActorLocation(), FirstCharacter->GetCharacterMovement()->Velocity);
+		OutResult.SurfingFrames.Add(CastChecked<ULyraCharacterMovementComponent>(FirstCharacter->GetCharacterMovement())->IsSurfing());
+	}
+
+	DestroyCharacters();
+
+	return true;
+}
+
+FString FLyraMovementSimulation::GetGoldenDirectory()
+{
+	return FPaths::ProjectDir() / TEXT("Tests/Movement");
+}
+
+FString FLyraMovementSimulation::GetGoldenFilename(const FString& ScenarioName)
+{
+	return GetGoldenDirectory() / (ScenarioName + TEXT(".trajectory"));
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,148 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "Containers/Array.h"
+#include "Containers/UnrealString.h"
+#include "Math/Vector.h"
+#include "Misc/Build.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+class ALyraCharacter;
+class UWorld;
+
+/**
+ * FLyraMovementInputFrame
+ *
+ *	A single fixed-timestep frame of recorded movement input.
+ */
+struct FLyraMovementInputFrame
+{
+	// World space input vector, as it would be passed to AddMovementInput.
+	FVector InputVector = FVector::ZeroVector;
+
+	// True if the jump button is held during this frame.
+	bool bJump = false;
+
+	// Velocity requested by path following (RequestDirectMove) during this frame, zero for none.
+	FVector RequestedVelocity = FVector::ZeroVector;
+};
+
+/**
+ * FLyraMovementInputStream
+ *
+ *	A recorded (or scripted) stream of movement input that is replayed at a fixed timestep.
+ */
+struct LYRAGAME_API FLyraMovementInputStream
+{
+	FString Name;
+
+	float FixedDeltaTime = 1.0f / 60.0f;
+
+	// Where the first character is spawned, before the spawn height and per character spacing are added.
+	FVector StartLocation = FVector::ZeroVector;
+
+	TArray<FLyraMovementInputFrame> Frames;
+
+	bool SaveToFile(const FString& Filename) const;
+	bool LoadFromFile(const FString& Filename);
+
+	friend FArchive& operator<<(FArchive& Ar, FLyraMovementInputStream& Stream);
+
+	// Returns the names of the built-in scenarios.
+	static TArray<FString> GetBuiltInScenarioNames();
+
+	// Builds one of the built-in scenarios, returns false if the name is unknown.
+	static bool MakeBuiltInScenario(const FString& ScenarioName, FLyraMovementInputStream& OutStream);
+};
+
+/**
+ * FLyraMovementTrajectory
+ *
+ *	Per-frame location and velocity of a simulated character.  Compared bit-for-bit against golden files.
+ */
+struct LYRAGAME_API FLyraMovementTrajectory
+{
+	TArray<FVector> Locations;
+	TArray<FVector> Velocities;
+
+	void Reset(int32 ExpectedFrames);
+	void AddSample(const FVector& Location, const FVector& Velocity);
+	int32 Num() const { return Locations.Num(); }
+
+	// Returns true if both trajectories are bit identical, otherwise fills in the first frame that differs.
+	bool IsBitIdentical(const FLyraMovementTrajectory& Other, int32& OutFirstMismatchFrame) const;
+
+	bool SaveToFile(const FString& Filename) const;
+	bool LoadFromFile(const FString& Filename);
+
+	friend FArchive& operator<<(FArchive& Ar, FLyraMovementTrajectory& Trajectory);
+};
+
+/**
+ * FLyraMovementSimulationResult
+ */
+struct LYRAGAME_API FLyraMovementSimulationResult
+{
+	// Trajectory of the first simulated character.
+	FLyraMovementTrajectory Trajectory;
+
+	// Per frame, true if the first simulated character was surfing at the end of it.  Not part of the goldens.
+	TArray<bool> SurfingFrames;
+
+	// Number of character movement ticks that were simulated.
+	int64 CharacterTicks = 0;
+
+	// Wall clock time spent inside the movement component ticks.
+	double MovementSeconds = 0.0;
+
+	double GetCharacterTicksPerSecond() const
+	{
+		return (MovementSeconds > 0.0) ? (double(CharacterTicks) / MovementSeconds) : 0.0;
+	}
+};
+
+/**
+ * FLyraMovementSimulation
+ *
+ *	Headless harness that replays an input stream through ULyraCharacterMovementComponent at a fixed timestep.
+ *	A transient game world is created with a flat test arena and a surf ramp far from the origin, every
+ *	character replays the same stream and the trajectory of the first character is recorded.  Used by the movement automation test and commandlet.
+ */
+class LYRAGAME_API FLyraMovementSimulation
+{
+public:
+
+	FLyraMovementSimulation();
+	~FLyraMovementSimulation();
+
+	// Creates the transient world and test arena.  Returns false if a world could not be created.
+	bool Initialize();
+
+	// Destroys the transient world.  Called automatically on destruction.
+	void Shutdown();
+
+	// Replays the stream with the requested number of characters.
+	bool Run(const FLyraMovementInputStream& Stream, int32 NumCharacters, FLyraMovementSimulationResult& OutResult);
+
+	UWorld* GetWorld() const { return World; }
+
+	// Directory where golden trajectories are stored.
+	static FString GetGoldenDirectory();
+	static FString GetGoldenFilename(const FString& ScenarioName);
+
+private:
+
+	void SpawnArena();
+	ALyraCharacter* SpawnCharacter(int32 Index, const FVector& StartLocation);
+	void DestroyCharacters();
+
+private:
+
+	UWorld* World;
+
+	TArray<ALyraCharacter*> Characters;
+};
+
+#endif // WITH_DEV_AUTOMATION_TESTS
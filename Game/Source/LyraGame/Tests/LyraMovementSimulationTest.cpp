@@ -0,0 +1,473 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Character/LyraCharacter.h"
+#include "Character/LyraCharacterMovementComponent.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
+#include "PhysicsEngine/PhysicsSettings.h"
+#include "Tests/LyraMovementSimulation.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace LyraMovementSimulationTest
+{
+	// Number of characters used for the throughput pass, roughly a full 64 player server.
+	static const int32 ThroughputCharacters = 64;
+
+	// Number of bots strafing for the game thread vs physics thread movement comparison.
+	static const int32 AsyncMovementCharacters = 100;
+
+	// Physics thread results land a step late and the physics thread steps at its own rate, so game thread vs physics
+	// thread runs are compared by where the path took the character, as a fraction of the distance it covered.
+	static const double AsyncParityTolerance = 0.05;
+
+	// Frame of the PathFollow scenario half way down the second leg of the path, after the turn.
+	static const int32 PathFollowSecondLegFrame = 160;
+
+	// Frames the RampSurf scenario has to spend surfing, the slide down the ramp takes about three seconds.
+	static const int32 RampSurfMinFrames = 60;
+
+	// Replicated acceleration and speeds ExtrapolateProxyVelocity is run with in the proxy extrapolation test
+	static const float ProxyDeltaTime = 0.05f;
+	static const float ProxyMaxWalkSpeed = 600.0f;
+	static const float ProxyMaxFallAirSpeed = 30.0f;
+	static const FVector ProxyVelocity(600.0, 0.0, 0.0);
+	static const FVector ProxyAcceleration(0.0, 10.0, 0.0);
+
+	struct FProxyExtrapolationCase
+	{
+		int32 Mode;
+		EMovementMode MovementMode;
+		float TimeSinceProxyUpdate;
+		FVector ExpectedVelocity;
+	};
+
+	// Ground acceleration adds 10 * 600 * 0.05 = 300 uu/s towards the wish direction, air acceleration is capped at
+	// MaxFallAirSpeed.  Nothing bends the velocity once the proxy has gone without an update for too long.
+	static const FProxyExtrapolationCase ProxyExtrapolationCases[] =
+	{
+		{ 0, MOVE_Falling, 0.0f, FVector(600.0, 0.0, 0.0) },
+		{ 0, MOVE_Walking, 0.0f, FVector(600.0, 0.0, 0.0) },
+		{ 1, MOVE_Falling, 0.0f, FVector(600.0, 30.0, 0.0) },
+		{ 1, MOVE_Walking, 0.0f, FVector(600.0, 0.0, 0.0) },
+		{ 2, MOVE_Falling, 0.0f, FVector(600.0, 30.0, 0.0) },
+		{ 2, MOVE_Walking, 0.0f, FVector(600.0, 300.0, 0.0) },
+		{ 2, MOVE_Falling, 1.0f, FVector(600.0, 0.0, 0.0) },
+		{ 2, MOVE_Walking, 1.0f, FVector(600.0, 0.0, 0.0) },
+	};
+};
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLyraMovementSimulationGoldenTest, "Lyra.Movement.Simulation.Golden", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+bool FLyraMovementSimulationGoldenTest::RunTest(const FString& Parameters)
+{
+	FLyraMovementSimulation Simulation;
+	if (!Simulation.Initialize())
+	{
+		AddError(TEXT("Failed to initialize the movement simulation world."));
+		return false;
+	}
+
+	// Goldens are only ever written on request, same switch as the LyraMovementSimulation commandlet
+	const bool bUpdateGolden = FParse::Param(FCommandLine::Get(), TEXT("UpdateGolden"));
+
+	for (const FString& ScenarioName : FLyraMovementInputStream::GetBuiltInScenarioNames())
+	{
+		FLyraMovementInputStream Stream;
+		FLyraMovementInputStream::MakeBuiltInScenario(ScenarioName, Stream);
+
+		FLyraMovementSimulationResult Result;
+		if (!Simulation.Run(Stream, 1, Result))
+		{
+			AddError(FString::Printf(TEXT("[%s] Simulation failed to run."), *ScenarioName));
+			continue;
+		}
+
+		const FString GoldenFilename = FLyraMovementSimulation::GetGoldenFilename(ScenarioName);
+
+		if (bUpdateGolden)
+		{
+			if (Result.Trajectory.SaveToFile(GoldenFilename))
+			{
+				AddInfo(FString::Printf(TEXT("[%s] Wrote golden trajectory to %s."), *ScenarioName, *GoldenFilename));
+			}
+			else
+			{
+				AddError(FString::Printf(TEXT("[%s] Could not write %s."), *ScenarioName, *GoldenFilename));
+			}
+			continue;
+		}
+
+		FLyraMovementTrajectory Golden;
+		if (!Golden.LoadFromFile(GoldenFilename))
+		{
+			AddError(FString::Printf(TEXT("[%s] No golden trajectory at %s, run with -UpdateGolden to create one."), *ScenarioName, *GoldenFilename));
+			continue;
+		}
+
+		int32 MismatchFrame = INDEX_NONE;
+		if (!Result.Trajectory.IsBitIdentical(Golden, MismatchFrame))
+		{
+			const FVector Location = Result.Trajectory.Locations.IsValidIndex(MismatchFrame) ? Result.Trajectory.Locations[MismatchFrame] : FVector::ZeroVector;
+			const FVector GoldenLocation = Golden.Locations.IsValidIndex(MismatchFrame) ? Golden.Locations[MismatchFrame] : FVector::ZeroVector;
+			AddError(FString::Printf(TEXT("[%s] Trajectory diverges from golden at frame %d (got %s, expected %s)."),
+				*ScenarioName, MismatchFrame, *Location.ToString(), *GoldenLocation.ToString()));
+		}
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLyraMovementRampSurfTest, "Lyra.Movement.Simulation.RampSurf", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+bool FLyraMovementRampSurfTest::RunTest(const FString& Parameters)
+{
+	using namespace LyraMovementSimulationTest;
+
+	FLyraMovementSimulation Simulation;
+	if (!Simulation.Initialize())
+	{
+		AddError(TEXT("Failed to initialize the movement simulation world."));
+		return false;
+	}
+
+	FLyraMovementInputStream Stream;
+	FLyraMovementInputStream::MakeBuiltInScenario(TEXT("RampSurf"), Stream);
+
+	FLyraMovementSimulationResult Result;
+	if (!Simulation.Run(Stream, 1, Result))
+	{
+		AddError(TEXT("Simulation failed to run."));
+		return false;
+	}
+
+	const int32 FirstSurfFrame = Result.SurfingFrames.Find(true);
+	const int32 LastSurfFrame = Result.SurfingFrames.FindLast(true);
+	if (!TestTrue(TEXT("Landing on the ramp starts surfing"), FirstSurfFrame != INDEX_NONE))
+	{
+		return false;
+	}
+
+	int32 NumSurfFrames = 0;
+	for (const bool bSurfing : Result.SurfingFrames)
+	{
+		NumSurfFrames += bSurfing ? 1 : 0;
+	}
+	TestTrue(FString::Printf(TEXT("Surfed for %d frames"), NumSurfFrames), NumSurfFrames >= RampSurfMinFrames);
+
+	// Gravity slides the character down the ramp while the strafe carries it along
+	const FVector SurfStart = Result.Trajectory.Locations[FirstSurfFrame];
+	const FVector SurfEnd = Result.Trajectory.Locations[LastSurfFrame];
+	TestTrue(FString::Printf(TEXT("Slid down the ramp (%s to %s)"), *SurfStart.ToCompactString(), *SurfEnd.ToCompactString()), SurfEnd.Z < SurfStart.Z);
+	TestTrue(FString::Printf(TEXT("Strafed along the ramp (%s to %s)"), *SurfStart.ToCompactString(), *SurfEnd.ToCompactString()), SurfEnd.Y > SurfStart.Y);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLyraProxyExtrapolationTest, "Lyra.Movement.Simulation.ProxyExtrapolation", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+bool FLyraProxyExtrapolationTest::RunTest(const FString& Parameters)
+{
+	using namespace LyraMovementSimulationTest;
+
+	IConsoleVariable* ModeCVar = IConsoleManager::Get().FindConsoleVariable(TEXT("LyraCharacter.ProxyExtrapolationMode"));
+	IConsoleVariable* MaxTimeCVar = IConsoleManager::Get().FindConsoleVariable(TEXT("LyraCharacter.MaxProxyExtrapolationTime"));
+	if (!ModeCVar || !MaxTimeCVar)
+	{
+		AddError(TEXT("Missing LyraCharacter.ProxyExtrapolationMode or LyraCharacter.MaxProxyExtrapolationTime."));
+		return false;
+	}
+
+	FLyraMovementSimulation Simulation;
+	if (!Simulation.Initialize())
+	{
+		AddError(TEXT("Failed to initialize the movement simulation world."));
+		return false;
+	}
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	ALyraCharacter* Character = Simulation.GetWorld()->SpawnActor<ALyraCharacter>(ALyraCharacter::StaticClass(), FVector(0.0, 0.0, 200.0), FRotator::ZeroRotator, SpawnParams);
+	if (!Character)
+	{
+		AddError(TEXT("Failed to spawn a character."));
+		return false;
+	}
+
+	ULyraCharacterMovementComponent* MoveComp = CastChecked<ULyraCharacterMovementComponent>(Character->GetCharacterMovement());
+	MoveComp->MaxWalkSpeed = ProxyMaxWalkSpeed;
+	MoveComp->MaxFallAirSpeed = ProxyMaxFallAirSpeed;
+
+	const int32 OriginalMode = ModeCVar->GetInt();
+	const float OriginalMaxTime = MaxTimeCVar->GetFloat();
+	MaxTimeCVar->Set(0.25f, ECVF_SetByCode);
+
+	for (const FProxyExtrapolationCase& Case : ProxyExtrapolationCases)
+	{
+		ModeCVar->Set(Case.Mode, ECVF_SetByCode);
+
+		MoveComp->SetMovementMode(Case.MovementMode);
+		MoveComp->Velocity = ProxyVelocity;
+		MoveComp->Acceleration = ProxyAcceleration;
+		MoveComp->TimeSinceProxyUpdate = Case.TimeSinceProxyUpdate;
+
+		MoveComp->ExtrapolateProxyVelocity(ProxyDeltaTime);
+
+		TestEqual(FString::Printf(TEXT("Mode %d, %s, %.2fs since the last update"), Case.Mode, *UEnum::GetValueAsString(Case.MovementMode), Case.TimeSinceProxyUpdate),
+			MoveComp->Velocity, Case.ExpectedVelocity, 1.0e-3f);
+	}
+
+	ModeCVar->Set(OriginalMode, ECVF_SetByCode);
+	MaxTimeCVar->Set(OriginalMaxTime, ECVF_SetByCode);
+
+	Character->Destroy();
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLyraMovementSimulationThroughputTest, "Lyra.Movement.Simulation.Throughput", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::PerfFilter)
+
+bool FLyraMovementSimulationThroughputTest::RunTest(const FString& Parameters)
+{
+	FLyraMovementSimulation Simulation;
+	if (!Simulation.Initialize())
+	{
+		AddError(TEXT("Failed to initialize the movement simulation world."));
+		return false;
+	}
+
+	FLyraMovementInputStream Stream;
+	FLyraMovementInputStream::MakeBuiltInScenario(TEXT("BhopStrafe"), Stream);
+
+	FLyraMovementSimulationResult Result;
+	if (!Simulation.Run(Stream, LyraMovementSimulationTest::ThroughputCharacters, Result))
+	{
+		AddError(TEXT("Simulation failed to run."));
+		return false;
+	}
+
+	AddInfo(FString::Printf(TEXT("%lld character ticks in %.3f ms (%.0f character ticks/sec)"),
+		Result.CharacterTicks, Result.MovementSeconds * 1000.0, Result.GetCharacterTicksPerSecond()));
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLyraMovementCalcVelocityBenchmark, "Lyra.Movement.Simulation.CalcVelocityCost", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::PerfFilter)
+
+bool FLyraMovementCalcVelocityBenchmark::RunTest(const FString& Parameters)
+{
+	IConsoleVariable* LegacyCVar = IConsoleManager::Get().FindConsoleVariable(TEXT("LyraCharacter.UseLegacyCalcVelocity"));
+	if (!LegacyCVar)
+	{
+		AddError(TEXT("Missing LyraCharacter.UseLegacyCalcVelocity."));
+		return false;
+	}
+
+	FLyraMovementSimulation Simulation;
+	if (!Simulation.Initialize())
+	{
+		AddError(TEXT("Failed to initialize the movement simulation world."));
+		return false;
+	}
+
+	FLyraMovementInputStream Stream;
+	FLyraMovementInputStream::MakeBuiltInScenario(TEXT("BhopStrafe"), Stream);
+
+	const bool bOriginalValue = LegacyCVar->GetBool();
+
+	// Before: engine CalcVelocity followed by the bhop pass.  After: single pass bhop solver.
+	for (const bool bLegacy : { true, false })
+	{
+		LegacyCVar->Set(bLegacy, ECVF_SetByCode);
+
+		FLyraMovementSimulationResult Result;
+		if (!Simulation.Run(Stream, LyraMovementSimulationTest::ThroughputCharacters, Result))
+		{
+			AddError(TEXT("Simulation failed to run."));
+			break;
+		}
+
+		AddInfo(FString::Printf(TEXT("%s CalcVelocity: %.3f us per character tick (%.0f character ticks/sec)"),
+			bLegacy ? TEXT("Two pass") : TEXT("Single pass"),
+			(Result.MovementSeconds * 1e6) / FMath::Max<double>(Result.CharacterTicks, 1), Result.GetCharacterTicksPerSecond()));
+	}
+
+	LegacyCVar->Set(bOriginalValue, ECVF_SetByCode);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLyraMovementSubsteppingBenchmark, "Lyra.Movement.Simulation.SubsteppingCost", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::PerfFilter)
+
+bool FLyraMovementSubsteppingBenchmark::RunTest(const FString& Parameters)
+{
+	IConsoleVariable* AdaptiveCVar = IConsoleManager::Get().FindConsoleVariable(TEXT("LyraCharacter.AdaptiveSubstepping"));
+	if (!AdaptiveCVar)
+	{
+		AddError(TEXT("Missing LyraCharacter.AdaptiveSubstepping."));
+		return false;
+	}
+
+	FLyraMovementSimulation Simulation;
+	if (!Simulation.Initialize())
+	{
+		AddError(TEXT("Failed to initialize the movement simulation world."));
+		return false;
+	}
+
+	const bool bOriginalValue = AdaptiveCVar->GetBool();
+
+	for (const FString& ScenarioName : FLyraMovementInputStream::GetBuiltInScenarioNames())
+	{
+		FLyraMovementInputStream Stream;
+		FLyraMovementInputStream::MakeBuiltInScenario(ScenarioName, Stream);
+
+		for (const bool bAdaptive : { false, true })
+		{
+			AdaptiveCVar->Set(bAdaptive, ECVF_SetByCode);
+
+			FLyraMovementSimulationResult Result;
+			if (!Simulation.Run(Stream, LyraMovementSimulationTest::ThroughputCharacters, Result))
+			{
+				AddError(FString::Printf(TEXT("[%s] Simulation failed to run."), *ScenarioName));
+				break;
+			}
+
+			AddInfo(FString::Printf(TEXT("[%s] %s sub-stepping: %.3f us per character tick"),
+				*ScenarioName, bAdaptive ? TEXT("Adaptive") : TEXT("Fixed"),
+				(Result.MovementSeconds * 1e6) / FMath::Max<double>(Result.CharacterTicks, 1)));
+		}
+	}
+
+	AdaptiveCVar->Set(bOriginalValue, ECVF_SetByCode);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLyraMovementAsyncBenchmark, "Lyra.Movement.Simulation.AsyncMovement", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::PerfFilter)
+
+bool FLyraMovementAsyncBenchmark::RunTest(const FString& Parameters)
+{
+	IConsoleVariable* AsyncCVar = IConsoleManager::Get().FindConsoleVariable(TEXT("LyraCharacter.AsyncMovement"));
+	if (!AsyncCVar)
+	{
+		AddError(TEXT("Missing LyraCharacter.AsyncMovement."));
+		return false;
+	}
+
+	// The physics scene picks this up when the simulation world is created.
+	UPhysicsSettings* PhysicsSettings = UPhysicsSettings::Get();
+	const bool bOriginalTickPhysicsAsync = PhysicsSettings->bTickPhysicsAsync;
+	const int32 OriginalMode = AsyncCVar->GetInt();
+	PhysicsSettings->bTickPhysicsAsync = true;
+
+	FLyraMovementInputStream Stream;
+	FLyraMovementInputStream::MakeBuiltInScenario(TEXT("BhopStrafe"), Stream);
+
+	double GameThreadSeconds[2] = { 0.0, 0.0 };
+
+	for (const int32 Mode : { 0, 1 })
+	{
+		AsyncCVar->Set(Mode, ECVF_SetByCode);
+
+		FLyraMovementSimulation Simulation;
+		FLyraMovementSimulationResult Result;
+		if (!Simulation.Initialize() || !Simulation.Run(Stream, LyraMovementSimulationTest::AsyncMovementCharacters, Result))
+		{
+			AddError(TEXT("Simulation failed to run."));
+			break;
+		}
+
+		GameThreadSeconds[Mode] = Result.MovementSeconds;
+
+		AddInfo(FString::Printf(TEXT("%s: %d bots, %.3f ms game thread movement per frame"),
+			(Mode == 0) ? TEXT("Game thread") : TEXT("Physics thread"), LyraMovementSimulationTest::AsyncMovementCharacters,
+			(Result.MovementSeconds * 1000.0) / FMath::Max(Stream.Frames.Num(), 1)));
+	}
+
+	AddInfo(FString::Printf(TEXT("Game thread time recovered: %.3f ms over %d frames"),
+		(GameThreadSeconds[0] - GameThreadSeconds[1]) * 1000.0, Stream.Frames.Num()));
+
+	AsyncCVar->Set(OriginalMode, ECVF_SetByCode);
+	PhysicsSettings->bTickPhysicsAsync = bOriginalTickPhysicsAsync;
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLyraMovementAsyncParityTest, "Lyra.Movement.Simulation.AsyncMovement.Parity", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+bool FLyraMovementAsyncParityTest::RunTest(const FString& Parameters)
+{
+	using namespace LyraMovementSimulationTest;
+
+	IConsoleVariable* AsyncCVar = IConsoleManager::Get().FindConsoleVariable(TEXT("LyraCharacter.AsyncMovement"));
+	if (!AsyncCVar)
+	{
+		AddError(TEXT("Missing LyraCharacter.AsyncMovement."));
+		return false;
+	}
+
+	UPhysicsSettings* PhysicsSettings = UPhysicsSettings::Get();
+	const bool bOriginalTickPhysicsAsync = PhysicsSettings->bTickPhysicsAsync;
+	const int32 OriginalMode = AsyncCVar->GetInt();
+	PhysicsSettings->bTickPhysicsAsync = true;
+
+	// A bot following a path through RequestDirectMove, with no movement input at all.
+	FLyraMovementInputStream Stream;
+	FLyraMovementInputStream::MakeBuiltInScenario(TEXT("PathFollow"), Stream);
+
+	FLyraMovementTrajectory Trajectories[2];
+	bool bRan = true;
+
+	for (const int32 Mode : { 0, 1 })
+	{
+		AsyncCVar->Set(Mode, ECVF_SetByCode);
+
+		FLyraMovementSimulation Simulation;
+		FLyraMovementSimulationResult Result;
+		if (!Simulation.Initialize() || !Simulation.Run(Stream, 1, Result))
+		{
+			AddError(TEXT("Simulation failed to run."));
+			bRan = false;
+			break;
+		}
+
+		Trajectories[Mode] = MoveTemp(Result.Trajectory);
+	}
+
+	AsyncCVar->Set(OriginalMode, ECVF_SetByCode);
+	PhysicsSettings->bTickPhysicsAsync = bOriginalTickPhysicsAsync;
+
+	if (!bRan || !TestEqual(TEXT("Frame count"), Trajectories[1].Num(), Trajectories[0].Num()) || !Trajectories[0].Locations.IsValidIndex(PathFollowSecondLegFrame))
+	{
+		return false;
+	}
+
+	const FLyraMovementTrajectory& GameThread = Trajectories[0];
+	const FLyraMovementTrajectory& PhysicsThread = Trajectories[1];
+
+	const double PathLength = FVector::Dist2D(GameThread.Locations[0], GameThread.Locations.Last());
+	if (!TestTrue(TEXT("Game thread character follows the path"), PathLength > 1000.0))
+	{
+		return false;
+	}
+
+	const double AllowedError = PathLength * AsyncParityTolerance;
+
+	// Still heading the same way after the turn...
+	const FVector GameThreadHeading = GameThread.Velocities[PathFollowSecondLegFrame].GetSafeNormal2D();
+	const FVector PhysicsThreadHeading = PhysicsThread.Velocities[PathFollowSecondLegFrame].GetSafeNormal2D();
+	TestTrue(FString::Printf(TEXT("Heading after the turn (game thread %s, physics thread %s)"), *GameThreadHeading.ToCompactString(), *PhysicsThreadHeading.ToCompactString()),
+		FVector::DotProduct(GameThreadHeading, PhysicsThreadHeading) > FMath::Cos(FMath::DegreesToRadians(10.0)));
+
+	// ...and ending up in the same place once the path ends and friction stops the character.
+	const double EndError = FVector::Dist2D(GameThread.Locations.Last(), PhysicsThread.Locations.Last());
+	TestTrue(FString::Printf(TEXT("End of the path (%.1f apart over a %.1f path)"), EndError, PathLength), EndError <= AllowedError);
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,64 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Character/LyraMovementTelemetry.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLyraMovementTelemetryBufferTest, "Lyra.Movement.Telemetry.RingBuffer", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ServerContext | EAutomationTestFlags::EngineFilter)
+
+bool FLyraMovementTelemetryBufferTest::RunTest(const FString& Parameters)
+{
+	// Rounded up to 8.
+	FLyraMovementTelemetryBuffer Buffer(5);
+	TestEqual(TEXT("Capacity"), Buffer.GetCapacity(), 8);
+
+	TArray<FLyraMovementTelemetrySample> Samples;
+	Buffer.Snapshot(Samples);
+	TestEqual(TEXT("Empty snapshot"), Samples.Num(), 0);
+
+	for (int32 Index = 0; Index < 3; ++Index)
+	{
+		FLyraMovementTelemetrySample Sample;
+		Sample.Time = Index;
+		Buffer.Push(Sample);
+	}
+
+	Buffer.Snapshot(Samples);
+	TestEqual(TEXT("Partial snapshot size"), Samples.Num(), 3);
+	TestEqual(TEXT("Partial snapshot oldest"), Samples[0].Time, 0.0);
+
+	// Wrap around a couple of times, only the newest Capacity - 1 samples survive, oldest first.
+	for (int32 Index = 3; Index < 21; ++Index)
+	{
+		FLyraMovementTelemetrySample Sample;
+		Sample.Time = Index;
+		Buffer.Push(Sample);
+	}
+
+	Buffer.Snapshot(Samples);
+	TestEqual(TEXT("Full snapshot size"), Samples.Num(), 7);
+	TestEqual(TEXT("Samples pushed"), Buffer.GetNumPushed(), uint64(21));
+
+	for (int32 Index = 0; Index < Samples.Num(); ++Index)
+	{
+		TestEqual(FString::Printf(TEXT("Sample %d"), Index), Samples[Index].Time, double(14 + Index));
+	}
+
+	// Exactly full, the oldest slot is already the next write.
+	FLyraMovementTelemetryBuffer FullBuffer(8);
+	for (int32 Index = 0; Index < 8; ++Index)
+	{
+		FLyraMovementTelemetrySample Sample;
+		Sample.Time = Index;
+		FullBuffer.Push(Sample);
+	}
+
+	FullBuffer.Snapshot(Samples);
+	TestEqual(TEXT("Exactly full snapshot size"), Samples.Num(), 7);
+	TestEqual(TEXT("Exactly full snapshot oldest"), Samples[0].Time, 1.0);
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,188 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "AbilitySystem/LyraAbilitySystemComponent.h"
+#include "Components/BoxComponent.h"
+#include "Engine/CollisionProfile.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "HAL/IConsoleManager.h"
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+#include "Physics/LyraCollisionChannels.h"
+#include "UObject/Package.h"
+#include "Weapons/LyraGameplayAbility_RangedWeapon.h"
+#include "Weapons/LyraRangedWeaponInstance.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace LyraParallelBulletTraceTest
+{
+	static const int32 NumBullets = 12;
+	static const float SpreadAngle = 20.0f;
+	static const float SweepRadius = 5.0f;
+	static const int32 NumShots = 64;
+
+	/** Scratch world with walls and pawns in front of a shooter that has a shotgun ability granted. */
+	class FBulletTraceArena
+	{
+	public:
+		FBulletTraceArena()
+		{
+			World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("LyraBulletTraceArena"), GetTransientPackage());
+			World->AddToRoot();
+
+			FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+			WorldContext.SetCurrentWorld(World);
+
+			World->InitializeActorsForPlay(FURL());
+
+			// Pawns scattered in front of the shooter with walls behind and between them, so bullets hit both
+			FRandomStream Random(13);
+			for (int32 Index = 0; Index < 8; ++Index)
+			{
+				const FVector Location(Random.FRandRange(300.0f, 1500.0f), Random.FRandRange(-400.0f, 400.0f), Random.FRandRange(-100.0f, 100.0f));
+				AddBox(World->SpawnActor<APawn>(), FVector(40.0, 40.0, 90.0), Location, EComponentMobility::Movable);
+			}
+			for (int32 Index = 0; Index < 4; ++Index)
+			{
+				const FVector Location(Random.FRandRange(600.0f, 1800.0f), Random.FRandRange(-500.0f, 500.0f), 0.0);
+				AddBox(World->SpawnActor<AActor>(), FVector(20.0, Random.FRandRange(50.0f, 200.0f), 300.0), Location, EComponentMobility::Static);
+			}
+			AddBox(World->SpawnActor<AActor>(), FVector(20.0, 3000.0, 3000.0), FVector(2500.0, 0.0, 0.0), EComponentMobility::Static);
+
+			// One frame so the boxes are in the scene query structure before the first trace
+			World->Tick(LEVELTICK_All, 1.0f / 60.0f);
+
+			AActor* Shooter = World->SpawnActor<AActor>();
+			ULyraAbilitySystemComponent* AbilitySystem = NewObject<ULyraAbilitySystemComponent>(Shooter);
+			AbilitySystem->RegisterComponent();
+			AbilitySystem->InitAbilityActorInfo(Shooter, Shooter);
+
+			Weapon = NewObject<ULyraRangedWeaponInstance>(Shooter);
+			FIntProperty* BulletsProperty = FindFProperty<FIntProperty>(ULyraRangedWeaponInstance::StaticClass(), TEXT("BulletsPerCartridge"));
+			check(BulletsProperty);
+			BulletsProperty->SetPropertyValue_InContainer(Weapon, NumBullets);
+
+			FFloatProperty* SweepRadiusProperty = FindFProperty<FFloatProperty>(ULyraRangedWeaponInstance::StaticClass(), TEXT("BulletTraceSweepRadius"));
+			check(SweepRadiusProperty);
+			SweepRadiusProperty->SetPropertyValue_InContainer(Weapon, SweepRadius);
+
+			FStructProperty* SpreadProperty = FindFProperty<FStructProperty>(ULyraRangedWeaponInstance::StaticClass(), TEXT("HeatToSpreadCurve"));
+			check(SpreadProperty);
+			SpreadProperty->ContainerPtrToValuePtr<FRuntimeFloatCurve>(Weapon)->GetRichCurve()->UpdateOrAddKey(0.0f, SpreadAngle);
+			Weapon->OnEquipped();
+
+			const FGameplayAbilitySpecHandle AbilityHandle = AbilitySystem->GiveAbility(FGameplayAbilitySpec(ULyraGameplayAbility_RangedWeapon::StaticClass(), 1, INDEX_NONE, Weapon));
+			const FGameplayAbilitySpec* AbilitySpec = AbilitySystem->FindAbilitySpecFromHandle(AbilityHandle);
+			check(AbilitySpec);
+			Ability = CastChecked<ULyraGameplayAbility_RangedWeapon>(AbilitySpec->GetPrimaryInstance());
+		}
+
+		~FBulletTraceArena()
+		{
+			GEngine->DestroyWorldContext(World);
+			World->DestroyWorld(false);
+			World->RemoveFromRoot();
+		}
+
+		UWorld* World = nullptr;
+		ULyraRangedWeaponInstance* Weapon = nullptr;
+		ULyraGameplayAbility_RangedWeapon* Ability = nullptr;
+
+	private:
+		void AddBox(AActor* Actor, const FVector& Extent, const FVector& Location, EComponentMobility::Type Mobility)
+		{
+			check(Actor);
+
+			UBoxComponent* Box = NewObject<UBoxComponent>(Actor);
+			Box->SetMobility(Mobility);
+			Box->SetBoxExtent(Extent);
+			Box->SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
+			Box->SetCollisionResponseToChannel(Lyra_TraceChannel_Weapon, ECR_Block);
+			Actor->SetRootComponent(Box);
+			Box->SetWorldLocation(Location);
+			Box->RegisterComponent();
+		}
+	};
+
+	static bool HitsMatch(const FHitResult& A, const FHitResult& B)
+	{
+		return (A.HitObjectHandle == B.HitObjectHandle)
+			&& (A.bBlockingHit == B.bBlockingHit)
+			&& (A.bStartPenetrating == B.bStartPenetrating)
+			&& (A.Time == B.Time)
+			&& (A.Distance == B.Distance)
+			&& (A.Location == B.Location)
+			&& (A.ImpactPoint == B.ImpactPoint)
+			&& (A.ImpactNormal == B.ImpactNormal)
+			&& (A.TraceStart == B.TraceStart)
+			&& (A.TraceEnd == B.TraceEnd);
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLyraParallelBulletTraceTest, "Lyra.Weapon.Trace.ParallelParity", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ServerContext | EAutomationTestFlags::EngineFilter)
+
+bool FLyraParallelBulletTraceTest::RunTest(const FString& Parameters)
+{
+	using namespace LyraParallelBulletTraceTest;
+
+	IConsoleVariable* MinBulletsCVar = IConsoleManager::Get().FindConsoleVariable(TEXT("lyra.Weapon.ParallelBulletTraceMinBullets"));
+	if (!MinBulletsCVar)
+	{
+		AddError(TEXT("Missing lyra.Weapon.ParallelBulletTraceMinBullets."));
+		return false;
+	}
+
+	FBulletTraceArena Arena;
+	const int32 OriginalMinBullets = MinBulletsCVar->GetInt();
+
+	FRandomStream Random(7);
+	int32 NumPawnHits = 0;
+
+	for (int32 ShotIndex = 0; ShotIndex < NumShots; ++ShotIndex)
+	{
+		ULyraGameplayAbility_RangedWeapon::FRangedWeaponFiringInput InputData;
+		InputData.WeaponData = Arena.Weapon;
+		InputData.StartTrace = FVector(0.0, 0.0, Random.FRandRange(-50.0f, 50.0f));
+		InputData.AimDir = FVector(1.0, Random.FRandRange(-0.4f, 0.4f), Random.FRandRange(-0.1f, 0.1f)).GetSafeNormal();
+		InputData.EndAim = InputData.StartTrace + InputData.AimDir * 5000.0;
+		InputData.Seed = Random.RandHelper(MAX_int32);
+		InputData.ShotIndex = ShotIndex;
+
+		// The same cartridge traced on the game thread only, then spread over the task graph
+		TArray<FHitResult> SerialHits;
+		MinBulletsCVar->Set(0, ECVF_SetByCode);
+		Arena.Ability->TraceBulletsInCartridge(InputData, /*out*/ SerialHits);
+
+		TArray<FHitResult> ParallelHits;
+		MinBulletsCVar->Set(1, ECVF_SetByCode);
+		Arena.Ability->TraceBulletsInCartridge(InputData, /*out*/ ParallelHits);
+
+		if (SerialHits.Num() != ParallelHits.Num())
+		{
+			AddError(FString::Printf(TEXT("Shot %d has %d hits traced serially, %d in parallel."), ShotIndex, SerialHits.Num(), ParallelHits.Num()));
+			break;
+		}
+
+		for (int32 HitIndex = 0; HitIndex < SerialHits.Num(); ++HitIndex)
+		{
+			if (!HitsMatch(SerialHits[HitIndex], ParallelHits[HitIndex]))
+			{
+				AddError(FString::Printf(TEXT("Shot %d hit %d differs: serial %s, parallel %s."), ShotIndex, HitIndex, *SerialHits[HitIndex].ToString(), *ParallelHits[HitIndex].ToString()));
+				break;
+			}
+
+			NumPawnHits += (Cast<APawn>(SerialHits[HitIndex].GetActor()) != nullptr) ? 1 : 0;
+		}
+	}
+
+	MinBulletsCVar->Set(OriginalMinBullets, ECVF_SetByCode);
+
+	// Make sure the arena exercised the pawn hit resolution and not only walls
+	TestTrue(TEXT("Bullets hit pawns"), NumPawnHits > 0);
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,247 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Components/BoxComponent.h"
+#include "Engine/CollisionProfile.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "Misc/AutomationTest.h"
+#include "Physics/LyraCollisionChannels.h"
+#include "UObject/Package.h"
+#include "Weapons/LyraProjectileSubsystem.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace LyraProjectileSubsystemTest
+{
+	static const float StepTime = 1.0f / 60.0f;
+
+	// Inner faces of the two walls, the projectiles fly along X between them
+	static const double WallX = 990.0;
+	static const FVector WallExtent(10.0, 2000.0, 2000.0);
+
+	/** Scratch world with a wall on each side of the origin and nothing else, projectiles are stepped by hand. */
+	class FProjectileArena
+	{
+	public:
+		FProjectileArena()
+		{
+			World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("LyraProjectileArena"), GetTransientPackage());
+			World->AddToRoot();
+
+			FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+			WorldContext.SetCurrentWorld(World);
+
+			World->InitializeActorsForPlay(FURL());
+
+			AddWall(TEXT("PositiveWall"), WallX + WallExtent.X);
+			AddWall(TEXT("NegativeWall"), -(WallX + WallExtent.X));
+
+			// One frame so the walls are in the scene query structure before the first sweep
+			World->Tick(LEVELTICK_All, StepTime);
+
+			Subsystem = World->GetSubsystem<ULyraProjectileSubsystem>();
+			Subsystem->OnProjectileImpact.AddLambda([this](const FLyraProjectile& Projectile, const FHitResult& Hit)
+				{
+					Impacts.Add({ Projectile.Id, NumSteps, Hit.Location });
+				});
+		}
+
+		~FProjectileArena()
+		{
+			GEngine->DestroyWorldContext(World);
+			World->DestroyWorld(false);
+			World->RemoveFromRoot();
+		}
+
+		void Step()
+		{
+			Subsystem->StepProjectiles(StepTime);
+			++NumSteps;
+		}
+
+		struct FImpact
+		{
+			uint32 Id = 0;
+			int32 Step = 0;
+			FVector Location = FVector::ZeroVector;
+		};
+
+		UWorld* World = nullptr;
+		ULyraProjectileSubsystem* Subsystem = nullptr;
+		TArray<FImpact> Impacts;
+		int32 NumSteps = 0;
+
+	private:
+		void AddWall(const TCHAR* Name, double CenterX)
+		{
+			AActor* WallActor = World->SpawnActor<AActor>();
+			check(WallActor);
+
+			UBoxComponent* Wall = NewObject<UBoxComponent>(WallActor, Name);
+			Wall->SetMobility(EComponentMobility::Static);
+			Wall->SetBoxExtent(WallExtent);
+			Wall->SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
+			Wall->SetCollisionResponseToChannel(Lyra_TraceChannel_Weapon, ECR_Block);
+			WallActor->SetRootComponent(Wall);
+			Wall->SetWorldLocation(FVector(CenterX, 0.0, 0.0));
+			Wall->RegisterComponent();
+		}
+	};
+
+	static FLyraProjectileSpawnParams MakeParams(int32 Seed)
+	{
+		FLyraProjectileSpawnParams Params;
+		Params.Origin = FVector(0.0, 0.0, 100.0);
+		Params.Direction = FVector::ForwardVector;
+		Params.Speed = 1000.0f;
+		Params.Lifetime = 10.0f;
+		Params.BounceRestitution = 1.0f;
+		Params.Seed = Seed;
+		return Params;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLyraProjectileSubsystemFlightTest, "Lyra.Weapon.Projectile.Flight", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+bool FLyraProjectileSubsystemFlightTest::RunTest(const FString& Parameters)
+{
+	using namespace LyraProjectileSubsystemTest;
+
+	// Straight into the wall: 990 uu at 1000 uu/s crosses the wall during the 60th step
+	{
+		FProjectileArena Arena;
+		TestTrue(TEXT("Spawned"), Arena.Subsystem->SpawnCosmeticProjectile(MakeParams(1)));
+
+		while ((Arena.Subsystem->GetProjectiles().Num() > 0) && (Arena.NumSteps < 120))
+		{
+			Arena.Step();
+		}
+
+		if (TestEqual(TEXT("Impacts"), Arena.Impacts.Num(), 1))
+		{
+			TestEqual(TEXT("Impact step"), Arena.Impacts[0].Step, 59);
+			TestEqual(TEXT("Impact distance"), Arena.Impacts[0].Location.X, WallX, 0.01);
+		}
+		TestEqual(TEXT("Removed after the impact"), Arena.Subsystem->GetProjectiles().Num(), 0);
+	}
+
+	// Bounces off both walls and impacts on the third
+	{
+		static const int32 MaxBounces = 2;
+
+		FProjectileArena Arena;
+		FLyraProjectileSpawnParams Params = MakeParams(2);
+		Params.MaxBounces = MaxBounces;
+		TestTrue(TEXT("Spawned"), Arena.Subsystem->SpawnCosmeticProjectile(Params));
+
+		TArray<int32> BounceSteps;
+		uint8 BouncesLeft = Params.MaxBounces;
+		while ((Arena.Subsystem->GetProjectiles().Num() > 0) && (Arena.NumSteps < 600))
+		{
+			Arena.Step();
+
+			TConstArrayView<FLyraProjectile> Projectiles = Arena.Subsystem->GetProjectiles();
+			if ((Projectiles.Num() > 0) && (Projectiles[0].BouncesLeft != BouncesLeft))
+			{
+				BouncesLeft = Projectiles[0].BouncesLeft;
+				BounceSteps.Add(Arena.NumSteps - 1);
+			}
+		}
+
+		if (TestEqual(TEXT("Bounces"), BounceSteps.Num(), MaxBounces))
+		{
+			TestEqual(TEXT("First bounce step"), BounceSteps[0], 59);
+
+			// The way back is 1980 uu, a little longer after the scatter
+			TestTrue(TEXT("Second bounce after crossing the arena"), BounceSteps[1] >= BounceSteps[0] + 118);
+		}
+
+		if (TestEqual(TEXT("Impacts"), Arena.Impacts.Num(), 1))
+		{
+			TestTrue(TEXT("Impact after the last bounce"), Arena.Impacts[0].Step >= BounceSteps.Last() + 118);
+			TestEqual(TEXT("Impact on the first wall"), Arena.Impacts[0].Location.X, WallX, 0.01);
+		}
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLyraProjectileSubsystemDeterminismTest, "Lyra.Weapon.Projectile.Determinism", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::EngineFilter)
+
+bool FLyraProjectileSubsystemDeterminismTest::RunTest(const FString& Parameters)
+{
+	using namespace LyraProjectileSubsystemTest;
+
+	// Same spawns in two worlds, like the server and a client flying the replicated spawn params
+	FProjectileArena ArenaA;
+	FProjectileArena ArenaB;
+	FProjectileArena ArenaOtherSeed;
+
+	static const int32 Seeds[] = { 7, 1234, -99 };
+	for (int32 Index = 0; Index < UE_ARRAY_COUNT(Seeds); ++Index)
+	{
+		FLyraProjectileSpawnParams Params = MakeParams(Seeds[Index]);
+		Params.Direction = FVector(1.0, 0.1 * Index, 0.2).GetSafeNormal();
+		Params.GravityScale = 0.1f;
+		Params.Radius = 5.0f;
+		Params.MaxBounces = 2;
+
+		ArenaA.Subsystem->SpawnCosmeticProjectile(Params);
+		ArenaB.Subsystem->SpawnCosmeticProjectile(Params);
+
+		Params.Seed += 1;
+		ArenaOtherSeed.Subsystem->SpawnCosmeticProjectile(Params);
+	}
+
+	bool bSamePath = true;
+	bool bOtherSeedDiverged = false;
+	for (int32 Step = 0; (Step < 600) && bSamePath; ++Step)
+	{
+		ArenaA.Step();
+		ArenaB.Step();
+		ArenaOtherSeed.Step();
+
+		TConstArrayView<FLyraProjectile> ProjectilesA = ArenaA.Subsystem->GetProjectiles();
+		TConstArrayView<FLyraProjectile> ProjectilesB = ArenaB.Subsystem->GetProjectiles();
+		TConstArrayView<FLyraProjectile> ProjectilesOther = ArenaOtherSeed.Subsystem->GetProjectiles();
+
+		if (ProjectilesA.Num() != ProjectilesB.Num())
+		{
+			AddError(FString::Printf(TEXT("Step %d: %d projectiles against %d"), Step, ProjectilesA.Num(), ProjectilesB.Num()));
+			bSamePath = false;
+			break;
+		}
+
+		for (int32 Index = 0; Index < ProjectilesA.Num(); ++Index)
+		{
+			const FLyraProjectile& A = ProjectilesA[Index];
+			const FLyraProjectile& B = ProjectilesB[Index];
+			if ((A.Id != B.Id) || !A.Location.Equals(B.Location, 0.0) || !A.Velocity.Equals(B.Velocity, 0.0) || (A.BouncesLeft != B.BouncesLeft))
+			{
+				AddError(FString::Printf(TEXT("Step %d: projectile %u at %s, %s in the other world"), Step, A.Id, *A.Location.ToString(), *B.Location.ToString()));
+				bSamePath = false;
+				break;
+			}
+
+			if (ProjectilesOther.IsValidIndex(Index) && !ProjectilesOther[Index].Location.Equals(A.Location, 1.0))
+			{
+				bOtherSeedDiverged = true;
+			}
+		}
+	}
+
+	TestTrue(TEXT("Impacts to compare"), ArenaA.Impacts.Num() > 0);
+	TestEqual(TEXT("Same impacts"), ArenaA.Impacts.Num(), ArenaB.Impacts.Num());
+	for (int32 Index = 0; Index < FMath::Min(ArenaA.Impacts.Num(), ArenaB.Impacts.Num()); ++Index)
+	{
+		TestEqual(FString::Printf(TEXT("Impact %d step"), Index), ArenaA.Impacts[Index].Step, ArenaB.Impacts[Index].Step);
+		TestTrue(FString::Printf(TEXT("Impact %d location"), Index), ArenaA.Impacts[Index].Location.Equals(ArenaB.Impacts[Index].Location, 0.0));
+	}
+
+	// Guards against the seed not reaching the bounce scatter at all
+	TestTrue(TEXT("A different seed scatters differently"), bOtherSeedDiverged);
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
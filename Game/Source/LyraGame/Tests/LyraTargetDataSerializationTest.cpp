@@ -0,0 +1,209 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "AbilitySystem/LyraGameplayAbilityTargetData_Cartridge.h"
+#include "AbilitySystem/LyraGameplayAbilityTargetData_SingleTargetHit.h"
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+#include "Serialization/BitReader.h"
+#include "Serialization/BitWriter.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace LyraTargetDataSerializationTest
+{
+	// Plain bit archives leave object references out, so every size below excludes them (the same for both formats).
+	static const int64 MaxBits = 1 << 16;
+
+	// A shot fired far from the world origin, where absolute positions are the most expensive to send.
+	static void MakeCartridge(FRandomStream& Random, int32 NumBullets, float SweepRadius, TArray<FLyraGameplayAbilityTargetData_SingleTargetHit>& OutHits)
+	{
+		const FVector Shooter(Random.FRandRange(-60000.0f, 60000.0f), Random.FRandRange(-60000.0f, 60000.0f), Random.FRandRange(-2000.0f, 4000.0f));
+		const FVector AimDir = Random.GetUnitVector();
+		const int32 CartridgeID = Random.RandHelper(MAX_int32);
+
+		OutHits.Reset(NumBullets);
+		for (int32 BulletIndex = 0; BulletIndex < NumBullets; ++BulletIndex)
+		{
+			FLyraGameplayAbilityTargetData_SingleTargetHit& TargetData = OutHits.AddDefaulted_GetRef();
+			TargetData.CartridgeID = CartridgeID;
+
+			const FVector EndTrace = Shooter + (Random.VRandCone(AimDir, FMath::DegreesToRadians(5.0f)) * 25000.0);
+			FHitResult& Hit = TargetData.HitResult;
+			Hit = FHitResult(Shooter, EndTrace);
+
+			// Most bullets stop on something, a few fly off to the end of the trace
+			if (Random.FRand() < 0.8f)
+			{
+				Hit.bBlockingHit = true;
+				Hit.Time = Random.FRandRange(0.01f, 0.2f);
+				Hit.Location = FMath::Lerp(Hit.TraceStart, Hit.TraceEnd, double(Hit.Time));
+				Hit.ImpactNormal = Random.GetUnitVector();
+				Hit.Normal = Hit.ImpactNormal;
+				Hit.ImpactPoint = Hit.Location - (Hit.ImpactNormal * SweepRadius);
+				Hit.Distance = FVector::Dist(Hit.TraceStart, Hit.Location);
+				Hit.FaceIndex = Random.RandRange(0, 1000);
+				Hit.BoneName = TEXT("spine_03");
+			}
+			else
+			{
+				Hit.Location = EndTrace;
+				Hit.ImpactPoint = EndTrace;
+			}
+		}
+	}
+
+	static int64 NumBitsFull(FLyraGameplayAbilityTargetData_SingleTargetHit& TargetData)
+	{
+		// What the struct used to send: the stock SingleTargetHit serializer plus the cartridge id
+		FBitWriter Writer(MaxBits, /*AllowResize=*/ true);
+		bool bSuccess = true;
+		TargetData.FGameplayAbilityTargetData_SingleTargetHit::NetSerialize(Writer, nullptr, bSuccess);
+		Writer << TargetData.CartridgeID;
+		return Writer.GetNumBits();
+	}
+
+	static int64 NumBitsCompact(FLyraGameplayAbilityTargetData_SingleTargetHit& TargetData)
+	{
+		FBitWriter Writer(MaxBits, /*AllowResize=*/ true);
+		bool bSuccess = true;
+		TargetData.NetSerialize(Writer, nullptr, bSuccess);
+		return Writer.GetNumBits();
+	}
+
+	static int64 NumBitsSeeded(const TArray<FLyraGameplayAbilityTargetData_SingleTargetHit>& Hits)
+	{
+		FLyraGameplayAbilityTargetData_Cartridge Cartridge;
+		Cartridge.Origin = Hits[0].HitResult.TraceStart;
+		Cartridge.AimDir = (Hits[0].HitResult.TraceEnd - Hits[0].HitResult.TraceStart).GetSafeNormal();
+		Cartridge.SpreadAngle = 10.0f;
+		Cartridge.Seed = Hits[0].CartridgeID;
+
+		for (int32 Index = 0; Index < Hits.Num(); ++Index)
+		{
+			const FHitResult& Hit = Hits[Index].HitResult;
+
+			FLyraCartridgeHitClaim& Claim = Cartridge.Hits.AddDefaulted_GetRef();
+			Claim.BulletIndex = uint8(Index);
+			Claim.bBlockingHit = Hit.bBlockingHit;
+			Claim.ImpactPoint = Hit.ImpactPoint;
+			Claim.ImpactNormal = Hit.ImpactNormal;
+		}
+
+		FBitWriter Writer(MaxBits, /*AllowResize=*/ true);
+		bool bSuccess = true;
+		Cartridge.NetSerialize(Writer, nullptr, bSuccess);
+		return Writer.GetNumBits();
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLyraTargetDataSerializationTest, "Lyra.Weapon.TargetData.NetSerialize", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ServerContext | EAutomationTestFlags::EngineFilter)
+
+bool FLyraTargetDataSerializationTest::RunTest(const FString& Parameters)
+{
+	using namespace LyraTargetDataSerializationTest;
+
+	FRandomStream Random(7);
+
+	// Octahedral normals stay within a couple of degrees everywhere on the sphere, including the folded lower half
+	for (int32 Index = 0; Index < 1000; ++Index)
+	{
+		const FVector Normal = (Index < 6) ? FVector(Index % 3 == 0, Index % 3 == 1, Index % 3 == 2) * ((Index < 3) ? 1.0 : -1.0) : Random.GetUnitVector();
+		const FVector Decoded = LyraTargetData::DecodeOctahedralNormal16(LyraTargetData::EncodeOctahedralNormal16(Normal));
+
+		if ((Normal | Decoded) < FMath::Cos(FMath::DegreesToRadians(2.0f)))
+		{
+			AddError(FString::Printf(TEXT("Normal %s decoded as %s."), *Normal.ToString(), *Decoded.ToString()));
+			return false;
+		}
+	}
+
+	TArray<FLyraGameplayAbilityTargetData_SingleTargetHit> Hits;
+	MakeCartridge(Random, 64, 0.0f, Hits);
+
+	for (FLyraGameplayAbilityTargetData_SingleTargetHit& Original : Hits)
+	{
+		FBitWriter Writer(MaxBits, /*AllowResize=*/ true);
+		bool bSuccess = false;
+		Original.NetSerialize(Writer, nullptr, bSuccess);
+		TestTrue(TEXT("Write succeeded"), bSuccess);
+
+		FBitReader Reader(Writer.GetData(), Writer.GetNumBits());
+		FLyraGameplayAbilityTargetData_SingleTargetHit Received;
+		Received.NetSerialize(Reader, nullptr, bSuccess);
+		TestTrue(TEXT("Read succeeded"), bSuccess && !Reader.IsError());
+
+		const FHitResult& Sent = Original.HitResult;
+		const FHitResult& Got = Received.HitResult;
+
+		TestEqual(TEXT("CartridgeID"), Received.CartridgeID, Original.CartridgeID);
+		TestEqual(TEXT("Blocking"), Got.bBlockingHit, Sent.bBlockingHit);
+		TestTrue(TEXT("TraceStart"), Got.TraceStart.Equals(Sent.TraceStart, 0.06));
+		TestTrue(TEXT("TraceEnd"), Got.TraceEnd.Equals(Sent.TraceEnd, 0.12));
+		TestTrue(TEXT("ImpactPoint"), Got.ImpactPoint.Equals(Sent.ImpactPoint, 0.12));
+
+		// Location comes back from the 16 bit Time, a few tenths of a unit over a full length trace
+		TestTrue(TEXT("Location"), Got.Location.Equals(Sent.Location, 0.5));
+
+		if (Sent.bBlockingHit)
+		{
+			TestTrue(TEXT("ImpactNormal"), (Got.ImpactNormal | Sent.ImpactNormal) > FMath::Cos(FMath::DegreesToRadians(2.0f)));
+		}
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLyraTargetDataBandwidthBenchmark, "Lyra.Weapon.TargetData.Bandwidth", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ServerContext | EAutomationTestFlags::PerfFilter)
+
+bool FLyraTargetDataBandwidthBenchmark::RunTest(const FString& Parameters)
+{
+	using namespace LyraTargetDataSerializationTest;
+
+	struct FWeaponCase
+	{
+		const TCHAR* Name;
+		int32 NumBullets;
+		float SweepRadius;
+	};
+
+	const int32 NumShots = 1000;
+
+	for (const FWeaponCase& WeaponCase : { FWeaponCase{ TEXT("Rifle"), 1, 0.0f }, FWeaponCase{ TEXT("Shotgun"), 10, 5.0f } })
+	{
+		FRandomStream Random(WeaponCase.NumBullets);
+
+		int64 FullBits = 0;
+		int64 CompactBits = 0;
+		int64 SeededBits = 0;
+
+		TArray<FLyraGameplayAbilityTargetData_SingleTargetHit> Hits;
+		for (int32 Shot = 0; Shot < NumShots; ++Shot)
+		{
+			MakeCartridge(Random, WeaponCase.NumBullets, WeaponCase.SweepRadius, Hits);
+
+			for (FLyraGameplayAbilityTargetData_SingleTargetHit& TargetData : Hits)
+			{
+				FullBits += NumBitsFull(TargetData);
+				CompactBits += NumBitsCompact(TargetData);
+			}
+
+			SeededBits += NumBitsSeeded(Hits);
+		}
+
+		const double BytesPerShotFull = (FullBits / 8.0) / NumShots;
+		const double BytesPerShotCompact = (CompactBits / 8.0) / NumShots;
+		const double BytesPerShotSeeded = (SeededBits / 8.0) / NumShots;
+
+		AddInfo(FString::Printf(TEXT("%s (%d bullets): full hit results %.1f bytes/shot, quantized %.1f bytes/shot (%.0f%%), seeded cartridge %.1f bytes/shot (%.0f%%), object references excluded"),
+			WeaponCase.Name, WeaponCase.NumBullets,
+			BytesPerShotFull,
+			BytesPerShotCompact, (BytesPerShotCompact * 100.0) / BytesPerShotFull,
+			BytesPerShotSeeded, (BytesPerShotSeeded * 100.0) / BytesPerShotFull));
+
+		TestTrue(TEXT("Quantized target data is smaller"), CompactBits < FullBits);
+	}
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
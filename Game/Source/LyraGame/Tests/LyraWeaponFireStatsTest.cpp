@@ -0,0 +1,53 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+#include "Weapons/LyraWeaponFireStats.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FLyraWeaponFireHistogramTest, "Lyra.Weapon.FireStats.Histogram", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ServerContext | EAutomationTestFlags::EngineFilter)
+
+bool FLyraWeaponFireHistogramTest::RunTest(const FString& Parameters)
+{
+	FLyraWeaponFireHistogram Histogram;
+
+	// Bucket 0 is below 1, then each bucket doubles
+	Histogram.Add(0.5);
+	Histogram.Add(1.0);
+	Histogram.Add(1.9);
+	Histogram.Add(2.0);
+	Histogram.Add(3.9);
+	Histogram.Add(4.0);
+
+	TestEqual(TEXT("Below one"), Histogram.Counts[0], int64(1));
+	TestEqual(TEXT("[1, 2)"), Histogram.Counts[1], int64(2));
+	TestEqual(TEXT("[2, 4)"), Histogram.Counts[2], int64(2));
+	TestEqual(TEXT("[4, 8)"), Histogram.Counts[3], int64(1));
+	TestEqual(TEXT("Samples"), Histogram.NumSamples, int64(6));
+	TestEqual(TEXT("Max"), Histogram.MaxValue, 4.0);
+
+	// Negative values are clamped, huge ones land in the last bucket
+	Histogram.Add(-3.0);
+	Histogram.Add(1.0e12);
+	TestEqual(TEXT("Negative clamped to the first bucket"), Histogram.Counts[0], int64(2));
+	TestEqual(TEXT("Overflow bucket"), Histogram.Counts[FLyraWeaponFireHistogram::NumBuckets - 1], int64(1));
+
+	// Percentiles report the upper edge of the bucket they fall in
+	FLyraWeaponFireHistogram Latency;
+	for (int32 Index = 0; Index < 90; ++Index)
+	{
+		Latency.Add(40.0);
+	}
+	for (int32 Index = 0; Index < 10; ++Index)
+	{
+		Latency.Add(200.0);
+	}
+
+	TestEqual(TEXT("p50"), Latency.GetPercentile(0.5), 64.0);
+	TestEqual(TEXT("p90"), Latency.GetPercentile(0.9), 64.0);
+	TestEqual(TEXT("p99 is capped at the max"), Latency.GetPercentile(0.99), 200.0);
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
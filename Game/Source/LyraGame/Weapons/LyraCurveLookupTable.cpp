@@ -0,0 +1,148 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "LyraCurveLookupTable.h"
+
+#include "Algo/BinarySearch.h"
+#include "Curves/RichCurve.h"
+
+// The error is checked at this many points between each pair of samples
+static constexpr int32 NumErrorChecksPerSample = 4;
+
+bool FLyraCurveLookupTable::Bake(const FRichCurve& Curve, int32 NumSamples, float Tolerance)
+{
+	Reset();
+
+	float MinTime;
+	float MaxTime;
+	Curve.GetTimeRange(/*out*/ MinTime, /*out*/ MaxTime);
+
+	// A curve with a single key (or none) is a constant
+	if ((Curve.GetNumKeys() < 2) || (MaxTime <= MinTime))
+	{
+		Values.Add(Curve.Eval(MinTime));
+		MinX = MinTime;
+		bIsValid = true;
+		return true;
+	}
+
+	// Eval clamps to the key range, which only matches constant extrapolation.  Anything else (linear, cycle,
+	// oscillate) is left to the curve.
+	if ((Curve.PreInfinityExtrap != RCCE_Constant) || (Curve.PostInfinityExtrap != RCCE_Constant))
+	{
+		return false;
+	}
+
+	NumSamples = FMath::Max(NumSamples, 2);
+	const float Step = (MaxTime - MinTime) / float(NumSamples - 1);
+
+	MinX = MinTime;
+	InvStep = 1.0f / Step;
+
+	Values.SetNumUninitialized(NumSamples);
+	for (int32 Index = 0; Index < NumSamples; ++Index)
+	{
+		Values[Index] = Curve.Eval(MinTime + (Step * Index));
+	}
+
+	const int32 NumChecks = (NumSamples - 1) * NumErrorChecksPerSample;
+	for (int32 CheckIndex = 1; CheckIndex < NumChecks; ++CheckIndex)
+	{
+		const float X = MinTime + ((MaxTime - MinTime) * CheckIndex) / float(NumChecks);
+		MaxError = FMath::Max(MaxError, FMath::Abs(Eval(X) - Curve.Eval(X)));
+	}
+
+	bIsValid = (MaxError <= Tolerance);
+	return bIsValid;
+}
+
+void FLyraCurveLookupTable::Reset()
+{
+	Values.Reset();
+	MinX = 0.0f;
+	InvStep = 0.0f;
+	MaxError = 0.0f;
+	bIsValid = false;
+}
+
+void FLyraCoolingTimeTable::Build(const FRichCurve& CooldownCurve, float InMinHeat, float InMaxHeat, int32 NumSamples)
+{
+	Reset();
+
+	if (InMaxHeat <= InMinHeat)
+	{
+		return;
+	}
+
+	NumSamples = FMath::Max(NumSamples, 2);
+	MinHeat = InMinHeat;
+	HeatStep = (InMaxHeat - InMinHeat) / float(NumSamples - 1);
+
+	CoolingTimes.SetNumUninitialized(NumSamples);
+	FloorSamples.SetNumUninitialized(NumSamples - 1);
+	CoolingTimes[0] = 0.0;
+
+	int32 FloorSample = 0;
+	float PrevRate = CooldownCurve.Eval(MinHeat);
+	for (int32 Index = 1; Index < NumSamples; ++Index)
+	{
+		const float Rate = CooldownCurve.Eval(MinHeat + (HeatStep * Index));
+
+		if ((PrevRate > UE_KINDA_SMALL_NUMBER) && (Rate > UE_KINDA_SMALL_NUMBER))
+		{
+			// Trapezoid rule on the seconds per unit of heat
+			CoolingTimes[Index] = CoolingTimes[Index - 1] + (HeatStep * 0.5 * ((1.0 / PrevRate) + (1.0 / Rate)));
+			FloorSamples[Index - 1] = FloorSample;
+		}
+		else
+		{
+			// Cooling stalls somewhere in this interval, nothing above it can cool past its top
+			CoolingTimes[Index] = CoolingTimes[Index - 1];
+			FloorSamples[Index - 1] = INDEX_NONE;
+			FloorSample = Index;
+		}
+
+		PrevRate = Rate;
+	}
+}
+
+void FLyraCoolingTimeTable::Reset()
+{
+	CoolingTimes.Reset();
+	FloorSamples.Reset();
+	MinHeat = 0.0f;
+	HeatStep = 0.0f;
+}
+
+float FLyraCoolingTimeTable::Cool(float StartHeat, double CoolingTime) const
+{
+	const int32 NumSamples = CoolingTimes.Num();
+	if (NumSamples < 2)
+	{
+		return StartHeat;
+	}
+
+	const float StartAlpha = FMath::Clamp((StartHeat - MinHeat) / HeatStep, 0.0f, float(NumSamples - 1));
+	const int32 StartIndex = FMath::Min(FMath::FloorToInt(StartAlpha), NumSamples - 2);
+
+	const int32 FloorSample = FloorSamples[StartIndex];
+	if (FloorSample == INDEX_NONE)
+	{
+		return MinHeat + (HeatStep * StartAlpha);
+	}
+
+	// Look up how long StartHeat takes to cool all the way down, the heat we are after is the one that is
+	// CoolingTime closer to the minimum than that
+	const double StartTime = FMath::Lerp(CoolingTimes[StartIndex], CoolingTimes[StartIndex + 1], double(StartAlpha - StartIndex));
+
+	const double TimeLeft = StartTime - CoolingTime;
+	if (TimeLeft <= CoolingTimes[FloorSample])
+	{
+		return MinHeat + (HeatStep * FloorSample);
+	}
+
+	const int32 Index = FMath::Clamp(Algo::UpperBound(CoolingTimes, TimeLeft) - 1, FloorSample, NumSamples - 2);
+	const double SegmentTime = CoolingTimes[Index + 1] - CoolingTimes[Index];
+	const double Alpha = (SegmentTime > 0.0) ? FMath::Clamp((TimeLeft - CoolingTimes[Index]) / SegmentTime, 0.0, 1.0) : 0.0;
+
+	return MinHeat + (HeatStep * (Index + float(Alpha)));
+}
@@ -0,0 +1,108 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "Containers/Array.h"
+#include "HAL/Platform.h"
+#include "Math/UnrealMathUtility.h"
+
+struct FRichCurve;
+
+/**
+ * FLyraCurveLookupTable
+ *
+ *	A float curve sampled at a fixed number of evenly spaced points over its key range, evaluated with linear
+ *	interpolation between the samples.  Inputs outside the key range are clamped, which matches the default
+ *	constant extrapolation of rich curves.  Curves with any other extrapolation are never baked.
+ *
+ *	Baking measures the largest difference to the source curve, and the table refuses to be used (IsValid
+ *	returns false) when that is over the tolerance it was baked with, so callers can fall back to the curve.
+ */
+struct LYRAGAME_API FLyraCurveLookupTable
+{
+public:
+	// Samples the curve, returns false if the table could not match the curve within Tolerance
+	bool Bake(const FRichCurve& Curve, int32 NumSamples, float Tolerance);
+
+	void Reset();
+
+	// True if the table has been baked and is within its tolerance of the source curve
+	bool IsValid() const
+	{
+		return bIsValid;
+	}
+
+	// Largest difference to the source curve found while baking
+	float GetMaxError() const
+	{
+		return MaxError;
+	}
+
+	int32 Num() const
+	{
+		return Values.Num();
+	}
+
+	float Eval(float X) const
+	{
+		const int32 NumValues = Values.Num();
+		if (NumValues < 2)
+		{
+			return (NumValues == 1) ? Values[0] : 0.0f;
+		}
+
+		const float Alpha = FMath::Clamp((X - MinX) * InvStep, 0.0f, float(NumValues - 1));
+		const int32 Index = FMath::Min(FMath::FloorToInt(Alpha), NumValues - 2);
+
+		return FMath::Lerp(Values[Index], Values[Index + 1], Alpha - float(Index));
+	}
+
+private:
+	TArray<float> Values;
+	float MinX = 0.0f;
+	float InvStep = 0.0f;
+	float MaxError = 0.0f;
+	bool bIsValid = false;
+};
+
+/**
+ * FLyraCoolingTimeTable
+ *
+ *	A heat to cool down per second curve integrated into the time it takes to cool from the minimum heat up to each
+ *	of a fixed number of evenly spaced heats.  Inverting it gives the heat after cooling for any length of time
+ *	without stepping the cool down.
+ *
+ *	Wherever the curve does not cool (a rate of zero or less) the heat stops: cooling from above such a heat ends at
+ *	the top of the sample interval it is in, and cooling from inside one does nothing.
+ */
+struct LYRAGAME_API FLyraCoolingTimeTable
+{
+public:
+	void Build(const FRichCurve& CooldownCurve, float InMinHeat, float InMaxHeat, int32 NumSamples);
+
+	void Reset();
+
+	// False when the heat range is empty, there is nothing to cool through
+	bool IsValid() const
+	{
+		return CoolingTimes.Num() >= 2;
+	}
+
+	int32 Num() const
+	{
+		return CoolingTimes.Num();
+	}
+
+	// Returns the heat after cooling down from StartHeat (clamped to the table's heat range) for CoolingTime seconds
+	float Cool(float StartHeat, double CoolingTime) const;
+
+private:
+	// Seconds to cool from MinHeat down from each sample, intervals that do not cool add nothing as they are never crossed
+	TArray<double> CoolingTimes;
+
+	// Per sample interval, the lowest sample that cooling from inside it can reach (INDEX_NONE where it does not cool)
+	TArray<int32> FloorSamples;
+
+	float MinHeat = 0.0f;
+	float HeatStep = 0.0f;
+};
@@ -9,15 +9,34 @@
 #include "NativeGameplayTags.h"
 #include "GameFramework/GameplayMessageSubsystem.h"
 #include "Weapons/LyraWeaponStateComponent.h"
+#include "Weapons/LyraLagCompensationSubsystem.h"
+#include "Weapons/LyraProjectileSubsystem.h"
+#include "Weapons/LyraWeaponFireStats.h"
 #include "Teams/LyraTeamSubsystem.h"
 #include "AbilitySystemComponent.h"
+#include "AbilitySystemGlobals.h"
+#include "GameplayCueManager.h"
+#include "GameplayEffect.h"
 #include "GameFramework/PlayerController.h"
 #include "AbilitySystem/LyraGameplayEffectContext.h"
+#include "AbilitySystem/LyraGameplayAbilityTargetData_Cartridge.h"
 #include "AbilitySystem/LyraGameplayAbilityTargetData_SingleTargetHit.h"
 #include "DrawDebugHelpers.h"
+#include "Async/ParallelFor.h"
+#include "Math/RandomStream.h"
 
 #include UE_INLINE_GENERATED_CPP_BY_NAME(LyraGameplayAbility_RangedWeapon)
 
+// Scene queries of a single bullet, filled on a worker thread and resolved on the game thread
+struct FLyraBulletTraceQueries
+{
+	TArray<FHitResult> LineHits;
+	TArray<FHitResult> SweepHits;
+	FHitResult LineImpact;
+	FHitResult SweepImpact;
+	bool bSwept = false;
+};
+
 namespace LyraConsoleVariables
 {
 	static float DrawBulletTracesDuration = 0.0f;
@@ -40,6 +59,20 @@ namespace LyraConsoleVariables
 		DrawBulletHitRadius,
 		TEXT("When bullet hit debug drawing is enabled (see DrawBulletHitDuration), how big should the hit radius be? (in uu)"),
 		ECVF_Default);
+
+	static int32 ParallelBulletTraceMinBullets = 2;
+	static FAutoConsoleVariableRef CVarParallelBulletTraceMinBullets(
+		TEXT("lyra.Weapon.ParallelBulletTraceMinBullets"),
+		ParallelBulletTraceMinBullets,
+		TEXT("Cartridges with at least this many bullets trace them in parallel on the task graph (0 to always trace on the game thread)"),
+		ECVF_Default);
+
+	static bool bSendSeededCartridges = true;
+	static FAutoConsoleVariableRef CVarSendSeededCartridges(
+		TEXT("lyra.Weapon.SendSeededCartridges"),
+		bSendSeededCartridges,
+		TEXT("Should clients send each cartridge as aim, spread seed and claimed hits (otherwise every hit result is sent in full). While set, servers reject full hit results."),
+		ECVF_Default);
 }
 
 // Weapon fire will be blocked/canceled if the player has this tag
@@ -47,7 +80,7 @@ UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_WeaponFireBlocked, "Ability.Weapon.NoFiring");
 
 //////////////////////////////////////////////////////////////////////
 
-FVector VRandConeNormalDistribution(const FVector& Dir, const float ConeHalfAngleRad, const float Exponent)
+FVector VRandConeNormalDistribution(FRandomStream& RandomStream, const FVector& Dir, const float ConeHalfAngleRad, const float Exponent)
 {
 	if (ConeHalfAngleRad > 0.f)
 	{
@@ -55,9 +88,9 @@ FVector VRandConeNormalDistribution(const FVector& Dir, const float ConeHalfAngl
 
 		// consider the cone a concatenation of two rotations. one "away" from the center line, and another "around" the circle
 		// apply the exponent to the away-from-center rotation. a larger exponent will cluster points more tightly around the center
-		const float FromCenter = FMath::Pow(FMath::FRand(), Exponent);
+		const float FromCenter = FMath::Pow(RandomStream.FRand(), Exponent);
 		const float AngleFromCenter = FromCenter * ConeHalfAngleDegrees;
-		const float AngleAround = FMath::FRand() * 360.0f;
+		const float AngleAround = RandomStream.FRand() * 360.0f;
 
 		FRotator Rot = Dir.Rotation();
 		FQuat DirQuat(Rot);
@@ -129,6 +162,25 @@ int32 ULyraGameplayAbility_RangedWeapon::FindFirstPawnHitResult(const TArray<FHi
 	return INDEX_NONE;
 }
 
+int32 ULyraGameplayAbility_RangedWeapon::MakeCartridgeSeed(const FPredictionKey& ActivationPredictionKey, int32 ShotIndex)
+{
+	return int32(HashCombine(GetTypeHash(ActivationPredictionKey.Current), GetTypeHash(ShotIndex)));
+}
+
+void ULyraGameplayAbility_RangedWeapon::ComputeBulletEndTraces(const FVector& StartTrace, const FVector& AimDir, float SpreadAngle, float SpreadExponent, float MaxRange, int32 NumBullets, int32 Seed, OUT TArray<FVector>& OutEndTraces)
+{
+	FRandomStream RandomStream(Seed);
+
+	const float HalfSpreadAngleInRadians = FMath::DegreesToRadians(SpreadAngle * 0.5f);
+
+	OutEndTraces.Reset(NumBullets);
+	for (int32 BulletIndex = 0; BulletIndex < NumBullets; ++BulletIndex)
+	{
+		const FVector BulletDir = VRandConeNormalDistribution(RandomStream, AimDir, HalfSpreadAngleInRadians, SpreadExponent);
+		OutEndTraces.Add(StartTrace + (BulletDir * MaxRange));
+	}
+}
+
 void ULyraGameplayAbility_RangedWeapon::AddAdditionalTraceIgnoreActors(FCollisionQueryParams& TraceParams) const
 {
 	if (AActor* Avatar = GetAvatarActorFromActorInfo())
@@ -145,16 +197,27 @@ ECollisionChannel ULyraGameplayAbility_RangedWeapon::DetermineTraceChannel(FColl
 	return Lyra_TraceChannel_Weapon;
 }
 
+ECollisionChannel ULyraGameplayAbility_RangedWeapon::MakeWeaponTraceParams(bool bIsSimulated, OUT FCollisionQueryParams& OutTraceParams) const
+{
+	OutTraceParams = FCollisionQueryParams(SCENE_QUERY_STAT(WeaponTrace), /*bTraceComplex=*/ true, /*IgnoreActor=*/ GetAvatarActorFromActorInfo());
+	OutTraceParams.bReturnPhysicalMaterial = true;
+	AddAdditionalTraceIgnoreActors(OutTraceParams);
+	//OutTraceParams.bDebugQuery = true;
+
+	return DetermineTraceChannel(OutTraceParams, bIsSimulated);
+}
+
 FHitResult ULyraGameplayAbility_RangedWeapon::WeaponTrace(const FVector& StartTrace, const FVector& EndTrace, float SweepRadius, bool bIsSimulated, OUT TArray<FHitResult>& OutHitResults) const
 {
-	TArray<FHitResult> HitResults;
-	
-	FCollisionQueryParams TraceParams(SCENE_QUERY_STAT(WeaponTrace), /*bTraceComplex=*/ true, /*IgnoreActor=*/ GetAvatarActorFromActorInfo());
-	TraceParams.bReturnPhysicalMaterial = true;
-	AddAdditionalTraceIgnoreActors(TraceParams);
-	//TraceParams.bDebugQuery = true;
+	FCollisionQueryParams TraceParams;
+	const ECollisionChannel TraceChannel = MakeWeaponTraceParams(bIsSimulated, /*out*/ TraceParams);
 
-	const ECollisionChannel TraceChannel = DetermineTraceChannel(TraceParams, bIsSimulated);
+	return WeaponTrace(StartTrace, EndTrace, SweepRadius, TraceParams, TraceChannel, /*out*/ OutHitResults);
+}
+
+FHitResult ULyraGameplayAbility_RangedWeapon::WeaponTrace(const FVector& StartTrace, const FVector& EndTrace, float SweepRadius, const FCollisionQueryParams& TraceParams, ECollisionChannel TraceChannel, OUT TArray<FHitResult>& OutHitResults) const
+{
+	TArray<FHitResult> HitResults;
 
 	if (SweepRadius > 0.0f)
 	{
@@ -304,50 +367,93 @@ FHitResult ULyraGameplayAbility_RangedWeapon::DoSingleBulletTrace(const FVector&
 	}
 #endif // ENABLE_DRAW_DEBUG
 
-	FHitResult Impact;
+	FCollisionQueryParams TraceParams;
+	const ECollisionChannel TraceChannel = MakeWeaponTraceParams(bIsSimulated, /*out*/ TraceParams);
+
+	return DoSingleBulletTrace(StartTrace, EndTrace, SweepRadius, TraceParams, TraceChannel, /*out*/ OutHits);
+}
+
+FHitResult ULyraGameplayAbility_RangedWeapon::DoSingleBulletTrace(const FVector& StartTrace, const FVector& EndTrace, float SweepRadius, const FCollisionQueryParams& TraceParams, ECollisionChannel TraceChannel, OUT TArray<FHitResult>& OutHits, FLyraWeaponTraceCounts* OutTraceCounts) const
+{
+	FLyraBulletTraceQueries Queries;
+	RunBulletTraceQueries(StartTrace, EndTrace, SweepRadius, TraceParams, TraceChannel, /*out*/ Queries);
+
+	FLyraWeaponTraceCounts TraceCounts;
+	const FHitResult Impact = ResolveBulletTraceQueries(Queries, /*out*/ OutHits, TraceCounts);
+
+	if (OutTraceCounts != nullptr)
+	{
+		*OutTraceCounts += TraceCounts;
+	}
+
+	return Impact;
+}
 
-	// Trace and process instant hit if something was hit
+void ULyraGameplayAbility_RangedWeapon::RunBulletTraceQueries(const FVector& StartTrace, const FVector& EndTrace, float SweepRadius, const FCollisionQueryParams& TraceParams, ECollisionChannel TraceChannel, OUT FLyraBulletTraceQueries& OutQueries) const
+{
 	// First trace without using sweep radius
-	if (FindFirstPawnHitResult(OutHits) == INDEX_NONE)
+	OutQueries.LineImpact = WeaponTrace(StartTrace, EndTrace, /*SweepRadius=*/ 0.0f, TraceParams, TraceChannel, /*out*/ OutQueries.LineHits);
+
+	// Hits on something attached to a pawn need the actor to be resolved, which has to wait for the game thread.  Only
+	// skip the sweep when a hit already is a pawn, otherwise run it in case it ends up being used.
+	const bool bLineHitPawn = OutQueries.LineHits.ContainsByPredicate([](const FHitResult& Hit)
+		{
+			return Hit.HitObjectHandle.DoesRepresentClass(APawn::StaticClass());
+		});
+
+	if ((SweepRadius > 0.0f) && !bLineHitPawn)
 	{
-		Impact = WeaponTrace(StartTrace, EndTrace, /*SweepRadius=*/ 0.0f, bIsSimulated, /*out*/ OutHits);
+		OutQueries.SweepImpact = WeaponTrace(StartTrace, EndTrace, SweepRadius, TraceParams, TraceChannel, /*out*/ OutQueries.SweepHits);
+		OutQueries.bSwept = true;
 	}
+}
 
-	if (FindFirstPawnHitResult(OutHits) == INDEX_NONE)
+FHitResult ULyraGameplayAbility_RangedWeapon::ResolveBulletTraceQueries(FLyraBulletTraceQueries& Queries, OUT TArray<FHitResult>& OutHits, FLyraWeaponTraceCounts& InOutTraceCounts)
+{
+	check(IsInGameThread());
+
+	++InOutTraceCounts.LineTraces;
+	OutHits.Append(MoveTemp(Queries.LineHits));
+	FHitResult Impact = Queries.LineImpact;
+
+	if (Queries.bSwept)
 	{
-		// If this weapon didn't hit anything with a line trace and supports a sweep radius, try that
-		if (SweepRadius > 0.0f)
-		{
-			TArray<FHitResult> SweepHits;
-			Impact = WeaponTrace(StartTrace, EndTrace, SweepRadius, bIsSimulated, /*out*/ SweepHits);
+		++InOutTraceCounts.SweepTraces;
+	}
 
-			// If the trace with sweep radius enabled hit a pawn, check if we should use its hit results
-			const int32 FirstPawnIdx = FindFirstPawnHitResult(SweepHits);
-			if (SweepHits.IsValidIndex(FirstPawnIdx))
-			{
-				// If we had a blocking hit in our line trace that occurs in SweepHits before our
-				// hit pawn, we should just use our initial hit results since the Pawn hit should be blocked
-				bool bUseSweepHits = true;
-				for (int32 Idx = 0; Idx < FirstPawnIdx; ++Idx)
-				{
-					const FHitResult& CurHitResult = SweepHits[Idx];
+	// If this weapon didn't hit a pawn with a line trace and supports a sweep radius, try that
+	if (Queries.bSwept && (FindFirstPawnHitResult(OutHits) == INDEX_NONE))
+	{
+		Impact = Queries.SweepImpact;
+		const TArray<FHitResult>& SweepHits = Queries.SweepHits;
 
-					auto Pred = [&CurHitResult](const FHitResult& Other)
-					{
-						return Other.HitObjectHandle == CurHitResult.HitObjectHandle;
-					};
-					if (CurHitResult.bBlockingHit && OutHits.ContainsByPredicate(Pred))
-					{
-						bUseSweepHits = false;
-						break;
-					}
-				}
+		// If the trace with sweep radius enabled hit a pawn, check if we should use its hit results
+		const int32 FirstPawnIdx = FindFirstPawnHitResult(SweepHits);
+		if (SweepHits.IsValidIndex(FirstPawnIdx))
+		{
+			// If we had a blocking hit in our line trace that occurs in SweepHits before our
+			// hit pawn, we should just use our initial hit results since the Pawn hit should be blocked
+			bool bUseSweepHits = true;
+			for (int32 Idx = 0; Idx < FirstPawnIdx; ++Idx)
+			{
+				const FHitResult& CurHitResult = SweepHits[Idx];
 
-				if (bUseSweepHits)
+				auto Pred = [&CurHitResult](const FHitResult& Other)
+				{
+					return Other.HitObjectHandle == CurHitResult.HitObjectHandle;
+				};
+				if (CurHitResult.bBlockingHit && OutHits.ContainsByPredicate(Pred))
 				{
-					OutHits = SweepHits;
+					bUseSweepHits = false;
+					break;
 				}
 			}
+
+			if (bUseSweepHits)
+			{
+				OutHits = SweepHits;
+				++InOutTraceCounts.SweepReplacements;
+			}
 		}
 	}
 
@@ -356,6 +462,8 @@ FHitResult ULyraGameplayAbility_RangedWeapon::DoSingleBulletTrace(const FVector&
 
 void ULyraGameplayAbility_RangedWeapon::PerformLocalTargeting(OUT TArray<FHitResult>& OutHits)
 {
+	LYRA_WEAPON_FIRE_SCOPE(STAT_LyraWeaponFire_LocalTargeting);
+
 	APawn* const AvatarPawn = Cast<APawn>(GetAvatarActorFromActorInfo());
 
 	ULyraRangedWeaponInstance* WeaponData = GetWeaponInstance();
@@ -372,6 +480,9 @@ void ULyraGameplayAbility_RangedWeapon::PerformLocalTargeting(OUT TArray<FHitRes
 
 		InputData.EndAim = InputData.StartTrace + InputData.AimDir * WeaponData->GetMaxDamageRange();
 
+		InputData.ShotIndex = NextCartridgeIndex++;
+		InputData.Seed = MakeCartridgeSeed(CurrentActivationInfo.GetActivationPredictionKey(), InputData.ShotIndex);
+
 #if ENABLE_DRAW_DEBUG
 		if (LyraConsoleVariables::DrawBulletTracesDuration > 0.0f)
 		{
@@ -390,23 +501,80 @@ void ULyraGameplayAbility_RangedWeapon::TraceBulletsInCartridge(const FRangedWea
 	check(WeaponData);
 
 	const int32 BulletsPerCartridge = WeaponData->GetBulletsPerCartridge();
+	const float SweepRadius = WeaponData->GetBulletTraceSweepRadius();
 
-	for (int32 BulletIndex = 0; BulletIndex < BulletsPerCartridge; ++BulletIndex)
+	// Pick every bullet direction up front from the cartridge seed, the server regenerates the same ones from it
+	const float BaseSpreadAngle = WeaponData->GetCalculatedSpreadAngle();
+	const float SpreadAngleMultiplier = WeaponData->GetCalculatedSpreadAngleMultiplier();
+	const float ActualSpreadAngle = BaseSpreadAngle * SpreadAngleMultiplier;
+
+	MakeLocalCartridge(*WeaponData, InputData.StartTrace, InputData.AimDir, ActualSpreadAngle, InputData.Seed, InputData.ShotIndex, /*out*/ LastCartridge);
+
+	// Trace from the rounded origin the server will see
+	const FVector& StartTrace = LastCartridge.StartTrace;
+	const TArray<FVector>& EndTraces = LastCartridge.EndTraces;
+
+#if ENABLE_DRAW_DEBUG
+	if (LyraConsoleVariables::DrawBulletTracesDuration > 0.0f)
 	{
-		const float BaseSpreadAngle = WeaponData->GetCalculatedSpreadAngle();
-		const float SpreadAngleMultiplier = WeaponData->GetCalculatedSpreadAngleMultiplier();
-		const float ActualSpreadAngle = BaseSpreadAngle * SpreadAngleMultiplier;
+		for (const FVector& EndTrace : EndTraces)
+		{
+			static float DebugThickness = 1.0f;
+			DrawDebugLine(GetWorld(), StartTrace, EndTrace, FColor::Red, false, LyraConsoleVariables::DrawBulletTracesDuration, 0, DebugThickness);
+		}
+	}
+#endif // ENABLE_DRAW_DEBUG
 
-		const float HalfSpreadAngleInRadians = FMath::DegreesToRadians(ActualSpreadAngle * 0.5f);
+	// Projectile weapons only need the bullet directions, the projectile subsystem does the tracing as they fly
+	if (WeaponData->IsProjectileWeapon())
+	{
+		for (const FVector& EndTrace : EndTraces)
+		{
+			FHitResult& BulletPath = OutHits.Emplace_GetRef(StartTrace, EndTrace);
+			BulletPath.Location = EndTrace;
+			BulletPath.ImpactPoint = EndTrace;
+		}
 
-		const FVector BulletDir = VRandConeNormalDistribution(InputData.AimDir, HalfSpreadAngleInRadians, WeaponData->GetSpreadExponent());
+		FLyraWeaponFireStats::RecordShot(FLyraWeaponFireStats::GetWeaponKey(WeaponData), FLyraWeaponTraceCounts());
+		return;
+	}
 
-		const FVector EndTrace = InputData.StartTrace + (BulletDir * WeaponData->GetMaxDamageRange());
-		FVector HitLocation = EndTrace;
+	// Run the line and sweep queries of every bullet, the bullets are independent of each other so for multi pellet
+	// cartridges they are spread over the task graph.  Each bullet writes only to its own slot, and nothing on the
+	// workers touches the hit actors.
+	FCollisionQueryParams TraceParams;
+	const ECollisionChannel TraceChannel = MakeWeaponTraceParams(/*bIsSimulated=*/ false, /*out*/ TraceParams);
+
+	TArray<FLyraBulletTraceQueries, TInlineAllocator<16>> QueriesPerBullet;
+	QueriesPerBullet.SetNum(BulletsPerCartridge);
+
+	const bool bTraceInParallel = (BulletsPerCartridge >= LyraConsoleVariables::ParallelBulletTraceMinBullets) && (LyraConsoleVariables::ParallelBulletTraceMinBullets > 0);
+	ParallelFor(BulletsPerCartridge, [&](int32 BulletIndex)
+		{
+			RunBulletTraceQueries(StartTrace, EndTraces[BulletIndex], SweepRadius, TraceParams, TraceChannel, /*out*/ QueriesPerBullet[BulletIndex]);
+		}, /*bForceSingleThread=*/ !bTraceInParallel);
 
-		TArray<FHitResult> AllImpacts;
+	// Back on the game thread, pick the pawn hits and merge the line and sweep results of each bullet
+	TArray<FHitResult, TInlineAllocator<16>> Impacts;
+	Impacts.SetNum(BulletsPerCartridge);
+	TArray<TArray<FHitResult>, TInlineAllocator<16>> AllImpactsPerBullet;
+	AllImpactsPerBullet.SetNum(BulletsPerCartridge);
 
-		FHitResult Impact = DoSingleBulletTrace(InputData.StartTrace, EndTrace, WeaponData->GetBulletTraceSweepRadius(), /*bIsSimulated=*/ false, /*out*/ AllImpacts);
+	FLyraWeaponTraceCounts CartridgeTraceCounts;
+	for (int32 BulletIndex = 0; BulletIndex < BulletsPerCartridge; ++BulletIndex)
+	{
+		Impacts[BulletIndex] = ResolveBulletTraceQueries(QueriesPerBullet[BulletIndex], /*out*/ AllImpactsPerBullet[BulletIndex], CartridgeTraceCounts);
+	}
+	FLyraWeaponFireStats::RecordShot(FLyraWeaponFireStats::GetWeaponKey(WeaponData), CartridgeTraceCounts);
+
+	// Merge back in bullet order, exactly as if the bullets had been traced one after another
+	for (int32 BulletIndex = 0; BulletIndex < BulletsPerCartridge; ++BulletIndex)
+	{
+		const FVector& EndTrace = EndTraces[BulletIndex];
+		FVector HitLocation = EndTrace;
+
+		FHitResult& Impact = Impacts[BulletIndex];
+		const TArray<FHitResult>& AllImpacts = AllImpactsPerBullet[BulletIndex];
 
 		const AActor* HitActor = Impact.GetActor();
 
@@ -450,6 +618,11 @@ void ULyraGameplayAbility_RangedWeapon::ActivateAbility(const FGameplayAbilitySp
 
 	OnTargetDataReadyCallbackDelegateHandle = MyAbilityComponent->AbilityTargetDataSetDelegate(CurrentSpecHandle, CurrentActivationInfo.GetActivationPredictionKey()).AddUObject(this, &ThisClass::OnTargetDataReadyCallback);
 
+	// Spread seeds restart with every activation (they are keyed on its prediction key)
+	LastCartridge.bIsValid = false;
+	NextCartridgeIndex = 0;
+	NextRemoteCartridgeIndex = 0;
+
 	// Update the last firing time
 	ULyraRangedWeaponInstance* WeaponData = GetWeaponInstance();
 	check(WeaponData);
@@ -481,6 +654,8 @@ void ULyraGameplayAbility_RangedWeapon::EndAbility(const FGameplayAbilitySpecHan
 
 void ULyraGameplayAbility_RangedWeapon::OnTargetDataReadyCallback(const FGameplayAbilityTargetDataHandle& InData, FGameplayTag ApplicationTag)
 {
+	LYRA_WEAPON_FIRE_SCOPE(STAT_LyraWeaponFire_ProcessTargetData);
+
 	UAbilitySystemComponent* MyAbilityComponent = CurrentActorInfo->AbilitySystemComponent.Get();
 	check(MyAbilityComponent);
 
@@ -494,12 +669,47 @@ void ULyraGameplayAbility_RangedWeapon::OnTargetDataReadyCallback(const FGamepla
 		const bool bShouldNotifyServer = CurrentActorInfo->IsLocallyControlled() && !CurrentActorInfo->IsNetAuthority();
 		if (bShouldNotifyServer)
 		{
-			MyAbilityComponent->CallServerSetReplicatedTargetData(CurrentSpecHandle, CurrentActivationInfo.GetActivationPredictionKey(), LocalTargetDataHandle, ApplicationTag, MyAbilityComponent->ScopedPredictionKey);
+			if (LyraConsoleVariables::bSendSeededCartridges)
+			{
+				// Send the compact cartridge, the server regenerates the bullets from its seed.  Full hit results would be
+				// rejected by the server anyway, so a shot that does not pack into a cartridge is not sent at all.
+				FGameplayAbilityTargetDataHandle CartridgeTargetData;
+				if (MakeCartridgeTargetData(LastCartridge, LocalTargetDataHandle, /*out*/ CartridgeTargetData))
+				{
+					MyAbilityComponent->CallServerSetReplicatedTargetData(CurrentSpecHandle, CurrentActivationInfo.GetActivationPredictionKey(), CartridgeTargetData, ApplicationTag, MyAbilityComponent->ScopedPredictionKey);
+				}
+				else
+				{
+					UE_LOG(LogLyraAbilitySystem, Warning, TEXT("Shot %d of %s does not fit in a cartridge, not sending it to the server"), LastCartridge.ShotIndex, *GetNameSafe(GetAvatarActorFromActorInfo()));
+				}
+			}
+			else
+			{
+				MyAbilityComponent->CallServerSetReplicatedTargetData(CurrentSpecHandle, CurrentActivationInfo.GetActivationPredictionKey(), LocalTargetDataHandle, ApplicationTag, MyAbilityComponent->ScopedPredictionKey);
+			}
 		}
 
-		const bool bIsTargetDataValid = true;
+		bool bIsTargetDataValid = true;
 
-		bool bProjectileWeapon = false;
+		const ULyraRangedWeaponInstance* FiringWeaponData = GetWeaponInstance();
+		const bool bProjectileWeapon = FiringWeaponData && FiringWeaponData->IsProjectileWeapon();
+
+#if WITH_SERVER_CODE
+		// Hits computed on this machine are trusted, hits claimed by a remote client are checked against rewound hitboxes
+		// (projectile weapons have no hits yet, only the trace start of each bullet is checked)
+		if (CurrentActorInfo->IsNetAuthority() && !CurrentActorInfo->IsLocallyControlled())
+		{
+			// A cartridge that does not expand is rejected as a whole, its claims are never validated
+			const bool bExpanded = ExpandCartridgeTargetData(LocalTargetDataHandle);
+			bIsTargetDataValid = bExpanded;
+
+			if (ULyraLagCompensationSubsystem* LagCompensation = UWorld::GetSubsystem<ULyraLagCompensationSubsystem>(GetWorld()))
+			{
+				const float SweepRadius = FiringWeaponData ? FiringWeaponData->GetBulletTraceSweepRadius() : 0.0f;
+				bIsTargetDataValid = bExpanded && LagCompensation->ValidateTargetData(Cast<APawn>(GetAvatarActorFromActorInfo()), LocalTargetDataHandle, SweepRadius);
+			}
+		}
+#endif //WITH_SERVER_CODE
 
 #if WITH_SERVER_CODE
 		if (!bProjectileWeapon)
@@ -540,7 +750,18 @@ void ULyraGameplayAbility_RangedWeapon::OnTargetDataReadyCallback(const FGamepla
 			check(WeaponData);
 			WeaponData->AddSpread();
 
-			// Let the blueprint do stuff like apply effects to the targets
+			if (bProjectileWeapon && CurrentActorInfo->IsNetAuthority())
+			{
+				SpawnProjectilesFromTargetData(LocalTargetDataHandle, /*bAuthoritative=*/ true);
+			}
+
+			// One application per target hit by this shot for whatever the blueprint applies, however many bullets landed on it
+			if (!bProjectileWeapon)
+			{
+				BatchHitsPerTarget(LocalTargetDataHandle);
+			}
+
+			// Let the blueprint do stuff like apply other effects to the targets
 			OnRangedWeaponTargetDataReady(LocalTargetDataHandle);
 		}
 		else
@@ -556,6 +777,9 @@ void ULyraGameplayAbility_RangedWeapon::OnTargetDataReadyCallback(const FGamepla
 
 void ULyraGameplayAbility_RangedWeapon::StartRangedWeaponTargeting()
 {
+	LYRA_WEAPON_FIRE_SCOPE(STAT_LyraWeaponFire_StartTargeting);
+	const double StartTime = FPlatformTime::Seconds();
+
 	check(CurrentActorInfo);
 
 	AActor* AvatarActor = CurrentActorInfo->AvatarActor.Get();
@@ -579,7 +803,7 @@ void ULyraGameplayAbility_RangedWeapon::StartRangedWeaponTargeting()
 
 	if (FoundHits.Num() > 0)
 	{
-		const int32 CartridgeID = FMath::Rand();
+		const int32 CartridgeID = LastCartridge.bIsValid ? LastCartridge.Seed : FMath::Rand();
 
 		for (const FHitResult& FoundHit : FoundHits)
 		{
@@ -592,13 +816,364 @@ void ULyraGameplayAbility_RangedWeapon::StartRangedWeaponTargeting()
 	}
 
 	// Send hit marker information
-	const bool bProjectileWeapon = false;
+	const ULyraRangedWeaponInstance* WeaponData = GetWeaponInstance();
+	const bool bProjectileWeapon = WeaponData && WeaponData->IsProjectileWeapon();
 	if (!bProjectileWeapon && (WeaponStateComponent != nullptr))
 	{
-		WeaponStateComponent->AddUnconfirmedServerSideHitMarkers(TargetData, FoundHits);
+		WeaponStateComponent->AddUnconfirmedServerSideHitMarkers(TargetData, FoundHits, FLyraWeaponFireStats::GetWeaponKey(GetWeaponInstance()));
+	}
+
+	// Remote clients fly their own projectiles right away, the server's copies are not shown to the shooter
+	if (bProjectileWeapon && !CurrentActorInfo->IsNetAuthority())
+	{
+		SpawnProjectilesFromTargetData(TargetData, /*bAuthoritative=*/ false);
 	}
 
 	// Process the target data immediately
 	OnTargetDataReadyCallback(TargetData, FGameplayTag());
+
+	FLyraWeaponFireStats::RecordMeasure(FLyraWeaponFireStats::GetWeaponKey(GetWeaponInstance()), FLyraWeaponFireStats::EMeasure::TargetingTime, (FPlatformTime::Seconds() - StartTime) * 1.0e6);
+}
+
+namespace LyraRangedWeapon
+{
+	// Hits of one shot on a single target, in the order they were fired
+	struct FTargetHits
+	{
+		UAbilitySystemComponent* TargetAbilitySystem = nullptr;
+		int32 FirstDataIndex = INDEX_NONE;
+		TArray<FHitResult> Hits;
+	};
+
+	static void GroupHitsPerTarget(const FGameplayAbilityTargetDataHandle& TargetData, TArray<FTargetHits, TInlineAllocator<4>>& OutHitsPerTarget)
+	{
+		for (int32 DataIndex = 0; DataIndex < TargetData.Num(); ++DataIndex)
+		{
+			const FGameplayAbilityTargetData* Data = TargetData.Get(DataIndex);
+			const FHitResult* Hit = (Data != nullptr) ? Data->GetHitResult() : nullptr;
+			UAbilitySystemComponent* TargetAbilitySystem = (Hit != nullptr) ? UAbilitySystemGlobals::GetAbilitySystemComponentFromActor(Hit->GetActor()) : nullptr;
+			if (TargetAbilitySystem == nullptr)
+			{
+				continue;
+			}
+
+			FTargetHits* TargetHits = OutHitsPerTarget.FindByPredicate([TargetAbilitySystem](const FTargetHits& Entry) { return Entry.TargetAbilitySystem == TargetAbilitySystem; });
+			if (TargetHits == nullptr)
+			{
+				TargetHits = &OutHitsPerTarget.AddDefaulted_GetRef();
+				TargetHits->TargetAbilitySystem = TargetAbilitySystem;
+				TargetHits->FirstDataIndex = DataIndex;
+			}
+			TargetHits->Hits.Add(*Hit);
+		}
+	}
+}
+
+void ULyraGameplayAbility_RangedWeapon::BatchHitsPerTarget(FGameplayAbilityTargetDataHandle& TargetData)
+{
+	TArray<LyraRangedWeapon::FTargetHits, TInlineAllocator<4>> HitsPerTarget;
+	LyraRangedWeapon::GroupHitsPerTarget(TargetData, /*out*/ HitsPerTarget);
+
+	for (int32 DataIndex = 0; DataIndex < TargetData.Num(); ++DataIndex)
+	{
+		FGameplayAbilityTargetData* Data = TargetData.Get(DataIndex);
+		if ((Data == nullptr) || !Data->GetScriptStruct()->IsChildOf(FLyraGameplayAbilityTargetData_SingleTargetHit::StaticStruct()))
+		{
+			continue;
+		}
+
+		FLyraGameplayAbilityTargetData_SingleTargetHit* SingleTargetHit = static_cast<FLyraGameplayAbilityTargetData_SingleTargetHit*>(Data);
+		SingleTargetHit->BatchedHits.Reset();
+		SingleTargetHit->bFoldedIntoBatch = false;
+
+		const LyraRangedWeapon::FTargetHits* TargetHits = HitsPerTarget.FindByPredicate([DataIndex](const LyraRangedWeapon::FTargetHits& Entry) { return Entry.FirstDataIndex == DataIndex; });
+		if (TargetHits != nullptr)
+		{
+			if (TargetHits->Hits.Num() > 1)
+			{
+				SingleTargetHit->BatchedHits = TargetHits->Hits;
+			}
+		}
+		else
+		{
+			// Every hit on an ability system is in a group, the ones that do not start it were folded into the first
+			SingleTargetHit->bFoldedIntoBatch = (UAbilitySystemGlobals::GetAbilitySystemComponentFromActor(SingleTargetHit->HitResult.GetActor()) != nullptr);
+		}
+	}
+}
+
+TArray<FActiveGameplayEffectHandle> ULyraGameplayAbility_RangedWeapon::ApplyBatchedDamageEffect(const FGameplayAbilityTargetDataHandle& TargetData, TSubclassOf<UGameplayEffect> DamageEffect, int32 GameplayEffectLevel)
+{
+	if ((CurrentActorInfo == nullptr) || (DamageEffect == nullptr) || !CurrentActorInfo->IsNetAuthority())
+	{
+		return TArray<FActiveGameplayEffectHandle>();
+	}
+
+	FGameplayEffectSpecHandle SpecHandle = MakeOutgoingGameplayEffectSpec(DamageEffect, GameplayEffectLevel);
+	if (!SpecHandle.IsValid())
+	{
+		return TArray<FActiveGameplayEffectHandle>();
+	}
+
+	LYRA_WEAPON_FIRE_SCOPE(STAT_LyraWeaponFire_ApplyDamageEffect);
+	const double StartTime = FPlatformTime::Seconds();
+
+	TArray<FActiveGameplayEffectHandle> AppliedEffects = ApplyBatchedDamageEffectSpec(TargetData, *SpecHandle.Data.Get());
+
+	FLyraWeaponFireStats::RecordMeasure(FLyraWeaponFireStats::GetWeaponKey(GetWeaponInstance()), FLyraWeaponFireStats::EMeasure::ApplyDamageTime, (FPlatformTime::Seconds() - StartTime) * 1.0e6);
+
+	return AppliedEffects;
+}
+
+TArray<FActiveGameplayEffectHandle> ULyraGameplayAbility_RangedWeapon::ApplyBatchedDamageEffectSpec(const FGameplayAbilityTargetDataHandle& TargetData, const FGameplayEffectSpec& DamageSpec)
+{
+	TArray<FActiveGameplayEffectHandle> AppliedEffects;
+
+	UAbilitySystemComponent* InstigatorAbilitySystem = DamageSpec.GetContext().GetInstigatorAbilitySystemComponent();
+	if ((InstigatorAbilitySystem == nullptr) || (DamageSpec.Def == nullptr))
+	{
+		return AppliedEffects;
+	}
+
+	TArray<LyraRangedWeapon::FTargetHits, TInlineAllocator<4>> HitsPerTarget;
+	LyraRangedWeapon::GroupHitsPerTarget(TargetData, /*out*/ HitsPerTarget);
+
+	// Send the cues of every target and hit out together
+	FScopedGameplayCueSendContext GameplayCueSendContext;
+
+	for (LyraRangedWeapon::FTargetHits& TargetHits : HitsPerTarget)
+	{
+		// Every target gets its own copy of the spec and context, filled in the same way applying the target data would
+		FGameplayEffectSpec SpecToApply(DamageSpec);
+		FGameplayEffectContextHandle EffectContext = SpecToApply.GetContext().Duplicate();
+		SpecToApply.SetContext(EffectContext);
+		TargetData.Get(TargetHits.FirstDataIndex)->AddTargetDataToContext(EffectContext, /*bIncludeActorArray=*/ true);
+
+		if (FLyraGameplayEffectContext* TypedContext = FLyraGameplayEffectContext::ExtractEffectContext(EffectContext))
+		{
+			TypedContext->BatchedHits.Reset();
+			if (TargetHits.Hits.Num() > 1)
+			{
+				TypedContext->BatchedHits = TargetHits.Hits;
+			}
+		}
+
+		AppliedEffects.Add(InstigatorAbilitySystem->ApplyGameplayEffectSpecToTarget(SpecToApply, TargetHits.TargetAbilitySystem));
+
+		// Applying the effect executed its cues at the first hit, the other hits get their own
+		for (int32 HitIndex = 1; HitIndex < TargetHits.Hits.Num(); ++HitIndex)
+		{
+			FGameplayEffectContextHandle HitContext = EffectContext.Duplicate();
+			if (FLyraGameplayEffectContext* TypedHitContext = FLyraGameplayEffectContext::ExtractEffectContext(HitContext))
+			{
+				TypedHitContext->BatchedHits.Reset();
+			}
+			HitContext.AddHitResult(TargetHits.Hits[HitIndex], /*bReset=*/ true);
+
+			for (const FGameplayEffectCue& Cue : DamageSpec.Def->GameplayCues)
+			{
+				for (const FGameplayTag& CueTag : Cue.GameplayCueTags)
+				{
+					TargetHits.TargetAbilitySystem->ExecuteGameplayCue(CueTag, HitContext);
+				}
+			}
+		}
+	}
+
+	return AppliedEffects;
 }
 
+void ULyraGameplayAbility_RangedWeapon::SpawnProjectilesFromTargetData(const FGameplayAbilityTargetDataHandle& TargetData, bool bAuthoritative)
+{
+	ULyraRangedWeaponInstance* WeaponData = GetWeaponInstance();
+	ULyraProjectileSubsystem* ProjectileSubsystem = UWorld::GetSubsystem<ULyraProjectileSubsystem>(GetWorld());
+	if (!WeaponData || !ProjectileSubsystem)
+	{
+		return;
+	}
+
+	AActor* Instigator = GetAvatarActorFromActorInfo();
+	const FGameplayEffectContextHandle EffectContext = bAuthoritative ? MakeEffectContext(CurrentSpecHandle, CurrentActorInfo) : FGameplayEffectContextHandle();
+
+	for (int32 DataIndex = 0; DataIndex < TargetData.Num(); ++DataIndex)
+	{
+		const FGameplayAbilityTargetData* Data = TargetData.Get(DataIndex);
+		if (!Data || !Data->GetScriptStruct()->IsChildOf(FLyraGameplayAbilityTargetData_SingleTargetHit::StaticStruct()))
+		{
+			continue;
+		}
+
+		const FLyraGameplayAbilityTargetData_SingleTargetHit* BulletData = static_cast<const FLyraGameplayAbilityTargetData_SingleTargetHit*>(Data);
+		const FHitResult& BulletPath = BulletData->HitResult;
+
+		const FVector Direction = (BulletPath.TraceEnd - BulletPath.TraceStart).GetSafeNormal();
+		if (Direction.IsZero())
+		{
+			continue;
+		}
+
+		// The cartridge and bullet index are the same on the shooter and the server, so both fly the same projectile
+		const int32 Seed = int32(HashCombine(GetTypeHash(BulletData->CartridgeID), GetTypeHash(DataIndex)));
+
+		FLyraProjectileSpawnParams Params;
+		WeaponData->GetProjectileSpawnParams(BulletPath.TraceStart, Direction, Seed, Instigator, /*out*/ Params);
+
+		if (bAuthoritative)
+		{
+			ProjectileSubsystem->SpawnAuthoritativeProjectile(Params, ProjectileDamageEffect, EffectContext, GetAbilityLevel());
+		}
+		else
+		{
+			ProjectileSubsystem->SpawnCosmeticProjectile(Params);
+		}
+	}
+}
+
+void ULyraGameplayAbility_RangedWeapon::MakeLocalCartridge(const ULyraRangedWeaponInstance& WeaponData, const FVector& StartTrace, const FVector& AimDir, float SpreadAngle, int32 Seed, int32 ShotIndex, OUT FRangedWeaponCartridge& OutCartridge)
+{
+	OutCartridge.StartTrace = StartTrace;
+	OutCartridge.AimDir = AimDir;
+	FLyraGameplayAbilityTargetData_Cartridge::QuantizeAim(/*inout*/ OutCartridge.StartTrace, /*inout*/ OutCartridge.AimDir);
+
+	OutCartridge.SpreadAngle = SpreadAngle;
+	OutCartridge.Seed = Seed;
+	OutCartridge.ShotIndex = ShotIndex;
+	OutCartridge.bIsValid = true;
+
+	ComputeBulletEndTraces(OutCartridge.StartTrace, OutCartridge.AimDir, SpreadAngle, WeaponData.GetSpreadExponent(), WeaponData.GetMaxDamageRange(), WeaponData.GetBulletsPerCartridge(), Seed, /*out*/ OutCartridge.EndTraces);
+}
+
+bool ULyraGameplayAbility_RangedWeapon::MakeCartridgeTargetData(const FRangedWeaponCartridge& FiredCartridge, const FGameplayAbilityTargetDataHandle& HitData, OUT FGameplayAbilityTargetDataHandle& OutCartridgeData)
+{
+	if (!FiredCartridge.bIsValid || (HitData.Num() > 255))
+	{
+		return false;
+	}
+
+	TUniquePtr<FLyraGameplayAbilityTargetData_Cartridge> Cartridge = MakeUnique<FLyraGameplayAbilityTargetData_Cartridge>();
+	Cartridge->Origin = FiredCartridge.StartTrace;
+	Cartridge->AimDir = FiredCartridge.AimDir;
+	Cartridge->SpreadAngle = FiredCartridge.SpreadAngle;
+	Cartridge->Seed = FiredCartridge.Seed;
+	Cartridge->ShotIndex = uint8(FiredCartridge.ShotIndex);
+	Cartridge->Hits.Reserve(HitData.Num());
+
+	for (int32 DataIndex = 0; DataIndex < HitData.Num(); ++DataIndex)
+	{
+		const FGameplayAbilityTargetData* Data = HitData.Get(DataIndex);
+		if (!Data || !Data->GetScriptStruct()->IsChildOf(FLyraGameplayAbilityTargetData_SingleTargetHit::StaticStruct()))
+		{
+			return false;
+		}
+
+		const FHitResult& Hit = static_cast<const FLyraGameplayAbilityTargetData_SingleTargetHit*>(Data)->HitResult;
+
+		// Every hit came from one of the cartridge's bullets, find which one by where it was aimed
+		const int32 BulletIndex = FiredCartridge.EndTraces.IndexOfByPredicate([&Hit](const FVector& EndTrace) { return EndTrace.Equals(Hit.TraceEnd, UE_KINDA_SMALL_NUMBER); });
+		if ((BulletIndex == INDEX_NONE) || (BulletIndex > 255))
+		{
+			return false;
+		}
+
+		FLyraCartridgeHitClaim& Claim = Cartridge->Hits.AddDefaulted_GetRef();
+		Claim.BulletIndex = uint8(BulletIndex);
+		Claim.bBlockingHit = Hit.bBlockingHit;
+		Claim.Actor = Hit.GetActor();
+		Claim.PhysMaterial = Hit.PhysMaterial;
+		Claim.ImpactPoint = Hit.ImpactPoint;
+		Claim.ImpactNormal = Hit.ImpactNormal;
+	}
+
+	OutCartridgeData.Clear();
+	OutCartridgeData.UniqueId = HitData.UniqueId;
+	OutCartridgeData.Add(Cartridge.Release());
+	return true;
+}
+
+void ULyraGameplayAbility_RangedWeapon::ComputeCartridgeEndTraces(const FLyraGameplayAbilityTargetData_Cartridge& Cartridge, const ULyraRangedWeaponInstance& WeaponData, OUT TArray<FVector>& OutEndTraces)
+{
+	// The spread depends on heat and movement the server only approximates, so the shooter's own angle is used as long as
+	// this weapon could have fired with it.  A client claiming a spread it cannot have gets the nearest one it can.
+	float MinSpreadAngle;
+	float MaxSpreadAngle;
+	WeaponData.GetSpreadAngleRange(/*out*/ MinSpreadAngle, /*out*/ MaxSpreadAngle);
+
+	const float SpreadAngle = FMath::Clamp(Cartridge.SpreadAngle, FMath::Min(MinSpreadAngle, 180.0f), FMath::Min(MaxSpreadAngle, 180.0f));
+	UE_CLOG(SpreadAngle != Cartridge.SpreadAngle, LogLyraAbilitySystem, Verbose, TEXT("Cartridge %d claims %.3f degrees of spread, outside of [%.3f, %.3f]"),
+		int32(Cartridge.ShotIndex), Cartridge.SpreadAngle, MinSpreadAngle, MaxSpreadAngle);
+
+	ComputeBulletEndTraces(Cartridge.Origin, Cartridge.AimDir, SpreadAngle, WeaponData.GetSpreadExponent(), WeaponData.GetMaxDamageRange(), WeaponData.GetBulletsPerCartridge(), Cartridge.Seed, /*out*/ OutEndTraces);
+}
+
+bool ULyraGameplayAbility_RangedWeapon::ExpandCartridgeTargetData(FGameplayAbilityTargetDataHandle& InOutData)
+{
+	const FGameplayAbilityTargetData* Data = (InOutData.Num() == 1) ? InOutData.Get(0) : nullptr;
+	if (!Data || !Data->GetScriptStruct()->IsChildOf(FLyraGameplayAbilityTargetData_Cartridge::StaticStruct()))
+	{
+		// Full hit results carry no seed, so the bullet directions cannot be checked and only lag compensation stands
+		// between them and the damage (the trust model from before cartridges).  Only accepted with cartridges turned off.
+		if (LyraConsoleVariables::bSendSeededCartridges)
+		{
+			UE_LOG(LogLyraAbilitySystem, Verbose, TEXT("Rejecting full hit results from %s, lyra.Weapon.SendSeededCartridges requires a cartridge"), *GetNameSafe(GetAvatarActorFromActorInfo()));
+			return false;
+		}
+
+		return true;
+	}
+
+	const FLyraGameplayAbilityTargetData_Cartridge& Cartridge = *static_cast<const FLyraGameplayAbilityTargetData_Cartridge*>(Data);
+
+	const ULyraRangedWeaponInstance* WeaponData = GetWeaponInstance();
+	if (!WeaponData)
+	{
+		return false;
+	}
+
+	// Only the low byte of the shot index is sent, the full index is the one closest to the next expected shot
+	const int32 ShotIndex = NextRemoteCartridgeIndex + int8(uint8(Cartridge.ShotIndex - uint8(NextRemoteCartridgeIndex)));
+
+	// The seed has to be the one this activation and shot produce, and each shot may only be used once,
+	// so a client can neither pick a favourable spread pattern nor replay one
+	const int32 ExpectedSeed = MakeCartridgeSeed(CurrentActivationInfo.GetActivationPredictionKey(), ShotIndex);
+	if ((ShotIndex < NextRemoteCartridgeIndex) || (Cartridge.Seed != ExpectedSeed))
+	{
+		UE_LOG(LogLyraAbilitySystem, Verbose, TEXT("Rejecting cartridge %d from %s, seed or shot index does not match the activation"), ShotIndex, *GetNameSafe(GetAvatarActorFromActorInfo()));
+		return false;
+	}
+	NextRemoteCartridgeIndex = ShotIndex + 1;
+
+	TArray<FVector> EndTraces;
+	ComputeCartridgeEndTraces(Cartridge, *WeaponData, /*out*/ EndTraces);
+
+	FGameplayAbilityTargetDataHandle ExpandedData;
+	ExpandedData.UniqueId = InOutData.UniqueId;
+
+	for (const FLyraCartridgeHitClaim& Claim : Cartridge.Hits)
+	{
+		if (!EndTraces.IsValidIndex(Claim.BulletIndex))
+		{
+			return false;
+		}
+
+		const FVector& EndTrace = EndTraces[Claim.BulletIndex];
+
+		FHitResult Hit(Cartridge.Origin, EndTrace);
+		Hit.bBlockingHit = Claim.bBlockingHit;
+		Hit.Location = Claim.ImpactPoint;
+		Hit.ImpactPoint = Claim.ImpactPoint;
+		Hit.Normal = Claim.ImpactNormal;
+		Hit.ImpactNormal = Claim.ImpactNormal;
+		Hit.Distance = FVector::Dist(Hit.TraceStart, Hit.ImpactPoint);
+		Hit.Time = Hit.Distance / FMath::Max(FVector::Dist(Hit.TraceStart, Hit.TraceEnd), UE_KINDA_SMALL_NUMBER);
+		Hit.HitObjectHandle = FActorInstanceHandle(Claim.Actor.Get());
+		Hit.PhysMaterial = Claim.PhysMaterial;
+
+		FLyraGameplayAbilityTargetData_SingleTargetHit* NewTargetData = new FLyraGameplayAbilityTargetData_SingleTargetHit();
+		NewTargetData->HitResult = Hit;
+		NewTargetData->CartridgeID = Cartridge.Seed;
+		ExpandedData.Add(NewTargetData);
+	}
+
+	InOutData = MoveTemp(ExpandedData);
+	return true;
+}
@@ -3,6 +3,7 @@
 #pragma once
 
 #include "Abilities/GameplayAbilityTargetTypes.h"
+#include "ActiveGameplayEffectHandle.h"
 #include "Containers/Array.h"
 #include "Delegates/IDelegateInstance.h"
 #include "Engine/EngineTypes.h"
@@ -17,14 +18,18 @@
 #include "LyraGameplayAbility_RangedWeapon.generated.h"
 
 class APawn;
+class UGameplayEffect;
 class ULyraRangedWeaponInstance;
 class UObject;
 struct FCollisionQueryParams;
 struct FFrame;
 struct FGameplayAbilityActorInfo;
+struct FGameplayEffectSpec;
 struct FGameplayEventData;
 struct FGameplayTag;
 struct FGameplayTagContainer;
+struct FLyraBulletTraceQueries;
+struct FLyraGameplayAbilityTargetData_Cartridge;
 
 /** Defines where an ability starts its trace from and where it should face */
 UENUM(BlueprintType)
@@ -69,6 +74,43 @@ public:
 	virtual void EndAbility(const FGameplayAbilitySpecHandle Handle, const FGameplayAbilityActorInfo* ActorInfo, const FGameplayAbilityActivationInfo ActivationInfo, bool bReplicateEndAbility, bool bWasCancelled) override;
 	//~End of UGameplayAbility interface
 
+	// A cartridge fired locally, everything the server needs to regenerate its bullets
+	struct FRangedWeaponCartridge
+	{
+		FVector StartTrace = FVector::ZeroVector;
+		FVector AimDir = FVector::ZeroVector;
+		float SpreadAngle = 0.0f;
+		int32 Seed = 0;
+		int32 ShotIndex = 0;
+		TArray<FVector> EndTraces;
+		bool bIsValid = false;
+	};
+
+	// Client: picks the bullets of a cartridge fired from StartTrace along AimDir.  The origin and aim are rounded the way
+	// FLyraGameplayAbilityTargetData_Cartridge sends them, so the server regenerates exactly these bullets.
+	static void MakeLocalCartridge(const ULyraRangedWeaponInstance& WeaponData, const FVector& StartTrace, const FVector& AimDir, float SpreadAngle, int32 Seed, int32 ShotIndex, OUT FRangedWeaponCartridge& OutCartridge);
+
+	// Packs the locally traced hits of FiredCartridge into a single FLyraGameplayAbilityTargetData_Cartridge
+	static bool MakeCartridgeTargetData(const FRangedWeaponCartridge& FiredCartridge, const FGameplayAbilityTargetDataHandle& HitData, OUT FGameplayAbilityTargetDataHandle& OutCartridgeData);
+
+	// Server: bullet end points of a received cartridge, expanded with its claimed spread clamped to the weapon's spread range
+	static void ComputeCartridgeEndTraces(const FLyraGameplayAbilityTargetData_Cartridge& Cartridge, const ULyraRangedWeaponInstance& WeaponData, OUT TArray<FVector>& OutEndTraces);
+
+	// Folds the hits of one shot on the same target into the first of them, which then carries all of them in its
+	// BatchedHits.  Effects applied through the target data afterwards (ApplyGameplayEffectToTarget and friends) are
+	// applied once per target, ULyraDamageExecution sums the damage over the batched hits.  Called on the target data
+	// of every shot before OnRangedWeaponTargetDataReady.
+	static void BatchHitsPerTarget(FGameplayAbilityTargetDataHandle& TargetData);
+
+	// Server only: applies DamageEffect once per target in TargetData like BatchHitsPerTarget, and still executes the
+	// effect's gameplay cues once for every hit.  Not needed for effects applied through the target data the
+	// blueprint receives, those are batched already.
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category="Lyra|Ability")
+	TArray<FActiveGameplayEffectHandle> ApplyBatchedDamageEffect(const FGameplayAbilityTargetDataHandle& TargetData, TSubclassOf<UGameplayEffect> DamageEffect, int32 GameplayEffectLevel = 1);
+
+	// ApplyBatchedDamageEffect with a spec already made, applied by the spec's instigator
+	static TArray<FActiveGameplayEffectHandle> ApplyBatchedDamageEffectSpec(const FGameplayAbilityTargetDataHandle& TargetData, const FGameplayEffectSpec& DamageSpec);
+
 protected:
 	struct FRangedWeaponFiringInput
 	{
@@ -87,6 +129,12 @@ protected:
 		// Can we play bullet FX for hits during this trace
 		bool bCanPlayBulletFX = false;
 
+		// Seed for the bullet spread, see MakeCartridgeSeed
+		int32 Seed = 0;
+
+		// Index of the cartridge within the ability activation
+		int32 ShotIndex = 0;
+
 		FRangedWeaponFiringInput()
 			: StartTrace(ForceInitToZero)
 			, EndAim(ForceInitToZero)
@@ -98,12 +146,37 @@ protected:
 protected:
 	static int32 FindFirstPawnHitResult(const TArray<FHitResult>& HitResults);
 
+	// Deterministic spread seed shared by the shooter and the server
+	static int32 MakeCartridgeSeed(const FPredictionKey& ActivationPredictionKey, int32 ShotIndex);
+
+	// Bullet end points for a cartridge, the same for the same inputs on every machine
+	static void ComputeBulletEndTraces(const FVector& StartTrace, const FVector& AimDir, float SpreadAngle, float SpreadExponent, float MaxRange, int32 NumBullets, int32 Seed, OUT TArray<FVector>& OutEndTraces);
+
+	// Server: expands a FLyraGameplayAbilityTargetData_Cartridge back into single target hits, returns false if the cartridge is not plausible
+	bool ExpandCartridgeTargetData(FGameplayAbilityTargetDataHandle& InOutData);
+
 	// Does a single weapon trace, either sweeping or ray depending on if SweepRadius is above zero
 	FHitResult WeaponTrace(const FVector& StartTrace, const FVector& EndTrace, float SweepRadius, bool bIsSimulated, OUT TArray<FHitResult>& OutHitResults) const;
 
+	// Same as above with the query params and channel already set up, safe to call from worker threads
+	FHitResult WeaponTrace(const FVector& StartTrace, const FVector& EndTrace, float SweepRadius, const FCollisionQueryParams& TraceParams, ECollisionChannel TraceChannel, OUT TArray<FHitResult>& OutHitResults) const;
+
 	// Wrapper around WeaponTrace to handle trying to do a ray trace before falling back to a sweep trace if there were no hits and SweepRadius is above zero 
 	FHitResult DoSingleBulletTrace(const FVector& StartTrace, const FVector& EndTrace, float SweepRadius, bool bIsSimulated, OUT TArray<FHitResult>& OutHits) const;
 
+	// Same as above with the query params and channel already set up (no debug drawing)
+	FHitResult DoSingleBulletTrace(const FVector& StartTrace, const FVector& EndTrace, float SweepRadius, const FCollisionQueryParams& TraceParams, ECollisionChannel TraceChannel, OUT TArray<FHitResult>& OutHits, struct FLyraWeaponTraceCounts* OutTraceCounts = nullptr) const;
+
+	// The scene queries of DoSingleBulletTrace, safe to call from worker threads.  Never resolves hit actors, so the sweep
+	// is also run whenever the line hits do not obviously contain a pawn.
+	void RunBulletTraceQueries(const FVector& StartTrace, const FVector& EndTrace, float SweepRadius, const FCollisionQueryParams& TraceParams, ECollisionChannel TraceChannel, OUT FLyraBulletTraceQueries& OutQueries) const;
+
+	// Game thread half of DoSingleBulletTrace: picks the first pawn hit of the queries and merges the line and sweep hits
+	static FHitResult ResolveBulletTraceQueries(FLyraBulletTraceQueries& Queries, OUT TArray<FHitResult>& OutHits, struct FLyraWeaponTraceCounts& InOutTraceCounts);
+
+	// Sets up the query params and channel used by every weapon trace of this ability
+	ECollisionChannel MakeWeaponTraceParams(bool bIsSimulated, OUT FCollisionQueryParams& OutTraceParams) const;
+
 	// Traces all of the bullets in a single cartridge
 	void TraceBulletsInCartridge(const FRangedWeaponFiringInput& InputData, OUT TArray<FHitResult>& OutHits);
 
@@ -119,6 +192,9 @@ protected:
 
 	void OnTargetDataReadyCallback(const FGameplayAbilityTargetDataHandle& InData, FGameplayTag ApplicationTag);
 
+	// Launches one projectile per bullet in the target data, authoritative ones apply ProjectileDamageEffect on impact
+	void SpawnProjectilesFromTargetData(const FGameplayAbilityTargetDataHandle& TargetData, bool bAuthoritative);
+
 	UFUNCTION(BlueprintCallable)
 	void StartRangedWeaponTargeting();
 
@@ -126,6 +202,21 @@ protected:
 	UFUNCTION(BlueprintImplementableEvent)
 	void OnRangedWeaponTargetDataReady(const FGameplayAbilityTargetDataHandle& TargetData);
 
+	// Damage effect applied by projectiles when the weapon is a projectile weapon (hitscan weapons apply their effects in OnRangedWeaponTargetDataReady)
+	UPROPERTY(EditDefaultsOnly, Category="Lyra|Projectile")
+	TSubclassOf<UGameplayEffect> ProjectileDamageEffect;
+
 private:
+	// Traces the same cartridges serially and in parallel
+	friend class FLyraParallelBulletTraceTest;
+
 	FDelegateHandle OnTargetDataReadyCallbackDelegateHandle;
+
+	FRangedWeaponCartridge LastCartridge;
+
+	// Cartridges fired locally during this activation
+	int32 NextCartridgeIndex = 0;
+
+	// Server: lowest shot index still accepted from the remote shooter during this activation (only its low byte is sent)
+	int32 NextRemoteCartridgeIndex = 0;
 };
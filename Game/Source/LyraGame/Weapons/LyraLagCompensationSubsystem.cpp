@@ -0,0 +1,615 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "LyraLagCompensationSubsystem.h"
+
+#include "Abilities/GameplayAbilityTargetTypes.h"
+#include "CollisionQueryParams.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/PlayerState.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "LyraLogChannels.h"
+#include "Math/Box2D.h"
+#include "Math/VectorRegister.h"
+#include "Physics/LyraCollisionChannels.h"
+#include "Stats/Stats2.h"
+#include "System/LyraVectorLanes.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(LyraLagCompensationSubsystem)
+
+DECLARE_STATS_GROUP(TEXT("LyraLagCompensation"), STATGROUP_LyraLagCompensation, STATCAT_Advanced);
+DECLARE_CYCLE_STAT(TEXT("Record Hitboxes"), STAT_LyraLagCompensation_Record, STATGROUP_LyraLagCompensation);
+DECLARE_CYCLE_STAT(TEXT("Validate Shot"), STAT_LyraLagCompensation_Validate, STATGROUP_LyraLagCompensation);
+DECLARE_CYCLE_STAT(TEXT("Broad Phase"), STAT_LyraLagCompensation_BroadPhase, STATGROUP_LyraLagCompensation);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Rewound Candidates"), STAT_LyraLagCompensation_Candidates, STATGROUP_LyraLagCompensation);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Hits Replaced"), STAT_LyraLagCompensation_HitsReplaced, STATGROUP_LyraLagCompensation);
+DECLARE_DWORD_COUNTER_STAT(TEXT("World Traces"), STAT_LyraLagCompensation_WorldTraces, STATGROUP_LyraLagCompensation);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Shots Over Budget"), STAT_LyraLagCompensation_OverBudget, STATGROUP_LyraLagCompensation);
+
+namespace LyraConsoleVariables
+{
+	static bool bEnableLagCompensation = true;
+	static FAutoConsoleVariableRef CVarEnableLagCompensation(
+		TEXT("lyra.Weapon.LagCompensation.Enable"),
+		bEnableLagCompensation,
+		TEXT("Should the server validate client weapon hits against rewound hitboxes (otherwise every client hit is accepted)"),
+		ECVF_Default);
+
+	static float MaxRewindTime = 0.3f;
+	static FAutoConsoleVariableRef CVarMaxRewindTime(
+		TEXT("lyra.Weapon.LagCompensation.MaxRewindTime"),
+		MaxRewindTime,
+		TEXT("Furthest back in time (in seconds) the server will rewind hitboxes for a shot, regardless of the shooter's ping"),
+		ECVF_Default);
+
+	static float HitTolerance = 15.0f;
+	static FAutoConsoleVariableRef CVarHitTolerance(
+		TEXT("lyra.Weapon.LagCompensation.HitTolerance"),
+		HitTolerance,
+		TEXT("How far (in uu) a claimed hit may miss the rewound hitbox and still be accepted, covers limbs outside the capsule and interpolation error"),
+		ECVF_Default);
+
+	static float MaxTraceStartError = 250.0f;
+	static FAutoConsoleVariableRef CVarMaxTraceStartError(
+		TEXT("lyra.Weapon.LagCompensation.MaxTraceStartError"),
+		MaxTraceStartError,
+		TEXT("How far (in uu) from the shooter a claimed trace may start before the whole shot is rejected"),
+		ECVF_Default);
+
+	static float ValidationBudgetMicroseconds = 50.0f;
+	static FAutoConsoleVariableRef CVarValidationBudgetMicroseconds(
+		TEXT("lyra.Weapon.LagCompensation.BudgetMicroseconds"),
+		ValidationBudgetMicroseconds,
+		TEXT("Target cost of rewinding and validating a single shot.  Only measured, every hit is validated regardless: shots above it are counted in the LyraLagCompensation stats and logged"),
+		ECVF_Default);
+}
+
+namespace LyraLagCompensation
+{
+	// Enough for MaxRewindTime at server tick rates up to 200Hz.
+	static constexpr int32 HistoryCapacity = 64;
+
+	// Turns a claimed hit into a miss along the same trace.
+	static void ReplaceWithMiss(FGameplayAbilityTargetData_SingleTargetHit& SingleTargetHit)
+	{
+		const FVector TraceStart = SingleTargetHit.HitResult.TraceStart;
+		const FVector TraceEnd = SingleTargetHit.HitResult.TraceEnd;
+		SingleTargetHit.HitResult = FHitResult(TraceStart, TraceEnd);
+		SingleTargetHit.HitResult.Location = TraceEnd;
+		SingleTargetHit.HitResult.ImpactPoint = TraceEnd;
+
+		SingleTargetHit.bHitReplaced = true;
+		INC_DWORD_STAT(STAT_LyraLagCompensation_HitsReplaced);
+	}
+
+	static bool SegmentHitsCapsule(const FVector& Start, const FVector& End, const FLyraHitboxFrame& Frame, float Inflate, double& OutDistanceAlongSegment)
+	{
+		const float SegmentHalfLength = FMath::Max(Frame.CapsuleHalfHeight - Frame.CapsuleRadius, 0.0f);
+		const FVector CapsuleTop = Frame.Location + FVector(0.0, 0.0, SegmentHalfLength);
+		const FVector CapsuleBottom = Frame.Location - FVector(0.0, 0.0, SegmentHalfLength);
+
+		FVector PointOnSegment;
+		FVector PointOnCapsule;
+		FMath::SegmentDistToSegmentSafe(Start, End, CapsuleBottom, CapsuleTop, PointOnSegment, PointOnCapsule);
+
+		const double Radius = Frame.CapsuleRadius + Inflate;
+		if (FVector::DistSquared(PointOnSegment, PointOnCapsule) > (Radius * Radius))
+		{
+			return false;
+		}
+
+		OutDistanceAlongSegment = FVector::Dist(Start, PointOnSegment);
+		return true;
+	}
+};
+
+//////////////////////////////////////////////////////////////////////
+// FLyraHitboxHistory
+
+void FLyraHitboxHistory::Record(const FLyraHitboxFrame& Frame)
+{
+	if (Frames.Num() == 0)
+	{
+		Frames.SetNum(LyraLagCompensation::HistoryCapacity);
+	}
+
+	Head = (Head + 1) % Frames.Num();
+	Frames[Head] = Frame;
+	NumFrames = FMath::Min(NumFrames + 1, Frames.Num());
+}
+
+bool FLyraHitboxHistory::GetFrameAtTime(double Time, FLyraHitboxFrame& OutFrame) const
+{
+	if (NumFrames == 0)
+	{
+		return false;
+	}
+
+	// Walk back from the newest frame, the rewind window is only a handful of frames deep.
+	const FLyraHitboxFrame* Newer = &GetFrame(0);
+	if (Time >= Newer->Time)
+	{
+		OutFrame = *Newer;
+		return true;
+	}
+
+	for (int32 Age = 1; Age < NumFrames; ++Age)
+	{
+		const FLyraHitboxFrame& Older = GetFrame(Age);
+		if (Older.Time <= Time)
+		{
+			const double Span = Newer->Time - Older.Time;
+			const double Alpha = (Span > 0.0) ? ((Time - Older.Time) / Span) : 0.0;
+
+			OutFrame.Time = Time;
+			OutFrame.Location = FMath::Lerp(Older.Location, Newer->Location, Alpha);
+			OutFrame.CapsuleRadius = FMath::Lerp(Older.CapsuleRadius, Newer->CapsuleRadius, float(Alpha));
+			OutFrame.CapsuleHalfHeight = FMath::Lerp(Older.CapsuleHalfHeight, Newer->CapsuleHalfHeight, float(Alpha));
+			return true;
+		}
+
+		Newer = &Older;
+	}
+
+	// Older than anything recorded.
+	OutFrame = *Newer;
+	return true;
+}
+
+FLyraHitboxWindowCapsule FLyraHitboxHistory::GetWindowCapsule(double OldestTime) const
+{
+	FLyraHitboxWindowCapsule Capsule;
+
+	// Frames from the newest back to the first one older than the window, which is still needed to interpolate up to OldestTime
+	int32 NumWindowFrames = 0;
+	while (NumWindowFrames < NumFrames)
+	{
+		if (GetFrame(NumWindowFrames++).Time < OldestTime)
+		{
+			break;
+		}
+	}
+
+	if (NumWindowFrames == 0)
+	{
+		return Capsule;
+	}
+
+	// The axis stands in the middle of where the character went and spans every hitbox's own axis
+	FBox2D Footprint(ForceInit);
+	Capsule.BottomZ = UE_BIG_NUMBER;
+	Capsule.TopZ = -UE_BIG_NUMBER;
+	for (int32 Age = 0; Age < NumWindowFrames; ++Age)
+	{
+		const FLyraHitboxFrame& Frame = GetFrame(Age);
+		const double SegmentHalfLength = FMath::Max(Frame.CapsuleHalfHeight - Frame.CapsuleRadius, 0.0f);
+
+		Footprint += FVector2D(Frame.Location);
+		Capsule.BottomZ = FMath::Min(Capsule.BottomZ, Frame.Location.Z - SegmentHalfLength);
+		Capsule.TopZ = FMath::Max(Capsule.TopZ, Frame.Location.Z + SegmentHalfLength);
+	}
+	Capsule.Center = Footprint.GetCenter();
+
+	// A point within a hitbox's radius of its axis is within that radius plus the horizontal offset of the axis
+	// from the window axis, at the same height
+	for (int32 Age = 0; Age < NumWindowFrames; ++Age)
+	{
+		const FLyraHitboxFrame& Frame = GetFrame(Age);
+		Capsule.Radius = FMath::Max(Capsule.Radius, FVector2D::Distance(FVector2D(Frame.Location), Capsule.Center) + Frame.CapsuleRadius);
+	}
+
+	Capsule.bIsValid = true;
+	return Capsule;
+}
+
+//////////////////////////////////////////////////////////////////////
+// FLyraHitboxWindowCapsule
+
+bool FLyraHitboxWindowCapsule::IntersectsSegment(const FVector& Start, const FVector& End, float Inflate) const
+{
+	if (!bIsValid)
+	{
+		return false;
+	}
+
+	FVector PointOnSegment;
+	FVector PointOnAxis;
+	FMath::SegmentDistToSegmentSafe(Start, End, FVector(Center, BottomZ), FVector(Center, TopZ), PointOnSegment, PointOnAxis);
+
+	const double GrownRadius = Radius + Inflate;
+	return FVector::DistSquared(PointOnSegment, PointOnAxis) <= (GrownRadius * GrownRadius);
+}
+
+//////////////////////////////////////////////////////////////////////
+// FLyraHitboxCapsuleBatch
+
+void FLyraHitboxCapsuleBatch::Reset(int32 ExpectedNum)
+{
+	NumLanes = 0;
+
+	const int32 PaddedNum = LyraVectorLanes::GetPaddedNum(ExpectedNum);
+	for (TArray<double>* Array : { &CenterX, &CenterY, &BottomZ, &Height, &Radius })
+	{
+		Array->Reset(PaddedNum);
+	}
+}
+
+int32 FLyraHitboxCapsuleBatch::Add(const FLyraHitboxWindowCapsule& Capsule)
+{
+	const int32 Lane = NumLanes++;
+
+	// The unused lanes of the last register, and characters with nothing recorded yet, are a point at the far
+	// corner of the world.  No segment inside the world gets near it, so they never pass the distance test.
+	LyraVectorLanes::AddLane(CenterX, Lane, UE_BIG_NUMBER);
+	LyraVectorLanes::AddLane(CenterY, Lane, UE_BIG_NUMBER);
+	LyraVectorLanes::AddLane(BottomZ, Lane, UE_BIG_NUMBER);
+	LyraVectorLanes::AddLane(Height, Lane, 0.0);
+	LyraVectorLanes::AddLane(Radius, Lane, 0.0);
+
+	if (Capsule.bIsValid)
+	{
+		CenterX[Lane] = Capsule.Center.X;
+		CenterY[Lane] = Capsule.Center.Y;
+		BottomZ[Lane] = Capsule.BottomZ;
+		Height[Lane] = Capsule.TopZ - Capsule.BottomZ;
+		Radius[Lane] = Capsule.Radius;
+	}
+
+	return Lane;
+}
+
+void FLyraHitboxCapsuleBatch::GatherSegment(const FVector& Start, const FVector& End, float Inflate, TArray<int32>& OutLanes) const
+{
+	// Closest points between the segment Start + S * Direction and each axis Bottom + T * (0, 0, Height), S and T in
+	// [0, 1], following Ericson's segment to segment test (Real-Time Collision Detection, 5.1.9).  Every lane takes
+	// every branch and keeps the one that applies, so the test runs four capsules per register without branching.
+	const FVector Direction = End - Start;
+	const double DirectionSizeSquared = FMath::Max(Direction.SizeSquared(), UE_DOUBLE_SMALL_NUMBER);
+
+	const VectorRegister4Double StartX = VectorSetFloat1(Start.X);
+	const VectorRegister4Double StartY = VectorSetFloat1(Start.Y);
+	const VectorRegister4Double StartZ = VectorSetFloat1(Start.Z);
+	const VectorRegister4Double DirX = VectorSetFloat1(Direction.X);
+	const VectorRegister4Double DirY = VectorSetFloat1(Direction.Y);
+	const VectorRegister4Double DirZ = VectorSetFloat1(Direction.Z);
+	const VectorRegister4Double DirSizeSquared = VectorSetFloat1(DirectionSizeSquared);
+	const VectorRegister4Double InflateV = VectorSetFloat1(double(Inflate));
+	const VectorRegister4Double SmallNumber = VectorSetFloat1(UE_DOUBLE_SMALL_NUMBER);
+	const VectorRegister4Double Zero = VectorZeroDouble();
+	const VectorRegister4Double One = VectorSetFloat1(1.0);
+
+	auto Clamp01 = [&Zero, &One](const VectorRegister4Double& Value)
+	{
+		return VectorMin(VectorMax(Value, Zero), One);
+	};
+
+	for (int32 FirstLane = 0; FirstLane < NumLanes; FirstLane += LyraVectorLanes::DoublesPerRegister)
+	{
+		const VectorRegister4Double H = VectorLoad(&Height[FirstLane]);
+
+		// Start relative to the bottom of each axis
+		const VectorRegister4Double RX = VectorSubtract(StartX, VectorLoad(&CenterX[FirstLane]));
+		const VectorRegister4Double RY = VectorSubtract(StartY, VectorLoad(&CenterY[FirstLane]));
+		const VectorRegister4Double RZ = VectorSubtract(StartZ, VectorLoad(&BottomZ[FirstLane]));
+
+		const VectorRegister4Double E = VectorMultiply(H, H);
+		const VectorRegister4Double B = VectorMultiply(DirZ, H);
+		const VectorRegister4Double C = VectorAdd(VectorAdd(VectorMultiply(DirX, RX), VectorMultiply(DirY, RY)), VectorMultiply(DirZ, RZ));
+		const VectorRegister4Double F = VectorMultiply(H, RZ);
+
+		// Closest point on the segment to the axis' line, S = 0 when they are parallel
+		const VectorRegister4Double Denom = VectorSubtract(VectorMultiply(DirSizeSquared, E), VectorMultiply(B, B));
+		const VectorRegister4Double SOnLine = Clamp01(VectorDivide(VectorSubtract(VectorMultiply(B, F), VectorMultiply(C, E)), VectorMax(Denom, SmallNumber)));
+		const VectorRegister4Double S0 = VectorSelect(VectorCompareGT(Denom, Zero), SOnLine, Zero);
+
+		// Matching point on the axis.  Off either end it is clamped and the segment point recomputed for that end.
+		// A zero height axis (a sphere) lands on the bottom end and gets the closest segment point to it.
+		const VectorRegister4Double TRaw = VectorDivide(VectorAdd(VectorMultiply(B, S0), F), VectorMax(E, SmallNumber));
+		const VectorRegister4Double SAtBottom = Clamp01(VectorDivide(VectorNegate(C), DirSizeSquared));
+		const VectorRegister4Double SAtTop = Clamp01(VectorDivide(VectorSubtract(B, C), DirSizeSquared));
+
+		const VectorRegister4Double BelowBottom = VectorCompareLE(TRaw, Zero);
+		const VectorRegister4Double AboveTop = VectorCompareGE(TRaw, One);
+		const VectorRegister4Double T = VectorSelect(BelowBottom, Zero, VectorSelect(AboveTop, One, TRaw));
+		const VectorRegister4Double S = VectorSelect(BelowBottom, SAtBottom, VectorSelect(AboveTop, SAtTop, S0));
+
+		// Squared distance between the two closest points
+		const VectorRegister4Double DX = VectorAdd(RX, VectorMultiply(S, DirX));
+		const VectorRegister4Double DY = VectorAdd(RY, VectorMultiply(S, DirY));
+		const VectorRegister4Double DZ = VectorSubtract(VectorAdd(RZ, VectorMultiply(S, DirZ)), VectorMultiply(T, H));
+		const VectorRegister4Double DistanceSquared = VectorAdd(VectorAdd(VectorMultiply(DX, DX), VectorMultiply(DY, DY)), VectorMultiply(DZ, DZ));
+
+		const VectorRegister4Double GrownRadius = VectorAdd(VectorLoad(&Radius[FirstLane]), InflateV);
+
+		int32 HitMask = VectorMaskBits(VectorCompareLE(DistanceSquared, VectorMultiply(GrownRadius, GrownRadius)));
+		while (HitMask != 0)
+		{
+			const int32 Lane = FirstLane + FMath::CountTrailingZeros(uint32(HitMask));
+			if (Lane < NumLanes)
+			{
+				OutLanes.Add(Lane);
+			}
+			HitMask &= HitMask - 1;
+		}
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+// ULyraLagCompensationSubsystem
+
+void ULyraLagCompensationSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	UWorld* World = GetWorld();
+	if (!World || (World->GetNetMode() == NM_Client))
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_LyraLagCompensation_Record);
+
+	const double Now = World->GetTimeSeconds();
+
+	for (int32 Index = Histories.Num() - 1; Index >= 0; --Index)
+	{
+		FLyraHitboxHistory& History = Histories[Index];
+
+		const ACharacter* Character = History.Character.Get();
+		if (!Character)
+		{
+			Histories.RemoveAtSwap(Index);
+			continue;
+		}
+
+		const UCapsuleComponent* Capsule = Character->GetCapsuleComponent();
+
+		FLyraHitboxFrame Frame;
+		Frame.Time = Now;
+		Frame.Location = Capsule->GetComponentLocation();
+		Frame.CapsuleRadius = Capsule->GetScaledCapsuleRadius();
+		Frame.CapsuleHalfHeight = Capsule->GetScaledCapsuleHalfHeight();
+		History.Record(Frame);
+	}
+
+	RebuildWindowCapsules();
+}
+
+TStatId ULyraLagCompensationSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(ULyraLagCompensationSubsystem, STATGROUP_Tickables);
+}
+
+void ULyraLagCompensationSubsystem::RegisterCharacter(ACharacter* Character)
+{
+	if (Character && (FindHistoryIndex(Character) == INDEX_NONE))
+	{
+		FLyraHitboxHistory& History = Histories.AddDefaulted_GetRef();
+		History.Character = Character;
+		RebuildWindowCapsules();
+	}
+}
+
+void ULyraLagCompensationSubsystem::UnregisterCharacter(ACharacter* Character)
+{
+	const int32 Index = FindHistoryIndex(Character);
+	if (Index != INDEX_NONE)
+	{
+		Histories.RemoveAtSwap(Index);
+		RebuildWindowCapsules();
+	}
+}
+
+void ULyraLagCompensationSubsystem::RebuildWindowCapsules()
+{
+	const UWorld* World = GetWorld();
+	const double OldestTime = World ? (World->GetTimeSeconds() - LyraConsoleVariables::MaxRewindTime) : -UE_BIG_NUMBER;
+
+	WindowCapsules.Reset(Histories.Num());
+	for (const FLyraHitboxHistory& History : Histories)
+	{
+		WindowCapsules.Add(History.GetWindowCapsule(OldestTime));
+	}
+}
+
+int32 ULyraLagCompensationSubsystem::FindHistoryIndex(const AActor* Actor) const
+{
+	if (Actor)
+	{
+		for (int32 Index = 0; Index < Histories.Num(); ++Index)
+		{
+			if (Histories[Index].Character.Get() == Actor)
+			{
+				return Index;
+			}
+		}
+	}
+
+	return INDEX_NONE;
+}
+
+double ULyraLagCompensationSubsystem::GetRewindTime(const APawn* Shooter) const
+{
+	const double Now = GetWorld()->GetTimeSeconds();
+
+	// The client saw the world one way trip late and the shot took another one way trip to get here.
+	const APlayerState* PlayerState = Shooter ? Shooter->GetPlayerState() : nullptr;
+	const double Latency = PlayerState ? (PlayerState->GetPingInMilliseconds() * 0.001) : 0.0;
+
+	return Now - FMath::Clamp(Latency, 0.0, double(LyraConsoleVariables::MaxRewindTime));
+}
+
+void ULyraLagCompensationSubsystem::GatherCandidates(const FVector& Start, const FVector& End, float Inflate, const ACharacter* IgnoreCharacter, TArray<int32>& OutCandidates) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_LyraLagCompensation_BroadPhase);
+
+	OutCandidates.Reset();
+	check(WindowCapsules.Num() == Histories.Num());
+
+	WindowCapsules.GatherSegment(Start, End, Inflate, OutCandidates);
+
+	// Lanes come out in ascending order, keep it that way so the narrow phase resolves ties the same way every time.
+	OutCandidates.RemoveAll([this, IgnoreCharacter](int32 Index)
+		{
+			return (Histories[Index].NumFrames == 0) || (Histories[Index].Character.Get() == IgnoreCharacter);
+		});
+}
+
+int32 ULyraLagCompensationSubsystem::FindFirstRewoundHit(const FVector& Start, const FVector& End, float Inflate, double RewindTime, TArrayView<const int32> Candidates, double& OutHitDistance) const
+{
+	int32 FirstHit = INDEX_NONE;
+	double FirstHitDistance = TNumericLimits<double>::Max();
+
+	for (const int32 Index : Candidates)
+	{
+		FLyraHitboxFrame Frame;
+		double HitDistance = 0.0;
+		if (Histories[Index].GetFrameAtTime(RewindTime, Frame) && LyraLagCompensation::SegmentHitsCapsule(Start, End, Frame, Inflate, HitDistance))
+		{
+			if (HitDistance < FirstHitDistance)
+			{
+				FirstHit = Index;
+				FirstHitDistance = HitDistance;
+			}
+		}
+	}
+
+	OutHitDistance = FirstHitDistance;
+	return FirstHit;
+}
+
+void ULyraLagCompensationSubsystem::MakeWorldTraceParams(const APawn* Shooter, FCollisionQueryParams& OutTraceParams) const
+{
+	OutTraceParams = FCollisionQueryParams(SCENE_QUERY_STAT(LyraLagCompensationWorldTrace), /*bTraceComplex=*/ true, /*IgnoreActor=*/ Shooter);
+
+	TArray<AActor*> AttachedActors;
+	if (Shooter)
+	{
+		Shooter->GetAttachedActors(/*out*/ AttachedActors);
+		OutTraceParams.AddIgnoredActors(AttachedActors);
+	}
+
+	for (const FLyraHitboxHistory& History : Histories)
+	{
+		if (ACharacter* Character = History.Character.Get())
+		{
+			OutTraceParams.AddIgnoredActor(Character);
+
+			Character->GetAttachedActors(/*out*/ AttachedActors);
+			OutTraceParams.AddIgnoredActors(AttachedActors);
+		}
+	}
+}
+
+bool ULyraLagCompensationSubsystem::TraceWorld(const FVector& Start, const FVector& End, const FCollisionQueryParams& TraceParams, FHitResult& OutHit) const
+{
+	INC_DWORD_STAT(STAT_LyraLagCompensation_WorldTraces);
+
+	return GetWorld()->LineTraceSingleByChannel(OutHit, Start, End, Lyra_TraceChannel_Weapon, TraceParams);
+}
+
+bool ULyraLagCompensationSubsystem::ValidateTargetData(const APawn* Shooter, FGameplayAbilityTargetDataHandle& TargetData, float SweepRadius)
+{
+	if (!LyraConsoleVariables::bEnableLagCompensation || !Shooter)
+	{
+		return true;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_LyraLagCompensation_Validate);
+	const double StartSeconds = FPlatformTime::Seconds();
+
+	const double RewindTime = GetRewindTime(Shooter);
+	const float Inflate = SweepRadius + LyraConsoleVariables::HitTolerance;
+	const FVector ShooterLocation = Shooter->GetActorLocation();
+	const ACharacter* ShooterCharacter = Cast<ACharacter>(Shooter);
+
+	FCollisionQueryParams WorldTraceParams;
+	MakeWorldTraceParams(Shooter, /*out*/ WorldTraceParams);
+
+	bool bIsValid = true;
+	TArray<int32> Candidates;
+
+	for (int32 DataIndex = 0; DataIndex < TargetData.Num(); ++DataIndex)
+	{
+		FGameplayAbilityTargetData* Data = TargetData.Get(DataIndex);
+		if (!Data || !Data->GetScriptStruct()->IsChildOf(FGameplayAbilityTargetData_SingleTargetHit::StaticStruct()))
+		{
+			continue;
+		}
+
+		FGameplayAbilityTargetData_SingleTargetHit* SingleTargetHit = static_cast<FGameplayAbilityTargetData_SingleTargetHit*>(Data);
+		FHitResult& Hit = SingleTargetHit->HitResult;
+
+		if (FVector::DistSquared(Hit.TraceStart, ShooterLocation) > FMath::Square(LyraConsoleVariables::MaxTraceStartError))
+		{
+			UE_LOG(LogLyraAbilitySystem, Verbose, TEXT("Rejecting shot from %s, trace starts %.0f uu away from the shooter"), *GetNameSafe(Shooter), FVector::Dist(Hit.TraceStart, ShooterLocation));
+			bIsValid = false;
+			break;
+		}
+
+		// Hits on things attached to a character count as hits on that character.
+		const AActor* HitActor = Hit.GetActor();
+		int32 ClaimedIndex = FindHistoryIndex(HitActor);
+		if ((ClaimedIndex == INDEX_NONE) && HitActor)
+		{
+			ClaimedIndex = FindHistoryIndex(HitActor->GetAttachParentActor());
+		}
+
+		const FVector TraceDir = (Hit.TraceEnd - Hit.TraceStart).GetSafeNormal();
+		FHitResult WorldHit;
+
+		// The world is not lag compensated, a world hit has to be where the server's own trace stops.
+		if (ClaimedIndex == INDEX_NONE)
+		{
+			if (!Hit.bBlockingHit)
+			{
+				continue;
+			}
+
+			const double ClaimedDistance = FVector::Dist(Hit.TraceStart, Hit.Location);
+			const bool bOnTrace = FMath::PointDistToSegment(Hit.Location, Hit.TraceStart, Hit.TraceEnd) <= Inflate;
+			const bool bWorldHit = bOnTrace && TraceWorld(Hit.TraceStart, Hit.TraceStart + TraceDir * (ClaimedDistance + Inflate), WorldTraceParams, WorldHit);
+			if (!bWorldHit || (FMath::Abs(double(WorldHit.Distance) - ClaimedDistance) > Inflate))
+			{
+				UE_LOG(LogLyraAbilitySystem, Verbose, TEXT("Replacing world hit on %s from %s, server trace hit %s"), *GetNameSafe(HitActor), *GetNameSafe(Shooter),
+					bWorldHit ? *GetNameSafe(WorldHit.GetActor()) : TEXT("nothing"));
+				LyraLagCompensation::ReplaceWithMiss(*SingleTargetHit);
+			}
+			continue;
+		}
+
+		GatherCandidates(Hit.TraceStart, Hit.TraceEnd, Inflate, ShooterCharacter, Candidates);
+		INC_DWORD_STAT_BY(STAT_LyraLagCompensation_Candidates, Candidates.Num());
+
+		double FirstHitDistance = 0.0;
+		const int32 FirstHitIndex = FindFirstRewoundHit(Hit.TraceStart, Hit.TraceEnd, Inflate, RewindTime, Candidates, FirstHitDistance);
+		if (FirstHitIndex != ClaimedIndex)
+		{
+			// Not there at the time, or someone else was in the way: the bullet misses.
+			UE_LOG(LogLyraAbilitySystem, Verbose, TEXT("Replacing hit on %s from %s, rewound trace hit %s"), *GetNameSafe(HitActor), *GetNameSafe(Shooter),
+				Histories.IsValidIndex(FirstHitIndex) ? *GetNameSafe(Histories[FirstHitIndex].Character.Get()) : TEXT("nothing"));
+			LyraLagCompensation::ReplaceWithMiss(*SingleTargetHit);
+			continue;
+		}
+
+		// Nothing in the world may stand between the shooter and the rewound hitbox.  Stop short of the hitbox so
+		// geometry the character was touching does not count.
+		const double OcclusionDistance = FMath::Max(FirstHitDistance - Inflate, 0.0);
+		if ((OcclusionDistance > 0.0) && TraceWorld(Hit.TraceStart, Hit.TraceStart + TraceDir * OcclusionDistance, WorldTraceParams, WorldHit))
+		{
+			UE_LOG(LogLyraAbilitySystem, Verbose, TEXT("Replacing hit on %s from %s, %s is in the way"), *GetNameSafe(HitActor), *GetNameSafe(Shooter), *GetNameSafe(WorldHit.GetActor()));
+			LyraLagCompensation::ReplaceWithMiss(*SingleTargetHit);
+		}
+	}
+
+	const double ElapsedMicroseconds = (FPlatformTime::Seconds() - StartSeconds) * 1e6;
+	if (ElapsedMicroseconds > LyraConsoleVariables::ValidationBudgetMicroseconds)
+	{
+		INC_DWORD_STAT(STAT_LyraLagCompensation_OverBudget);
+		UE_LOG(LogLyraAbilitySystem, Verbose, TEXT("Shot validation took %.1f us (budget %.1f us) with %d tracked characters"), ElapsedMicroseconds, LyraConsoleVariables::ValidationBudgetMicroseconds, Histories.Num());
+	}
+
+	return bIsValid;
+}
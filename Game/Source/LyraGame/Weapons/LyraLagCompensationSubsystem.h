@@ -0,0 +1,152 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "Containers/Array.h"
+#include "Containers/ArrayView.h"
+#include "Math/Vector.h"
+#include "Math/Vector2D.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/WeakObjectPtr.h"
+
+#include "LyraLagCompensationSubsystem.generated.h"
+
+class AActor;
+class ACharacter;
+class APawn;
+class UObject;
+struct FCollisionQueryParams;
+struct FGameplayAbilityTargetDataHandle;
+struct FHitResult;
+
+/** One recorded hitbox state of a character, the capsule is used as the character's hitbox. */
+struct FLyraHitboxFrame
+{
+	double Time = 0.0;
+	FVector Location = FVector::ZeroVector;
+	float CapsuleRadius = 0.0f;
+	float CapsuleHalfHeight = 0.0f;
+};
+
+/**
+ * Upright capsule around every hitbox a character could be rewound to.  Hitbox capsules are upright as well, so
+ * this is their own shape grown to cover the path the character moved along during the window.
+ */
+struct FLyraHitboxWindowCapsule
+{
+	// The axis runs from BottomZ to TopZ above Center
+	FVector2D Center = FVector2D::ZeroVector;
+	double BottomZ = 0.0;
+	double TopZ = 0.0;
+	double Radius = 0.0;
+	bool bIsValid = false;
+
+	// True if the segment comes within Radius + Inflate of the axis.  Scalar reference for FLyraHitboxCapsuleBatch.
+	bool IntersectsSegment(const FVector& Start, const FVector& End, float Inflate) const;
+};
+
+/** Fixed size ring of hitbox frames for a single character, recorded at server tick rate. */
+struct FLyraHitboxHistory
+{
+	TWeakObjectPtr<ACharacter> Character;
+	TArray<FLyraHitboxFrame> Frames;
+	int32 Head = INDEX_NONE;
+	int32 NumFrames = 0;
+
+	void Record(const FLyraHitboxFrame& Frame);
+
+	// Interpolated hitbox at Time, clamped to the oldest and newest recorded frames.  Returns false if nothing was recorded.
+	bool GetFrameAtTime(double Time, FLyraHitboxFrame& OutFrame) const;
+
+	// Capsule around every hitbox that could be rewound to a time at or after OldestTime.
+	FLyraHitboxWindowCapsule GetWindowCapsule(double OldestTime = -UE_BIG_NUMBER) const;
+
+	const FLyraHitboxFrame& GetFrame(int32 Age) const { return Frames[(Head - Age + Frames.Num()) % Frames.Num()]; }
+};
+
+/**
+ * FLyraHitboxCapsuleBatch
+ *
+ *	Packed structure-of-arrays copy of every character's hitbox window capsule, used as the broad phase for
+ *	hit validation.  GatherSegment measures the closest approach of a segment to four capsule axes per
+ *	VectorRegister4Double, so only the few characters it returns need to be rewound and traced against.
+ */
+struct LYRAGAME_API FLyraHitboxCapsuleBatch
+{
+public:
+
+	void Reset(int32 ExpectedNum = 0);
+
+	// Adds the window capsule of one character and returns its lane index.  Invalid capsules never intersect anything.
+	int32 Add(const FLyraHitboxWindowCapsule& Capsule);
+
+	// Appends the lane of every capsule the segment passes through, after growing each capsule's radius by Inflate.
+	void GatherSegment(const FVector& Start, const FVector& End, float Inflate, TArray<int32>& OutLanes) const;
+
+	int32 Num() const { return NumLanes; }
+
+private:
+
+	int32 NumLanes = 0;
+
+	TArray<double> CenterX;
+	TArray<double> CenterY;
+	TArray<double> BottomZ;
+	TArray<double> Height;
+	TArray<double> Radius;
+};
+
+/**
+ * ULyraLagCompensationSubsystem
+ *
+ *	Server side hit validation for hitscan weapons.  Keeps a short history of every character's hitbox and
+ *	checks client hit claims against the hitboxes rewound to the time the client fired.
+ */
+UCLASS()
+class LYRAGAME_API ULyraLagCompensationSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	//~FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	//~End of FTickableGameObject interface
+
+	void RegisterCharacter(ACharacter* Character);
+	void UnregisterCharacter(ACharacter* Character);
+
+	// Validates the hits a remote client claimed for a single shot.  Pawn hits must hold up against the rewound
+	// hitboxes with no world geometry in between, world hits must match the world as the server sees it.  Hits
+	// that do not are turned into misses and flagged with bHitReplaced.  Returns false if the shot as a whole is
+	// not plausible (for example the trace did not start near the shooter).
+	bool ValidateTargetData(const APawn* Shooter, FGameplayAbilityTargetDataHandle& TargetData, float SweepRadius);
+
+	// Server time the given shooter was looking at when they fired, based on their ping.
+	double GetRewindTime(const APawn* Shooter) const;
+
+protected:
+
+	// Broad phase: characters whose recorded window could intersect the segment, skipping IgnoreCharacter.
+	void GatherCandidates(const FVector& Start, const FVector& End, float Inflate, const ACharacter* IgnoreCharacter, TArray<int32>& OutCandidates) const;
+
+	// Narrow phase: closest rewound hitbox along the segment, or INDEX_NONE.  OutHitDistance is measured from Start.
+	int32 FindFirstRewoundHit(const FVector& Start, const FVector& End, float Inflate, double RewindTime, TArrayView<const int32> Candidates, double& OutHitDistance) const;
+
+	// Weapon trace params that only see the world: the shooter, every tracked character and what is attached to
+	// them are ignored, characters are checked against their rewound hitboxes instead.
+	void MakeWorldTraceParams(const APawn* Shooter, FCollisionQueryParams& OutTraceParams) const;
+
+	// Returns false if nothing in the world blocks the segment.
+	bool TraceWorld(const FVector& Start, const FVector& End, const FCollisionQueryParams& TraceParams, FHitResult& OutHit) const;
+
+	int32 FindHistoryIndex(const AActor* Actor) const;
+
+	// Refreshes WindowCapsules from Histories, lanes match history indices.
+	void RebuildWindowCapsules();
+
+	TArray<FLyraHitboxHistory> Histories;
+
+	FLyraHitboxCapsuleBatch WindowCapsules;
+};
@@ -0,0 +1,365 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "LyraProjectileSubsystem.h"
+
+#include "AbilitySystem/LyraGameplayAbilityTargetData_Cartridge.h"
+#include "AbilitySystemComponent.h"
+#include "AbilitySystemGlobals.h"
+#include "Async/ParallelFor.h"
+#include "DrawDebugHelpers.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "GameModes/LyraGameState.h"
+#include "HAL/IConsoleManager.h"
+#include "LyraLogChannels.h"
+#include "Physics/LyraCollisionChannels.h"
+#include "Stats/Stats2.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(LyraProjectileSubsystem)
+
+DECLARE_STATS_GROUP(TEXT("LyraProjectiles"), STATGROUP_LyraProjectiles, STATCAT_Advanced);
+DECLARE_CYCLE_STAT(TEXT("Step"), STAT_LyraProjectiles_Step, STATGROUP_LyraProjectiles);
+DECLARE_CYCLE_STAT(TEXT("Sweep"), STAT_LyraProjectiles_Sweep, STATGROUP_LyraProjectiles);
+DECLARE_CYCLE_STAT(TEXT("Apply Damage"), STAT_LyraProjectiles_ApplyDamage, STATGROUP_LyraProjectiles);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Active Projectiles"), STAT_LyraProjectiles_Active, STATGROUP_LyraProjectiles);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Sweeps"), STAT_LyraProjectiles_Sweeps, STATGROUP_LyraProjectiles);
+
+namespace LyraConsoleVariables
+{
+	static float ProjectileStepRate = 60.0f;
+	static FAutoConsoleVariableRef CVarProjectileStepRate(
+		TEXT("lyra.Projectile.StepRate"),
+		ProjectileStepRate,
+		TEXT("How many times per second projectiles are stepped (fixed rate, independent of frame rate)"),
+		ECVF_Default);
+
+	static int32 ProjectileMaxStepsPerFrame = 4;
+	static FAutoConsoleVariableRef CVarProjectileMaxStepsPerFrame(
+		TEXT("lyra.Projectile.MaxStepsPerFrame"),
+		ProjectileMaxStepsPerFrame,
+		TEXT("Most fixed steps run in a single frame, after a hitch the remaining time is dropped"),
+		ECVF_Default);
+
+	static int32 ProjectileMaxActive = 2048;
+	static FAutoConsoleVariableRef CVarProjectileMaxActive(
+		TEXT("lyra.Projectile.MaxActive"),
+		ProjectileMaxActive,
+		TEXT("Size of the projectile pool, spawns past it are dropped (read when the world starts)"),
+		ECVF_Default);
+
+	static int32 ProjectileParallelSweepMin = 32;
+	static FAutoConsoleVariableRef CVarProjectileParallelSweepMin(
+		TEXT("lyra.Projectile.ParallelSweepMin"),
+		ProjectileParallelSweepMin,
+		TEXT("With at least this many live projectiles their sweeps are spread over the task graph (0 to always sweep on the game thread)"),
+		ECVF_Default);
+
+	static float ProjectileBounceScatter = 5.0f;
+	static FAutoConsoleVariableRef CVarProjectileBounceScatter(
+		TEXT("lyra.Projectile.BounceScatter"),
+		ProjectileBounceScatter,
+		TEXT("Half angle (in degrees) of the seeded random scatter applied to bounces"),
+		ECVF_Default);
+
+	static float ProjectileMinBounceSpeed = 50.0f;
+	static FAutoConsoleVariableRef CVarProjectileMinBounceSpeed(
+		TEXT("lyra.Projectile.MinBounceSpeed"),
+		ProjectileMinBounceSpeed,
+		TEXT("Projectiles that would bounce away slower than this (in uu/s) impact instead"),
+		ECVF_Default);
+
+	static float DrawProjectilesDuration = 0.0f;
+	static FAutoConsoleVariableRef CVarDrawProjectilesDuration(
+		TEXT("lyra.Projectile.DrawDebugDuration"),
+		DrawProjectilesDuration,
+		TEXT("Should we do debug drawing for projectile paths (if above zero, sets how long (in seconds))"),
+		ECVF_Default);
+}
+
+namespace LyraProjectile
+{
+	static bool IsPawnHit(const FHitResult& Hit)
+	{
+		const AActor* HitActor = Hit.GetActor();
+		return HitActor && (HitActor->IsA<APawn>() || Cast<APawn>(HitActor->GetAttachParentActor()));
+	}
+};
+
+void ULyraProjectileSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	// Allocate the pool up front, spawning and removing projectiles never allocates after this
+	const int32 PoolSize = FMath::Max(LyraConsoleVariables::ProjectileMaxActive, 0);
+	Projectiles.Reserve(PoolSize);
+	Payloads.Reserve(PoolSize);
+	Moves.Reserve(PoolSize);
+}
+
+TStatId ULyraProjectileSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(ULyraProjectileSubsystem, STATGROUP_Tickables);
+}
+
+void ULyraProjectileSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (Projectiles.Num() == 0)
+	{
+		StepAccumulator = 0.0;
+		return;
+	}
+
+	const float StepTime = 1.0f / FMath::Max(LyraConsoleVariables::ProjectileStepRate, 1.0f);
+
+	StepAccumulator += DeltaTime;
+
+	int32 NumSteps = 0;
+	while ((StepAccumulator >= StepTime) && (NumSteps < LyraConsoleVariables::ProjectileMaxStepsPerFrame))
+	{
+		StepProjectiles(StepTime);
+		StepAccumulator -= StepTime;
+		++NumSteps;
+	}
+
+	if (NumSteps == LyraConsoleVariables::ProjectileMaxStepsPerFrame)
+	{
+		StepAccumulator = FMath::Min(StepAccumulator, double(StepTime));
+	}
+}
+
+bool ULyraProjectileSubsystem::SpawnAuthoritativeProjectile(const FLyraProjectileSpawnParams& Params, TSubclassOf<UGameplayEffect> DamageEffect, const FGameplayEffectContextHandle& EffectContext, float EffectLevel)
+{
+	UWorld* World = GetWorld();
+	check(World && (World->GetNetMode() != NM_Client));
+
+	const int32 Index = AddProjectile(Params, /*bAuthoritative=*/ true);
+	if (Index == INDEX_NONE)
+	{
+		return false;
+	}
+
+	FDamagePayload& Payload = Payloads[Index];
+	Payload.DamageEffect = DamageEffect;
+	Payload.EffectContext = EffectContext;
+	Payload.SourceAbilitySystem = EffectContext.GetInstigatorAbilitySystemComponent();
+	Payload.EffectLevel = EffectLevel;
+
+	if (World->GetNetMode() != NM_Standalone)
+	{
+		if (ALyraGameState* GameState = World->GetGameState<ALyraGameState>())
+		{
+			GameState->MulticastProjectileSpawn(Params);
+		}
+	}
+
+	return true;
+}
+
+bool ULyraProjectileSubsystem::SpawnCosmeticProjectile(const FLyraProjectileSpawnParams& Params)
+{
+	return AddProjectile(Params, /*bAuthoritative=*/ false) != INDEX_NONE;
+}
+
+int32 ULyraProjectileSubsystem::AddProjectile(const FLyraProjectileSpawnParams& Params, bool bAuthoritative)
+{
+	if ((Params.Speed <= 0.0f) || (Params.Lifetime <= 0.0f))
+	{
+		return INDEX_NONE;
+	}
+
+	if (Projectiles.Num() >= LyraConsoleVariables::ProjectileMaxActive)
+	{
+		UE_LOG(LogLyra, Verbose, TEXT("Projectile pool is full (%d), dropping projectile from %s"), Projectiles.Num(), *GetNameSafe(Params.Instigator));
+		return INDEX_NONE;
+	}
+
+	// Every copy flies from the origin and direction as the spawn multicast delivers them, so the server's copy
+	// follows the same path as the ones on clients
+	FVector Origin = Params.Origin;
+	FVector Direction = Params.Direction;
+	FLyraGameplayAbilityTargetData_Cartridge::QuantizeAim(Origin, Direction);
+
+	const int32 Index = Projectiles.AddDefaulted();
+	FLyraProjectile& Projectile = Projectiles[Index];
+	Projectile.Origin = Origin;
+	Projectile.Location = Origin;
+	Projectile.Velocity = Direction * Params.Speed;
+	Projectile.Lifetime = Params.Lifetime;
+	Projectile.Radius = Params.Radius;
+	Projectile.GravityScale = Params.GravityScale;
+	Projectile.BounceRestitution = Params.BounceRestitution;
+	Projectile.BouncesLeft = Params.MaxBounces;
+	Projectile.bAuthoritative = bAuthoritative;
+	Projectile.Id = NextProjectileId++;
+	Projectile.Random.Initialize(Params.Seed);
+	Projectile.Instigator = Params.Instigator;
+
+	Payloads.AddDefaulted();
+
+	OnProjectileSpawned.Broadcast(Projectile);
+
+	return Index;
+}
+
+void ULyraProjectileSubsystem::RemoveProjectile(int32 Index)
+{
+	Projectiles.RemoveAtSwap(Index, 1, /*bAllowShrinking=*/ false);
+	Payloads.RemoveAtSwap(Index, 1, /*bAllowShrinking=*/ false);
+}
+
+void ULyraProjectileSubsystem::SweepMoves(float StepTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_LyraProjectiles_Sweep);
+	INC_DWORD_STAT_BY(STAT_LyraProjectiles_Sweeps, Projectiles.Num());
+
+	const UWorld* World = GetWorld();
+	const double GravityZ = World->GetGravityZ();
+
+	Moves.SetNum(Projectiles.Num(), /*bAllowShrinking=*/ false);
+
+	// Every projectile only reads the scene and writes its own move, so the sweeps can go wide
+	const bool bSweepInParallel = (LyraConsoleVariables::ProjectileParallelSweepMin > 0) && (Projectiles.Num() >= LyraConsoleVariables::ProjectileParallelSweepMin);
+	ParallelFor(Projectiles.Num(), [this, World, GravityZ, StepTime](int32 Index)
+		{
+			const FLyraProjectile& Projectile = Projectiles[Index];
+			FMove& Move = Moves[Index];
+
+			const FVector Acceleration(0.0, 0.0, GravityZ * Projectile.GravityScale);
+			Move.End = Projectile.Location + (Projectile.Velocity * StepTime) + (0.5 * Acceleration * FMath::Square(StepTime));
+			Move.EndVelocity = Projectile.Velocity + (Acceleration * StepTime);
+
+			FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(LyraProjectileSweep), /*bTraceComplex=*/ false, Projectile.Instigator.Get());
+			QueryParams.bReturnPhysicalMaterial = Projectile.bAuthoritative;
+
+			if (Projectile.Radius > 0.0f)
+			{
+				Move.bHit = World->SweepSingleByChannel(Move.Hit, Projectile.Location, Move.End, FQuat::Identity, Lyra_TraceChannel_Weapon, FCollisionShape::MakeSphere(Projectile.Radius), QueryParams);
+			}
+			else
+			{
+				Move.bHit = World->LineTraceSingleByChannel(Move.Hit, Projectile.Location, Move.End, Lyra_TraceChannel_Weapon, QueryParams);
+			}
+		}, /*bForceSingleThread=*/ !bSweepInParallel);
+}
+
+void ULyraProjectileSubsystem::StepProjectiles(float StepTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_LyraProjectiles_Step);
+
+	SweepMoves(StepTime);
+
+	// Resolve the moves in array order on the game thread.  Impacts may run gameplay code that spawns more projectiles,
+	// those are appended past NumStepped and first move next step.
+	const int32 NumStepped = Moves.Num();
+	TArray<int32, TInlineAllocator<32>> Finished;
+
+	for (int32 Index = 0; Index < NumStepped; ++Index)
+	{
+		FLyraProjectile& Projectile = Projectiles[Index];
+		const FMove& Move = Moves[Index];
+
+#if ENABLE_DRAW_DEBUG
+		if (LyraConsoleVariables::DrawProjectilesDuration > 0.0f)
+		{
+			const FVector DrawEnd = Move.bHit ? Move.Hit.Location : Move.End;
+			DrawDebugLine(GetWorld(), Projectile.Location, DrawEnd, Projectile.bAuthoritative ? FColor::Red : FColor::Green, false, LyraConsoleVariables::DrawProjectilesDuration);
+		}
+#endif // ENABLE_DRAW_DEBUG
+
+		bool bImpact = false;
+
+		if (Move.bHit)
+		{
+			const FVector Bounced = Move.EndVelocity.MirrorByVector(Move.Hit.Normal) * Projectile.BounceRestitution;
+			const bool bCanBounce = (Projectile.BouncesLeft > 0) && !Move.Hit.bStartPenetrating && !LyraProjectile::IsPawnHit(Move.Hit) &&
+				(Bounced.SizeSquared() > FMath::Square(LyraConsoleVariables::ProjectileMinBounceSpeed));
+
+			if (bCanBounce)
+			{
+				// Seeded scatter, the same on every machine
+				const float ScatterHalfAngle = FMath::DegreesToRadians(LyraConsoleVariables::ProjectileBounceScatter);
+				Projectile.Velocity = Projectile.Random.VRandCone(Bounced.GetSafeNormal(), ScatterHalfAngle) * Bounced.Size();
+				Projectile.Location = Move.Hit.Location + (Move.Hit.Normal * 0.1);
+				--Projectile.BouncesLeft;
+			}
+			else
+			{
+				bImpact = true;
+			}
+		}
+		else
+		{
+			Projectile.Location = Move.End;
+			Projectile.Velocity = Move.EndVelocity;
+		}
+
+		Projectile.Age += StepTime;
+
+		if (bImpact)
+		{
+			Projectile.Location = Move.Hit.Location;
+
+			// Copies, the callbacks below may add projectiles
+			const FLyraProjectile ImpactProjectile = Projectile;
+			const FDamagePayload Payload = Payloads[Index];
+			const FHitResult Hit = Move.Hit;
+
+			if (ImpactProjectile.bAuthoritative)
+			{
+				ApplyImpactDamage(ImpactProjectile, Payload, Hit);
+			}
+
+			OnProjectileImpact.Broadcast(ImpactProjectile, Hit);
+			Finished.Add(Index);
+		}
+		else if (Projectile.Age >= Projectile.Lifetime)
+		{
+			Finished.Add(Index);
+		}
+	}
+
+	// Back to front so every swap pulls in a projectile that is still alive
+	for (int32 FinishedIndex = Finished.Num() - 1; FinishedIndex >= 0; --FinishedIndex)
+	{
+		RemoveProjectile(Finished[FinishedIndex]);
+	}
+
+	SET_DWORD_STAT(STAT_LyraProjectiles_Active, Projectiles.Num());
+}
+
+void ULyraProjectileSubsystem::ApplyImpactDamage(const FLyraProjectile& Projectile, const FDamagePayload& Payload, const FHitResult& Hit) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_LyraProjectiles_ApplyDamage);
+
+	UAbilitySystemComponent* SourceAbilitySystem = Payload.SourceAbilitySystem.Get();
+	if (!SourceAbilitySystem || !Payload.DamageEffect)
+	{
+		return;
+	}
+
+	// Hits on things attached to a pawn damage the pawn
+	AActor* HitActor = Hit.GetActor();
+	UAbilitySystemComponent* TargetAbilitySystem = UAbilitySystemGlobals::GetAbilitySystemComponentFromActor(HitActor);
+	if (!TargetAbilitySystem && HitActor)
+	{
+		TargetAbilitySystem = UAbilitySystemGlobals::GetAbilitySystemComponentFromActor(HitActor->GetAttachParentActor());
+	}
+
+	if (!TargetAbilitySystem)
+	{
+		return;
+	}
+
+	// Same context the hitscan path builds, plus the impact and the muzzle for distance falloff
+	FGameplayEffectContextHandle EffectContext = Payload.EffectContext.Duplicate();
+	EffectContext.AddHitResult(Hit, /*bReset=*/ true);
+	EffectContext.AddOrigin(Projectile.Origin);
+
+	const FGameplayEffectSpecHandle SpecHandle = SourceAbilitySystem->MakeOutgoingSpec(Payload.DamageEffect, Payload.EffectLevel, EffectContext);
+	if (SpecHandle.IsValid())
+	{
+		SourceAbilitySystem->ApplyGameplayEffectSpecToTarget(*SpecHandle.Data.Get(), TargetAbilitySystem);
+	}
+}
@@ -0,0 +1,163 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "Containers/Array.h"
+#include "Containers/ArrayView.h"
+#include "Engine/EngineTypes.h"
+#include "Engine/HitResult.h"
+#include "GameplayEffectTypes.h"
+#include "Math/RandomStream.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Templates/SubclassOf.h"
+#include "UObject/WeakObjectPtr.h"
+
+#include "LyraProjectileSubsystem.generated.h"
+
+class AActor;
+class UAbilitySystemComponent;
+class UGameplayEffect;
+class UObject;
+
+/**
+ * FLyraProjectileSpawnParams
+ *
+ *	Everything needed to simulate a projectile from the moment it was fired.  This is all that gets sent to
+ *	clients, the flight itself is re-simulated on every machine from these and the seed.
+ */
+USTRUCT()
+struct FLyraProjectileSpawnParams
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FVector_NetQuantize10 Origin = FVector::ZeroVector;
+
+	UPROPERTY()
+	FVector_NetQuantizeNormal Direction = FVector::ForwardVector;
+
+	UPROPERTY()
+	float Speed = 0.0f;
+
+	UPROPERTY()
+	float GravityScale = 0.0f;
+
+	// Collision radius, 0 does line traces
+	UPROPERTY()
+	float Radius = 0.0f;
+
+	UPROPERTY()
+	float Lifetime = 0.0f;
+
+	// Number of times the projectile bounces off world geometry before it impacts (pawns are always impacts)
+	UPROPERTY()
+	uint8 MaxBounces = 0;
+
+	UPROPERTY()
+	float BounceRestitution = 0.5f;
+
+	// Drives the bounce scatter, so every machine flies the same path through the same geometry
+	UPROPERTY()
+	int32 Seed = 0;
+
+	UPROPERTY()
+	TObjectPtr<AActor> Instigator = nullptr;
+};
+
+/** One simulated projectile, kept by value in a contiguous array. */
+struct FLyraProjectile
+{
+	FVector Origin = FVector::ZeroVector;
+	FVector Location = FVector::ZeroVector;
+	FVector Velocity = FVector::ZeroVector;
+
+	float Age = 0.0f;
+	float Lifetime = 0.0f;
+	float Radius = 0.0f;
+	float GravityScale = 0.0f;
+	float BounceRestitution = 0.0f;
+	uint8 BouncesLeft = 0;
+
+	// False for client side copies, which never apply damage
+	bool bAuthoritative = false;
+
+	// Unique for the lifetime of the subsystem, lets presentation code follow a projectile around the array
+	uint32 Id = 0;
+
+	FRandomStream Random;
+	TWeakObjectPtr<AActor> Instigator;
+};
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FLyraProjectileSpawnedDelegate, const FLyraProjectile& /*Projectile*/);
+DECLARE_MULTICAST_DELEGATE_TwoParams(FLyraProjectileImpactDelegate, const FLyraProjectile& /*Projectile*/, const FHitResult& /*Hit*/);
+
+/**
+ * ULyraProjectileSubsystem
+ *
+ *	Simulates projectile weapons without spawning actors.  Projectiles are plain structs stepped at a fixed rate,
+ *	each step sweeps every live projectile in one batch.  The server spawns the authoritative projectiles and
+ *	applies the damage effect on impact, clients fly cosmetic copies from the replicated spawn params.
+ */
+UCLASS()
+class LYRAGAME_API ULyraProjectileSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	//~USubsystem interface
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	//~End of USubsystem interface
+
+	//~FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	//~End of FTickableGameObject interface
+
+	// Server only: spawns a projectile that applies DamageEffect to whatever it impacts, and sends the spawn to clients
+	bool SpawnAuthoritativeProjectile(const FLyraProjectileSpawnParams& Params, TSubclassOf<UGameplayEffect> DamageEffect, const FGameplayEffectContextHandle& EffectContext, float EffectLevel);
+
+	// Spawns a projectile that is only shown, used for replicated and locally predicted shots
+	bool SpawnCosmeticProjectile(const FLyraProjectileSpawnParams& Params);
+
+	// Advances every projectile by one fixed step
+	void StepProjectiles(float StepTime);
+
+	TConstArrayView<FLyraProjectile> GetProjectiles() const { return Projectiles; }
+
+	FLyraProjectileSpawnedDelegate OnProjectileSpawned;
+	FLyraProjectileImpactDelegate OnProjectileImpact;
+
+private:
+
+	// Server side data needed to apply damage, stored at the same index as the projectile
+	struct FDamagePayload
+	{
+		TSubclassOf<UGameplayEffect> DamageEffect;
+		FGameplayEffectContextHandle EffectContext;
+		TWeakObjectPtr<UAbilitySystemComponent> SourceAbilitySystem;
+		float EffectLevel = 1.0f;
+	};
+
+	// Where each projectile wants to go this step and what it hit on the way
+	struct FMove
+	{
+		FVector End = FVector::ZeroVector;
+		FVector EndVelocity = FVector::ZeroVector;
+		FHitResult Hit;
+		bool bHit = false;
+	};
+
+	// Returns the index of the new projectile, or INDEX_NONE if it could not be spawned
+	int32 AddProjectile(const FLyraProjectileSpawnParams& Params, bool bAuthoritative);
+	void SweepMoves(float StepTime);
+	void ApplyImpactDamage(const FLyraProjectile& Projectile, const FDamagePayload& Payload, const FHitResult& Hit) const;
+	void RemoveProjectile(int32 Index);
+
+	TArray<FLyraProjectile> Projectiles;
+	TArray<FDamagePayload> Payloads;
+	TArray<FMove> Moves;
+
+	double StepAccumulator = 0.0;
+	uint32 NextProjectileId = 1;
+};
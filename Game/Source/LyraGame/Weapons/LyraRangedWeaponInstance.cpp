@@ -5,12 +5,32 @@
 #include "GameFramework/Pawn.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "Camera/LyraCameraComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "LyraLogChannels.h"
 #include "Physics/PhysicalMaterialWithTags.h"
+#include "Weapons/LyraProjectileSubsystem.h"
 
 #include UE_INLINE_GENERATED_CPP_BY_NAME(LyraRangedWeaponInstance)
 
 UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_Lyra_Weapon_SteadyAimingCamera, "Lyra.Weapon.SteadyAimingCamera");
 
+namespace LyraConsoleVariables
+{
+	static int32 CurveTableSamples = 256;
+	static FAutoConsoleVariableRef CVarCurveTableSamples(
+		TEXT("lyra.Weapon.CurveTableSamples"),
+		CurveTableSamples,
+		TEXT("Number of samples used when baking weapon heat, spread and damage falloff curves into lookup tables (takes effect on the next equip)"),
+		ECVF_Default);
+
+	static float CurveTableTolerance = 0.01f;
+	static FAutoConsoleVariableRef CVarCurveTableTolerance(
+		TEXT("lyra.Weapon.CurveTableTolerance"),
+		CurveTableTolerance,
+		TEXT("Largest error allowed between a weapon curve and its lookup table, curves that do not fit are evaluated directly instead"),
+		ECVF_Default);
+}
+
 ULyraRangedWeaponInstance::ULyraRangedWeaponInstance(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
 {
@@ -22,6 +42,8 @@ void ULyraRangedWeaponInstance::PostLoad()
 {
 	Super::PostLoad();
 
+	BakeCurveTables();
+
 #if WITH_EDITOR
 	UpdateDebugVisualization();
 #endif
@@ -31,6 +53,7 @@ void ULyraRangedWeaponInstance::PostLoad()
 void ULyraRangedWeaponInstance::PostEditChangeProperty(struct FPropertyChangedEvent& PropertyChangedEvent)
 {
 	Super::PostEditChangeProperty(PropertyChangedEvent);
+	BakeCurveTables();
 	UpdateDebugVisualization();
 }
 
@@ -48,20 +71,26 @@ void ULyraRangedWeaponInstance::OnEquipped()
 {
 	Super::OnEquipped();
 
-	// Start heat in the middle
+	// Instances are created at runtime rather than loaded, so the tables are baked here as well
+	BakeCurveTables();
+
+	// Start heat in the middle, cooling down right away
 	float MinHeatRange;
 	float MaxHeatRange;
 	ComputeHeatRange(/*out*/ MinHeatRange, /*out*/ MaxHeatRange);
-	CurrentHeat = (MinHeatRange + MaxHeatRange) * 0.5f;
+	HeatAtLastFire = (MinHeatRange + MaxHeatRange) * 0.5f;
+	LastFireTime = GetSpreadStateTime() - SpreadRecoveryCooldownDelay;
 
 	// Derive spread
-	CurrentSpreadAngle = HeatToSpreadCurve.GetRichCurveConst()->Eval(CurrentHeat);
+	CurrentHeat = HeatAtLastFire;
+	CurrentSpreadAngle = EvalCurveTable(HeatToSpreadTable, HeatToSpreadCurve, CurrentHeat);
 
 	// Default the multipliers to 1x
 	CurrentSpreadAngleMultiplier = 1.0f;
 	StandingStillMultiplier = 1.0f;
 	JumpFallMultiplier = 1.0f;
 	CrouchingMultiplier = 1.0f;
+	LastSpreadUpdateTime = -1.0;
 }
 
 void ULyraRangedWeaponInstance::OnUnequipped()
@@ -69,22 +98,70 @@ void ULyraRangedWeaponInstance::OnUnequipped()
 	Super::OnUnequipped();
 }
 
-void ULyraRangedWeaponInstance::Tick(float DeltaSeconds)
+double ULyraRangedWeaponInstance::GetSpreadStateTime() const
 {
-	APawn* Pawn = GetPawn();
-	check(Pawn != nullptr);
-	
-	const bool bMinSpread = UpdateSpread(DeltaSeconds);
+	const UWorld* World = GetWorld();
+	return (World != nullptr) ? World->GetTimeSeconds() : LastFireTime;
+}
+
+void ULyraRangedWeaponInstance::UpdateSpreadState() const
+{
+	const double WorldTime = GetSpreadStateTime();
+	if (WorldTime == LastSpreadUpdateTime)
+	{
+		return;
+	}
+
+	// The multipliers blend towards the pawn's current state over however long it has been since the last query
+	const float DeltaSeconds = (LastSpreadUpdateTime >= 0.0) ? float(WorldTime - LastSpreadUpdateTime) : 0.0f;
+	LastSpreadUpdateTime = WorldTime;
+
+	const bool bMinSpread = UpdateSpread(WorldTime);
 	const bool bMinMultipliers = UpdateMultipliers(DeltaSeconds);
 
 	bHasFirstShotAccuracy = bAllowFirstShotAccuracy && bMinMultipliers && bMinSpread;
+}
 
-#if WITH_EDITOR
-	UpdateDebugVisualization();
-#endif
+void ULyraRangedWeaponInstance::BakeCurveTables()
+{
+	auto BakeTable = [this](FLyraCurveLookupTable& Table, const FRuntimeFloatCurve& Curve, const TCHAR* CurveName)
+	{
+		if (!Table.Bake(*Curve.GetRichCurveConst(), LyraConsoleVariables::CurveTableSamples, LyraConsoleVariables::CurveTableTolerance))
+		{
+			UE_LOG(LogLyra, Warning, TEXT("%s on %s does not fit a %d sample lookup table (error %f, tolerance %f, extrapolation must be constant), it will be evaluated directly"),
+				CurveName, *GetPathNameSafe(GetClass()), LyraConsoleVariables::CurveTableSamples, Table.GetMaxError(), LyraConsoleVariables::CurveTableTolerance);
+		}
+	};
+
+	BakeTable(HeatToSpreadTable, HeatToSpreadCurve, TEXT("HeatToSpreadCurve"));
+	BakeTable(HeatToHeatPerShotTable, HeatToHeatPerShotCurve, TEXT("HeatToHeatPerShotCurve"));
+	BakeTable(DistanceDamageFalloffTable, DistanceDamageFalloff, TEXT("DistanceDamageFalloff"));
+
+	// The cooldown curve is only needed to build the cooling time table, which is its baked form
+	BuildCoolingTimeTable();
 }
 
-void ULyraRangedWeaponInstance::ComputeHeatRange(float& MinHeat, float& MaxHeat)
+void ULyraRangedWeaponInstance::BuildCoolingTimeTable()
+{
+	float MinHeat;
+	float MaxHeat;
+	ComputeHeatRange(/*out*/ MinHeat, /*out*/ MaxHeat);
+
+	CoolingTimeTable.Build(*HeatToCoolDownPerSecondCurve.GetRichCurveConst(), MinHeat, MaxHeat, NumCoolingTimeSamples);
+}
+
+float ULyraRangedWeaponInstance::EvaluateHeat(double WorldTime) const
+{
+	const double CoolingTime = (WorldTime - LastFireTime) - SpreadRecoveryCooldownDelay;
+	return (CoolingTime > 0.0) ? CoolHeat(HeatAtLastFire, CoolingTime) : HeatAtLastFire;
+}
+
+float ULyraRangedWeaponInstance::CoolHeat(float StartHeat, double CoolingTime) const
+{
+	return CoolingTimeTable.IsValid() ? CoolingTimeTable.Cool(StartHeat, CoolingTime) : ClampHeat(StartHeat);
+}
+
+void ULyraRangedWeaponInstance::ComputeHeatRange(float& MinHeat, float& MaxHeat) const
 {
 	float Min1;
 	float Max1;
@@ -102,29 +179,68 @@ void ULyraRangedWeaponInstance::ComputeHeatRange(float& MinHeat, float& MaxHeat)
 	MaxHeat = FMath::Max(FMath::Max(Max1, Max2), Max3);
 }
 
-void ULyraRangedWeaponInstance::ComputeSpreadRange(float& MinSpread, float& MaxSpread)
+void ULyraRangedWeaponInstance::ComputeSpreadRange(float& MinSpread, float& MaxSpread) const
 {
 	HeatToSpreadCurve.GetRichCurveConst()->GetValueRange(/*out*/ MinSpread, /*out*/ MaxSpread);
 }
 
+void ULyraRangedWeaponInstance::GetSpreadAngleRange(float& OutMinSpreadAngle, float& OutMaxSpreadAngle) const
+{
+	float MinSpread;
+	float MaxSpread;
+	ComputeSpreadRange(/*out*/ MinSpread, /*out*/ MaxSpread);
+
+	// Each multiplier blends between 1x and its own value, see UpdateMultipliers
+	const float Multipliers[] = { SpreadAngleMultiplier_Aiming, SpreadAngleMultiplier_StandingStill, SpreadAngleMultiplier_Crouching, SpreadAngleMultiplier_JumpingOrFalling };
+	float MinMultiplier = 1.0f;
+	float MaxMultiplier = 1.0f;
+	for (const float Multiplier : Multipliers)
+	{
+		MinMultiplier *= FMath::Min(Multiplier, 1.0f);
+		MaxMultiplier *= FMath::Max(Multiplier, 1.0f);
+	}
+
+	OutMinSpreadAngle = bAllowFirstShotAccuracy ? 0.0f : FMath::Max(MinSpread * MinMultiplier, 0.0f);
+	OutMaxSpreadAngle = FMath::Max(MaxSpread * MaxMultiplier, OutMinSpreadAngle);
+}
+
 void ULyraRangedWeaponInstance::AddSpread()
 {
+	UpdateSpreadState();
+
 	// Sample the heat up curve
-	const float HeatPerShot = HeatToHeatPerShotCurve.GetRichCurveConst()->Eval(CurrentHeat);
-	CurrentHeat = ClampHeat(CurrentHeat + HeatPerShot);
+	const double WorldTime = GetSpreadStateTime();
+	const float HeatBeforeShot = EvaluateHeat(WorldTime);
+	const float HeatPerShot = EvalCurveTable(HeatToHeatPerShotTable, HeatToHeatPerShotCurve, HeatBeforeShot);
+	HeatAtLastFire = ClampHeat(HeatBeforeShot + HeatPerShot);
+	LastFireTime = WorldTime;
 
 	// Map the heat to the spread angle
-	CurrentSpreadAngle = HeatToSpreadCurve.GetRichCurveConst()->Eval(CurrentHeat);
+	const bool bMinSpread = UpdateSpread(WorldTime);
+	bHasFirstShotAccuracy = bHasFirstShotAccuracy && bMinSpread;
 
 #if WITH_EDITOR
 	UpdateDebugVisualization();
 #endif
 }
 
+void ULyraRangedWeaponInstance::GetProjectileSpawnParams(const FVector& Origin, const FVector& Direction, int32 Seed, AActor* Instigator, FLyraProjectileSpawnParams& OutParams) const
+{
+	OutParams.Origin = Origin;
+	OutParams.Direction = Direction;
+	OutParams.Speed = ProjectileSpeed;
+	OutParams.GravityScale = ProjectileGravityScale;
+	OutParams.Radius = ProjectileRadius;
+	OutParams.Lifetime = ProjectileLifetime;
+	OutParams.MaxBounces = uint8(FMath::Clamp(ProjectileMaxBounces, 0, 255));
+	OutParams.BounceRestitution = ProjectileBounceRestitution;
+	OutParams.Seed = Seed;
+	OutParams.Instigator = Instigator;
+}
+
 float ULyraRangedWeaponInstance::GetDistanceAttenuation(float Distance, const FGameplayTagContainer* SourceTags, const FGameplayTagContainer* TargetTags) const
 {
-	const FRichCurve* Curve = DistanceDamageFalloff.GetRichCurveConst();
-	return Curve->HasAnyData() ? Curve->Eval(Distance) : 1.0f;
+	return DistanceDamageFalloff.GetRichCurveConst()->HasAnyData() ? EvalCurveTable(DistanceDamageFalloffTable, DistanceDamageFalloff, Distance) : 1.0f;
 }
 
 float ULyraRangedWeaponInstance::GetPhysicalMaterialAttenuation(const UPhysicalMaterial* PhysicalMaterial, const FGameplayTagContainer* SourceTags, const FGameplayTagContainer* TargetTags) const
@@ -144,17 +260,11 @@ float ULyraRangedWeaponInstance::GetPhysicalMaterialAttenuation(const UPhysicalM
 	return CombinedMultiplier;
 }
 
-bool ULyraRangedWeaponInstance::UpdateSpread(float DeltaSeconds)
+bool ULyraRangedWeaponInstance::UpdateSpread(double WorldTime) const
 {
-	const float TimeSinceFired = GetWorld()->TimeSince(LastFireTime);
+	CurrentHeat = EvaluateHeat(WorldTime);
+	CurrentSpreadAngle = EvalCurveTable(HeatToSpreadTable, HeatToSpreadCurve, CurrentHeat);
 
-	if (TimeSinceFired > SpreadRecoveryCooldownDelay)
-	{
-		const float CooldownRate = HeatToCoolDownPerSecondCurve.GetRichCurveConst()->Eval(CurrentHeat);
-		CurrentHeat = ClampHeat(CurrentHeat - (CooldownRate * DeltaSeconds));
-		CurrentSpreadAngle = HeatToSpreadCurve.GetRichCurveConst()->Eval(CurrentHeat);
-	}
-	
 	float MinSpread;
 	float MaxSpread;
 	ComputeSpreadRange(/*out*/ MinSpread, /*out*/ MaxSpread);
@@ -162,12 +272,15 @@ bool ULyraRangedWeaponInstance::UpdateSpread(float DeltaSeconds)
 	return FMath::IsNearlyEqual(CurrentSpreadAngle, MinSpread, KINDA_SMALL_NUMBER);
 }
 
-bool ULyraRangedWeaponInstance::UpdateMultipliers(float DeltaSeconds)
+bool ULyraRangedWeaponInstance::UpdateMultipliers(float DeltaSeconds) const
 {
 	const float MultiplierNearlyEqualThreshold = 0.05f;
 
 	APawn* Pawn = GetPawn();
-	check(Pawn != nullptr);
+	if (Pawn == nullptr)
+	{
+		return true;
+	}
 	UCharacterMovementComponent* CharMovementComp = Cast<UCharacterMovementComponent>(Pawn->GetMovementComponent());
 
 	// See if we are standing still, and if so, smoothly apply the bonus
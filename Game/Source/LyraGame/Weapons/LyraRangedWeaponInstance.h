@@ -7,9 +7,11 @@
 
 #include "LyraWeaponInstance.h"
 #include "AbilitySystem/LyraAbilitySourceInterface.h"
+#include "Weapons/LyraCurveLookupTable.h"
 
 #include "LyraRangedWeaponInstance.generated.h"
 
+class AActor;
 class UPhysicalMaterial;
 
 /**
@@ -41,19 +43,31 @@ public:
 	/** Returns the current spread angle (in degrees, diametrical) */
 	float GetCalculatedSpreadAngle() const
 	{
+		UpdateSpreadState();
 		return CurrentSpreadAngle;
 	}
 
 	float GetCalculatedSpreadAngleMultiplier() const
 	{
+		UpdateSpreadState();
 		return bHasFirstShotAccuracy ? 0.0f : CurrentSpreadAngleMultiplier;
 	}
 
 	bool HasFirstShotAccuracy() const
 	{
+		UpdateSpreadState();
 		return bHasFirstShotAccuracy;
 	}
 
+	/** Returns the lowest and highest spread angle, multipliers included, this weapon can fire with (in degrees, diametrical) */
+	void GetSpreadAngleRange(float& OutMinSpreadAngle, float& OutMaxSpreadAngle) const;
+
+	/** Returns the heat at the current world time */
+	float GetCurrentHeat() const
+	{
+		return EvaluateHeat(GetSpreadStateTime());
+	}
+
 	float GetSpreadExponent() const
 	{
 		return SpreadExponent;
@@ -69,6 +83,15 @@ public:
 		return BulletTraceSweepRadius;
 	}
 
+	/** Returns true if each bullet is simulated as a projectile (see ULyraProjectileSubsystem) instead of traced instantly */
+	bool IsProjectileWeapon() const
+	{
+		return ProjectileSpeed > 0.0f;
+	}
+
+	/** Fills in the flight parameters of a projectile fired by this weapon */
+	void GetProjectileSpawnParams(const FVector& Origin, const FVector& Direction, int32 Seed, AActor* Instigator, struct FLyraProjectileSpawnParams& OutParams) const;
+
 protected:
 #if WITH_EDITORONLY_DATA
 	UPROPERTY(VisibleAnywhere, Category = "Spread|Fire Params")
@@ -179,6 +202,30 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Weapon Config", meta=(ForceUnits=cm))
 	float BulletTraceSweepRadius = 0.0f;
 
+	// Launch speed of projectiles, 0 makes this a hitscan weapon
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Weapon Config|Projectile", meta=(ForceUnits="cm/s", ClampMin=0))
+	float ProjectileSpeed = 0.0f;
+
+	// Multiplier on world gravity for projectiles (0 flies straight, 1 for grenades)
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Weapon Config|Projectile", meta=(EditCondition="ProjectileSpeed > 0"))
+	float ProjectileGravityScale = 0.0f;
+
+	// Collision radius of projectiles (0.0 will result in line traces)
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Weapon Config|Projectile", meta=(ForceUnits=cm, ClampMin=0, EditCondition="ProjectileSpeed > 0"))
+	float ProjectileRadius = 0.0f;
+
+	// How long a projectile flies before it is removed without an impact
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Weapon Config|Projectile", meta=(ForceUnits=s, ClampMin=0, EditCondition="ProjectileSpeed > 0"))
+	float ProjectileLifetime = 5.0f;
+
+	// Number of times a projectile bounces off world geometry before it impacts (pawns are always impacts)
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Weapon Config|Projectile", meta=(ClampMin=0, ClampMax=255, EditCondition="ProjectileSpeed > 0"))
+	int32 ProjectileMaxBounces = 0;
+
+	// Fraction of the speed kept on each bounce
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Weapon Config|Projectile", meta=(ClampMin=0, ClampMax=1, EditCondition="ProjectileSpeed > 0"))
+	float ProjectileBounceRestitution = 0.5f;
+
 	// A curve that maps the distance (in cm) to a multiplier on the base damage from the associated gameplay effect
 	// If there is no data in this curve, then the weapon is assumed to have no falloff with distance
 	UPROPERTY(EditAnywhere, Category = "Weapon Config")
@@ -191,33 +238,52 @@ protected:
 	TMap<FGameplayTag, float> MaterialDamageMultiplier;
 
 private:
-	// Time since this weapon was last fired (relative to world time)
+	// Heat and spread are not ticked, they are functions of the time since the last shot.  The heat right
+	// after that shot is all that is stored, the rest below is a cache refreshed by UpdateSpreadState
+	// whenever the spread is queried.
+
+	// World time this weapon was last fired (cooldown starts SpreadRecoveryCooldownDelay after it)
 	double LastFireTime = 0.0;
 
+	// The heat right after the last shot
+	float HeatAtLastFire = 0.0f;
+
+	// Time it takes to cool from the minimum heat up to each of NumCoolingTimeSamples evenly spaced heats,
+	// inverted to find the heat after cooling for a given time (see BuildCoolingTimeTable)
+	FLyraCoolingTimeTable CoolingTimeTable;
+
+	static constexpr int32 NumCoolingTimeSamples = 64;
+
+	// Baked copies of the curves above, see BakeCurveTables
+	FLyraCurveLookupTable HeatToSpreadTable;
+	FLyraCurveLookupTable HeatToHeatPerShotTable;
+	FLyraCurveLookupTable DistanceDamageFalloffTable;
+
+	// World time the cached values below were last brought up to date
+	mutable double LastSpreadUpdateTime = -1.0;
+
 	// The current heat
-	float CurrentHeat = 0.0f;
+	mutable float CurrentHeat = 0.0f;
 
 	// The current spread angle (in degrees, diametrical)
-	float CurrentSpreadAngle = 0.0f;
+	mutable float CurrentSpreadAngle = 0.0f;
 
 	// Do we currently have first shot accuracy?
-	bool bHasFirstShotAccuracy = false;
+	mutable bool bHasFirstShotAccuracy = false;
 
 	// The current *combined* spread angle multiplier
-	float CurrentSpreadAngleMultiplier = 1.0f;
+	mutable float CurrentSpreadAngleMultiplier = 1.0f;
 
 	// The current standing still multiplier
-	float StandingStillMultiplier = 1.0f;
+	mutable float StandingStillMultiplier = 1.0f;
 
 	// The current jumping/falling multiplier
-	float JumpFallMultiplier = 1.0f;
+	mutable float JumpFallMultiplier = 1.0f;
 
 	// The current crouching multiplier
-	float CrouchingMultiplier = 1.0f;
+	mutable float CrouchingMultiplier = 1.0f;
 
 public:
-	void Tick(float DeltaSeconds);
-
 	//~ULyraEquipmentInstance interface
 	virtual void OnEquipped();
 	virtual void OnUnequipped();
@@ -231,10 +297,10 @@ public:
 	//~End of ILyraAbilitySourceInterface interface
 
 private:
-	void ComputeSpreadRange(float& MinSpread, float& MaxSpread);
-	void ComputeHeatRange(float& MinHeat, float& MaxHeat);
+	void ComputeSpreadRange(float& MinSpread, float& MaxSpread) const;
+	void ComputeHeatRange(float& MinHeat, float& MaxHeat) const;
 
-	inline float ClampHeat(float NewHeat)
+	inline float ClampHeat(float NewHeat) const
 	{
 		float MinHeat;
 		float MaxHeat;
@@ -243,9 +309,32 @@ private:
 		return FMath::Clamp(NewHeat, MinHeat, MaxHeat);
 	}
 
+	// Bakes the curves into lookup tables and the cooling time table, needs to run whenever the curves change
+	void BakeCurveTables();
+
+	// Integrates the cooldown curve into CoolingTimeTable
+	void BuildCoolingTimeTable();
+
+	// Evaluates a baked table, or the curve itself if the table could not be baked within tolerance
+	static float EvalCurveTable(const FLyraCurveLookupTable& Table, const FRuntimeFloatCurve& Curve, float X)
+	{
+		return Table.IsValid() ? Table.Eval(X) : Curve.GetRichCurveConst()->Eval(X);
+	}
+
+	// Returns the heat at the given world time, cooling down from HeatAtLastFire
+	float EvaluateHeat(double WorldTime) const;
+
+	// Returns the heat after cooling down from StartHeat for CoolingTime seconds
+	float CoolHeat(float StartHeat, double CoolingTime) const;
+
+	double GetSpreadStateTime() const;
+
+	// Brings the cached heat, spread and multipliers up to the current world time, does nothing if they already are
+	void UpdateSpreadState() const;
+
 	// Updates the spread and returns true if the spread is at minimum
-	bool UpdateSpread(float DeltaSeconds);
+	bool UpdateSpread(double WorldTime) const;
 
 	// Updates the multipliers and returns true if they are at minimum
-	bool UpdateMultipliers(float DeltaSeconds);
+	bool UpdateMultipliers(float DeltaSeconds) const;
 };
@@ -0,0 +1,167 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "LyraWeaponFireStats.h"
+
+#include "Containers/Map.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/OutputDevice.h"
+#include "UObject/Class.h"
+#include "UObject/Object.h"
+
+DEFINE_STAT(STAT_LyraWeaponFire_StartTargeting);
+DEFINE_STAT(STAT_LyraWeaponFire_LocalTargeting);
+DEFINE_STAT(STAT_LyraWeaponFire_ProcessTargetData);
+DEFINE_STAT(STAT_LyraWeaponFire_ApplyDamageEffect);
+DEFINE_STAT(STAT_LyraWeaponFire_LineTraces);
+DEFINE_STAT(STAT_LyraWeaponFire_SweepTraces);
+DEFINE_STAT(STAT_LyraWeaponFire_SweepReplacements);
+DEFINE_STAT(STAT_LyraWeaponFire_ConfirmLatency);
+
+UE_TRACE_CHANNEL_DEFINE(LyraWeaponFireChannel);
+
+//////////////////////////////////////////////////////////////////////
+// FLyraWeaponFireHistogram
+
+void FLyraWeaponFireHistogram::Add(double Value)
+{
+	Value = FMath::Max(Value, 0.0);
+
+	const int32 Bucket = (Value < 1.0) ? 0 : FMath::Min(FMath::FloorLog2(uint32(FMath::Min(Value, double(MAX_uint32)))) + 1, NumBuckets - 1);
+	++Counts[Bucket];
+	++NumSamples;
+	Sum += Value;
+	MaxValue = FMath::Max(MaxValue, Value);
+}
+
+double FLyraWeaponFireHistogram::GetPercentile(double Fraction) const
+{
+	const int64 Target = FMath::CeilToInt64(double(NumSamples) * Fraction);
+
+	int64 Seen = 0;
+	for (int32 Bucket = 0; Bucket < NumBuckets; ++Bucket)
+	{
+		Seen += Counts[Bucket];
+		if ((Seen >= Target) && (Seen > 0))
+		{
+			return (Bucket < NumBuckets - 1) ? FMath::Min(double(1u << Bucket), MaxValue) : MaxValue;
+		}
+	}
+
+	return MaxValue;
+}
+
+FString FLyraWeaponFireHistogram::ToString(const TCHAR* Units) const
+{
+	if (NumSamples == 0)
+	{
+		return TEXT("no samples");
+	}
+
+	FString Result = FString::Printf(TEXT("n=%lld avg=%.1f%s p50<=%.0f%s p90<=%.0f%s p99<=%.0f%s max=%.1f%s |"),
+		NumSamples, Sum / double(NumSamples), Units,
+		GetPercentile(0.5), Units, GetPercentile(0.9), Units, GetPercentile(0.99), Units,
+		MaxValue, Units);
+
+	for (int32 Bucket = 0; Bucket < NumBuckets; ++Bucket)
+	{
+		if (Counts[Bucket] > 0)
+		{
+			const uint32 UpperEdge = 1u << Bucket;
+			if (Bucket == NumBuckets - 1)
+			{
+				Result += FString::Printf(TEXT(" >=%u:%lld"), UpperEdge >> 1, Counts[Bucket]);
+			}
+			else
+			{
+				Result += FString::Printf(TEXT(" <%u:%lld"), UpperEdge, Counts[Bucket]);
+			}
+		}
+	}
+
+	return Result;
+}
+
+//////////////////////////////////////////////////////////////////////
+// FLyraWeaponFireStats
+
+namespace LyraWeaponFireStats
+{
+	struct FWeaponRecord
+	{
+		int64 NumShots = 0;
+		int64 LineTraces = 0;
+		int64 SweepTraces = 0;
+		int64 SweepReplacements = 0;
+
+		FLyraWeaponFireHistogram Measures[(int32)FLyraWeaponFireStats::EMeasure::Num];
+	};
+
+	static TMap<FName, FWeaponRecord> WeaponRecords;
+
+	static FAutoConsoleCommand CmdDumpFireStats(
+		TEXT("Lyra.Weapon.DumpFireStats"),
+		TEXT("Prints per weapon trace counts and histograms of targeting time, server confirm latency and damage application time. Pass 'reset' to clear them."),
+		FConsoleCommandWithArgsAndOutputDeviceDelegate::CreateStatic([](const TArray<FString>& Args, FOutputDevice& Ar)
+		{
+			FLyraWeaponFireStats::Dump(Ar);
+
+			if ((Args.Num() > 0) && Args[0].Equals(TEXT("reset"), ESearchCase::IgnoreCase))
+			{
+				FLyraWeaponFireStats::Reset();
+			}
+		}));
+}
+
+FName FLyraWeaponFireStats::GetWeaponKey(const UObject* WeaponInstance)
+{
+	return (WeaponInstance != nullptr) ? WeaponInstance->GetClass()->GetFName() : NAME_None;
+}
+
+void FLyraWeaponFireStats::RecordShot(FName WeaponKey, const FLyraWeaponTraceCounts& TraceCounts)
+{
+	check(IsInGameThread());
+
+	INC_DWORD_STAT_BY(STAT_LyraWeaponFire_LineTraces, TraceCounts.LineTraces);
+	INC_DWORD_STAT_BY(STAT_LyraWeaponFire_SweepTraces, TraceCounts.SweepTraces);
+	INC_DWORD_STAT_BY(STAT_LyraWeaponFire_SweepReplacements, TraceCounts.SweepReplacements);
+
+	LyraWeaponFireStats::FWeaponRecord& Record = LyraWeaponFireStats::WeaponRecords.FindOrAdd(WeaponKey);
+	++Record.NumShots;
+	Record.LineTraces += TraceCounts.LineTraces;
+	Record.SweepTraces += TraceCounts.SweepTraces;
+	Record.SweepReplacements += TraceCounts.SweepReplacements;
+}
+
+void FLyraWeaponFireStats::RecordMeasure(FName WeaponKey, EMeasure Measure, double Value)
+{
+	check(IsInGameThread());
+	check(Measure < EMeasure::Num);
+
+	LyraWeaponFireStats::WeaponRecords.FindOrAdd(WeaponKey).Measures[(int32)Measure].Add(Value);
+}
+
+void FLyraWeaponFireStats::Dump(FOutputDevice& Ar)
+{
+	if (LyraWeaponFireStats::WeaponRecords.Num() == 0)
+	{
+		Ar.Logf(TEXT("No weapon fire stats recorded"));
+		return;
+	}
+
+	for (const TPair<FName, LyraWeaponFireStats::FWeaponRecord>& Pair : LyraWeaponFireStats::WeaponRecords)
+	{
+		const LyraWeaponFireStats::FWeaponRecord& Record = Pair.Value;
+		const double ShotCount = FMath::Max(double(Record.NumShots), 1.0);
+
+		Ar.Logf(TEXT("%s: %lld shots, %.2f line traces/shot, %.2f sweep traces/shot, %lld hits replaced by sweeps"),
+			*Pair.Key.ToString(), Record.NumShots, Record.LineTraces / ShotCount, Record.SweepTraces / ShotCount, Record.SweepReplacements);
+		Ar.Logf(TEXT("    Targeting time:   %s"), *Record.Measures[(int32)EMeasure::TargetingTime].ToString(TEXT("us")));
+		Ar.Logf(TEXT("    Confirm latency:  %s"), *Record.Measures[(int32)EMeasure::ConfirmLatency].ToString(TEXT("ms")));
+		Ar.Logf(TEXT("    Apply damage:     %s"), *Record.Measures[(int32)EMeasure::ApplyDamageTime].ToString(TEXT("us")));
+	}
+}
+
+void FLyraWeaponFireStats::Reset()
+{
+	LyraWeaponFireStats::WeaponRecords.Reset();
+}
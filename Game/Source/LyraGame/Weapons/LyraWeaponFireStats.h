@@ -0,0 +1,98 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "Containers/UnrealString.h"
+#include "HAL/Platform.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "Stats/Stats.h"
+#include "Trace/Trace.h"
+#include "UObject/NameTypes.h"
+
+class FOutputDevice;
+class UObject;
+
+DECLARE_STATS_GROUP(TEXT("LyraWeaponFire"), STATGROUP_LyraWeaponFire, STATCAT_Advanced);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Start Targeting"), STAT_LyraWeaponFire_StartTargeting, STATGROUP_LyraWeaponFire, LYRAGAME_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Local Targeting"), STAT_LyraWeaponFire_LocalTargeting, STATGROUP_LyraWeaponFire, LYRAGAME_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Process Target Data"), STAT_LyraWeaponFire_ProcessTargetData, STATGROUP_LyraWeaponFire, LYRAGAME_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Apply Damage Effect"), STAT_LyraWeaponFire_ApplyDamageEffect, STATGROUP_LyraWeaponFire, LYRAGAME_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Line Traces"), STAT_LyraWeaponFire_LineTraces, STATGROUP_LyraWeaponFire, LYRAGAME_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Sweep Traces"), STAT_LyraWeaponFire_SweepTraces, STATGROUP_LyraWeaponFire, LYRAGAME_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Hits Replaced By Sweeps"), STAT_LyraWeaponFire_SweepReplacements, STATGROUP_LyraWeaponFire, LYRAGAME_API);
+DECLARE_FLOAT_COUNTER_STAT_EXTERN(TEXT("Confirm Latency (ms)"), STAT_LyraWeaponFire_ConfirmLatency, STATGROUP_LyraWeaponFire, LYRAGAME_API);
+
+// Insights channel for the weapon fire events, enable with -trace=cpu,LyraWeaponFire
+UE_TRACE_CHANNEL_EXTERN(LyraWeaponFireChannel, LYRAGAME_API);
+
+// Times a scope into both the stat and an Insights event on LyraWeaponFireChannel
+#define LYRA_WEAPON_FIRE_SCOPE(StatName) \
+	SCOPE_CYCLE_COUNTER(StatName); \
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(StatName, LyraWeaponFireChannel)
+
+/** Line and sweep queries made for one bullet (or added up over a cartridge) */
+struct FLyraWeaponTraceCounts
+{
+	int32 LineTraces = 0;
+	int32 SweepTraces = 0;
+
+	// Bullets whose line trace results were thrown away for the results of the sweep
+	int32 SweepReplacements = 0;
+
+	FLyraWeaponTraceCounts& operator+=(const FLyraWeaponTraceCounts& Other)
+	{
+		LineTraces += Other.LineTraces;
+		SweepTraces += Other.SweepTraces;
+		SweepReplacements += Other.SweepReplacements;
+		return *this;
+	}
+};
+
+/** Fixed size histogram with power of two buckets */
+struct LYRAGAME_API FLyraWeaponFireHistogram
+{
+	// Bucket 0 holds values below 1, bucket N holds [2^(N-1), 2^N) and the last bucket everything above
+	static constexpr int32 NumBuckets = 20;
+
+	void Add(double Value);
+
+	// Returns the upper edge of the bucket the given fraction of the samples falls into
+	double GetPercentile(double Fraction) const;
+
+	FString ToString(const TCHAR* Units) const;
+
+	int64 Counts[NumBuckets] = {};
+	int64 NumSamples = 0;
+	double Sum = 0.0;
+	double MaxValue = 0.0;
+};
+
+/**
+ * FLyraWeaponFireStats
+ *
+ *	Per weapon measurements of the firing pipeline, kept on the game thread and printed by Lyra.Weapon.DumpFireStats.
+ *	Weapons are keyed by the class of their weapon instance.
+ */
+class LYRAGAME_API FLyraWeaponFireStats
+{
+public:
+	enum class EMeasure : uint8
+	{
+		// Time spent in StartRangedWeaponTargeting (microseconds)
+		TargetingTime,
+		// Time between sending hit markers and the server confirming them (milliseconds)
+		ConfirmLatency,
+		// Time spent applying damage effects to the targets of one shot (microseconds)
+		ApplyDamageTime,
+
+		Num
+	};
+
+	static FName GetWeaponKey(const UObject* WeaponInstance);
+
+	static void RecordShot(FName WeaponKey, const FLyraWeaponTraceCounts& TraceCounts);
+	static void RecordMeasure(FName WeaponKey, EMeasure Measure, double Value);
+
+	static void Dump(FOutputDevice& Ar);
+	static void Reset();
+};
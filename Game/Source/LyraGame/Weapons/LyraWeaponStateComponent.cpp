@@ -6,9 +6,7 @@
 #include "Engine/HitResult.h"
 #include "Engine/NetSerialization.h"
 #include "Engine/World.h"
-#include "Equipment/LyraEquipmentManagerComponent.h"
 #include "GameFramework/Actor.h"
-#include "GameFramework/Pawn.h"
 #include "GameFramework/PlayerController.h"
 #include "GameplayEffectTypes.h"
 #include "Kismet/GameplayStatics.h"
@@ -20,7 +18,7 @@
 #include "UObject/NameTypes.h"
 #include "UObject/WeakObjectPtr.h"
 #include "UObject/WeakObjectPtrTemplates.h"
-#include "Weapons/LyraRangedWeaponInstance.h"
+#include "Weapons/LyraWeaponFireStats.h"
 
 #include UE_INLINE_GENERATED_CPP_BY_NAME(LyraWeaponStateComponent)
 
@@ -31,7 +29,7 @@ ULyraWeaponStateComponent::ULyraWeaponStateComponent(const FObjectInitializer& O
 {
 	SetIsReplicatedByDefault(true);
 
-	PrimaryComponentTick.bStartWithTickEnabled = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
 	PrimaryComponentTick.bCanEverTick = true;
 }
 
@@ -39,15 +37,16 @@ void ULyraWeaponStateComponent::TickComponent(float DeltaTime, enum ELevelTick T
 {
 	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
 
-	if (APawn* Pawn = GetPawn<APawn>())
+	// Drop batches the server never confirmed (e.g., the ability ended before the target data got there)
+	const double OldestCreationTime = GetWorld()->GetTimeSeconds() - UnconfirmedHitMarkerTimeout;
+	UnconfirmedServerSideHitMarkers.RemoveAll([OldestCreationTime](const FLyraServerSideHitMarkerBatch& Batch)
 	{
-		if (ULyraEquipmentManagerComponent* EquipmentManager = Pawn->FindComponentByClass<ULyraEquipmentManagerComponent>())
-		{
-			if (ULyraRangedWeaponInstance* CurrentWeapon = Cast<ULyraRangedWeaponInstance>(EquipmentManager->GetFirstInstanceOfType(ULyraRangedWeaponInstance::StaticClass())))
-			{
-				CurrentWeapon->Tick(DeltaTime);
-			}
-		}
+		return Batch.CreationTime < OldestCreationTime;
+	});
+
+	if (UnconfirmedServerSideHitMarkers.Num() == 0)
+	{
+		SetComponentTickEnabled(false);
 	}
 }
 
@@ -80,6 +79,10 @@ void ULyraWeaponStateComponent::ClientConfirmTargetData_Implementation(uint16 Un
 		FLyraServerSideHitMarkerBatch& Batch = UnconfirmedServerSideHitMarkers[i];
 		if (Batch.UniqueId == UniqueId)
 		{
+			const double ConfirmLatencyMs = (GetWorld()->GetTimeSeconds() - Batch.CreationTime) * 1000.0;
+			SET_FLOAT_STAT(STAT_LyraWeaponFire_ConfirmLatency, ConfirmLatencyMs);
+			FLyraWeaponFireStats::RecordMeasure(Batch.WeaponStatKey, FLyraWeaponFireStats::EMeasure::ConfirmLatency, ConfirmLatencyMs);
+
 			if (bSuccess && (HitReplaces.Num() != Batch.Markers.Num()))
 			{
 				UWorld* World = GetWorld();
@@ -105,14 +108,24 @@ void ULyraWeaponStateComponent::ClientConfirmTargetData_Implementation(uint16 Un
 			}
 
 			UnconfirmedServerSideHitMarkers.RemoveAt(i);
+
+			if (UnconfirmedServerSideHitMarkers.Num() == 0)
+			{
+				SetComponentTickEnabled(false);
+			}
 			break;
 		}
 	}
 }
 
-void ULyraWeaponStateComponent::AddUnconfirmedServerSideHitMarkers(const FGameplayAbilityTargetDataHandle& InTargetData, const TArray<FHitResult>& FoundHits)
+void ULyraWeaponStateComponent::AddUnconfirmedServerSideHitMarkers(const FGameplayAbilityTargetDataHandle& InTargetData, const TArray<FHitResult>& FoundHits, FName WeaponStatKey)
 {
 	FLyraServerSideHitMarkerBatch& NewUnconfirmedHitMarker = UnconfirmedServerSideHitMarkers.Emplace_GetRef(InTargetData.UniqueId);
+	NewUnconfirmedHitMarker.CreationTime = GetWorld()->GetTimeSeconds();
+	NewUnconfirmedHitMarker.WeaponStatKey = WeaponStatKey;
+
+	// Tick until the server has confirmed (or we give up on) this batch
+	SetComponentTickEnabled(true);
 
 	if (APlayerController* OwnerPC = GetController<APlayerController>())
 	{
@@ -38,10 +38,17 @@ struct FLyraServerSideHitMarkerBatch
 
 	TArray<FLyraScreenSpaceHitLocation> Markers;
 
+	/** World time the batch was added, unconfirmed batches are dropped once they get too old */
+	double CreationTime = 0.0;
+
+	/** Weapon that fired the shot, for FLyraWeaponFireStats */
+	FName WeaponStatKey;
+
 	uint8 UniqueId = 0;
 };
 
 // Tracks weapon state and recent confirmed hit markers to display on screen
+// Only ticks while there are hit markers waiting for the server to confirm them
 UCLASS()
 class ULyraWeaponStateComponent : public UControllerComponent
 {
@@ -56,7 +63,7 @@ public:
 	UFUNCTION(Client, Reliable)
 	void ClientConfirmTargetData(uint16 UniqueId, bool bSuccess, const TArray<uint8>& HitReplaces);
 
-	void AddUnconfirmedServerSideHitMarkers(const FGameplayAbilityTargetDataHandle& InTargetData, const TArray<FHitResult>& FoundHits);
+	void AddUnconfirmedServerSideHitMarkers(const FGameplayAbilityTargetDataHandle& InTargetData, const TArray<FHitResult>& FoundHits, FName WeaponStatKey = NAME_None);
 
 	/** Updates this player's last damage instigated time */
 	void UpdateDamageInstigatedTime(const FGameplayEffectContextHandle& EffectContext);
@@ -85,6 +92,10 @@ protected:
 
 	void ActuallyUpdateDamageInstigatedTime();
 
+	// Unconfirmed hit markers older than this (in seconds) are assumed lost and dropped
+	UPROPERTY(EditDefaultsOnly, Category="Hit Markers", meta=(ForceUnits=s))
+	float UnconfirmedHitMarkerTimeout = 2.0f;
+
 private:
 	/** Last time this controller instigated weapon damage */
 	double LastWeaponDamageInstigatedTime = 0.0;